@@ -1,4 +1,5 @@
 @echo off
 %VULKAN_SDK%/Bin/glslangValidator.exe -V shader.vert
 %VULKAN_SDK%/Bin/glslangValidator.exe -V shader.frag
+%VULKAN_SDK%/Bin/glslangValidator.exe -V depth.vert -o depth.spv
 pause
\ No newline at end of file
@@ -7,6 +7,20 @@ layout(set = 1, binding = 0) uniform sampler2D textureSampler;
 
 layout(location = 0) out vec4 outColour;    // Final output colour (must also have layout location, which is separate from 'in' variables)
 
+// Material features (specialization constants, one pipeline variant each: see Material in "Mesh.h")
+layout(constant_id = 0) const bool TEXTURED = true;         // Sample the texture (otherwise: interpolated vertex colour)
+layout(constant_id = 1) const bool ALPHA_TESTED = false;    // Discard the fragments under ALPHA_CUTOFF (disables early depth tests)
+
+const float ALPHA_CUTOFF = 0.5;
+
 void main() {
-    outColour = texture(textureSampler, fragTexture);
+    if (TEXTURED) {
+        outColour = texture(textureSampler, fragTexture);
+    } else {
+        outColour = vec4(fragColour, 1.0);
+    }
+
+    if (ALPHA_TESTED && outColour.a < ALPHA_CUTOFF) {
+        discard;
+    }
 }
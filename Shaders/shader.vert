@@ -12,8 +12,12 @@ layout(set = 0, binding = 0) uniform UboViewProjection {
 
 layout(push_constant) uniform PushModel {
     mat4 model;
+    vec4 uvScaleOffset;     // Texture UVs to atlas page UVs (xy: scale, zw: offset), identity for textures of their own
 } pushModel;
 
+// Must match "depth.vert" bit for bit: the main pass tests the pre-pass depth with VK_COMPARE_OP_EQUAL
+invariant gl_Position;
+
 layout(location = 0) out vec3 fragColour;   // Output colour for vertex (layout location is required for Vulkan SPIR-V)
 layout(location = 1) out vec2 fragTexture;  // Output coordinate for texture
 
@@ -21,5 +25,5 @@ void main() {
     gl_Position = uboViewProjection.projection * uboViewProjection.view * pushModel.model * vec4(pos, 1.0);
 
     fragColour = col;
-    fragTexture = tex;
+    fragTexture = tex * pushModel.uvScaleOffset.xy + pushModel.uvScaleOffset.zw;
 }
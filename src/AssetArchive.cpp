@@ -0,0 +1,324 @@
+#include "AssetArchive.h"
+
+// C++ STL
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+
+// Project includes
+#include "Lz4.h"
+#include "Utilities.h"          // Utilities header includes GLFW [Graphics Library FrameWork] + Vulkan API
+
+using namespace Utilities;
+
+// Archive identification ('AARC'), bump the version when the layout changes
+static const uint32_t ARCHIVE_MAGIC = 0x43524141;
+static const uint32_t ARCHIVE_VERSION = 1;
+
+struct ArchiveHeader
+{
+    uint32_t    magic;
+    uint32_t    version;
+    uint32_t    entryCount;
+    uint32_t    namesSize;
+    uint64_t    entriesOffset;
+    uint64_t    namesOffset;
+};
+
+struct AssetArchive::Entry
+{
+    uint64_t    nameHash;
+    uint64_t    contentHash;        // Of the uncompressed data
+    uint64_t    offset;             // Blob offset in the archive
+    uint64_t    storedSize;
+    uint64_t    size;               // Uncompressed
+    uint32_t    nameOffset;         // In the names block (not null terminated)
+    uint32_t    nameLength;
+    uint32_t    compression;        // AssetCompression
+    uint32_t    reserved;
+};
+
+//------------------------------------------------------------------------------
+// Path separators unified, so 'Textures\\a.png' and 'Textures/a.png' are the same asset
+static std::string normalizeName(const std::string &name)
+{
+    std::string normalized = name;
+    std::replace(normalized.begin(), normalized.end(), '\\', '/');
+    return normalized;
+}
+//------------------------------------------------------------------------------
+AssetArchive::AssetArchive()
+{
+}
+//------------------------------------------------------------------------------
+AssetArchive::~AssetArchive()
+{
+}
+//------------------------------------------------------------------------------
+bool AssetArchive::open(const std::string &filePath)
+{
+    close();
+    if (!m_file.open(filePath))
+    {
+        return false;
+    }
+
+    // The whole index is validated once here: lookups and reads trust it afterwards
+    const uint8_t * data = m_file.getData();
+    const uint64_t size = m_file.getSize();
+    ArchiveHeader header;
+    if (size < sizeof(ArchiveHeader))
+    {
+        close();
+        return false;
+    }
+    memcpy(&header, data, sizeof(ArchiveHeader));
+    if (header.magic != ARCHIVE_MAGIC || header.version != ARCHIVE_VERSION || header.entriesOffset % alignof(Entry) != 0
+        || header.entriesOffset + static_cast<uint64_t>(header.entryCount) * sizeof(Entry) > size
+        || header.namesOffset + header.namesSize > size)
+    {
+        close();
+        return false;
+    }
+
+    const Entry * entries = reinterpret_cast<const Entry *>(data + header.entriesOffset);
+    for (uint32_t i = 0; i < header.entryCount; ++i)
+    {
+        const Entry &entry = entries[i];
+        bool sizesValid = (entry.compression == static_cast<uint32_t>(AssetCompression::None)) ? entry.storedSize == entry.size
+                        : (entry.compression == static_cast<uint32_t>(AssetCompression::Lz4));
+        if (!sizesValid || entry.offset + entry.storedSize > size || entry.offset + entry.storedSize < entry.offset
+            || static_cast<uint64_t>(entry.nameOffset) + entry.nameLength > header.namesSize
+            || (i > 0 && entries[i - 1].nameHash > entry.nameHash))
+        {
+            close();
+            return false;
+        }
+    }
+
+    m_entries = entries;
+    m_entryCount = header.entryCount;
+    m_names = reinterpret_cast<const char *>(data + header.namesOffset);
+    return true;
+}
+//------------------------------------------------------------------------------
+void AssetArchive::close()
+{
+    m_file.close();
+    m_entries = nullptr;
+    m_entryCount = 0;
+    m_names = nullptr;
+}
+//------------------------------------------------------------------------------
+bool AssetArchive::isOpen() const
+{
+    return m_file.isOpen();
+}
+//------------------------------------------------------------------------------
+bool AssetArchive::contains(const std::string &name) const
+{
+    return findEntry(name) != nullptr;
+}
+//------------------------------------------------------------------------------
+uint64_t AssetArchive::getContentHash(const std::string &name) const
+{
+    const Entry * entry = findEntry(name);
+    return entry ? entry->contentHash : 0;
+}
+//------------------------------------------------------------------------------
+std::span<const uint8_t> AssetArchive::find(const std::string &name) const
+{
+    const Entry * entry = findEntry(name);
+    if (!entry || entry->compression != static_cast<uint32_t>(AssetCompression::None))
+    {
+        return {};
+    }
+    return std::span<const uint8_t>(m_file.getData() + entry->offset, static_cast<size_t>(entry->size));
+}
+//------------------------------------------------------------------------------
+bool AssetArchive::read(const std::string &name, std::vector<uint8_t> * storage, std::span<const uint8_t> * data) const
+{
+    const Entry * entry = findEntry(name);
+    if (!entry)
+    {
+        return false;
+    }
+
+    const uint8_t * blob = m_file.getData() + entry->offset;
+    if (entry->compression == static_cast<uint32_t>(AssetCompression::None))
+    {
+        *data = std::span<const uint8_t>(blob, static_cast<size_t>(entry->size));
+        return true;
+    }
+
+    storage->resize(static_cast<size_t>(entry->size));
+    if (!Lz4::decompress(blob, static_cast<size_t>(entry->storedSize), storage->data(), storage->size()))
+    {
+        throw std::runtime_error("Asset archive: '" + name + "' is corrupted!");
+    }
+    *data = std::span<const uint8_t>(storage->data(), storage->size());
+    return true;
+}
+//------------------------------------------------------------------------------
+uint32_t AssetArchive::getEntryCount() const
+{
+    return m_entryCount;
+}
+//------------------------------------------------------------------------------
+void AssetArchive::readAsset(const AssetArchive * archive, const std::string &filePath,
+                             std::vector<uint8_t> * storage, std::span<const uint8_t> * data)
+{
+    if (archive && archive->read(filePath, storage, data))
+    {
+        return;
+    }
+    if (archive && archive->isOpen())
+    {
+        // Not cooked (or not under its runtime path): the archive doesn't cover the scene
+        std::cout << "'" << filePath << "' isn't in the asset archive: loading the loose file" << std::endl;
+    }
+
+    std::ifstream file(filePath, std::ios::binary | std::ios::ate);
+    if (!file.is_open())
+    {
+        throw std::runtime_error("Failed to open a file! ('" + filePath + "')");
+    }
+    storage->resize(static_cast<size_t>(file.tellg()));
+    file.seekg(0);
+    file.read(reinterpret_cast<char *>(storage->data()), storage->size());
+    *data = std::span<const uint8_t>(storage->data(), storage->size());
+}
+//------------------------------------------------------------------------------
+const AssetArchive::Entry * AssetArchive::findEntry(const std::string &name) const
+{
+    if (!m_entries)
+    {
+        return nullptr;
+    }
+
+    // Binary search on the hash, then the names of the entries with that hash (collisions are adjacent)
+    std::string normalized = normalizeName(name);
+    uint64_t nameHash = hashFnv1a(normalized.data(), normalized.size());
+    const Entry * end = m_entries + m_entryCount;
+    const Entry * entry = std::lower_bound(m_entries, end, nameHash,
+                                           [](const Entry &e, uint64_t hash) { return e.nameHash < hash; });
+    for (; entry != end && entry->nameHash == nameHash; ++entry)
+    {
+        if (entry->nameLength == normalized.size() && memcmp(m_names + entry->nameOffset, normalized.data(), normalized.size()) == 0)
+        {
+            return entry;
+        }
+    }
+    return nullptr;
+}
+
+//------------------------------------------------------------------------------
+AssetArchiveWriter::AssetArchiveWriter()
+{
+}
+//------------------------------------------------------------------------------
+AssetArchiveWriter::~AssetArchiveWriter()
+{
+}
+//------------------------------------------------------------------------------
+void AssetArchiveWriter::add(const std::string &name, const uint8_t * data, size_t size, AssetCompression compression)
+{
+    PendingEntry entry;
+    entry.name = normalizeName(name);
+    entry.nameHash = hashFnv1a(entry.name.data(), entry.name.size());
+    entry.contentHash = hashCombine(hashFnv1a(data, size), size);
+    entry.size = size;
+    entry.compression = AssetCompression::None;
+    if (compression == AssetCompression::Lz4)
+    {
+        std::vector<uint8_t> compressed = Lz4::compress(data, size);
+        if (!compressed.empty() && compressed.size() <= size - size / 8)
+        {
+            entry.compression = AssetCompression::Lz4;
+            entry.data = std::move(compressed);
+        }
+    }
+    if (entry.compression == AssetCompression::None)
+    {
+        entry.data.assign(data, data + size);
+    }
+    m_entries.push_back(std::move(entry));
+}
+//------------------------------------------------------------------------------
+void AssetArchiveWriter::write(const std::string &filePath)
+{
+    std::sort(m_entries.begin(), m_entries.end(), [](const PendingEntry &a, const PendingEntry &b) {
+        return a.nameHash != b.nameHash ? a.nameHash < b.nameHash : a.name < b.name;
+    });
+    for (size_t i = 1; i < m_entries.size(); ++i)
+    {
+        if (m_entries[i].name == m_entries[i - 1].name)
+        {
+            throw std::runtime_error("Asset archive: '" + m_entries[i].name + "' added twice!");
+        }
+    }
+
+    // Index and names first, then the aligned blobs
+    std::vector<AssetArchive::Entry> entries(m_entries.size());
+    std::string names;
+    for (size_t i = 0; i < m_entries.size(); ++i)
+    {
+        entries[i] = {};
+        entries[i].nameHash = m_entries[i].nameHash;
+        entries[i].contentHash = m_entries[i].contentHash;
+        entries[i].storedSize = m_entries[i].data.size();
+        entries[i].size = m_entries[i].size;
+        entries[i].nameOffset = static_cast<uint32_t>(names.size());
+        entries[i].nameLength = static_cast<uint32_t>(m_entries[i].name.size());
+        entries[i].compression = static_cast<uint32_t>(m_entries[i].compression);
+        names += m_entries[i].name;
+    }
+
+    ArchiveHeader header = {};
+    header.magic = ARCHIVE_MAGIC;
+    header.version = ARCHIVE_VERSION;
+    header.entryCount = static_cast<uint32_t>(entries.size());
+    header.namesSize = static_cast<uint32_t>(names.size());
+    header.entriesOffset = sizeof(ArchiveHeader);
+    header.namesOffset = header.entriesOffset + entries.size() * sizeof(AssetArchive::Entry);
+
+    uint64_t offset = header.namesOffset + names.size();
+    for (AssetArchive::Entry &entry : entries)
+    {
+        offset = (offset + AssetArchive::BLOB_ALIGNMENT - 1) & ~(AssetArchive::BLOB_ALIGNMENT - 1);
+        entry.offset = offset;
+        offset += entry.storedSize;
+    }
+
+    // Written aside and renamed: a running application never maps a half written archive
+    std::string tempFilePath = filePath + ".tmp";
+    {
+        std::ofstream file(tempFilePath, std::ios::binary | std::ios::trunc);
+        if (!file.is_open())
+        {
+            throw std::runtime_error("Failed to create the asset archive '" + filePath + "'!");
+        }
+        file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+        file.write(reinterpret_cast<const char *>(entries.data()), entries.size() * sizeof(AssetArchive::Entry));
+        file.write(names.data(), names.size());
+        const char padding[AssetArchive::BLOB_ALIGNMENT] = {};
+        for (size_t i = 0; i < entries.size(); ++i)
+        {
+            file.write(padding, static_cast<std::streamsize>(entries[i].offset - static_cast<uint64_t>(file.tellp())));
+            file.write(reinterpret_cast<const char *>(m_entries[i].data.data()), m_entries[i].data.size());
+        }
+        if (!file)
+        {
+            throw std::runtime_error("Failed to write the asset archive '" + filePath + "'!");
+        }
+    }
+    std::error_code errorCode;
+    std::filesystem::rename(tempFilePath, filePath, errorCode);
+    if (errorCode)
+    {
+        throw std::runtime_error("Failed to write the asset archive '" + filePath + "'!");
+    }
+}
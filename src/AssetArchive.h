@@ -0,0 +1,85 @@
+#ifndef ASSET_ARCHIVE_H
+#define ASSET_ARCHIVE_H
+
+// C++ STL
+#include <span>
+#include <string>
+#include <vector>
+
+// Project includes
+#include "MappedFile.h"
+
+// How a blob is stored in the archive
+enum class AssetCompression : uint32_t
+{
+    None    = 0,
+    Lz4     = 1,    // LZ4 block
+};
+
+// Single file package of assets (written by the AssetCooker tool with --archive), memory mapped as a whole.
+// Layout: header | entries (sorted by name hash) | names | blobs (BLOB_ALIGNMENT aligned).
+// Assets are named by their path relative to the Current Working Directory ('Textures/x.ktx2', 'Shaders/vert.spv').
+// Lookups are a binary search in the mapped index, and uncompressed assets are spans into the mapping: one open and
+// no stream read per asset, the pages come straight from the OS file cache. Read-only once opened: thread safe.
+class AssetArchive
+{
+public:
+    static constexpr uint64_t   BLOB_ALIGNMENT  = 16;           // Block compressed levels, SPIR-V words, staging copies
+
+    AssetArchive();
+    ~AssetArchive();
+
+    bool            open(const std::string &filePath);          // False if the file is missing or malformed
+    void            close();
+    bool            isOpen() const;
+
+    bool            contains(const std::string &name) const;
+    uint64_t        getContentHash(const std::string &name) const;                          // Same as TextureCache::hashFileContent, 0: not packed
+    std::span<const uint8_t>    find(const std::string &name) const;                        // Empty: not packed, or compressed
+    bool            read(const std::string &name, std::vector<uint8_t> * storage, std::span<const uint8_t> * data) const;
+    uint32_t        getEntryCount() const;
+
+    // Bytes of an asset: from the archive if it's packed there (a span into the mapping, or inflated into 'storage'),
+    // otherwise read from the loose file into 'storage'. 'archive' may be null. Throws if it's neither.
+    static void     readAsset(const AssetArchive * archive, const std::string &filePath,
+                              std::vector<uint8_t> * storage, std::span<const uint8_t> * data);
+
+private:
+    friend class AssetArchiveWriter;
+    struct Entry;
+
+    MappedFile      m_file;
+    const Entry *   m_entries = nullptr;
+    uint32_t        m_entryCount = 0;
+    const char *    m_names = nullptr;
+
+    // Methods
+    const Entry *   findEntry(const std::string &name) const;
+};
+
+// Builds an asset archive (offline)
+class AssetArchiveWriter
+{
+public:
+    AssetArchiveWriter();
+    ~AssetArchiveWriter();
+
+    // Compressed only if it saves at least 1/8 of the size (block compressed textures usually don't: they stay mappable)
+    void            add(const std::string &name, const uint8_t * data, size_t size, AssetCompression compression);
+    void            write(const std::string &filePath);         // Throws on I/O errors or duplicate names
+
+private:
+    struct PendingEntry
+    {
+        std::string             name;
+        uint64_t                nameHash;
+        uint64_t                contentHash;
+        uint64_t                size;
+        AssetCompression        compression;
+        std::vector<uint8_t>    data;                           // As stored
+    };
+
+    std::vector<PendingEntry>   m_entries;
+};
+
+#endif //ASSET_ARCHIVE_H
@@ -0,0 +1,163 @@
+#include "AssetLoader.h"
+
+// C++ STL
+#include <algorithm>
+#include <stdexcept>
+
+//------------------------------------------------------------------------------
+AssetLoader::AssetLoader()
+{
+}
+//------------------------------------------------------------------------------
+AssetLoader::~AssetLoader()
+{
+}
+//------------------------------------------------------------------------------
+void AssetLoader::create(TextureDecoder decoder, WorkerPool * workerPool)
+{
+    m_decoder = decoder;
+    m_workerPool = workerPool;
+    m_stop = false;
+    m_fileReader.create([this](FileReadResult &&result) { onFileRead(std::move(result)); });
+}
+//------------------------------------------------------------------------------
+void AssetLoader::destroy()
+{
+    // Reads in flight are dropped first (no more decode requests after this)
+    m_fileReader.destroy();
+    {
+        std::unique_lock<std::mutex> lock(m_requestMutex);
+        m_stop = true;
+        m_requests.clear();     // Not started yet: just drop them (their pool jobs find nothing to do)
+        m_reading.clear();
+        m_decodeDone.wait(lock, [this]() { return m_decodingCount == 0; });
+    }
+
+    // Completions nobody collected
+    takeCompleted();
+    m_pendingCount = 0;
+}
+//------------------------------------------------------------------------------
+uint64_t AssetLoader::requestTexture(int textureId, const std::string &fileName, const std::string &filePath)
+{
+    uint64_t ticket = m_nextTicket++;
+    ++m_pendingCount;
+    if (!filePath.empty())
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_requestMutex);
+            m_reading[ticket] = { textureId, ticket, fileName, {} };
+        }
+        m_fileReader.read(filePath, ticket);
+        return ticket;
+    }
+
+    queueDecode({ textureId, ticket, fileName, {} });
+    return ticket;
+}
+//------------------------------------------------------------------------------
+std::vector<std::unique_ptr<AssetCompletion>> AssetLoader::takeCompleted()
+{
+    // Detach the whole stack at once (newest first), then reverse it
+    AssetCompletion * completion = m_completed.exchange(nullptr, std::memory_order_acquire);
+
+    std::vector<std::unique_ptr<AssetCompletion>> completions;
+    for (; completion != nullptr; completion = completion->next)
+    {
+        completions.emplace_back(completion);
+    }
+    std::reverse(completions.begin(), completions.end());
+
+    m_pendingCount -= static_cast<uint32_t>(completions.size());
+    return completions;
+}
+//------------------------------------------------------------------------------
+uint32_t AssetLoader::getPendingCount()
+{
+    return m_pendingCount;
+}
+//------------------------------------------------------------------------------
+void AssetLoader::queueDecode(AssetRequest &&request)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_requestMutex);
+        m_requests.push_back(std::move(request));
+    }
+    m_workerPool->submit([this]() { decodeNext(); });
+}
+//------------------------------------------------------------------------------
+void AssetLoader::decodeNext()
+{
+    AssetRequest request;
+    {
+        std::lock_guard<std::mutex> lock(m_requestMutex);
+        if (m_stop || m_requests.empty())
+        {
+            return;     // Dropped (shutdown)
+        }
+        request = std::move(m_requests.front());
+        m_requests.pop_front();
+        ++m_decodingCount;
+    }
+
+    AssetCompletion * completion = new AssetCompletion();
+    completion->textureId = request.textureId;
+    completion->ticket = request.ticket;
+    completion->fileName = request.fileName;
+    try
+    {
+        m_decoder(request.fileName, request.fileData, &completion->texture);
+    }
+    catch (const std::exception &e)
+    {
+        completion->error = e.what();   // Exceptions can't cross the thread: the render thread reports them
+    }
+    pushCompleted(completion);
+
+    {
+        std::lock_guard<std::mutex> lock(m_requestMutex);
+        --m_decodingCount;
+    }
+    m_decodeDone.notify_all();
+}
+//------------------------------------------------------------------------------
+void AssetLoader::onFileRead(FileReadResult &&result)
+{
+    AssetRequest request;
+    {
+        std::lock_guard<std::mutex> lock(m_requestMutex);
+        auto reading = m_reading.find(result.userData);
+        if (reading == m_reading.end())
+        {
+            return;     // Dropped (shutdown)
+        }
+        request = std::move(reading->second);
+        m_reading.erase(reading);
+    }
+
+    // Read: on to the pool (the decode frees the file data as soon as it's done)
+    if (result.error.empty())
+    {
+        request.fileData = std::move(result.data);
+        queueDecode(std::move(request));
+        return;
+    }
+
+    // Nothing to decode
+    AssetCompletion * completion = new AssetCompletion();
+    completion->textureId = request.textureId;
+    completion->ticket = request.ticket;
+    completion->fileName = request.fileName;
+    completion->error = result.error;
+    pushCompleted(completion);
+}
+//------------------------------------------------------------------------------
+void AssetLoader::pushCompleted(AssetCompletion * completion)
+{
+    // Lock-free push (the consumer only ever detaches the whole stack, so there's no ABA problem)
+    completion->next = m_completed.load(std::memory_order_relaxed);
+    while (!m_completed.compare_exchange_weak(completion->next, completion,
+                                              std::memory_order_release, std::memory_order_relaxed))
+    {
+    }
+}
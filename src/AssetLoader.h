@@ -0,0 +1,97 @@
+#ifndef ASSET_LOADER_H
+#define ASSET_LOADER_H
+
+// C++ STL
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Project includes
+#include "AsyncFileReader.h"
+#include "Utilities.h"          // Utilities header includes GLFW [Graphics Library FrameWork] + Vulkan API
+#include "WorkerPool.h"
+
+// CPU side texture, decoded and ready to be uploaded
+struct TextureData
+{
+    VkFormat                        format      = VK_FORMAT_UNDEFINED;
+    uint32_t                        width       = 0;
+    uint32_t                        height      = 0;
+    uint32_t                        mipLevels   = 1;    // Levels without a region are generated on the GPU (blit)
+    std::vector<uint8_t>            data;               // Texels of all the levels in 'regions'
+    const uint8_t *                 stagingData = nullptr;  // Texels decoded straight into the staging arena (instead of 'data')
+    std::vector<VkBufferImageCopy>  regions;            // One per level, offsets in 'data'
+};
+
+// Result of a texture request (the texture is valid only when 'error' is empty)
+struct AssetCompletion
+{
+    int                 textureId   = -1;
+    uint64_t            ticket      = 0;
+    std::string         fileName;
+    TextureData         texture;
+    std::string         error;
+    AssetCompletion *   next        = nullptr;          // Completion stack link
+};
+
+// Decodes a texture file (called on the pool workers: it must be thread safe). Throws on failures.
+// 'fileData': the file, read ahead by the loader (empty: nothing was read ahead, the decoder gets the data itself).
+using TextureDecoder = std::function<void(const std::string &fileName, std::span<const uint8_t> fileData, TextureData * texture)>;
+
+// Asset loading service: file reads are queued on the asynchronous file reader (many in flight), and each file is
+// decoded on a worker pool as soon as its read completes. The pool is shared (e.g. with the block compression the
+// decodes do): the CPU work never runs on more threads than it has. Finished decodes are pushed on a lock-free
+// (multiple producers, single consumer) completion stack and collected by the render thread, which does the uploads
+// at a frame boundary.
+class AssetLoader
+{
+public:
+    AssetLoader();
+    ~AssetLoader();
+
+    void        create(TextureDecoder decoder, WorkerPool * workerPool);
+    void        destroy();                              // Waits for the decodes in progress (the others are dropped)
+
+    // 'filePath': file to read ahead (empty: straight to the decoder, e.g. packed assets). Returns the ticket of the request
+    uint64_t    requestTexture(int textureId, const std::string &fileName, const std::string &filePath = "");
+    std::vector<std::unique_ptr<AssetCompletion>> takeCompleted();              // In completion order (render thread only)
+    uint32_t    getPendingCount();
+
+private:
+    struct AssetRequest
+    {
+        int             textureId;
+        uint64_t        ticket;
+        std::string     fileName;
+        std::vector<uint8_t>    fileData;               // Read ahead
+    };
+
+    TextureDecoder                      m_decoder;
+    WorkerPool *                        m_workerPool = nullptr;
+    std::mutex                          m_requestMutex;
+    std::condition_variable             m_decodeDone;
+    std::deque<AssetRequest>            m_requests;         // Ready to be decoded (a pool job each)
+    uint32_t                            m_decodingCount = 0;    // Decodes in progress on the pool
+    std::unordered_map<uint64_t, AssetRequest>  m_reading;  // Key: ticket (file read in flight)
+    AsyncFileReader                     m_fileReader;
+    bool                                m_stop = false;
+
+    std::atomic<AssetCompletion *>      m_completed { nullptr };
+    std::atomic<uint32_t>               m_pendingCount { 0 };
+    uint64_t                            m_nextTicket = 1;
+
+    // Methods
+    void        queueDecode(AssetRequest &&request);
+    void        decodeNext();                           // Pool job
+    void        onFileRead(FileReadResult &&result);    // Called on the file reader threads
+    void        pushCompleted(AssetCompletion * completion);
+};
+
+#endif //ASSET_LOADER_H
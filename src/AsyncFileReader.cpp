@@ -0,0 +1,528 @@
+#include "AsyncFileReader.h"
+
+// C++ STL
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+
+// Platform
+#ifndef _WIN32
+    #include <fcntl.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+#if ASYNC_FILE_READER_IO_URING
+    #include <linux/io_uring.h>
+    #include <sys/eventfd.h>
+    #include <sys/mman.h>
+    #include <sys/syscall.h>
+    #include <sys/uio.h>
+#endif
+
+// Fallback: blocking reads, one per thread (a few are enough to keep a queue busy)
+static const uint32_t MAX_FALLBACK_THREADS = 8;
+
+#if ASYNC_FILE_READER_IO_URING
+// user_data of the wake up (eventfd) read, chunk reads use their index + 1
+static const uint64_t WAKE_USER_DATA = 0;
+
+// Submission and completion rings, mapped from the kernel, with the chunk buffers
+struct AsyncFileReader::IoUring
+{
+    int                     fd              = -1;
+    void *                  sqRing          = MAP_FAILED;
+    size_t                  sqRingSize      = 0;
+    void *                  cqRing          = MAP_FAILED;
+    size_t                  cqRingSize      = 0;
+    io_uring_sqe *          sqes            = nullptr;
+    size_t                  sqesSize        = 0;
+    uint32_t *              sqTail          = nullptr;
+    uint32_t *              sqMask          = nullptr;
+    uint32_t *              sqArray         = nullptr;
+    uint32_t *              cqHead          = nullptr;
+    uint32_t *              cqTail          = nullptr;
+    uint32_t *              cqMask          = nullptr;
+    io_uring_cqe *          cqes            = nullptr;
+
+    uint32_t                chunkCount      = 0;
+    std::unique_ptr<uint8_t[]>  buffers;                // chunkCount x CHUNK_SIZE
+    bool                    buffersRegistered = false;  // READ_FIXED (pinned once), otherwise READV
+    uint32_t                toSubmit        = 0;        // Queued in the SQ, not submitted yet
+    uint64_t                wakeValue       = 0;        // Target of the wake up read (outlives the ring thread)
+    iovec                   wakeIov         = {};
+
+    io_uring_sqe * getSqe(uint64_t userData)
+    {
+        // Never full: at most one chunk read per buffer, plus the wake up read, are in flight
+        uint32_t tail = *sqTail;
+        uint32_t index = tail & *sqMask;
+        io_uring_sqe * sqe = &sqes[index];
+        memset(sqe, 0, sizeof(io_uring_sqe));
+        sqe->user_data = userData;
+        sqArray[index] = index;
+        __atomic_store_n(sqTail, tail + 1, __ATOMIC_RELEASE);
+        ++toSubmit;
+        return sqe;
+    }
+};
+
+// A file being read by the ring, and its chunk reads
+struct RingFile
+{
+    FileReadResult          result;
+    int                     fd              = -1;
+    uint64_t                nextOffset      = 0;        // First byte not requested yet
+    uint32_t                chunksInFlight  = 0;
+};
+struct RingChunk
+{
+    RingFile *              file            = nullptr;  // Null: free
+    uint64_t                offset          = 0;
+    uint32_t                length          = 0;
+    iovec                   iov             = {};
+};
+#endif
+
+//------------------------------------------------------------------------------
+AsyncFileReader::AsyncFileReader()
+{
+}
+//------------------------------------------------------------------------------
+AsyncFileReader::~AsyncFileReader()
+{
+}
+//------------------------------------------------------------------------------
+void AsyncFileReader::create(FileReadCallback callback, uint32_t queueDepth)
+{
+    m_callback = callback;
+    m_stop = false;
+    queueDepth = std::max(queueDepth, 1U);
+
+#if ASYNC_FILE_READER_IO_URING
+    if (createRing(queueDepth))
+    {
+        m_threads.emplace_back(&AsyncFileReader::ringLoop, this);
+        return;
+    }
+#endif
+
+    uint32_t threadCount = std::min(queueDepth, MAX_FALLBACK_THREADS);
+    for (uint32_t i = 0; i < threadCount; ++i)
+    {
+        m_threads.emplace_back(&AsyncFileReader::workerLoop, this);
+    }
+}
+//------------------------------------------------------------------------------
+void AsyncFileReader::destroy()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_requestMutex);
+        m_stop = true;
+        m_requests.clear();
+    }
+    m_requestCondition.notify_all();
+#if ASYNC_FILE_READER_IO_URING
+    if (m_wakeEventFd >= 0)
+    {
+        uint64_t one = 1;
+        (void)!::write(m_wakeEventFd, &one, sizeof(one));
+    }
+#endif
+
+    for (std::thread &thread : m_threads)
+    {
+        thread.join();
+    }
+    m_threads.clear();
+
+#if ASYNC_FILE_READER_IO_URING
+    destroyRing();
+#endif
+}
+//------------------------------------------------------------------------------
+void AsyncFileReader::read(const std::string &filePath, uint64_t userData)
+{
+    FileReadResult request;
+    request.userData = userData;
+    request.filePath = filePath;
+    {
+        std::lock_guard<std::mutex> lock(m_requestMutex);
+        m_requests.push_back(std::move(request));
+    }
+
+#if ASYNC_FILE_READER_IO_URING
+    if (m_ring)
+    {
+        uint64_t one = 1;
+        (void)!::write(m_wakeEventFd, &one, sizeof(one));
+        return;
+    }
+#endif
+    m_requestCondition.notify_one();
+}
+//------------------------------------------------------------------------------
+bool AsyncFileReader::isIoUringEnabled() const
+{
+#if ASYNC_FILE_READER_IO_URING
+    return m_ring != nullptr;
+#else
+    return false;
+#endif
+}
+//------------------------------------------------------------------------------
+void AsyncFileReader::workerLoop()
+{
+    while (true)
+    {
+        FileReadResult result;
+        {
+            std::unique_lock<std::mutex> lock(m_requestMutex);
+            m_requestCondition.wait(lock, [this] { return m_stop || !m_requests.empty(); });
+            if (m_stop)
+            {
+                return;
+            }
+            result = std::move(m_requests.front());
+            m_requests.pop_front();
+        }
+
+        readWholeFile(result);
+        m_callback(std::move(result));
+    }
+}
+//------------------------------------------------------------------------------
+void AsyncFileReader::readWholeFile(FileReadResult &result)
+{
+#ifdef _WIN32
+    std::ifstream file(result.filePath, std::ios::binary | std::ios::ate);
+    if (!file.is_open())
+    {
+        result.error = "Failed to open a file! ('" + result.filePath + "')";
+        return;
+    }
+    result.data.resize(static_cast<size_t>(file.tellg()));
+    file.seekg(0);
+    if (!file.read(reinterpret_cast<char *>(result.data.data()), result.data.size()))
+    {
+        result.error = "Failed to read a file! ('" + result.filePath + "')";
+    }
+#else
+    int fd = ::open(result.filePath.c_str(), O_RDONLY | O_CLOEXEC);
+    struct stat fileStat;
+    if (fd < 0 || ::fstat(fd, &fileStat) != 0)
+    {
+        result.error = "Failed to open a file! ('" + result.filePath + "')";
+        if (fd >= 0)
+        {
+            ::close(fd);
+        }
+        return;
+    }
+
+    result.data.resize(static_cast<size_t>(fileStat.st_size));
+    size_t offset = 0;
+    while (offset < result.data.size())
+    {
+        ssize_t bytesRead = ::pread(fd, result.data.data() + offset, result.data.size() - offset, static_cast<off_t>(offset));
+        if (bytesRead < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (bytesRead <= 0)
+        {
+            result.error = "Failed to read a file! ('" + result.filePath + "')";
+            break;
+        }
+        offset += static_cast<size_t>(bytesRead);
+    }
+    ::close(fd);
+#endif
+}
+
+#if ASYNC_FILE_READER_IO_URING
+//------------------------------------------------------------------------------
+bool AsyncFileReader::createRing(uint32_t queueDepth)
+{
+    // Blocked by some container/seccomp profiles, missing before Linux 5.1: the caller falls back to the thread pool
+    io_uring_params params = {};
+    int ringFd = static_cast<int>(syscall(__NR_io_uring_setup, queueDepth + 1, &params));
+    if (ringFd < 0)
+    {
+        return false;
+    }
+
+    m_ring = std::make_unique<IoUring>();
+    IoUring &ring = *m_ring;
+    ring.fd = ringFd;
+    ring.sqRingSize = params.sq_off.array + params.sq_entries * sizeof(uint32_t);
+    ring.cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    bool singleMapping = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    if (singleMapping)
+    {
+        ring.sqRingSize = ring.cqRingSize = std::max(ring.sqRingSize, ring.cqRingSize);
+    }
+    ring.sqRing = mmap(nullptr, ring.sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_SQ_RING);
+    ring.cqRing = singleMapping ? ring.sqRing
+                : mmap(nullptr, ring.cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_CQ_RING);
+    ring.sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+    void * sqes = mmap(nullptr, ring.sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_SQES);
+    m_wakeEventFd = eventfd(0, EFD_CLOEXEC);
+    if (ring.sqRing == MAP_FAILED || ring.cqRing == MAP_FAILED || sqes == MAP_FAILED || m_wakeEventFd < 0)
+    {
+        if (sqes != MAP_FAILED)
+        {
+            munmap(sqes, ring.sqesSize);
+        }
+        destroyRing();
+        return false;
+    }
+    ring.sqes = static_cast<io_uring_sqe *>(sqes);
+
+    uint8_t * sq = static_cast<uint8_t *>(ring.sqRing);
+    uint8_t * cq = static_cast<uint8_t *>(ring.cqRing);
+    ring.sqTail  = reinterpret_cast<uint32_t *>(sq + params.sq_off.tail);
+    ring.sqMask  = reinterpret_cast<uint32_t *>(sq + params.sq_off.ring_mask);
+    ring.sqArray = reinterpret_cast<uint32_t *>(sq + params.sq_off.array);
+    ring.cqHead  = reinterpret_cast<uint32_t *>(cq + params.cq_off.head);
+    ring.cqTail  = reinterpret_cast<uint32_t *>(cq + params.cq_off.tail);
+    ring.cqMask  = reinterpret_cast<uint32_t *>(cq + params.cq_off.ring_mask);
+    ring.cqes    = reinterpret_cast<io_uring_cqe *>(cq + params.cq_off.cqes);
+
+    // Chunk buffers registered once: the kernel doesn't have to pin and map the pages of every read.
+    // Registration can exceed RLIMIT_MEMLOCK on older kernels: plain vectored reads then.
+    ring.chunkCount = queueDepth;
+    ring.buffers = std::make_unique<uint8_t[]>(static_cast<size_t>(queueDepth) * CHUNK_SIZE);
+    std::vector<iovec> iovecs(queueDepth);
+    for (uint32_t i = 0; i < queueDepth; ++i)
+    {
+        iovecs[i].iov_base = ring.buffers.get() + static_cast<size_t>(i) * CHUNK_SIZE;
+        iovecs[i].iov_len = CHUNK_SIZE;
+    }
+    ring.buffersRegistered = syscall(__NR_io_uring_register, ringFd, IORING_REGISTER_BUFFERS, iovecs.data(), queueDepth) == 0;
+    return true;
+}
+//------------------------------------------------------------------------------
+void AsyncFileReader::destroyRing()
+{
+    if (m_ring)
+    {
+        IoUring &ring = *m_ring;
+        if (ring.sqes)
+        {
+            munmap(ring.sqes, ring.sqesSize);
+        }
+        if (ring.cqRing != MAP_FAILED && ring.cqRing != ring.sqRing)
+        {
+            munmap(ring.cqRing, ring.cqRingSize);
+        }
+        if (ring.sqRing != MAP_FAILED)
+        {
+            munmap(ring.sqRing, ring.sqRingSize);
+        }
+        ::close(ring.fd);           // Also unregisters the buffers
+        m_ring.reset();
+    }
+    if (m_wakeEventFd >= 0)
+    {
+        ::close(m_wakeEventFd);
+        m_wakeEventFd = -1;
+    }
+}
+//------------------------------------------------------------------------------
+void AsyncFileReader::ringLoop()
+{
+    IoUring &ring = *m_ring;
+    std::vector<RingChunk> chunks(ring.chunkCount);
+    std::vector<uint32_t> freeChunks(ring.chunkCount);
+    for (uint32_t i = 0; i < ring.chunkCount; ++i)
+    {
+        freeChunks[i] = ring.chunkCount - 1 - i;
+    }
+    std::deque<std::unique_ptr<RingFile>> files;        // In request order: the first files get their chunks first
+    std::vector<uint32_t> retries;                      // Short reads: the rest of the chunk is read again
+    uint32_t chunksInFlight = 0;
+
+    ring.wakeIov = { &ring.wakeValue, sizeof(ring.wakeValue) };
+    bool wakePending = false;
+    bool stopping = false;
+
+    auto finishFile = [&](RingFile * file) {
+        ::close(file->fd);
+        m_callback(std::move(file->result));
+        files.erase(std::find_if(files.begin(), files.end(), [file](const std::unique_ptr<RingFile> &f) { return f.get() == file; }));
+    };
+
+    while (true)
+    {
+        // Newly queued files: opened here (metadata only), read by chunks below
+        if (!stopping)
+        {
+            std::deque<FileReadResult> requests;
+            {
+                std::lock_guard<std::mutex> lock(m_requestMutex);
+                requests.swap(m_requests);
+                stopping = m_stop;
+            }
+            for (FileReadResult &request : requests)
+            {
+                std::unique_ptr<RingFile> file = std::make_unique<RingFile>();
+                file->result = std::move(request);
+                file->fd = ::open(file->result.filePath.c_str(), O_RDONLY | O_CLOEXEC);
+                struct stat fileStat;
+                if (file->fd < 0 || ::fstat(file->fd, &fileStat) != 0)
+                {
+                    file->result.error = "Failed to open a file! ('" + file->result.filePath + "')";
+                    if (file->fd >= 0)
+                    {
+                        ::close(file->fd);
+                    }
+                    m_callback(std::move(file->result));
+                    continue;
+                }
+                file->result.data.resize(static_cast<size_t>(fileStat.st_size));
+                files.push_back(std::move(file));
+                if (files.back()->result.data.empty())
+                {
+                    finishFile(files.back().get());
+                }
+            }
+        }
+
+        // Shutdown: no new reads, the ones in flight are waited for (the kernel writes into the buffers)
+        if (stopping)
+        {
+            chunksInFlight -= static_cast<uint32_t>(retries.size());
+            retries.clear();
+            if (chunksInFlight == 0)
+            {
+                break;
+            }
+        }
+
+        // Chunk reads, as many as there are free buffers (retries first: their file is the closest to completion)
+        auto submitChunk = [&](uint32_t chunkIndex) {
+            RingChunk &chunk = chunks[chunkIndex];
+            uint8_t * buffer = ring.buffers.get() + static_cast<size_t>(chunkIndex) * CHUNK_SIZE;
+            io_uring_sqe * sqe = ring.getSqe(chunkIndex + 1);
+            sqe->fd = chunk.file->fd;
+            sqe->off = chunk.offset;
+            if (ring.buffersRegistered)
+            {
+                sqe->opcode = IORING_OP_READ_FIXED;
+                sqe->addr = reinterpret_cast<uint64_t>(buffer);
+                sqe->len = chunk.length;
+                sqe->buf_index = static_cast<uint16_t>(chunkIndex);
+            }
+            else
+            {
+                chunk.iov = { buffer, chunk.length };
+                sqe->opcode = IORING_OP_READV;
+                sqe->addr = reinterpret_cast<uint64_t>(&chunk.iov);
+                sqe->len = 1;
+            }
+        };
+        if (!stopping)
+        {
+            for (uint32_t chunkIndex : retries)
+            {
+                submitChunk(chunkIndex);
+            }
+            retries.clear();
+            for (auto it = files.begin(); it != files.end() && !freeChunks.empty(); ++it)
+            {
+                RingFile * file = it->get();
+                while (file->result.error.empty() && file->nextOffset < file->result.data.size() && !freeChunks.empty())
+                {
+                    uint32_t chunkIndex = freeChunks.back();
+                    freeChunks.pop_back();
+                    RingChunk &chunk = chunks[chunkIndex];
+                    chunk.file = file;
+                    chunk.offset = file->nextOffset;
+                    chunk.length = static_cast<uint32_t>(std::min<uint64_t>(CHUNK_SIZE, file->result.data.size() - file->nextOffset));
+                    file->nextOffset += chunk.length;
+                    ++file->chunksInFlight;
+                    ++chunksInFlight;
+                    submitChunk(chunkIndex);
+                }
+            }
+            if (!wakePending)
+            {
+                io_uring_sqe * sqe = ring.getSqe(WAKE_USER_DATA);
+                sqe->opcode = IORING_OP_READV;
+                sqe->fd = m_wakeEventFd;
+                sqe->addr = reinterpret_cast<uint64_t>(&ring.wakeIov);
+                sqe->len = 1;
+                wakePending = true;
+            }
+        }
+
+        // One syscall: submit everything queued, and wait for at least one completion
+        int submitted = static_cast<int>(syscall(__NR_io_uring_enter, ring.fd, ring.toSubmit, 1, IORING_ENTER_GETEVENTS, nullptr, 0));
+        if (submitted < 0 && errno != EINTR && errno != EAGAIN && errno != EBUSY)
+        {
+            break;      // Ring unusable: pending reads are dropped
+        }
+        ring.toSubmit -= (submitted > 0) ? static_cast<uint32_t>(submitted) : 0;
+
+        // Completions
+        uint32_t head = *ring.cqHead;
+        uint32_t tail = __atomic_load_n(ring.cqTail, __ATOMIC_ACQUIRE);
+        for (; head != tail; ++head)
+        {
+            const io_uring_cqe &cqe = ring.cqes[head & *ring.cqMask];
+            if (cqe.user_data == WAKE_USER_DATA)
+            {
+                wakePending = false;        // Counter consumed: new requests (or shutdown) are picked up at the top of the loop
+                continue;
+            }
+
+            uint32_t chunkIndex = static_cast<uint32_t>(cqe.user_data - 1);
+            RingChunk &chunk = chunks[chunkIndex];
+            RingFile * file = chunk.file;
+            if (stopping)
+            {
+                // Dropped: only the buffers matter now
+            }
+            else if (cqe.res == -EINTR || cqe.res == -EAGAIN)
+            {
+                retries.push_back(chunkIndex);
+                continue;
+            }
+            else if (cqe.res <= 0)
+            {
+                file->result.error = "Failed to read a file! ('" + file->result.filePath + "': "
+                                   + (cqe.res < 0 ? strerror(-cqe.res) : "unexpected end of file") + ")";
+            }
+            else
+            {
+                uint32_t bytesRead = static_cast<uint32_t>(cqe.res);
+                memcpy(file->result.data.data() + chunk.offset, ring.buffers.get() + static_cast<size_t>(chunkIndex) * CHUNK_SIZE, bytesRead);
+                if (bytesRead < chunk.length)
+                {
+                    // Short read: the rest at the next submission, into the start of the same buffer
+                    chunk.offset += bytesRead;
+                    chunk.length -= bytesRead;
+                    retries.push_back(chunkIndex);
+                    continue;
+                }
+            }
+
+            chunk.file = nullptr;
+            freeChunks.push_back(chunkIndex);
+            --chunksInFlight;
+            --file->chunksInFlight;
+            if (!stopping && file->chunksInFlight == 0 && (!file->result.error.empty() || file->nextOffset == file->result.data.size()))
+            {
+                finishFile(file);
+            }
+        }
+        __atomic_store_n(ring.cqHead, head, __ATOMIC_RELEASE);
+    }
+
+    for (std::unique_ptr<RingFile> &file : files)
+    {
+        ::close(file->fd);
+    }
+}
+#endif
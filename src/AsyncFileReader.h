@@ -0,0 +1,76 @@
+#ifndef ASYNC_FILE_READER_H
+#define ASYNC_FILE_READER_H
+
+// C++ STL
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Linux io_uring (kernel headers only: the syscalls are issued directly, liburing isn't needed)
+#if defined(__linux__) && __has_include(<linux/io_uring.h>)
+    #define ASYNC_FILE_READER_IO_URING  1
+#else
+    #define ASYNC_FILE_READER_IO_URING  0
+#endif
+
+// A finished whole file read ('data' is valid only when 'error' is empty)
+struct FileReadResult
+{
+    uint64_t                userData    = 0;
+    std::string             filePath;
+    std::vector<uint8_t>    data;
+    std::string             error;
+};
+
+// Called on the reader threads as the reads complete: must be thread safe, and short (hand the data over to other workers)
+using FileReadCallback = std::function<void(FileReadResult &&result)>;
+
+// Asynchronous whole file reads, many in flight at once (NVMe drives reach their bandwidth only with a deep queue).
+// io_uring: one thread submits the chunk reads of all the queued files in batches (one syscall for many reads, into
+// buffers registered once) and hands each file over as soon as its last chunk completes.
+// Fallback (other platforms, or kernels without io_uring): a pool of threads doing blocking positional reads.
+class AsyncFileReader
+{
+public:
+    static constexpr uint32_t   QUEUE_DEPTH     = 32;               // Chunk reads in flight
+    static constexpr uint32_t   CHUNK_SIZE      = 512 * 1024;       // Size of a read, and of a registered buffer [bytes]
+
+    AsyncFileReader();
+    ~AsyncFileReader();
+
+    void        create(FileReadCallback callback, uint32_t queueDepth = QUEUE_DEPTH);
+    void        destroy();                              // Reads not finished yet are dropped (no callback)
+
+    void        read(const std::string &filePath, uint64_t userData);
+    bool        isIoUringEnabled() const;
+
+private:
+    FileReadCallback            m_callback;
+    std::mutex                  m_requestMutex;
+    std::condition_variable     m_requestCondition;     // Fallback workers
+    std::deque<FileReadResult>  m_requests;             // Queued reads (path and user data only)
+    std::vector<std::thread>    m_threads;
+    bool                        m_stop = false;
+
+#if ASYNC_FILE_READER_IO_URING
+    struct IoUring;
+    std::unique_ptr<IoUring>    m_ring;                 // Null: fallback
+    int                         m_wakeEventFd = -1;     // Wakes the ring thread up when reads are queued (or on shutdown)
+
+    bool        createRing(uint32_t queueDepth);
+    void        destroyRing();
+    void        ringLoop();
+#endif
+
+    // Methods
+    void        workerLoop();
+    static void readWholeFile(FileReadResult &result);
+};
+
+#endif //ASYNC_FILE_READER_H
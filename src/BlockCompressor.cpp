@@ -0,0 +1,603 @@
+#include "BlockCompressor.h"
+
+// C++ STL
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+#include <thread>
+
+#if BLOCK_COMPRESSOR_SSE2
+    #include <emmintrin.h>
+#endif
+
+// Block sizes [bytes]
+static const uint32_t BC1_BLOCK_SIZE = 8;
+static const uint32_t BC7_BLOCK_SIZE = 16;
+
+// BC7 4 bit index interpolation weights (out of 64)
+static const uint32_t BC7_WEIGHTS4[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+// Midpoints between consecutive weights (normalized): nearest index selection
+static const float BC7_MIDPOINTS4[15] = {  4 / 128.0f,  13 / 128.0f,  22 / 128.0f,  30 / 128.0f,  38 / 128.0f,
+                                          47 / 128.0f,  56 / 128.0f,  64 / 128.0f,  72 / 128.0f,  81 / 128.0f,
+                                          90 / 128.0f,  98 / 128.0f, 106 / 128.0f, 115 / 128.0f, 124 / 128.0f };
+
+// Number of least squares refinements of the endpoints (Quality only)
+static const uint32_t REFINE_ITERATIONS = 2;
+
+// 4x4 texels in SoA layout (one row of 16 floats per channel: R, G, B, A)
+struct BlockTexels
+{
+    alignas(16) float channel[4][16];
+};
+
+//------------------------------------------------------------------------------
+// Block kernels //
+//------------------------------------------------------------------------------
+static void loadBlock(const uint8_t * pixels, uint32_t width, uint32_t height, uint32_t blockX, uint32_t blockY, BlockTexels * block)
+{
+    for (uint32_t y = 0; y < 4; ++y)
+    {
+        uint32_t pixelY = std::min(blockY * 4 + y, height - 1);     // Clamp to the edge (sizes not multiple of 4)
+        for (uint32_t x = 0; x < 4; ++x)
+        {
+            uint32_t pixelX = std::min(blockX * 4 + x, width - 1);
+            const uint8_t * pixel = pixels + (static_cast<size_t>(pixelY) * width + pixelX) * 4;
+            for (uint32_t c = 0; c < 4; ++c)
+            {
+                block->channel[c][y * 4 + x] = static_cast<float>(pixel[c]);
+            }
+        }
+    }
+}
+//------------------------------------------------------------------------------
+// Projects every texel on the segment e0 -> e1 and returns, for each one, how many midpoints are below its
+// position (i.e. the nearest interpolation weight, when the midpoints are the ones between consecutive weights)
+static void selectIndices(const BlockTexels &block, uint32_t channels, const float e0[4], const float e1[4],
+                          const float * midpoints, uint32_t midpointCount, uint8_t indices[16])
+{
+    float direction[4] = {};
+    float lengthSquared = 0.0f;
+    for (uint32_t c = 0; c < channels; ++c)
+    {
+        direction[c] = e1[c] - e0[c];
+        lengthSquared += direction[c] * direction[c];
+    }
+    if (lengthSquared < 1e-6f)
+    {
+        memset(indices, 0, 16);
+        return;
+    }
+    const float invLengthSquared = 1.0f / lengthSquared;
+
+#if BLOCK_COMPRESSOR_SSE2
+    for (uint32_t i = 0; i < 16; i += 4)
+    {
+        // t = dot(texel - e0, direction) / |direction|^2   (4 texels at once)
+        __m128 t = _mm_setzero_ps();
+        for (uint32_t c = 0; c < channels; ++c)
+        {
+            __m128 delta = _mm_sub_ps(_mm_load_ps(&block.channel[c][i]), _mm_set1_ps(e0[c]));
+            t = _mm_add_ps(t, _mm_mul_ps(delta, _mm_set1_ps(direction[c])));
+        }
+        t = _mm_mul_ps(t, _mm_set1_ps(invLengthSquared));
+
+        // Comparison masks are -1 when true: subtracting them counts the midpoints below t
+        __m128i index = _mm_setzero_si128();
+        for (uint32_t k = 0; k < midpointCount; ++k)
+        {
+            index = _mm_sub_epi32(index, _mm_castps_si128(_mm_cmpgt_ps(t, _mm_set1_ps(midpoints[k]))));
+        }
+
+        alignas(16) int32_t lanes[4];
+        _mm_store_si128(reinterpret_cast<__m128i *>(lanes), index);
+        for (uint32_t j = 0; j < 4; ++j)
+        {
+            indices[i + j] = static_cast<uint8_t>(lanes[j]);
+        }
+    }
+#else
+    for (uint32_t i = 0; i < 16; ++i)
+    {
+        float t = 0.0f;
+        for (uint32_t c = 0; c < channels; ++c)
+        {
+            t += (block.channel[c][i] - e0[c]) * direction[c];
+        }
+        t *= invLengthSquared;
+
+        uint8_t index = 0;
+        for (uint32_t k = 0; k < midpointCount; ++k)
+        {
+            index += (t > midpoints[k]) ? 1 : 0;
+        }
+        indices[i] = index;
+    }
+#endif
+}
+//------------------------------------------------------------------------------
+// Initial endpoints: bounding box diagonal (Fast) or extremes along the principal axis (Quality)
+static void findEndpoints(const BlockTexels &block, uint32_t channels, CompressionQuality quality, float e0[4], float e1[4])
+{
+    float mean[4] = {}, minimum[4], maximum[4];
+    for (uint32_t c = 0; c < channels; ++c)
+    {
+        minimum[c] = maximum[c] = block.channel[c][0];
+        for (uint32_t i = 0; i < 16; ++i)
+        {
+            mean[c] += block.channel[c][i];
+            minimum[c] = std::min(minimum[c], block.channel[c][i]);
+            maximum[c] = std::max(maximum[c], block.channel[c][i]);
+        }
+        mean[c] /= 16.0f;
+    }
+
+    // Covariance matrix
+    float covariance[4][4] = {};
+    for (uint32_t i = 0; i < 16; ++i)
+    {
+        for (uint32_t a = 0; a < channels; ++a)
+        {
+            for (uint32_t b = a; b < channels; ++b)
+            {
+                covariance[a][b] += (block.channel[a][i] - mean[a]) * (block.channel[b][i] - mean[b]);
+            }
+        }
+    }
+    for (uint32_t a = 0; a < channels; ++a)
+    {
+        for (uint32_t b = 0; b < a; ++b)
+        {
+            covariance[a][b] = covariance[b][a];
+        }
+    }
+
+    if (quality == CompressionQuality::Fast)
+    {
+        // Bounding box diagonal, with the direction of each channel following its correlation with the widest one
+        uint32_t widest = 0;
+        for (uint32_t c = 1; c < channels; ++c)
+        {
+            widest = (maximum[c] - minimum[c] > maximum[widest] - minimum[widest]) ? c : widest;
+        }
+        for (uint32_t c = 0; c < channels; ++c)
+        {
+            bool inverted = covariance[widest][c] < 0.0f;
+            float inset = (maximum[c] - minimum[c]) / 16.0f;   // Inset: extremes are rarely hit exactly by the palette
+            e0[c] = (inverted ? maximum[c] - inset : minimum[c] + inset);
+            e1[c] = (inverted ? minimum[c] + inset : maximum[c] - inset);
+        }
+        return;
+    }
+
+    // Principal axis (power iteration, starting from the bounding box diagonal)
+    float axis[4] = {};
+    for (uint32_t c = 0; c < channels; ++c)
+    {
+        axis[c] = maximum[c] - minimum[c] + 1e-3f;
+    }
+    for (uint32_t iteration = 0; iteration < 8; ++iteration)
+    {
+        float next[4] = {};
+        float length = 0.0f;
+        for (uint32_t a = 0; a < channels; ++a)
+        {
+            for (uint32_t b = 0; b < channels; ++b)
+            {
+                next[a] += covariance[a][b] * axis[b];
+            }
+            length = std::max(length, std::fabs(next[a]));
+        }
+        if (length < 1e-6f)
+        {
+            break;  // Flat block: keep the previous axis
+        }
+        for (uint32_t c = 0; c < channels; ++c)
+        {
+            axis[c] = next[c] / length;
+        }
+    }
+
+    // Extremes of the texels projected on the axis
+    float axisLengthSquared = 0.0f;
+    for (uint32_t c = 0; c < channels; ++c)
+    {
+        axisLengthSquared += axis[c] * axis[c];
+    }
+    float tMin = 0.0f, tMax = 0.0f;
+    for (uint32_t i = 0; i < 16; ++i)
+    {
+        float t = 0.0f;
+        for (uint32_t c = 0; c < channels; ++c)
+        {
+            t += (block.channel[c][i] - mean[c]) * axis[c];
+        }
+        t /= std::max(axisLengthSquared, 1e-6f);
+        tMin = std::min(tMin, t);
+        tMax = std::max(tMax, t);
+    }
+    for (uint32_t c = 0; c < channels; ++c)
+    {
+        e0[c] = std::clamp(mean[c] + tMin * axis[c], 0.0f, 255.0f);
+        e1[c] = std::clamp(mean[c] + tMax * axis[c], 0.0f, 255.0f);
+    }
+}
+//------------------------------------------------------------------------------
+// Least squares endpoints for the given indices (weights in [0, 1]): minimizes sum |(1-w)*e0 + w*e1 - texel|^2
+static bool refineEndpoints(const BlockTexels &block, uint32_t channels, const uint8_t indices[16], const float * weights,
+                            float e0[4], float e1[4])
+{
+    float aa = 0.0f, ab = 0.0f, bb = 0.0f;
+    float ax[4] = {}, bx[4] = {};
+    for (uint32_t i = 0; i < 16; ++i)
+    {
+        float b = weights[indices[i]];
+        float a = 1.0f - b;
+        aa += a * a;
+        ab += a * b;
+        bb += b * b;
+        for (uint32_t c = 0; c < channels; ++c)
+        {
+            ax[c] += a * block.channel[c][i];
+            bx[c] += b * block.channel[c][i];
+        }
+    }
+
+    float determinant = aa * bb - ab * ab;
+    if (std::fabs(determinant) < 1e-6f)
+    {
+        return false;   // All the texels on the same index
+    }
+    for (uint32_t c = 0; c < channels; ++c)
+    {
+        e0[c] = std::clamp((bb * ax[c] - ab * bx[c]) / determinant, 0.0f, 255.0f);
+        e1[c] = std::clamp((aa * bx[c] - ab * ax[c]) / determinant, 0.0f, 255.0f);
+    }
+    return true;
+}
+//------------------------------------------------------------------------------
+// Squared error of the block encoded with the given palette and indices
+static float paletteError(const BlockTexels &block, uint32_t channels, const float palette[][4], const uint8_t indices[16])
+{
+    float error = 0.0f;
+    for (uint32_t i = 0; i < 16; ++i)
+    {
+        for (uint32_t c = 0; c < channels; ++c)
+        {
+            float delta = palette[indices[i]][c] - block.channel[c][i];
+            error += delta * delta;
+        }
+    }
+    return error;
+}
+
+//------------------------------------------------------------------------------
+// BC1 //
+//------------------------------------------------------------------------------
+static uint16_t packRgb565(const float color[4])
+{
+    uint32_t r = static_cast<uint32_t>(std::lround(std::clamp(color[0], 0.0f, 255.0f) * 31.0f / 255.0f));
+    uint32_t g = static_cast<uint32_t>(std::lround(std::clamp(color[1], 0.0f, 255.0f) * 63.0f / 255.0f));
+    uint32_t b = static_cast<uint32_t>(std::lround(std::clamp(color[2], 0.0f, 255.0f) * 31.0f / 255.0f));
+    return static_cast<uint16_t>((r << 11) | (g << 5) | b);
+}
+//------------------------------------------------------------------------------
+static void unpackRgb565(uint16_t packed, float color[4])
+{
+    uint32_t r = (packed >> 11) & 0x1F, g = (packed >> 5) & 0x3F, b = packed & 0x1F;
+    color[0] = static_cast<float>((r << 3) | (r >> 2));
+    color[1] = static_cast<float>((g << 2) | (g >> 4));
+    color[2] = static_cast<float>((b << 3) | (b >> 2));
+    color[3] = 255.0f;
+}
+//------------------------------------------------------------------------------
+// Quantizes the endpoints and selects the indices (4 colors mode: color0 > color1). Returns the squared error.
+static float encodeBc1Endpoints(const BlockTexels &block, const float e0[4], const float e1[4],
+                                uint16_t * color0, uint16_t * color1, uint8_t lineIndices[16])
+{
+    static const float midpoints[3] = { 1.0f / 6.0f, 0.5f, 5.0f / 6.0f };
+
+    uint16_t c0 = packRgb565(e0);
+    uint16_t c1 = packRgb565(e1);
+    if (c0 < c1)
+    {
+        std::swap(c0, c1);
+    }
+
+    // Palette in the order along the line color0 -> color1
+    float palette[4][4];
+    unpackRgb565(c0, palette[0]);
+    unpackRgb565(c1, palette[3]);
+    for (uint32_t c = 0; c < 3; ++c)
+    {
+        palette[1][c] = (2.0f * palette[0][c] + palette[3][c]) / 3.0f;
+        palette[2][c] = (palette[0][c] + 2.0f * palette[3][c]) / 3.0f;
+    }
+
+    if (c0 == c1)
+    {
+        memset(lineIndices, 0, 16);  // Single color block
+    }
+    else
+    {
+        selectIndices(block, 3, palette[0], palette[3], midpoints, 3, lineIndices);
+    }
+
+    *color0 = c0;
+    *color1 = c1;
+    return paletteError(block, 3, palette, lineIndices);
+}
+//------------------------------------------------------------------------------
+static void encodeBc1Block(const BlockTexels &block, CompressionQuality quality, uint8_t * output)
+{
+    static const float lineWeights[4] = { 0.0f, 1.0f / 3.0f, 2.0f / 3.0f, 1.0f };
+    static const uint32_t lineToIndex[4] = { 0, 2, 3, 1 };  // BC1 index order: color0, color1, 2/3 c0 + 1/3 c1, 1/3 c0 + 2/3 c1
+
+    float e0[4], e1[4];
+    findEndpoints(block, 3, quality, e0, e1);
+
+    uint16_t color0, color1;
+    uint8_t lineIndices[16];
+    float error = encodeBc1Endpoints(block, e0, e1, &color0, &color1, lineIndices);
+
+    // Refine the endpoints on the selected indices, and keep the result only if it's better
+    uint32_t iterations = (quality == CompressionQuality::Quality) ? REFINE_ITERATIONS : 0;
+    for (uint32_t iteration = 0; iteration < iterations && error > 0.0f; ++iteration)
+    {
+        // Endpoints as seen by the indices (line order goes from color0 to color1)
+        unpackRgb565(color0, e0);
+        unpackRgb565(color1, e1);
+        if (!refineEndpoints(block, 3, lineIndices, lineWeights, e0, e1))
+        {
+            break;
+        }
+
+        uint16_t newColor0, newColor1;
+        uint8_t newLineIndices[16];
+        float newError = encodeBc1Endpoints(block, e0, e1, &newColor0, &newColor1, newLineIndices);
+        if (newError >= error)
+        {
+            break;
+        }
+        error = newError;
+        color0 = newColor0;
+        color1 = newColor1;
+        memcpy(lineIndices, newLineIndices, 16);
+    }
+
+    // Layout: color0 (16 bit) | color1 (16 bit) | 16 x 2 bit indices (texel 0 in the lowest bits)
+    uint32_t packedIndices = 0;
+    for (uint32_t i = 0; i < 16; ++i)
+    {
+        packedIndices |= lineToIndex[lineIndices[i]] << (i * 2);
+    }
+    memcpy(output + 0, &color0, sizeof(uint16_t));
+    memcpy(output + 2, &color1, sizeof(uint16_t));
+    memcpy(output + 4, &packedIndices, sizeof(uint32_t));
+}
+
+//------------------------------------------------------------------------------
+// BC7 (mode 6: single subset, RGBA 7.7.7.7 endpoints + unique P-bit, 4 bit indices) //
+//------------------------------------------------------------------------------
+// Quantizes an endpoint to 7 bits per channel plus the P-bit (LSB shared by all the channels) giving the lowest error
+static void quantizeBc7Endpoint(const float endpoint[4], uint8_t quantized[4], uint8_t * pBit, float dequantized[4])
+{
+    float bestError = -1.0f;
+    for (uint8_t p = 0; p < 2; ++p)
+    {
+        uint8_t values[4];
+        float error = 0.0f;
+        for (uint32_t c = 0; c < 4; ++c)
+        {
+            values[c] = static_cast<uint8_t>(std::clamp(std::lround((endpoint[c] - p) / 2.0f), 0L, 127L));
+            float delta = static_cast<float>((values[c] << 1) | p) - endpoint[c];
+            error += delta * delta;
+        }
+        if (bestError < 0.0f || error < bestError)
+        {
+            bestError = error;
+            *pBit = p;
+            memcpy(quantized, values, 4);
+        }
+    }
+    for (uint32_t c = 0; c < 4; ++c)
+    {
+        dequantized[c] = static_cast<float>((quantized[c] << 1) | *pBit);
+    }
+}
+//------------------------------------------------------------------------------
+struct Bc7Mode6Block
+{
+    uint8_t endpoints[2][4];    // 7 bit per channel
+    uint8_t pBits[2];
+    uint8_t indices[16];        // 4 bit
+};
+//------------------------------------------------------------------------------
+static float encodeBc7Endpoints(const BlockTexels &block, const float e0[4], const float e1[4], Bc7Mode6Block * encoded)
+{
+    float endpoints[2][4];
+    quantizeBc7Endpoint(e0, encoded->endpoints[0], &encoded->pBits[0], endpoints[0]);
+    quantizeBc7Endpoint(e1, encoded->endpoints[1], &encoded->pBits[1], endpoints[1]);
+    selectIndices(block, 4, endpoints[0], endpoints[1], BC7_MIDPOINTS4, 15, encoded->indices);
+
+    // Palette exactly as the decoder interpolates it
+    float blockPalette[16][4];
+    for (uint32_t k = 0; k < 16; ++k)
+    {
+        for (uint32_t c = 0; c < 4; ++c)
+        {
+            uint32_t a = static_cast<uint32_t>(endpoints[0][c]), b = static_cast<uint32_t>(endpoints[1][c]);
+            blockPalette[k][c] = static_cast<float>(((64 - BC7_WEIGHTS4[k]) * a + BC7_WEIGHTS4[k] * b + 32) >> 6);
+        }
+    }
+    return paletteError(block, 4, blockPalette, encoded->indices);
+}
+//------------------------------------------------------------------------------
+static void encodeBc7Block(const BlockTexels &block, CompressionQuality quality, uint8_t * output)
+{
+    float weights[16];
+    for (uint32_t k = 0; k < 16; ++k)
+    {
+        weights[k] = BC7_WEIGHTS4[k] / 64.0f;
+    }
+
+    float e0[4], e1[4];
+    findEndpoints(block, 4, quality, e0, e1);
+
+    Bc7Mode6Block encoded;
+    float error = encodeBc7Endpoints(block, e0, e1, &encoded);
+
+    // Refine the endpoints on the selected indices, and keep the result only if it's better
+    uint32_t iterations = (quality == CompressionQuality::Quality) ? REFINE_ITERATIONS : 0;
+    for (uint32_t iteration = 0; iteration < iterations && error > 0.0f; ++iteration)
+    {
+        if (!refineEndpoints(block, 4, encoded.indices, weights, e0, e1))
+        {
+            break;
+        }
+
+        Bc7Mode6Block refined;
+        float newError = encodeBc7Endpoints(block, e0, e1, &refined);
+        if (newError >= error)
+        {
+            break;
+        }
+        error = newError;
+        encoded = refined;
+    }
+
+    // The anchor index (texel 0) is stored without its MSB: it must be < 8, otherwise swap the endpoints
+    if (encoded.indices[0] & 0x8)
+    {
+        for (uint32_t c = 0; c < 4; ++c)
+        {
+            std::swap(encoded.endpoints[0][c], encoded.endpoints[1][c]);
+        }
+        std::swap(encoded.pBits[0], encoded.pBits[1]);
+        for (uint32_t i = 0; i < 16; ++i)
+        {
+            encoded.indices[i] = 15 - encoded.indices[i];
+        }
+    }
+
+    // Layout (LSB first): mode (7 bit: 0b1000000) | R0 R1 G0 G1 B0 B1 A0 A1 (7 bit each) | P0 P1 | indices (3 + 15 x 4 bit)
+    uint64_t bits[2] = {};
+    uint32_t position = 0;
+    auto write = [&bits, &position](uint64_t value, uint32_t count) {
+        for (uint32_t i = 0; i < count; ++i, ++position)
+        {
+            bits[position / 64] |= ((value >> i) & 1ULL) << (position % 64);
+        }
+    };
+    write(1ULL << 6, 7);
+    for (uint32_t c = 0; c < 4; ++c)
+    {
+        write(encoded.endpoints[0][c], 7);
+        write(encoded.endpoints[1][c], 7);
+    }
+    write(encoded.pBits[0], 1);
+    write(encoded.pBits[1], 1);
+    write(encoded.indices[0], 3);
+    for (uint32_t i = 1; i < 16; ++i)
+    {
+        write(encoded.indices[i], 4);
+    }
+    memcpy(output, bits, BC7_BLOCK_SIZE);
+}
+
+//------------------------------------------------------------------------------
+// BlockCompressor //
+//------------------------------------------------------------------------------
+BlockCompressor::BlockCompressor(uint32_t workerCount)
+{
+    m_workerCount = (workerCount > 0) ? workerCount : std::max(std::thread::hardware_concurrency(), 1U);
+}
+//------------------------------------------------------------------------------
+BlockCompressor::~BlockCompressor()
+{
+    m_workerPool.destroy();
+}
+//------------------------------------------------------------------------------
+void BlockCompressor::setWorkerPool(WorkerPool * workerPool)
+{
+    m_sharedWorkerPool = workerPool;
+}
+//------------------------------------------------------------------------------
+std::vector<uint8_t> BlockCompressor::compress(const uint8_t * pixels, uint32_t width, uint32_t height,
+                                               TextureCompression compression, CompressionQuality quality)
+{
+    if (compression == TextureCompression::None || width == 0 || height == 0)
+    {
+        throw std::runtime_error("Invalid block compression request!");
+    }
+
+    std::vector<uint8_t> output(static_cast<size_t>(getCompressedSize(width, height, compression)));
+
+    // Rows of blocks are handed out to the pool workers and to this thread (small levels stay on this one)
+    uint32_t blockRows = (height + 3) / 4;
+    if ((m_sharedWorkerPool == nullptr && m_workerCount <= 1) || blockRows <= 1)
+    {
+        compressRows(pixels, width, height, 0, 1, compression, quality, output.data());
+        return output;
+    }
+
+    WorkerPool * workerPool = m_sharedWorkerPool;
+    if (workerPool == nullptr)
+    {
+        std::call_once(m_workerPoolCreated, [this]() { m_workerPool.create(m_workerCount - 1); });
+        workerPool = &m_workerPool;
+    }
+    workerPool->parallelFor(blockRows, [&](uint32_t blockRow) {
+        compressRows(pixels, width, height, blockRow, blockRows, compression, quality, output.data());
+    });
+
+    return output;
+}
+//------------------------------------------------------------------------------
+VkFormat BlockCompressor::getFormat(TextureCompression compression)
+{
+    switch (compression)
+    {
+    case TextureCompression::BC1:   return VK_FORMAT_BC1_RGB_UNORM_BLOCK;
+    case TextureCompression::BC7:   return VK_FORMAT_BC7_UNORM_BLOCK;
+    default:                        return VK_FORMAT_R8G8B8A8_UNORM;
+    }
+}
+//------------------------------------------------------------------------------
+VkDeviceSize BlockCompressor::getCompressedSize(uint32_t width, uint32_t height, TextureCompression compression)
+{
+    VkDeviceSize blocks = static_cast<VkDeviceSize>((width + 3) / 4) * ((height + 3) / 4);
+    switch (compression)
+    {
+    case TextureCompression::BC1:   return blocks * BC1_BLOCK_SIZE;
+    case TextureCompression::BC7:   return blocks * BC7_BLOCK_SIZE;
+    default:                        return static_cast<VkDeviceSize>(width) * height * 4;
+    }
+}
+//------------------------------------------------------------------------------
+void BlockCompressor::compressRows(const uint8_t * pixels, uint32_t width, uint32_t height, uint32_t firstRow, uint32_t rowStep,
+                                   TextureCompression compression, CompressionQuality quality, uint8_t * output)
+{
+    const uint32_t blocksX = (width + 3) / 4;
+    const uint32_t blocksY = (height + 3) / 4;
+    const uint32_t blockSize = (compression == TextureCompression::BC1) ? BC1_BLOCK_SIZE : BC7_BLOCK_SIZE;
+
+    BlockTexels block;
+    for (uint32_t blockY = firstRow; blockY < blocksY; blockY += rowStep)
+    {
+        for (uint32_t blockX = 0; blockX < blocksX; ++blockX)
+        {
+            loadBlock(pixels, width, height, blockX, blockY, &block);
+
+            uint8_t * blockOutput = output + (static_cast<size_t>(blockY) * blocksX + blockX) * blockSize;
+            if (compression == TextureCompression::BC1)
+            {
+                encodeBc1Block(block, quality, blockOutput);
+            }
+            else
+            {
+                encodeBc7Block(block, quality, blockOutput);
+            }
+        }
+    }
+}
@@ -0,0 +1,63 @@
+#ifndef BLOCK_COMPRESSOR_H
+#define BLOCK_COMPRESSOR_H
+
+// C++ STL
+#include <mutex>
+#include <vector>
+
+// Project includes
+#include "Utilities.h"          // Utilities header includes GLFW [Graphics Library FrameWork] + Vulkan API
+#include "WorkerPool.h"
+
+// SSE2 kernels (always available on x64, optional on x86)
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #define BLOCK_COMPRESSOR_SSE2 1
+#else
+    #define BLOCK_COMPRESSOR_SSE2 0
+#endif
+
+// Texture compression applied at load time to JPG/PNG textures
+enum class TextureCompression : uint32_t
+{
+    None    = 0,    // RGBA8 (uncompressed)
+    BC1     = 1,    // 4 bpp, RGB (alpha dropped)
+    BC7     = 2,    // 8 bpp, RGBA (mode 6)
+};
+
+// Fast: bounding box endpoints | Quality: principal axis endpoints, refined with least squares
+enum class CompressionQuality : uint32_t
+{
+    Fast    = 0,
+    Quality = 1,
+};
+
+// Runtime BC1/BC7 encoder for RGBA8 images. Blocks are 4x4 texels (edges are clamped for sizes that aren't a multiple of 4),
+// rows of blocks are spread on a pool of persistent worker threads (a shared one, or its own started by the first
+// compression that needs it), and index selection uses SSE2 kernels (scalar fallback elsewhere).
+// N.B.: bump TEXTURE_COOKER_VERSION (AssetCooker) when the encoded blocks change.
+class BlockCompressor
+{
+public:
+    BlockCompressor(uint32_t workerCount = 0);
+    ~BlockCompressor();
+
+    void                    setWorkerPool(WorkerPool * workerPool);     // Shared with other work (instead of its own)
+
+    std::vector<uint8_t>    compress(const uint8_t * pixels, uint32_t width, uint32_t height,
+                                     TextureCompression compression, CompressionQuality quality);
+
+    static VkFormat         getFormat(TextureCompression compression);
+    static VkDeviceSize     getCompressedSize(uint32_t width, uint32_t height, TextureCompression compression);
+
+private:
+    uint32_t    m_workerCount = 1;                      // With the calling thread
+    WorkerPool  m_workerPool;                           // Own workers (without a shared pool)
+    std::once_flag  m_workerPoolCreated;
+    WorkerPool *    m_sharedWorkerPool = nullptr;
+
+    // Methods
+    void        compressRows(const uint8_t * pixels, uint32_t width, uint32_t height, uint32_t firstRow, uint32_t rowStep,
+                             TextureCompression compression, CompressionQuality quality, uint8_t * output);
+};
+
+#endif //BLOCK_COMPRESSOR_H
@@ -0,0 +1,223 @@
+#include "FileWatcher.h"
+
+// C++ STL
+#include <chrono>
+
+// Platform
+#if FILE_WATCHER_INOTIFY
+    #include <poll.h>
+    #include <sys/inotify.h>
+    #include <unistd.h>
+#endif
+
+#if FILE_WATCHER_INOTIFY
+// Events of interest: a file written and closed, or moved in; new sub-directories are watched too
+static const uint32_t INOTIFY_MASK = IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE;
+#endif
+
+//------------------------------------------------------------------------------
+FileWatcher::FileWatcher()
+{
+}
+//------------------------------------------------------------------------------
+FileWatcher::~FileWatcher()
+{
+}
+//------------------------------------------------------------------------------
+void FileWatcher::create(const std::vector<std::string> &directories)
+{
+    m_directories = directories;
+    m_stop = false;
+
+#if FILE_WATCHER_INOTIFY
+    m_inotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (m_inotifyFd >= 0)
+    {
+        for (const std::string &directory : m_directories)
+        {
+            addWatches(directory);
+        }
+        m_thread = std::thread(&FileWatcher::inotifyLoop, this);
+        return;
+    }
+#endif
+
+    scan(false);    // Current state: only later changes are reported
+    m_thread = std::thread(&FileWatcher::pollLoop, this);
+}
+//------------------------------------------------------------------------------
+void FileWatcher::destroy()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    if (m_thread.joinable())
+    {
+        m_thread.join();
+    }
+
+#if FILE_WATCHER_INOTIFY
+    if (m_inotifyFd >= 0)
+    {
+        close(m_inotifyFd);     // Removes all the watches
+        m_inotifyFd = -1;
+    }
+    m_watches.clear();
+#endif
+    m_files.clear();
+    m_changed.clear();
+}
+//------------------------------------------------------------------------------
+std::vector<std::string> FileWatcher::takeChanged()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    std::vector<std::string> changed(m_changed.begin(), m_changed.end());
+    m_changed.clear();
+    return changed;
+}
+//------------------------------------------------------------------------------
+bool FileWatcher::isInotifyEnabled() const
+{
+#if FILE_WATCHER_INOTIFY
+    return m_inotifyFd >= 0;
+#else
+    return false;
+#endif
+}
+#if FILE_WATCHER_INOTIFY
+//------------------------------------------------------------------------------
+void FileWatcher::addWatches(const std::string &directory)
+{
+    int watch = inotify_add_watch(m_inotifyFd, directory.c_str(), INOTIFY_MASK);
+    if (watch < 0)
+    {
+        return;     // Missing (or not a directory)
+    }
+    m_watches[watch] = directory;
+
+    std::error_code error;
+    for (const auto &entry : std::filesystem::directory_iterator(directory, error))
+    {
+        if (entry.is_directory(error))
+        {
+            addWatches(entry.path().generic_string());
+        }
+    }
+}
+//------------------------------------------------------------------------------
+void FileWatcher::inotifyLoop()
+{
+    // Aligned as the events it receives
+    alignas(inotify_event) char buffer[16 * 1024];
+
+    while (!isStopping())
+    {
+        pollfd pollFd = { m_inotifyFd, POLLIN, 0 };
+        if (poll(&pollFd, 1, static_cast<int>(POLL_INTERVAL)) <= 0)
+        {
+            continue;   // Timeout (check the stop flag) or interrupted
+        }
+
+        ssize_t length;
+        while ((length = read(m_inotifyFd, buffer, sizeof(buffer))) > 0)
+        {
+            for (char * event = buffer; event < buffer + length; )
+            {
+                const inotify_event * notification = reinterpret_cast<const inotify_event *>(event);
+                event += sizeof(inotify_event) + notification->len;
+
+                auto watch = m_watches.find(notification->wd);
+                if (notification->mask & IN_IGNORED)
+                {
+                    if (watch != m_watches.end())
+                    {
+                        m_watches.erase(watch);     // Directory removed
+                    }
+                    continue;
+                }
+                if (watch == m_watches.end() || notification->len == 0)
+                {
+                    continue;
+                }
+
+                std::string filePath = watch->second + "/" + notification->name;
+                if (notification->mask & IN_ISDIR)
+                {
+                    if (notification->mask & (IN_CREATE | IN_MOVED_TO))
+                    {
+                        addWatches(filePath);
+                    }
+                }
+                else if (notification->mask & (IN_CLOSE_WRITE | IN_MOVED_TO))
+                {
+                    pushChanged(filePath);
+                }
+            }
+        }
+    }
+}
+#endif
+//------------------------------------------------------------------------------
+void FileWatcher::pollLoop()
+{
+    while (!isStopping())
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(POLL_INTERVAL));
+        scan(true);
+    }
+}
+//------------------------------------------------------------------------------
+void FileWatcher::scan(bool report)
+{
+    std::set<std::string> found;
+    std::error_code error;
+    for (const std::string &directory : m_directories)
+    {
+        for (auto it = std::filesystem::recursive_directory_iterator(directory, error);
+             it != std::filesystem::recursive_directory_iterator(); it.increment(error))
+        {
+            if (error || !it->is_regular_file(error))
+            {
+                continue;
+            }
+
+            std::string filePath = it->path().generic_string();
+            FileState current;
+            current.time = it->last_write_time(error);
+            current.size = it->file_size(error);
+            found.insert(filePath);
+
+            auto file = m_files.find(filePath);
+            if (file == m_files.end() || file->second.time != current.time || file->second.size != current.size)
+            {
+                // New or modified: reported on the next scan if it didn't change in between (the writer is done)
+                current.reported = !report;
+                m_files[filePath] = current;
+            }
+            else if (!file->second.reported)
+            {
+                file->second.reported = true;
+                pushChanged(filePath);
+            }
+        }
+    }
+
+    // Deleted files
+    for (auto file = m_files.begin(); file != m_files.end(); )
+    {
+        file = found.count(file->first) ? std::next(file) : m_files.erase(file);
+    }
+}
+//------------------------------------------------------------------------------
+void FileWatcher::pushChanged(const std::string &filePath)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_changed.insert(filePath);
+}
+//------------------------------------------------------------------------------
+bool FileWatcher::isStopping()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_stop;
+}
@@ -0,0 +1,71 @@
+#ifndef FILE_WATCHER_H
+#define FILE_WATCHER_H
+
+// C++ STL
+#include <cstdint>
+#include <filesystem>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+// Linux inotify (otherwise the directories are polled)
+#if defined(__linux__) && __has_include(<sys/inotify.h>)
+    #define FILE_WATCHER_INOTIFY    1
+#else
+    #define FILE_WATCHER_INOTIFY    0
+#endif
+
+// Watches directory trees for modified files on a background thread (for asset hot-reload).
+// inotify: files are reported when their writer closes them, or when they're renamed in place (editors often save to
+// a temporary file first). Polling fallback: modification time and size, reported once they stopped changing.
+// Changes are collected (deduplicated) until the render thread takes them, at a frame boundary.
+class FileWatcher
+{
+public:
+    static constexpr uint32_t   POLL_INTERVAL   = 250;          // Polling fallback period, and stop latency [ms]
+
+    FileWatcher();
+    ~FileWatcher();
+
+    void        create(const std::vector<std::string> &directories);   // Relative paths are reported relative too
+    void        destroy();
+
+    std::vector<std::string>    takeChanged();                  // Generic paths ('Shaders/shader.frag'), sorted
+    bool        isInotifyEnabled() const;
+
+private:
+    struct FileState
+    {
+        std::filesystem::file_time_type     time;
+        uintmax_t                           size = 0;
+        bool                                reported = true;    // False while the file is still being written
+    };
+
+    std::vector<std::string>    m_directories;
+    std::thread                 m_thread;
+    std::mutex                  m_mutex;
+    std::set<std::string>       m_changed;                      // Guarded by m_mutex
+    bool                        m_stop = false;                 // Guarded by m_mutex
+
+    // Polling fallback
+    std::unordered_map<std::string, FileState>  m_files;        // Watcher thread only
+
+#if FILE_WATCHER_INOTIFY
+    int                         m_inotifyFd = -1;
+    std::unordered_map<int, std::string>    m_watches;          // Watch descriptor -> directory (watcher thread only)
+
+    void        addWatches(const std::string &directory);       // The directory and its sub-directories
+    void        inotifyLoop();
+#endif
+
+    // Methods
+    void        pollLoop();
+    void        scan(bool report);
+    void        pushChanged(const std::string &filePath);
+    bool        isStopping();
+};
+
+#endif //FILE_WATCHER_H
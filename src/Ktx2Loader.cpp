@@ -0,0 +1,391 @@
+#include "Ktx2Loader.h"
+
+// C++ STL
+#include <array>
+#include <cstring>
+#include <mutex>
+#include <stdexcept>
+
+// Optional libraries
+#if KTX2_BASISU_SUPPORT
+    #include <basisu_transcoder.h>
+#endif
+#if KTX2_ZSTD_SUPPORT
+    #include <zstd.h>
+#endif
+
+using std::cout;
+using std::endl;
+
+// KTX2 file layout: identifier + header (9 x uint32) + index (4 x uint32, 2 x uint64), then the level index
+static const std::array<uint8_t, 12> KTX2_IDENTIFIER = { 0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n' };
+static const size_t KTX2_HEADER_SIZE        = 80;
+static const size_t KTX2_LEVEL_INDEX_SIZE   = 3 * sizeof(uint64_t);    // byteOffset, byteLength, uncompressedByteLength
+
+// Data Format Descriptor color models of the Basis Universal payloads
+static const uint8_t KHR_DF_MODEL_ETC1S     = 163;
+static const uint8_t KHR_DF_MODEL_UASTC     = 166;
+
+// Alignment of each level in Ktx2Texture::data (multiple of every block size)
+static const VkDeviceSize KTX2_LEVEL_ALIGNMENT = 16;
+// Largest level 0 accepted (level sizes can't overflow, and the mip count stays within 32 bits of shifts)
+static const uint32_t KTX2_MAX_SIZE         = 65536;
+
+//------------------------------------------------------------------------------
+// Read a little endian value at the given offset (bounds checked)
+template <typename T>
+static T readValue(std::span<const uint8_t> data, size_t offset)
+{
+    if (offset + sizeof(T) > data.size())
+    {
+        throw std::runtime_error("Malformed KTX2 file: unexpected end of file!");
+    }
+    T value;
+    memcpy(&value, data.data() + offset, sizeof(T));
+    return value;
+}
+
+//------------------------------------------------------------------------------
+// Texel block of the native formats: size [texels] and bytes per block (false: not a format the loader knows)
+static bool getBlockInfo(VkFormat format, uint32_t * blockWidth, uint32_t * blockHeight, uint32_t * blockBytes)
+{
+    *blockWidth = 1;
+    *blockHeight = 1;
+    switch (format)
+    {
+    case VK_FORMAT_R8_UNORM:
+    case VK_FORMAT_R8_SRGB:                     *blockBytes = 1;    return true;
+    case VK_FORMAT_R8G8_UNORM:
+    case VK_FORMAT_R8G8_SRGB:
+    case VK_FORMAT_R16_SFLOAT:                  *blockBytes = 2;    return true;
+    case VK_FORMAT_R8G8B8A8_UNORM:
+    case VK_FORMAT_R8G8B8A8_SRGB:
+    case VK_FORMAT_B8G8R8A8_UNORM:
+    case VK_FORMAT_B8G8R8A8_SRGB:
+    case VK_FORMAT_R16G16_SFLOAT:
+    case VK_FORMAT_R32_SFLOAT:                  *blockBytes = 4;    return true;
+    case VK_FORMAT_R16G16B16A16_SFLOAT:
+    case VK_FORMAT_R32G32_SFLOAT:               *blockBytes = 8;    return true;
+    case VK_FORMAT_R32G32B32A32_SFLOAT:         *blockBytes = 16;   return true;
+    default:                                                        break;
+    }
+
+    // 4x4 blocks: BC1, BC4, ETC2 RGB(A1) and EAC R11 take 8 bytes, the others 16
+    *blockWidth = 4;
+    *blockHeight = 4;
+    switch (format)
+    {
+    case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+    case VK_FORMAT_BC1_RGB_SRGB_BLOCK:
+    case VK_FORMAT_BC1_RGBA_UNORM_BLOCK:
+    case VK_FORMAT_BC1_RGBA_SRGB_BLOCK:
+    case VK_FORMAT_BC4_UNORM_BLOCK:
+    case VK_FORMAT_BC4_SNORM_BLOCK:
+    case VK_FORMAT_ETC2_R8G8B8_UNORM_BLOCK:
+    case VK_FORMAT_ETC2_R8G8B8_SRGB_BLOCK:
+    case VK_FORMAT_ETC2_R8G8B8A1_UNORM_BLOCK:
+    case VK_FORMAT_ETC2_R8G8B8A1_SRGB_BLOCK:
+    case VK_FORMAT_EAC_R11_UNORM_BLOCK:
+    case VK_FORMAT_EAC_R11_SNORM_BLOCK:         *blockBytes = 8;    return true;
+    case VK_FORMAT_BC2_UNORM_BLOCK:
+    case VK_FORMAT_BC2_SRGB_BLOCK:
+    case VK_FORMAT_BC3_UNORM_BLOCK:
+    case VK_FORMAT_BC3_SRGB_BLOCK:
+    case VK_FORMAT_BC5_UNORM_BLOCK:
+    case VK_FORMAT_BC5_SNORM_BLOCK:
+    case VK_FORMAT_BC6H_UFLOAT_BLOCK:
+    case VK_FORMAT_BC6H_SFLOAT_BLOCK:
+    case VK_FORMAT_BC7_UNORM_BLOCK:
+    case VK_FORMAT_BC7_SRGB_BLOCK:
+    case VK_FORMAT_ETC2_R8G8B8A8_UNORM_BLOCK:
+    case VK_FORMAT_ETC2_R8G8B8A8_SRGB_BLOCK:
+    case VK_FORMAT_EAC_R11G11_UNORM_BLOCK:
+    case VK_FORMAT_EAC_R11G11_SNORM_BLOCK:
+    case VK_FORMAT_ASTC_4x4_UNORM_BLOCK:
+    case VK_FORMAT_ASTC_4x4_SRGB_BLOCK:         *blockBytes = 16;   return true;
+    default:                                                        return false;
+    }
+}
+
+//------------------------------------------------------------------------------
+Ktx2Loader::Ktx2Loader()
+{
+}
+//------------------------------------------------------------------------------
+Ktx2Loader::~Ktx2Loader()
+{
+}
+//------------------------------------------------------------------------------
+void Ktx2Loader::create(VkPhysicalDevice physicalDevice)
+{
+    m_physicalDevice = physicalDevice;
+
+#if KTX2_BASISU_SUPPORT
+    // Global transcoder tables (once per process)
+    static std::once_flag basisInitFlag;
+    std::call_once(basisInitFlag, []() { basist::basisu_transcoder_init(); });
+#endif
+}
+//------------------------------------------------------------------------------
+void Ktx2Loader::load(std::span<const uint8_t> fileData, const std::string &filePath, Ktx2Texture * texture)
+{
+    // Header
+    if (fileData.size() < KTX2_HEADER_SIZE || memcmp(fileData.data(), KTX2_IDENTIFIER.data(), KTX2_IDENTIFIER.size()) != 0)
+    {
+        throw std::runtime_error("'" + filePath + "' is not a KTX2 file!");
+    }
+    uint32_t vkFormat           = readValue<uint32_t>(fileData, 12);
+    uint32_t pixelWidth         = readValue<uint32_t>(fileData, 20);
+    uint32_t pixelHeight        = readValue<uint32_t>(fileData, 24);
+    uint32_t pixelDepth         = readValue<uint32_t>(fileData, 28);
+    uint32_t layerCount         = readValue<uint32_t>(fileData, 32);
+    uint32_t faceCount          = readValue<uint32_t>(fileData, 36);
+    uint32_t levelCount         = std::max(readValue<uint32_t>(fileData, 40), 1U);    // 0: mip levels to be generated (not supported here)
+    uint32_t supercompression   = readValue<uint32_t>(fileData, 44);
+    uint32_t dfdOffset          = readValue<uint32_t>(fileData, 48);
+    uint32_t dfdLength          = readValue<uint32_t>(fileData, 52);
+
+    if (pixelWidth == 0 || pixelHeight == 0 || pixelDepth > 1 || layerCount > 1 || faceCount != 1)
+    {
+        throw std::runtime_error("KTX2 file '" + filePath + "': only 2D textures are supported (no 1D/3D, arrays or cube maps)!");
+    }
+    if (pixelWidth > KTX2_MAX_SIZE || pixelHeight > KTX2_MAX_SIZE || levelCount > 32)
+    {
+        throw std::runtime_error("KTX2 file '" + filePath + "': texture too large (or too many levels)!");
+    }
+    if (levelCount > (fileData.size() - KTX2_HEADER_SIZE) / KTX2_LEVEL_INDEX_SIZE)
+    {
+        throw std::runtime_error("Malformed KTX2 file '" + filePath + "': truncated level index!");
+    }
+
+    texture->width = pixelWidth;
+    texture->height = pixelHeight;
+    texture->levels.clear();
+    texture->data.clear();
+
+    // Basis Universal payloads have no Vulkan format: they're transcoded to one the device supports
+    if (vkFormat == VK_FORMAT_UNDEFINED)
+    {
+        transcodeBasis(fileData, hasAlphaChannel(fileData, dfdOffset, dfdLength), texture);
+    }
+    else
+    {
+        loadNative(fileData, vkFormat, supercompression, levelCount, texture);
+    }
+}
+//------------------------------------------------------------------------------
+bool Ktx2Loader::isFormatSupported(VkFormat format)
+{
+    VkFormatProperties formatProperties;
+    vkGetPhysicalDeviceFormatProperties(m_physicalDevice, format, &formatProperties);
+
+    const VkFormatFeatureFlags requiredFeatures = VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT | VK_FORMAT_FEATURE_TRANSFER_DST_BIT;
+    return (formatProperties.optimalTilingFeatures & requiredFeatures) == requiredFeatures;
+}
+//------------------------------------------------------------------------------
+VkFormat Ktx2Loader::chooseTranscodeFormat(bool hasAlpha)
+{
+    // Best quality per bit first: desktop GPUs have BC, mobile ones ETC2 and/or ASTC
+    std::vector<VkFormat> candidates;
+    if (hasAlpha)
+    {
+        candidates = { VK_FORMAT_BC7_UNORM_BLOCK, VK_FORMAT_ASTC_4x4_UNORM_BLOCK, VK_FORMAT_ETC2_R8G8B8A8_UNORM_BLOCK, VK_FORMAT_BC3_UNORM_BLOCK };
+    }
+    else
+    {
+        candidates = { VK_FORMAT_BC7_UNORM_BLOCK, VK_FORMAT_ASTC_4x4_UNORM_BLOCK, VK_FORMAT_ETC2_R8G8B8_UNORM_BLOCK, VK_FORMAT_BC1_RGB_UNORM_BLOCK };
+    }
+
+    for (VkFormat format : candidates)
+    {
+        if (isFormatSupported(format))
+        {
+            return format;
+        }
+    }
+
+    // Uncompressed, always supported
+    return VK_FORMAT_R8G8B8A8_UNORM;
+}
+//------------------------------------------------------------------------------
+void Ktx2Loader::loadNative(std::span<const uint8_t> fileData, uint32_t vkFormat, uint32_t supercompression,
+                            uint32_t levelCount, Ktx2Texture * texture)
+{
+    texture->format = static_cast<VkFormat>(vkFormat);
+    if (!isFormatSupported(texture->format))
+    {
+        throw std::runtime_error("KTX2 format " + std::to_string(vkFormat) + " can't be sampled by this device!");
+    }
+
+    if (supercompression == SUPERCOMPRESSION_BASIS_LZ)
+    {
+        throw std::runtime_error("Malformed KTX2 file: BasisLZ supercompression with a native format!");
+    }
+#if !KTX2_ZSTD_SUPPORT
+    if (supercompression == SUPERCOMPRESSION_ZSTD)
+    {
+        throw std::runtime_error("KTX2 file is Zstandard supercompressed, but Zstandard support isn't built in!");
+    }
+#endif
+    if (supercompression == SUPERCOMPRESSION_ZLIB || supercompression > SUPERCOMPRESSION_ZLIB)
+    {
+        throw std::runtime_error("KTX2 supercompression scheme " + std::to_string(supercompression) + " isn't supported!");
+    }
+
+    uint32_t blockWidth, blockHeight, blockBytes;
+    if (!getBlockInfo(texture->format, &blockWidth, &blockHeight, &blockBytes))
+    {
+        throw std::runtime_error("KTX2 format " + std::to_string(vkFormat) + " isn't supported!");
+    }
+
+    // Levels sizes (from their extent: the copy to the image reads all their blocks) and their offsets in the output
+    VkDeviceSize totalSize = 0;
+    texture->levels.resize(levelCount);
+    for (uint32_t level = 0; level < levelCount; ++level)
+    {
+        size_t indexOffset = KTX2_HEADER_SIZE + level * KTX2_LEVEL_INDEX_SIZE;
+        uint64_t byteOffset = readValue<uint64_t>(fileData, indexOffset);
+        uint64_t byteLength = readValue<uint64_t>(fileData, indexOffset + sizeof(uint64_t));
+        uint64_t uncompressedLength = readValue<uint64_t>(fileData, indexOffset + 2 * sizeof(uint64_t));
+        if (byteOffset > fileData.size() || byteLength > fileData.size() - byteOffset)
+        {
+            throw std::runtime_error("Malformed KTX2 file: level " + std::to_string(level) + " out of the file!");
+        }
+
+        Ktx2Level &textureLevel = texture->levels[level];
+        textureLevel.offset = totalSize;
+        textureLevel.width = std::max(texture->width >> level, 1U);
+        textureLevel.height = std::max(texture->height >> level, 1U);
+        textureLevel.size = static_cast<VkDeviceSize>((textureLevel.width + blockWidth - 1) / blockWidth)
+            * ((textureLevel.height + blockHeight - 1) / blockHeight) * blockBytes;
+        if (((supercompression == SUPERCOMPRESSION_NONE) ? byteLength : uncompressedLength) < textureLevel.size)
+        {
+            throw std::runtime_error("Malformed KTX2 file: level " + std::to_string(level) + " is truncated!");
+        }
+        totalSize += (textureLevel.size + KTX2_LEVEL_ALIGNMENT - 1) & ~(KTX2_LEVEL_ALIGNMENT - 1);
+    }
+    texture->data.resize(static_cast<size_t>(totalSize));
+
+    // Copy (or inflate) each level
+    for (uint32_t level = 0; level < levelCount; ++level)
+    {
+        size_t indexOffset = KTX2_HEADER_SIZE + level * KTX2_LEVEL_INDEX_SIZE;
+        uint64_t byteOffset = readValue<uint64_t>(fileData, indexOffset);
+        uint64_t byteLength = readValue<uint64_t>(fileData, indexOffset + sizeof(uint64_t));
+
+        const Ktx2Level &textureLevel = texture->levels[level];
+        uint8_t * dst = texture->data.data() + textureLevel.offset;
+        if (supercompression == SUPERCOMPRESSION_NONE)
+        {
+            memcpy(dst, fileData.data() + byteOffset, static_cast<size_t>(textureLevel.size));
+        }
+#if KTX2_ZSTD_SUPPORT
+        else
+        {
+            size_t result = ZSTD_decompress(dst, static_cast<size_t>(textureLevel.size), fileData.data() + byteOffset, static_cast<size_t>(byteLength));
+            if (ZSTD_isError(result) || result != textureLevel.size)
+            {
+                throw std::runtime_error("Failed to inflate KTX2 level " + std::to_string(level) + " (Zstandard)!");
+            }
+        }
+#endif
+    }
+}
+//------------------------------------------------------------------------------
+void Ktx2Loader::transcodeBasis(std::span<const uint8_t> fileData, bool hasAlpha, Ktx2Texture * texture)
+{
+#if KTX2_BASISU_SUPPORT
+    basist::ktx2_transcoder transcoder;
+    if (!transcoder.init(fileData.data(), static_cast<uint32_t>(fileData.size())) || !transcoder.start_transcoding())
+    {
+        throw std::runtime_error("Failed to start the Basis Universal transcoding!");
+    }
+
+    // Target format (device dependent)
+    texture->format = chooseTranscodeFormat(hasAlpha);
+    basist::transcoder_texture_format targetFormat = basist::transcoder_texture_format::cTFRGBA32;
+    switch (texture->format)
+    {
+    case VK_FORMAT_BC7_UNORM_BLOCK:             targetFormat = basist::transcoder_texture_format::cTFBC7_RGBA;          break;
+    case VK_FORMAT_ASTC_4x4_UNORM_BLOCK:        targetFormat = basist::transcoder_texture_format::cTFASTC_4x4_RGBA;     break;
+    case VK_FORMAT_ETC2_R8G8B8A8_UNORM_BLOCK:   targetFormat = basist::transcoder_texture_format::cTFETC2_RGBA;         break;
+    case VK_FORMAT_ETC2_R8G8B8_UNORM_BLOCK:     targetFormat = basist::transcoder_texture_format::cTFETC1_RGB;          break;  // ETC1 is a subset of ETC2
+    case VK_FORMAT_BC3_UNORM_BLOCK:             targetFormat = basist::transcoder_texture_format::cTFBC3_RGBA;          break;
+    case VK_FORMAT_BC1_RGB_UNORM_BLOCK:         targetFormat = basist::transcoder_texture_format::cTFBC1_RGB;           break;
+    default:                                    targetFormat = basist::transcoder_texture_format::cTFRGBA32;            break;
+    }
+    const bool uncompressed = basist::basis_transcoder_format_is_uncompressed(targetFormat);
+    const uint32_t bytesPerUnit = basist::basis_get_bytes_per_block_or_pixel(targetFormat);
+
+    // Levels sizes and their offsets in the output
+    uint32_t levelCount = std::max(transcoder.get_levels(), 1U);
+    std::vector<uint32_t> levelUnits(levelCount);   // Blocks (or pixels, if uncompressed)
+    VkDeviceSize totalSize = 0;
+    texture->levels.resize(levelCount);
+    for (uint32_t level = 0; level < levelCount; ++level)
+    {
+        basist::ktx2_image_level_info levelInfo;
+        if (!transcoder.get_image_level_info(levelInfo, level, 0, 0))
+        {
+            throw std::runtime_error("Failed to get the Basis Universal level " + std::to_string(level) + " info!");
+        }
+        levelUnits[level] = uncompressed ? levelInfo.m_orig_width * levelInfo.m_orig_height : levelInfo.m_total_blocks;
+
+        Ktx2Level &textureLevel = texture->levels[level];
+        textureLevel.offset = totalSize;
+        textureLevel.size = static_cast<VkDeviceSize>(levelUnits[level]) * bytesPerUnit;
+        textureLevel.width = levelInfo.m_orig_width;
+        textureLevel.height = levelInfo.m_orig_height;
+        totalSize += (textureLevel.size + KTX2_LEVEL_ALIGNMENT - 1) & ~(KTX2_LEVEL_ALIGNMENT - 1);
+    }
+    texture->data.resize(static_cast<size_t>(totalSize));
+
+    // Transcode each level
+    for (uint32_t level = 0; level < levelCount; ++level)
+    {
+        if (!transcoder.transcode_image_level(level, 0, 0, texture->data.data() + texture->levels[level].offset, levelUnits[level], targetFormat))
+        {
+            throw std::runtime_error("Failed to transcode the Basis Universal level " + std::to_string(level) + "!");
+        }
+    }
+#else
+    (void)fileData;
+    (void)hasAlpha;
+    (void)texture;
+    throw std::runtime_error("KTX2 file has a Basis Universal payload, but the Basis Universal transcoder isn't built in!");
+#endif
+}
+//------------------------------------------------------------------------------
+bool Ktx2Loader::hasAlphaChannel(std::span<const uint8_t> fileData, uint32_t dfdOffset, uint32_t dfdLength)
+{
+    // Data Format Descriptor: uint32 totalSize, then the basic descriptor block (6 x uint32 header + 4 x uint32 per sample)
+    const size_t blockOffset = static_cast<size_t>(dfdOffset) + sizeof(uint32_t);
+    const size_t samplesOffset = blockOffset + 6 * sizeof(uint32_t);
+    if (dfdLength < samplesOffset - dfdOffset || dfdOffset > fileData.size() || dfdLength > fileData.size() - dfdOffset)
+    {
+        return true;    // Unknown: keep the alpha channel to be safe
+    }
+
+    uint8_t colorModel = fileData[blockOffset + 2 * sizeof(uint32_t)];
+    uint16_t blockSize = readValue<uint16_t>(fileData, blockOffset + sizeof(uint32_t) + sizeof(uint16_t));
+    size_t sampleCount = (blockSize > 24) ? (blockSize - 24) / 16 : 0;
+
+    for (size_t sample = 0; sample < sampleCount; ++sample)
+    {
+        size_t sampleOffset = samplesOffset + sample * 16;
+        if (sampleOffset + 16 > static_cast<size_t>(dfdOffset) + dfdLength)
+        {
+            break;
+        }
+        uint8_t channelId = fileData[sampleOffset + 3] & 0x0F;
+
+        // ETC1S: AAA = 15 | UASTC: RGBA = 3, RRRG = 5
+        if (    (colorModel == KHR_DF_MODEL_ETC1S && channelId == 15)
+            ||  (colorModel == KHR_DF_MODEL_UASTC && (channelId == 3 || channelId == 5)))
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
@@ -0,0 +1,80 @@
+#ifndef KTX2_LOADER_H
+#define KTX2_LOADER_H
+
+// C++ STL
+#include <span>
+#include <string>
+#include <vector>
+
+// Project includes
+#include "Utilities.h"          // Utilities header includes GLFW [Graphics Library FrameWork] + Vulkan API
+
+// Optional libraries: build with UseBasisu=true (defines USE_BASISU, compiles the transcoder from
+// Libraries/BASISU) and UseZstd=true (defines USE_ZSTD, links libzstd_static.lib from Libraries/ZSTD)
+#ifdef USE_BASISU
+    #define KTX2_BASISU_SUPPORT 1   // Basis Universal transcoder (BasisLZ/ETC1S and UASTC payloads)
+#else
+    #define KTX2_BASISU_SUPPORT 0
+#endif
+#ifdef USE_ZSTD
+    #define KTX2_ZSTD_SUPPORT   1   // Zstandard supercompression
+#else
+    #define KTX2_ZSTD_SUPPORT   0
+#endif
+
+// A mip level inside Ktx2Texture::data
+struct Ktx2Level
+{
+    VkDeviceSize    offset  = 0;
+    VkDeviceSize    size    = 0;
+    uint32_t        width   = 0;
+    uint32_t        height  = 0;
+};
+
+// Texture ready to be uploaded: every level already in the (block compressed) format of the VkImage
+struct Ktx2Texture
+{
+    VkFormat                format      = VK_FORMAT_UNDEFINED;
+    uint32_t                width       = 0;
+    uint32_t                height      = 0;
+    std::vector<Ktx2Level>  levels;                 // Level 0 is the largest one
+    std::vector<uint8_t>    data;                   // All the levels, tightly packed (16 bytes aligned)
+};
+
+// KTX2 (https://registry.khronos.org/KTX/specs/2.0/ktxspec.v2.html) loader for 2D textures.
+// Native payloads (BC1/BC3/BC5/BC7, ETC2, ASTC, ...) are used as they are, if the device can sample their format.
+// Basis Universal payloads are transcoded to the best block compressed format the device supports
+// (BC7, ASTC 4x4, ETC2, BC3/BC1), and to RGBA8 as last resort.
+class Ktx2Loader
+{
+public:
+    Ktx2Loader();
+    ~Ktx2Loader();
+
+    void        create(VkPhysicalDevice physicalDevice);
+
+    // 'fileData': the whole file (e.g. mapped from the asset archive), 'filePath' for the error messages
+    void        load(std::span<const uint8_t> fileData, const std::string &filePath, Ktx2Texture * texture);   // Throws on malformed/unsupported files
+    bool        isFormatSupported(VkFormat format);
+
+private:
+    // Supercompression schemes
+    enum SupercompressionScheme : uint32_t
+    {
+        SUPERCOMPRESSION_NONE       = 0,
+        SUPERCOMPRESSION_BASIS_LZ   = 1,
+        SUPERCOMPRESSION_ZSTD       = 2,
+        SUPERCOMPRESSION_ZLIB       = 3
+    };
+
+    VkPhysicalDevice    m_physicalDevice = nullptr;
+
+    // Methods
+    VkFormat    chooseTranscodeFormat(bool hasAlpha);
+    void        loadNative(std::span<const uint8_t> fileData, uint32_t vkFormat, uint32_t supercompression,
+                           uint32_t levelCount, Ktx2Texture * texture);
+    void        transcodeBasis(std::span<const uint8_t> fileData, bool hasAlpha, Ktx2Texture * texture);
+    bool        hasAlphaChannel(std::span<const uint8_t> fileData, uint32_t dfdOffset, uint32_t dfdLength);
+};
+
+#endif //KTX2_LOADER_H
@@ -0,0 +1,133 @@
+#include "LayoutCache.h"
+
+// C++ STL
+#include <stdexcept>
+
+using Utilities::getHandleKey;
+
+//------------------------------------------------------------------------------
+LayoutCache::LayoutCache()
+{
+}
+//------------------------------------------------------------------------------
+LayoutCache::~LayoutCache()
+{
+}
+//------------------------------------------------------------------------------
+void LayoutCache::create(VkDevice device)
+{
+    m_device = device;
+}
+//------------------------------------------------------------------------------
+void LayoutCache::destroy()
+{
+    // Pipeline layouts first (they reference the set layouts)
+    for (auto &pipelineLayout : m_pipelineLayouts)
+    {
+        vkDestroyPipelineLayout(m_device, pipelineLayout.second, nullptr);
+    }
+    m_pipelineLayouts.clear();
+    {
+        std::lock_guard<std::mutex> lock(m_infoMutex);
+        m_pipelineLayoutInfos.clear();
+    }
+
+    for (auto &setLayout : m_setLayouts)
+    {
+        vkDestroyDescriptorSetLayout(m_device, setLayout.second, nullptr);
+    }
+    m_setLayouts.clear();
+}
+//------------------------------------------------------------------------------
+VkDescriptorSetLayout LayoutCache::getSetLayout(const std::vector<VkDescriptorSetLayoutBinding> &bindings)
+{
+    std::vector<uint32_t> key;
+    for (const VkDescriptorSetLayoutBinding &binding : bindings)
+    {
+        key.insert(key.end(), { binding.binding, static_cast<uint32_t>(binding.descriptorType), binding.descriptorCount, binding.stageFlags });
+    }
+
+    auto found = m_setLayouts.find(key);
+    if (found != m_setLayouts.end())
+    {
+        return found->second;
+    }
+
+    // Create a Descriptor Set Layout with given bindings
+    VkDescriptorSetLayoutCreateInfo layoutCreateInfo = {};
+    layoutCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    layoutCreateInfo.bindingCount = static_cast<uint32_t>(bindings.size());     // Number of binding infos
+    layoutCreateInfo.pBindings = bindings.data();                               // Array of binding infos
+
+    VkDescriptorSetLayout setLayout = 0;
+    VkResult result = vkCreateDescriptorSetLayout(m_device, &layoutCreateInfo, nullptr, &setLayout);
+    if (result != VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to create a Descriptor Set Layout!");
+    }
+    m_setLayouts[key] = setLayout;
+    return setLayout;
+}
+//------------------------------------------------------------------------------
+VkDescriptorSetLayout LayoutCache::getSetLayout(const ShaderReflection &reflection, uint32_t set)
+{
+    auto bindings = reflection.descriptorSets.find(set);
+    return getSetLayout(bindings != reflection.descriptorSets.end() ? bindings->second : std::vector<VkDescriptorSetLayoutBinding>());
+}
+//------------------------------------------------------------------------------
+VkPipelineLayout LayoutCache::getPipelineLayout(const ShaderReflection &reflection)
+{
+    // Every set up to the last one declared (the unused ones in between get an empty layout)
+    std::vector<VkDescriptorSetLayout> setLayouts;
+    uint32_t setCount = reflection.descriptorSets.empty() ? 0 : reflection.descriptorSets.rbegin()->first + 1;
+    for (uint32_t set = 0; set < setCount; ++set)
+    {
+        setLayouts.push_back(getSetLayout(reflection, set));
+    }
+
+    const VkPushConstantRange &pushConstantRange = reflection.pushConstantRange;
+    std::vector<uint64_t> key = { pushConstantRange.stageFlags, pushConstantRange.offset, pushConstantRange.size };
+    for (VkDescriptorSetLayout setLayout : setLayouts)
+    {
+        key.push_back(getHandleKey(setLayout));
+    }
+
+    auto found = m_pipelineLayouts.find(key);
+    if (found != m_pipelineLayouts.end())
+    {
+        return found->second;
+    }
+
+    VkPipelineLayoutCreateInfo pipelineLayoutCreateInfo = {};
+    pipelineLayoutCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    pipelineLayoutCreateInfo.setLayoutCount = static_cast<uint32_t>(setLayouts.size());
+    pipelineLayoutCreateInfo.pSetLayouts = setLayouts.data();
+    pipelineLayoutCreateInfo.pushConstantRangeCount = pushConstantRange.size != 0 ? 1 : 0;
+    pipelineLayoutCreateInfo.pPushConstantRanges = &pushConstantRange;
+
+    // Create Pipeline Layout
+    VkPipelineLayout pipelineLayout = 0;
+    VkResult result = vkCreatePipelineLayout(m_device, &pipelineLayoutCreateInfo, nullptr, &pipelineLayout);
+    if (result != VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to create Pipeline Layout!");
+    }
+    m_pipelineLayouts[key] = pipelineLayout;
+    {
+        std::lock_guard<std::mutex> lock(m_infoMutex);
+        m_pipelineLayoutInfos[getHandleKey(pipelineLayout)] = { setLayouts, pushConstantRange };
+    }
+    return pipelineLayout;
+}
+//------------------------------------------------------------------------------
+PipelineLayoutInfo LayoutCache::getPipelineLayoutInfo(VkPipelineLayout pipelineLayout)
+{
+    std::lock_guard<std::mutex> lock(m_infoMutex);
+
+    auto info = m_pipelineLayoutInfos.find(getHandleKey(pipelineLayout));
+    if (info == m_pipelineLayoutInfos.end())
+    {
+        throw std::runtime_error("Unknown Pipeline Layout!");
+    }
+    return info->second;
+}
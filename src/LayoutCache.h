@@ -0,0 +1,50 @@
+#ifndef LAYOUT_CACHE_H
+#define LAYOUT_CACHE_H
+
+// C++ STL
+#include <map>
+#include <mutex>
+#include <vector>
+
+// Project includes
+#include "ShaderReflection.h"
+#include "Utilities.h"          // Utilities header includes GLFW [Graphics Library FrameWork] + Vulkan API
+
+// What a pipeline layout was created with (shader objects take these instead of a layout)
+struct PipelineLayoutInfo
+{
+    std::vector<VkDescriptorSetLayout>  setLayouts;
+    VkPushConstantRange                 pushConstantRange = {};     // Size 0: no push constants
+};
+
+// Descriptor set layouts and pipeline layouts, built from reflected shader interfaces and shared: identical
+// declarations get the same handles. Pipelines whose layouts share their first sets (and push constant range) are
+// "compatible" for them, so the descriptor sets bound there stay bound across pipeline switches.
+// Render thread only, except getPipelineLayoutInfo() (pipeline workers). The layouts live until destroy().
+class LayoutCache
+{
+public:
+    LayoutCache();
+    ~LayoutCache();
+
+    void                    create(VkDevice device);
+    void                    destroy();
+
+    VkDescriptorSetLayout   getSetLayout(const std::vector<VkDescriptorSetLayoutBinding> &bindings);
+    VkDescriptorSetLayout   getSetLayout(const ShaderReflection &reflection, uint32_t set);     // Empty if not declared
+    VkPipelineLayout        getPipelineLayout(const ShaderReflection &reflection);   // Sets 0 to the last one declared
+    PipelineLayoutInfo      getPipelineLayoutInfo(VkPipelineLayout pipelineLayout);  // Of a layout from this cache
+
+private:
+    VkDevice                m_device = nullptr;         // This is our Logical Device
+
+    // By declaration (binding, type, count and stages of each binding / set layouts and push constant range)
+    std::map<std::vector<uint32_t>, VkDescriptorSetLayout>  m_setLayouts;
+    std::map<std::vector<uint64_t>, VkPipelineLayout>       m_pipelineLayouts;
+
+    // By pipeline layout (guarded by m_infoMutex)
+    std::map<uint64_t, PipelineLayoutInfo>  m_pipelineLayoutInfos;
+    std::mutex                              m_infoMutex;
+};
+
+#endif //LAYOUT_CACHE_H
@@ -0,0 +1,180 @@
+#include "Lz4.h"
+
+// C++ STL
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+// Block format limits
+static const size_t MIN_MATCH       = 4;
+static const size_t LAST_LITERALS   = 5;            // The last 5 bytes are always literals
+static const size_t MF_LIMIT        = 12;           // The last match starts at least 12 bytes before the end
+static const size_t MAX_OFFSET      = 65535;
+static const uint32_t HASH_BITS     = 16;
+
+//------------------------------------------------------------------------------
+static uint32_t read32(const uint8_t * p)
+{
+    uint32_t value;
+    memcpy(&value, p, sizeof(value));
+    return value;
+}
+//------------------------------------------------------------------------------
+// Length of a field beyond its 4 bits token nibble: 255 bytes, then the remainder
+static void writeLength(std::vector<uint8_t> &dst, size_t length)
+{
+    for (; length >= 255; length -= 255)
+    {
+        dst.push_back(255);
+    }
+    dst.push_back(static_cast<uint8_t>(length));
+}
+//------------------------------------------------------------------------------
+// Token, literals, then the match (offset + length); matchLength 0: last sequence (literals only)
+static void writeSequence(std::vector<uint8_t> &dst, const uint8_t * literals, size_t literalLength, size_t offset, size_t matchLength)
+{
+    size_t matchCode = (matchLength > 0) ? matchLength - MIN_MATCH : 0;
+    dst.push_back(static_cast<uint8_t>((std::min<size_t>(literalLength, 15) << 4) | std::min<size_t>(matchCode, 15)));
+    if (literalLength >= 15)
+    {
+        writeLength(dst, literalLength - 15);
+    }
+    dst.insert(dst.end(), literals, literals + literalLength);
+
+    if (matchLength > 0)
+    {
+        dst.push_back(static_cast<uint8_t>(offset));
+        dst.push_back(static_cast<uint8_t>(offset >> 8));
+        if (matchCode >= 15)
+        {
+            writeLength(dst, matchCode - 15);
+        }
+    }
+}
+//------------------------------------------------------------------------------
+std::vector<uint8_t> Lz4::compress(const uint8_t * src, size_t srcSize)
+{
+    std::vector<uint8_t> dst;
+    if (srcSize > std::numeric_limits<uint32_t>::max())
+    {
+        return dst;
+    }
+    dst.reserve(srcSize + srcSize / 255 + 16);
+
+    // Last position where each 4 bytes sequence (hashed) was seen
+    std::vector<uint32_t> table(size_t(1) << HASH_BITS, 0);
+    size_t anchor = 0;              // First literal not written yet
+    size_t pos = 0;
+    if (srcSize > MF_LIMIT)
+    {
+        const size_t searchEnd = srcSize - MF_LIMIT;
+        const size_t matchEnd = srcSize - LAST_LITERALS;
+        while (pos < searchEnd)
+        {
+            uint32_t sequence = read32(src + pos);
+            uint32_t hash = (sequence * 2654435761U) >> (32 - HASH_BITS);
+            size_t candidate = table[hash];
+            table[hash] = static_cast<uint32_t>(pos);
+            if (candidate >= pos || pos - candidate > MAX_OFFSET || read32(src + candidate) != sequence)
+            {
+                ++pos;
+                continue;
+            }
+
+            // Extend the match backwards (over pending literals), then forwards
+            while (pos > anchor && candidate > 0 && src[pos - 1] == src[candidate - 1])
+            {
+                --pos;
+                --candidate;
+            }
+            size_t matchLength = MIN_MATCH;
+            while (pos + matchLength < matchEnd && src[pos + matchLength] == src[candidate + matchLength])
+            {
+                ++matchLength;
+            }
+
+            writeSequence(dst, src + anchor, pos - anchor, pos - candidate, matchLength);
+            pos += matchLength;
+            anchor = pos;
+        }
+    }
+    writeSequence(dst, src + anchor, srcSize - anchor, 0, 0);
+    return dst;
+}
+//------------------------------------------------------------------------------
+bool Lz4::decompress(const uint8_t * src, size_t srcSize, uint8_t * dst, size_t dstSize)
+{
+    size_t srcPos = 0;
+    size_t dstPos = 0;
+    while (srcPos < srcSize)
+    {
+        uint8_t token = src[srcPos++];
+
+        // Literals
+        size_t literalLength = token >> 4;
+        if (literalLength == 15)
+        {
+            uint8_t byte;
+            do
+            {
+                if (srcPos >= srcSize)
+                {
+                    return false;
+                }
+                byte = src[srcPos++];
+                literalLength += byte;
+            } while (byte == 255);
+        }
+        if (literalLength > srcSize - srcPos || literalLength > dstSize - dstPos)
+        {
+            return false;
+        }
+        memcpy(dst + dstPos, src + srcPos, literalLength);
+        srcPos += literalLength;
+        dstPos += literalLength;
+        if (srcPos == srcSize)
+        {
+            break;          // Last sequence: literals only
+        }
+
+        // Match (may overlap its own output: offset < length repeats a pattern)
+        if (srcSize - srcPos < 2)
+        {
+            return false;
+        }
+        size_t offset = src[srcPos] | (static_cast<size_t>(src[srcPos + 1]) << 8);
+        srcPos += 2;
+        size_t matchLength = (token & 15) + MIN_MATCH;
+        if ((token & 15) == 15)
+        {
+            uint8_t byte;
+            do
+            {
+                if (srcPos >= srcSize)
+                {
+                    return false;
+                }
+                byte = src[srcPos++];
+                matchLength += byte;
+            } while (byte == 255);
+        }
+        if (offset == 0 || offset > dstPos || matchLength > dstSize - dstPos)
+        {
+            return false;
+        }
+        const uint8_t * match = dst + dstPos - offset;
+        if (offset >= matchLength)
+        {
+            memcpy(dst + dstPos, match, matchLength);
+        }
+        else
+        {
+            for (size_t i = 0; i < matchLength; ++i)
+            {
+                dst[dstPos + i] = match[i];
+            }
+        }
+        dstPos += matchLength;
+    }
+    return dstPos == dstSize;
+}
@@ -0,0 +1,18 @@
+#ifndef LZ4_H
+#define LZ4_H
+
+// C++ STL
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// LZ4 block format (https://github.com/lz4/lz4/blob/dev/doc/lz4_Block_format.md): byte oriented LZ77, decoded at
+// memory copy speed. The compressor is greedy (single probe hash table), good enough for offline packing.
+class Lz4
+{
+public:
+    static std::vector<uint8_t> compress(const uint8_t * src, size_t srcSize);      // Empty if the source is too large
+    static bool                 decompress(const uint8_t * src, size_t srcSize, uint8_t * dst, size_t dstSize);   // False on malformed data
+};
+
+#endif //LZ4_H
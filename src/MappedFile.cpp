@@ -0,0 +1,154 @@
+#include "MappedFile.h"
+
+// C++ STL
+#include <utility>
+
+// Platform mapping APIs
+#ifdef _WIN32
+    #define WIN32_LEAN_AND_MEAN
+    #define NOMINMAX
+    #include <windows.h>
+#else
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+//------------------------------------------------------------------------------
+MappedFile::MappedFile()
+{
+}
+//------------------------------------------------------------------------------
+MappedFile::~MappedFile()
+{
+    close();
+}
+//------------------------------------------------------------------------------
+MappedFile::MappedFile(MappedFile &&other) noexcept
+{
+    *this = std::move(other);
+}
+//------------------------------------------------------------------------------
+MappedFile & MappedFile::operator=(MappedFile &&other) noexcept
+{
+    if (this != &other)
+    {
+        close();
+        std::swap(m_data, other.m_data);
+        std::swap(m_size, other.m_size);
+#ifdef _WIN32
+        std::swap(m_fileHandle, other.m_fileHandle);
+        std::swap(m_mappingHandle, other.m_mappingHandle);
+#else
+        std::swap(m_fileDescriptor, other.m_fileDescriptor);
+#endif
+    }
+    return *this;
+}
+//------------------------------------------------------------------------------
+bool MappedFile::open(const std::string &filePath)
+{
+    close();
+
+#ifdef _WIN32
+    HANDLE file = CreateFileA(filePath.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING,
+                              FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        return false;
+    }
+    m_fileHandle = file;
+
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0)
+    {
+        close();
+        return false;
+    }
+
+    m_mappingHandle = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!m_mappingHandle)
+    {
+        close();
+        return false;
+    }
+    m_data = static_cast<const uint8_t *>(MapViewOfFile(m_mappingHandle, FILE_MAP_READ, 0, 0, 0));
+    m_size = static_cast<size_t>(fileSize.QuadPart);
+#else
+    m_fileDescriptor = ::open(filePath.c_str(), O_RDONLY);
+    if (m_fileDescriptor < 0)
+    {
+        return false;
+    }
+
+    struct stat fileStat;
+    if (fstat(m_fileDescriptor, &fileStat) != 0 || fileStat.st_size == 0)
+    {
+        close();
+        return false;
+    }
+
+    void * data = mmap(nullptr, static_cast<size_t>(fileStat.st_size), PROT_READ, MAP_PRIVATE, m_fileDescriptor, 0);
+    if (data != MAP_FAILED)
+    {
+        m_data = static_cast<const uint8_t *>(data);
+        m_size = static_cast<size_t>(fileStat.st_size);
+        madvise(data, m_size, MADV_SEQUENTIAL);     // Read once, front to back
+    }
+#endif
+
+    if (!m_data)
+    {
+        close();
+        return false;
+    }
+    return true;
+}
+//------------------------------------------------------------------------------
+void MappedFile::close()
+{
+#ifdef _WIN32
+    if (m_data)
+    {
+        UnmapViewOfFile(m_data);
+    }
+    if (m_mappingHandle)
+    {
+        CloseHandle(m_mappingHandle);
+    }
+    if (m_fileHandle)
+    {
+        CloseHandle(m_fileHandle);
+    }
+    m_mappingHandle = nullptr;
+    m_fileHandle = nullptr;
+#else
+    if (m_data)
+    {
+        munmap(const_cast<uint8_t *>(m_data), m_size);
+    }
+    if (m_fileDescriptor >= 0)
+    {
+        ::close(m_fileDescriptor);
+    }
+    m_fileDescriptor = -1;
+#endif
+    m_data = nullptr;
+    m_size = 0;
+}
+//------------------------------------------------------------------------------
+const uint8_t * MappedFile::getData() const
+{
+    return m_data;
+}
+//------------------------------------------------------------------------------
+size_t MappedFile::getSize() const
+{
+    return m_size;
+}
+//------------------------------------------------------------------------------
+bool MappedFile::isOpen() const
+{
+    return m_data != nullptr;
+}
@@ -0,0 +1,40 @@
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+// C++ STL
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Read-only memory mapping of a whole file (the pages are read on first access, straight from the OS file cache).
+// Move-only: the mapping is released by close() or by the destructor.
+class MappedFile
+{
+public:
+    MappedFile();
+    ~MappedFile();
+
+    MappedFile(const MappedFile &) = delete;
+    MappedFile & operator=(const MappedFile &) = delete;
+    MappedFile(MappedFile &&other) noexcept;
+    MappedFile & operator=(MappedFile &&other) noexcept;
+
+    bool            open(const std::string &filePath);  // False if the file can't be opened (or is empty)
+    void            close();
+
+    const uint8_t * getData() const;
+    size_t          getSize() const;
+    bool            isOpen() const;
+
+private:
+    const uint8_t * m_data = nullptr;
+    size_t          m_size = 0;
+#ifdef _WIN32
+    void *          m_fileHandle = nullptr;             // HANDLE
+    void *          m_mappingHandle = nullptr;          // HANDLE
+#else
+    int             m_fileDescriptor = -1;
+#endif
+};
+
+#endif //MAPPED_FILE_H
@@ -15,10 +15,47 @@ Mesh::Mesh( VkPhysicalDevice newPhysicalDevice, VkDevice newDevice,
     m_physicalDevice = newPhysicalDevice;
     m_device = newDevice;
     createVertexBuffer(transferQueue, transferCommandPool, vertices);
+    createPositionBuffer(transferQueue, transferCommandPool, vertices);
     createIndexBuffer(transferQueue, transferCommandPool, indices);
 
     m_model.model = glm::mat4(1.0f);
     m_textureIdx = textureIdx;
+
+    // Bounding sphere: center of the bounding box, radius to the farthest vertex
+    if (!vertices->empty())
+    {
+        glm::vec3 minimum = (*vertices)[0].pos, maximum = (*vertices)[0].pos;
+        for (const Vertex &vertex : *vertices)
+        {
+            minimum = glm::min(minimum, vertex.pos);
+            maximum = glm::max(maximum, vertex.pos);
+        }
+        m_boundsCenter = (minimum + maximum) * 0.5f;
+        for (const Vertex &vertex : *vertices)
+        {
+            m_boundsRadius = std::max(m_boundsRadius, glm::length(vertex.pos - m_boundsCenter));
+        }
+    }
+}
+
+Mesh::Mesh( VkPhysicalDevice newPhysicalDevice, VkDevice newDevice,
+            VkQueue transferQueue, VkCommandPool transferCommandPool,
+            MeshPackage * package, int textureIdx)
+{
+    m_vertexCount = static_cast<uint32_t>(package->vertices.size());
+    m_indexCount = static_cast<uint32_t>(package->indices.size());
+    m_physicalDevice = newPhysicalDevice;
+    m_device = newDevice;
+    createVertexBuffer(transferQueue, transferCommandPool, &package->vertices);
+    createPositionBuffer(transferQueue, transferCommandPool, &package->vertices);
+    createIndexBuffer(transferQueue, transferCommandPool, &package->indices);
+
+    m_model.model = glm::mat4(1.0f);
+    m_textureIdx = textureIdx;
+
+    // Cooked: the bounding sphere is precomputed
+    m_boundsCenter = package->boundsCenter;
+    m_boundsRadius = package->boundsRadius;
 }
 
 Model Mesh::getModel()
@@ -36,6 +73,36 @@ int Mesh::getTextureIdx()
     return m_textureIdx;
 }
 
+glm::vec3 Mesh::getBoundsCenter()
+{
+    return m_boundsCenter;
+}
+
+float Mesh::getBoundsRadius()
+{
+    return m_boundsRadius;
+}
+
+bool Mesh::isTransparent()
+{
+    return m_transparent;
+}
+
+void Mesh::setTransparent(bool transparent)
+{
+    m_transparent = transparent;
+}
+
+Material Mesh::getMaterial()
+{
+    return m_material;
+}
+
+void Mesh::setMaterial(const Material &material)
+{
+    m_material = material;
+}
+
 uint32_t Mesh::getVertexCount()
 {
     return m_vertexCount;
@@ -46,6 +113,11 @@ VkBuffer Mesh::getVertexBuffer()
     return m_vertexBuffer;
 }
 
+VkBuffer Mesh::getPositionBuffer()
+{
+    return m_positionBuffer;
+}
+
 uint32_t Mesh::getIndexCount()
 {
     return m_indexCount;
@@ -61,6 +133,9 @@ void Mesh::destroyBuffers()
     // Vertex Buffer Destroy + Free
     vkDestroyBuffer(m_device, m_vertexBuffer, nullptr);
     vkFreeMemory(m_device, m_vertexBufferMemory, nullptr);
+    // Position Buffer Destroy + Free
+    vkDestroyBuffer(m_device, m_positionBuffer, nullptr);
+    vkFreeMemory(m_device, m_positionBufferMemory, nullptr);
     // Index Buffer Destroy + Free
     vkDestroyBuffer(m_device, m_indexBuffer, nullptr);
     vkFreeMemory(m_device, m_indexBufferMemory, nullptr);
@@ -105,6 +180,42 @@ void Mesh::createVertexBuffer(VkQueue transferQueue, VkCommandPool transferComma
     vkFreeMemory(m_device, stagingBufferMemory, nullptr);
 }
 
+void Mesh::createPositionBuffer(VkQueue transferQueue, VkCommandPool transferCommandPool, std::vector<Vertex>* vertices)
+{
+    // Tightly packed positions: the depth pre-pass fetches 12 bytes per vertex instead of the whole Vertex
+    std::vector<glm::vec3> positions(vertices->size());
+    for (size_t i = 0; i < vertices->size(); ++i)
+    {
+        positions[i] = (*vertices)[i].pos;
+    }
+
+    // Get size of buffer needed for positions
+    VkDeviceSize bufferSize = sizeof(glm::vec3) * positions.size();
+
+    // Temporary buffer to "stage" position data before transferring to GPU
+    VkBuffer stagingBuffer;
+    VkDeviceMemory stagingBufferMemory;
+    createBuffer(m_physicalDevice, m_device, bufferSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, &stagingBuffer, &stagingBufferMemory);
+
+    // MAP MEMORY TO POSITION BUFFER (staging)
+    void * data;
+    vkMapMemory(m_device, stagingBufferMemory, 0, bufferSize, 0, &data);
+    memcpy(data, positions.data(), (size_t)bufferSize);
+    vkUnmapMemory(m_device, stagingBufferMemory);
+
+    // Create buffer for POSITION data on GPU access only area
+    createBuffer(m_physicalDevice, m_device, bufferSize, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, &m_positionBuffer, &m_positionBufferMemory);
+
+    // Copy from staging buffer to GPU access buffer
+    copyBuffer(m_device, transferQueue, transferCommandPool, stagingBuffer, m_positionBuffer, bufferSize);
+
+    // Destroy + Release Staging Buffer resources
+    vkDestroyBuffer(m_device, stagingBuffer, nullptr);
+    vkFreeMemory(m_device, stagingBufferMemory, nullptr);
+}
+
 void Mesh::createIndexBuffer(VkQueue transferQueue, VkCommandPool transferCommandPool, std::vector<uint32_t>* indices)
 {
     // Get size of buffer needed for indices
@@ -5,6 +5,7 @@
 #include <vector>
 
 // Project includes
+#include "MeshPackage.h"
 #include "Utilities.h"          // Utilities header includes GLFW [Graphics Library FrameWork] + Vulkan API
 
 using namespace Utilities;
@@ -14,6 +15,16 @@ struct Model {
     glm::mat4 model;
 };
 
+// Shader features of a mesh: specialization constants of "shader.frag", so each combination is a pipeline variant
+// compiled from the same SPIR-V (a feature turned off costs nothing in the shader code)
+struct Material {
+    bool textured = true;               // Samples its texture (otherwise: interpolated vertex colours)
+    bool alphaTested = false;           // Discards the fragments under the alpha cutoff (cut-outs, no blending needed)
+
+    static const uint32_t VARIANT_COUNT = 4;
+    uint32_t getVariant() const { return (textured ? 1U : 0U) | (alphaTested ? 2U : 0U); }
+};
+
 class Mesh
 {
 public:
@@ -22,14 +33,27 @@ public:
             VkQueue transferQueue, VkCommandPool transferCommandPool, 
             std::vector<Vertex> * vertices, std::vector<uint32_t> * indices,
             int textureIdx);
+    Mesh(   VkPhysicalDevice newPhysicalDevice, VkDevice newDevice,
+            VkQueue transferQueue, VkCommandPool transferCommandPool,
+            MeshPackage * package, int textureIdx);
 
     Model       getModel();
     void        setModel(glm::mat4 newModel);
 
     int         getTextureIdx();
 
+    glm::vec3   getBoundsCenter();
+    float       getBoundsRadius();
+
+    bool        isTransparent();
+    void        setTransparent(bool transparent);
+
+    Material    getMaterial();
+    void        setMaterial(const Material &material);
+
     uint32_t    getVertexCount();
     VkBuffer    getVertexBuffer();
+    VkBuffer    getPositionBuffer();
 
     uint32_t    getIndexCount();
     VkBuffer    getIndexBuffer();
@@ -41,10 +65,16 @@ public:
 private:
     Model               m_model = {};
     int                 m_textureIdx;
+    bool                m_transparent = false;          // Transparent meshes are blended and drawn back-to-front after the opaque ones
+    Material            m_material = {};
+    glm::vec3           m_boundsCenter = glm::vec3(0.0f);   // Bounding sphere (model space)
+    float               m_boundsRadius = 0.0f;
 
     uint32_t            m_vertexCount = 0U;
     VkBuffer            m_vertexBuffer = 0;             // '0' instead of 'nullptr' for compatibility with 32bit version
     VkDeviceMemory      m_vertexBufferMemory = 0;       // '0' instead of 'nullptr' for compatibility with 32bit version
+    VkBuffer            m_positionBuffer = 0;           // Position-only vertex stream (used by the depth pre-pass)
+    VkDeviceMemory      m_positionBufferMemory = 0;     // '0' instead of 'nullptr' for compatibility with 32bit version
 
     uint32_t            m_indexCount = 0U;
     VkBuffer            m_indexBuffer = 0;              // '0' instead of 'nullptr' for compatibility with 32bit version
@@ -55,6 +85,7 @@ private:
 
     // Methods
     void createVertexBuffer(VkQueue transferQueue, VkCommandPool transferCommandPool, std::vector<Vertex> * vertices);
+    void createPositionBuffer(VkQueue transferQueue, VkCommandPool transferCommandPool, std::vector<Vertex> * vertices);
     void createIndexBuffer(VkQueue transferQueue, VkCommandPool transferCommandPool, std::vector<uint32_t> * indices);
 };
 
@@ -0,0 +1,108 @@
+#include "MeshPackage.h"
+
+// C++ STL
+#include <stdexcept>
+
+using namespace Utilities;
+
+// Package header identification ('MSHP'), bump the version when the layout (or Vertex) changes
+static const uint32_t MESH_PACKAGE_MAGIC = 0x5048534D;
+static const uint32_t MESH_PACKAGE_VERSION = 1;
+
+// File layout: header | vertices | indices
+struct MeshPackageHeader
+{
+    uint32_t    magic;
+    uint32_t    version;
+    uint32_t    vertexSize;         // sizeof(Vertex) of the writer
+    uint32_t    vertexCount;
+    uint32_t    indexCount;
+    float       boundsCenter[3];
+    float       boundsRadius;
+};
+
+//------------------------------------------------------------------------------
+void MeshPackage::read(std::span<const uint8_t> fileData, const std::string &filePath)
+{
+    MeshPackageHeader header;
+    if (fileData.size() < sizeof(MeshPackageHeader))
+    {
+        throw std::runtime_error("Malformed Mesh Package '" + filePath + "'!");
+    }
+    memcpy(&header, fileData.data(), sizeof(MeshPackageHeader));
+    if (header.magic != MESH_PACKAGE_MAGIC || header.version != MESH_PACKAGE_VERSION || header.vertexSize != sizeof(Vertex))
+    {
+        throw std::runtime_error("Mesh Package '" + filePath + "' was cooked by another version: cook it again!");
+    }
+
+    size_t verticesSize = static_cast<size_t>(header.vertexCount) * sizeof(Vertex);
+    size_t indicesSize = static_cast<size_t>(header.indexCount) * sizeof(uint32_t);
+    if (fileData.size() != sizeof(MeshPackageHeader) + verticesSize + indicesSize || header.indexCount % 3 != 0)
+    {
+        throw std::runtime_error("Malformed Mesh Package '" + filePath + "'!");
+    }
+
+    vertices.resize(header.vertexCount);
+    indices.resize(header.indexCount);
+    memcpy(vertices.data(), fileData.data() + sizeof(MeshPackageHeader), verticesSize);
+    memcpy(indices.data(), fileData.data() + sizeof(MeshPackageHeader) + verticesSize, indicesSize);
+    boundsCenter = glm::vec3(header.boundsCenter[0], header.boundsCenter[1], header.boundsCenter[2]);
+    boundsRadius = header.boundsRadius;
+
+    for (uint32_t index : indices)
+    {
+        if (index >= header.vertexCount)
+        {
+            throw std::runtime_error("Malformed Mesh Package '" + filePath + "': index out of range!");
+        }
+    }
+}
+//------------------------------------------------------------------------------
+void MeshPackage::write(const std::string &filePath) const
+{
+    MeshPackageHeader header = {};
+    header.magic = MESH_PACKAGE_MAGIC;
+    header.version = MESH_PACKAGE_VERSION;
+    header.vertexSize = sizeof(Vertex);
+    header.vertexCount = static_cast<uint32_t>(vertices.size());
+    header.indexCount = static_cast<uint32_t>(indices.size());
+    header.boundsCenter[0] = boundsCenter.x;
+    header.boundsCenter[1] = boundsCenter.y;
+    header.boundsCenter[2] = boundsCenter.z;
+    header.boundsRadius = boundsRadius;
+
+    std::ofstream file(filePath, std::ios::binary | std::ios::trunc);
+    if (!file.is_open())
+    {
+        throw std::runtime_error("Failed to write the Mesh Package '" + filePath + "'!");
+    }
+    file.write(reinterpret_cast<const char *>(&header), sizeof(MeshPackageHeader));
+    file.write(reinterpret_cast<const char *>(vertices.data()), vertices.size() * sizeof(Vertex));
+    file.write(reinterpret_cast<const char *>(indices.data()), indices.size() * sizeof(uint32_t));
+    if (!file.good())
+    {
+        throw std::runtime_error("Failed to write the Mesh Package '" + filePath + "'!");
+    }
+}
+//------------------------------------------------------------------------------
+void MeshPackage::computeBounds()
+{
+    boundsCenter = glm::vec3(0.0f);
+    boundsRadius = 0.0f;
+    if (vertices.empty())
+    {
+        return;
+    }
+
+    glm::vec3 minimum = vertices[0].pos, maximum = vertices[0].pos;
+    for (const Vertex &vertex : vertices)
+    {
+        minimum = glm::min(minimum, vertex.pos);
+        maximum = glm::max(maximum, vertex.pos);
+    }
+    boundsCenter = (minimum + maximum) * 0.5f;
+    for (const Vertex &vertex : vertices)
+    {
+        boundsRadius = std::max(boundsRadius, glm::length(vertex.pos - boundsCenter));
+    }
+}
@@ -0,0 +1,28 @@
+#ifndef MESH_PACKAGE_H
+#define MESH_PACKAGE_H
+
+// C++ STL
+#include <span>
+#include <string>
+#include <vector>
+
+// Project includes
+#include "Utilities.h"          // Utilities header includes GLFW [Graphics Library FrameWork] + Vulkan API
+
+// GPU-ready mesh, as written by the AssetCooker tool (tools/AssetCooker): vertices in the layout of the vertex buffer,
+// indices optimized for the post-transform cache and vertices in fetch order, bounding sphere precomputed.
+// The runtime reads it as it is (no processing at load).
+struct MeshPackage
+{
+    std::vector<Utilities::Vertex>  vertices;
+    std::vector<uint32_t>           indices;            // Triangle list
+    glm::vec3                       boundsCenter = glm::vec3(0.0f);     // Bounding sphere (model space)
+    float                           boundsRadius = 0.0f;
+
+    void        read(std::span<const uint8_t> fileData, const std::string &filePath);   // Throws on malformed/outdated files
+    void        write(const std::string &filePath) const;
+
+    void        computeBounds();                        // Center of the bounding box, radius to the farthest vertex
+};
+
+#endif //MESH_PACKAGE_H
@@ -0,0 +1,179 @@
+#include "PipelineCache.h"
+
+// C++ STL
+#include <cstring>
+#include <filesystem>
+#include <iomanip>
+#include <sstream>
+#include <stdexcept>
+
+using std::cout;
+using std::endl;
+
+// Directory (relative to the Current Working Directory) where pipeline caches are stored
+static const char * PIPELINE_CACHE_DIR = "PipelineCache";
+
+//------------------------------------------------------------------------------
+PipelineCache::PipelineCache()
+{
+}
+//------------------------------------------------------------------------------
+PipelineCache::~PipelineCache()
+{
+}
+//------------------------------------------------------------------------------
+void PipelineCache::create(VkPhysicalDevice physicalDevice, VkDevice device, const std::string &name)
+{
+    m_device = device;
+    m_name = name;
+    vkGetPhysicalDeviceProperties(physicalDevice, &m_deviceProperties);
+    m_filePath = buildFilePath();
+
+    // Load the previous cache data (if any, and only if it was produced by this device + driver)
+    std::vector<char> cacheData;
+    std::ifstream file(m_filePath, std::ios::binary | std::ios::ate);
+    if (file.is_open())
+    {
+        cacheData.resize(static_cast<size_t>(file.tellg()));
+        file.seekg(0);
+        file.read(cacheData.data(), cacheData.size());
+        file.close();
+
+        if (!isCompatible(cacheData))
+        {
+            cout << "Pipeline Cache '" << m_name << "' discarded: created by another device or driver." << endl;
+            cacheData.clear();
+        }
+    }
+
+    // Pipeline Cache creation information (initial data is optional)
+    VkPipelineCacheCreateInfo cacheCreateInfo = {};
+    cacheCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+    cacheCreateInfo.initialDataSize = cacheData.size();                             // Size of the previously saved blob
+    cacheCreateInfo.pInitialData = cacheData.empty() ? nullptr : cacheData.data();  // Previously saved blob
+
+    VkResult result = vkCreatePipelineCache(m_device, &cacheCreateInfo, nullptr, &m_pipelineCache);
+    if (result != VK_SUCCESS && !cacheData.empty())
+    {
+        // Drivers may still refuse a blob that passed the header check: start from an empty cache
+        cacheCreateInfo.initialDataSize = 0;
+        cacheCreateInfo.pInitialData = nullptr;
+        cacheData.clear();
+        result = vkCreatePipelineCache(m_device, &cacheCreateInfo, nullptr, &m_pipelineCache);
+    }
+    if (result != VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to create a Pipeline Cache!");
+    }
+
+    cout << "Pipeline Cache '" << m_name << "' " << (cacheData.empty() ? "created empty." : "loaded from disk")
+         << (cacheData.empty() ? "" : " (" + std::to_string(cacheData.size()) + " bytes).") << endl;
+}
+//------------------------------------------------------------------------------
+bool PipelineCache::save()
+{
+    if (m_pipelineCache == 0)
+    {
+        return false;
+    }
+
+    // Get Pipeline Cache data (first size, then values)
+    size_t dataSize = 0;
+    vkGetPipelineCacheData(m_device, m_pipelineCache, &dataSize, nullptr);
+    std::vector<char> cacheData(dataSize);
+    if (dataSize == 0 || vkGetPipelineCacheData(m_device, m_pipelineCache, &dataSize, cacheData.data()) != VK_SUCCESS)
+    {
+        return false;
+    }
+
+    // Write to a temporary file, then rename it over the previous one:
+    // a crash (or a concurrent instance) never leaves a truncated cache behind
+    std::error_code errorCode;
+    std::filesystem::create_directories(PIPELINE_CACHE_DIR, errorCode);
+    std::string tempFilePath = m_filePath + ".tmp";
+    {
+        std::ofstream file(tempFilePath, std::ios::binary | std::ios::trunc);
+        if (!file.is_open())
+        {
+            cout << "Failed to write the Pipeline Cache '" << m_name << "' ('" << tempFilePath << "')" << endl;
+            return false;
+        }
+        file.write(cacheData.data(), dataSize);
+        file.flush();
+        if (!file.good())
+        {
+            file.close();
+            std::filesystem::remove(tempFilePath, errorCode);
+            return false;
+        }
+    }
+
+    std::filesystem::rename(tempFilePath, m_filePath, errorCode);
+    if (errorCode)
+    {
+        cout << "Failed to replace the Pipeline Cache '" << m_name << "': " << errorCode.message() << endl;
+        std::filesystem::remove(tempFilePath, errorCode);
+        return false;
+    }
+
+    return true;
+}
+//------------------------------------------------------------------------------
+void PipelineCache::destroy()
+{
+    if (m_pipelineCache == 0)
+    {
+        return;
+    }
+
+    // Write back what has been compiled during this run
+    save();
+
+    vkDestroyPipelineCache(m_device, m_pipelineCache, nullptr);
+    m_pipelineCache = 0;
+}
+//------------------------------------------------------------------------------
+VkPipelineCache PipelineCache::getHandle()
+{
+    return m_pipelineCache;
+}
+//------------------------------------------------------------------------------
+std::string PipelineCache::buildFilePath()
+{
+    // <name>_<vendorID>_<deviceID>_<pipelineCacheUUID>.bin
+    std::ostringstream path;
+    path << PIPELINE_CACHE_DIR << "/" << m_name << "_" << std::hex << std::setfill('0')
+         << std::setw(4) << m_deviceProperties.vendorID << "_" << std::setw(4) << m_deviceProperties.deviceID << "_";
+    for (uint32_t i = 0; i < VK_UUID_SIZE; ++i)
+    {
+        path << std::setw(2) << static_cast<uint32_t>(m_deviceProperties.pipelineCacheUUID[i]);
+    }
+    path << ".bin";
+
+    return path.str();
+}
+//------------------------------------------------------------------------------
+bool PipelineCache::isCompatible(const std::vector<char> &cacheData)
+{
+    // Pipeline Cache header (version one):
+    //  uint32_t headerSize | uint32_t headerVersion | uint32_t vendorID | uint32_t deviceID | uint8_t UUID[VK_UUID_SIZE]
+    const size_t headerMinSize = 4 * sizeof(uint32_t) + VK_UUID_SIZE;
+    if (cacheData.size() < headerMinSize)
+    {
+        return false;
+    }
+
+    uint32_t headerSize, headerVersion, vendorID, deviceID;
+    uint8_t  cacheUUID[VK_UUID_SIZE];
+    memcpy(&headerSize,     cacheData.data() +  0, sizeof(uint32_t));
+    memcpy(&headerVersion,  cacheData.data() +  4, sizeof(uint32_t));
+    memcpy(&vendorID,       cacheData.data() +  8, sizeof(uint32_t));
+    memcpy(&deviceID,       cacheData.data() + 12, sizeof(uint32_t));
+    memcpy(cacheUUID,       cacheData.data() + 16, VK_UUID_SIZE);
+
+    return  headerSize >= headerMinSize && headerSize <= cacheData.size()
+        &&  headerVersion == VK_PIPELINE_CACHE_HEADER_VERSION_ONE
+        &&  vendorID == m_deviceProperties.vendorID
+        &&  deviceID == m_deviceProperties.deviceID
+        &&  memcmp(cacheUUID, m_deviceProperties.pipelineCacheUUID, VK_UUID_SIZE) == 0;
+}
@@ -0,0 +1,40 @@
+#ifndef PIPELINE_CACHE_H
+#define PIPELINE_CACHE_H
+
+// C++ STL
+#include <string>
+#include <vector>
+
+// Project includes
+#include "Utilities.h"          // Utilities header includes GLFW [Graphics Library FrameWork] + Vulkan API
+
+// Persistent VkPipelineCache: loaded from disk at startup and written back (atomically) at shutdown.
+// Each cache has a name, so more caches can live side by side for the same device (e.g. one per pipeline family).
+// The file name embeds vendor ID, device ID and pipeline cache UUID, and the blob header is validated against
+// them as well: data produced by another GPU or driver is discarded instead of being handed to the driver.
+class PipelineCache
+{
+public:
+    PipelineCache();
+    ~PipelineCache();
+
+    void            create(VkPhysicalDevice physicalDevice, VkDevice device, const std::string &name = "main");
+    bool            save();
+    void            destroy();
+
+    VkPipelineCache getHandle();
+
+private:
+    std::string                 m_name;
+    std::string                 m_filePath;
+
+    VkPipelineCache             m_pipelineCache = 0;            // '0' instead of 'nullptr' for compatibility with 32bit version
+    VkPhysicalDeviceProperties  m_deviceProperties = {};
+    VkDevice                    m_device = nullptr;             // This is our Logical Device
+
+    // Methods
+    std::string buildFilePath();
+    bool        isCompatible(const std::vector<char> &cacheData);
+};
+
+#endif //PIPELINE_CACHE_H
@@ -0,0 +1,895 @@
+#include "PipelineManager.h"
+
+// C++ STL
+#include <algorithm>
+#include <array>
+#include <stdexcept>
+
+using namespace Utilities;
+using std::cout;
+using std::endl;
+
+// Maximum number of compilation threads (drivers scale well up to a few threads only)
+static const uint32_t MAX_PIPELINE_WORKERS = 4;
+
+//------------------------------------------------------------------------------
+template <typename T>
+static void loadDeviceFunction(VkDevice device, const char * name, T * function)
+{
+    // Extension commands aren't exported by the loader: they come from the device
+    *function = reinterpret_cast<T>(vkGetDeviceProcAddr(device, name));
+    if (*function == nullptr)
+    {
+        throw std::runtime_error(std::string("Failed to load ") + name + "!");
+    }
+}
+
+//------------------------------------------------------------------------------
+// PipelineDesc //
+//------------------------------------------------------------------------------
+uint64_t PipelineDesc::hash() const
+{
+    uint64_t hash = FNV_OFFSET_BASIS;
+    hash = hashCombine(hash, vertexShader);
+    hash = hashCombine(hash, fragmentShader);
+    for (const std::string &define : shaderDefines)
+    {
+        hash = hashCombine(hash, define);
+    }
+    for (uint32_t constant : specializationConstants)
+    {
+        hash = hashCombine(hash, constant);
+    }
+    hash = hashCombine(hash, vertexLayout);
+    hash = hashCombine(hash, topology);
+    hash = hashCombine(hash, cullMode);
+    hash = hashCombine(hash, blendEnable);
+    hash = hashCombine(hash, depthTestEnable);
+    hash = hashCombine(hash, depthWriteEnable);
+    hash = hashCombine(hash, depthCompareOp);
+    hash = hashCombine(hash, colourAttachmentCount);
+    hash = hashCombine(hash, layout);
+    hash = hashCombine(hash, renderPass);
+    hash = hashCombine(hash, subpass);
+    return hash;
+}
+//------------------------------------------------------------------------------
+bool PipelineDesc::operator==(const PipelineDesc &other) const
+{
+    return  vertexShader == other.vertexShader
+        &&  fragmentShader == other.fragmentShader
+        &&  shaderDefines == other.shaderDefines
+        &&  specializationConstants == other.specializationConstants
+        &&  vertexLayout == other.vertexLayout
+        &&  topology == other.topology
+        &&  cullMode == other.cullMode
+        &&  blendEnable == other.blendEnable
+        &&  depthTestEnable == other.depthTestEnable
+        &&  depthWriteEnable == other.depthWriteEnable
+        &&  depthCompareOp == other.depthCompareOp
+        &&  colourAttachmentCount == other.colourAttachmentCount
+        &&  layout == other.layout
+        &&  renderPass == other.renderPass
+        &&  subpass == other.subpass;
+}
+
+//------------------------------------------------------------------------------
+// PipelineManager //
+//------------------------------------------------------------------------------
+PipelineManager::PipelineManager()
+{
+}
+//------------------------------------------------------------------------------
+PipelineManager::~PipelineManager()
+{
+}
+//------------------------------------------------------------------------------
+void PipelineManager::create(VkDevice device, VkPipelineCache pipelineCache, const AssetArchive * assetArchive,
+                             ShaderCompiler * shaderCompiler, LayoutCache * layoutCache, PipelineBackend backend,
+                             uint32_t workerCount)
+{
+    m_device = device;
+    m_pipelineCache = pipelineCache;    // VkPipelineCache is internally synchronized: workers can share it
+    m_assetArchive = assetArchive;      // Read-only once opened: workers can share it
+    m_shaderCompiler = shaderCompiler;  // compile() is thread safe: workers can share it
+    m_layoutCache = layoutCache;        // getPipelineLayoutInfo() is thread safe: workers can share it
+    m_backend = backend;
+    m_stopping = false;
+
+    // The device must have VK_EXT_shader_object (and its shaderObject feature) enabled
+    if (m_backend == PipelineBackend::ShaderObjects)
+    {
+        loadDeviceFunction(device, "vkCreateShadersEXT", &m_shaderObjects.createShaders);
+        loadDeviceFunction(device, "vkDestroyShaderEXT", &m_shaderObjects.destroyShader);
+        loadDeviceFunction(device, "vkCmdBindShadersEXT", &m_shaderObjects.cmdBindShaders);
+        loadDeviceFunction(device, "vkCmdSetViewportWithCountEXT", &m_shaderObjects.cmdSetViewportWithCount);
+        loadDeviceFunction(device, "vkCmdSetScissorWithCountEXT", &m_shaderObjects.cmdSetScissorWithCount);
+        loadDeviceFunction(device, "vkCmdSetVertexInputEXT", &m_shaderObjects.cmdSetVertexInput);
+        loadDeviceFunction(device, "vkCmdSetPrimitiveTopologyEXT", &m_shaderObjects.cmdSetPrimitiveTopology);
+        loadDeviceFunction(device, "vkCmdSetPrimitiveRestartEnableEXT", &m_shaderObjects.cmdSetPrimitiveRestartEnable);
+        loadDeviceFunction(device, "vkCmdSetRasterizerDiscardEnableEXT", &m_shaderObjects.cmdSetRasterizerDiscardEnable);
+        loadDeviceFunction(device, "vkCmdSetPolygonModeEXT", &m_shaderObjects.cmdSetPolygonMode);
+        loadDeviceFunction(device, "vkCmdSetCullModeEXT", &m_shaderObjects.cmdSetCullMode);
+        loadDeviceFunction(device, "vkCmdSetFrontFaceEXT", &m_shaderObjects.cmdSetFrontFace);
+        loadDeviceFunction(device, "vkCmdSetDepthBiasEnableEXT", &m_shaderObjects.cmdSetDepthBiasEnable);
+        loadDeviceFunction(device, "vkCmdSetRasterizationSamplesEXT", &m_shaderObjects.cmdSetRasterizationSamples);
+        loadDeviceFunction(device, "vkCmdSetSampleMaskEXT", &m_shaderObjects.cmdSetSampleMask);
+        loadDeviceFunction(device, "vkCmdSetAlphaToCoverageEnableEXT", &m_shaderObjects.cmdSetAlphaToCoverageEnable);
+        loadDeviceFunction(device, "vkCmdSetColorBlendEnableEXT", &m_shaderObjects.cmdSetColorBlendEnable);
+        loadDeviceFunction(device, "vkCmdSetColorBlendEquationEXT", &m_shaderObjects.cmdSetColorBlendEquation);
+        loadDeviceFunction(device, "vkCmdSetColorWriteMaskEXT", &m_shaderObjects.cmdSetColorWriteMask);
+        loadDeviceFunction(device, "vkCmdSetDepthTestEnableEXT", &m_shaderObjects.cmdSetDepthTestEnable);
+        loadDeviceFunction(device, "vkCmdSetDepthWriteEnableEXT", &m_shaderObjects.cmdSetDepthWriteEnable);
+        loadDeviceFunction(device, "vkCmdSetDepthCompareOpEXT", &m_shaderObjects.cmdSetDepthCompareOp);
+        loadDeviceFunction(device, "vkCmdSetStencilTestEnableEXT", &m_shaderObjects.cmdSetStencilTestEnable);
+    }
+
+    // Leave one core to the render thread
+    if (workerCount == 0)
+    {
+        uint32_t cores = std::thread::hardware_concurrency();
+        workerCount = std::clamp(cores > 1 ? cores - 1 : 1U, 1U, MAX_PIPELINE_WORKERS);
+    }
+
+    for (uint32_t i = 0; i < workerCount; ++i)
+    {
+        m_workers.emplace_back(&PipelineManager::workerLoop, this);
+    }
+}
+//------------------------------------------------------------------------------
+void PipelineManager::destroy()
+{
+    // Stop the workers (queued compilations are dropped, running ones complete)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+        m_jobs.clear();
+        m_reloadJobs.clear();
+    }
+    m_jobAvailable.notify_all();
+    for (auto &worker : m_workers)
+    {
+        worker.join();
+    }
+    m_workers.clear();
+
+    // Destroy all the Pipelines (and the reloaded ones never swapped in)
+    for (auto &pipeline : m_pipelines)
+    {
+        destroyObjects(pipeline.second->objects);
+        destroyObjects(pipeline.second->reloaded);
+    }
+    m_pipelines.clear();
+    m_looseShaders.clear();
+}
+//------------------------------------------------------------------------------
+bool PipelineManager::bind(VkCommandBuffer commandBuffer, const PipelineDesc &desc)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    // Not ready (yet): use a compatible variant for this frame
+    PipelineDesc entryDesc = getEntryDesc(desc);
+    PipelineEntry * entry = findOrQueue(entryDesc);
+    const PipelineObjects * objects = (entry->state == PipelineState::Ready) ? &entry->objects : findCompatible(entryDesc);
+    if (objects == nullptr)
+    {
+        return false;
+    }
+
+    if (m_backend == PipelineBackend::ShaderObjects)
+    {
+        recordShaderObjectState(commandBuffer, desc, *objects);
+    }
+    else
+    {
+        vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, objects->pipeline);
+    }
+    return true;
+}
+//------------------------------------------------------------------------------
+void PipelineManager::setViewport(VkCommandBuffer commandBuffer, const VkViewport &viewport, const VkRect2D &scissor)
+{
+    // Shader objects have no viewport state at all: the viewport count is dynamic too
+    if (m_backend == PipelineBackend::ShaderObjects)
+    {
+        m_shaderObjects.cmdSetViewportWithCount(commandBuffer, 1, &viewport);
+        m_shaderObjects.cmdSetScissorWithCount(commandBuffer, 1, &scissor);
+        return;
+    }
+    vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+    vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
+}
+//------------------------------------------------------------------------------
+void PipelineManager::requirePipeline(const PipelineDesc &desc)
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+
+    PipelineDesc entryDesc = getEntryDesc(desc);
+    PipelineEntry * entry = findOrQueue(entryDesc);
+    while (entry->state == PipelineState::Pending)
+    {
+        // If no worker picked it up yet, compile it right here instead of waiting in the queue
+        auto job = std::find(m_jobs.begin(), m_jobs.end(), entryDesc);
+        if (job != m_jobs.end())
+        {
+            m_jobs.erase(job);
+            lock.unlock();
+            PipelineObjects objects = compilePipeline(entryDesc);
+            lock.lock();
+
+            completePipeline(entry, std::move(objects));
+            m_jobDone.notify_all();
+        }
+        else
+        {
+            m_jobDone.wait(lock);
+        }
+    }
+
+    if (entry->state == PipelineState::Failed)
+    {
+        throw std::runtime_error("Failed to create a Graphics Pipeline! ('" + desc.vertexShader + "', '" + desc.fragmentShader + "')");
+    }
+}
+//------------------------------------------------------------------------------
+void PipelineManager::prepare(const PipelineDesc &desc)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    findOrQueue(getEntryDesc(desc));
+}
+//------------------------------------------------------------------------------
+bool PipelineManager::isReady(const PipelineDesc &desc)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    auto pipeline = m_pipelines.find(getEntryDesc(desc));
+    return pipeline != m_pipelines.end() && pipeline->second->state == PipelineState::Ready;
+}
+//------------------------------------------------------------------------------
+void PipelineManager::reloadShader(const std::string &filePath)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    // The loose file is the modified one (the archive still has the cooked version)
+    m_looseShaders.insert(filePath);
+
+    // Queued variants are compiled from the new file anyway, the ones being compiled may have read the old one
+    for (const auto &pipeline : m_pipelines)
+    {
+        const PipelineDesc &desc = pipeline.first;
+        bool queued = pipeline.second->state == PipelineState::Pending
+                   && std::find(m_jobs.begin(), m_jobs.end(), desc) != m_jobs.end();
+        if (    !queued
+            &&  (desc.vertexShader == filePath || desc.fragmentShader == filePath)
+            &&  std::find(m_reloadJobs.begin(), m_reloadJobs.end(), desc) == m_reloadJobs.end())
+        {
+            m_reloadJobs.push_back(desc);
+        }
+    }
+    m_jobAvailable.notify_all();
+}
+//------------------------------------------------------------------------------
+std::vector<PipelineObjects> PipelineManager::applyReloads()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    // Frames in flight may still use the replaced pipelines: the caller destroys them once they are done
+    std::vector<PipelineObjects> replaced;
+    for (auto &pipeline : m_pipelines)
+    {
+        PipelineEntry * entry = pipeline.second.get();
+        if (!entry->reloaded.isValid())
+        {
+            continue;
+        }
+        if (entry->objects.isValid())
+        {
+            replaced.push_back(std::move(entry->objects));
+        }
+        entry->objects = std::move(entry->reloaded);
+        entry->state = PipelineState::Ready;        // Failed variants get a second chance with every change
+        entry->reloaded = PipelineObjects();
+    }
+
+    return replaced;
+}
+//------------------------------------------------------------------------------
+void PipelineManager::destroyObjects(const PipelineObjects &objects)
+{
+    if (objects.pipeline != 0)
+    {
+        vkDestroyPipeline(m_device, objects.pipeline, nullptr);
+    }
+    if (objects.fragmentShader != 0)
+    {
+        m_shaderObjects.destroyShader(m_device, objects.fragmentShader, nullptr);
+    }
+    if (objects.vertexShader != 0)
+    {
+        m_shaderObjects.destroyShader(m_device, objects.vertexShader, nullptr);
+    }
+}
+//------------------------------------------------------------------------------
+PipelineDesc PipelineManager::getEntryDesc(const PipelineDesc &desc) const
+{
+    if (m_backend != PipelineBackend::ShaderObjects)
+    {
+        return desc;
+    }
+
+    // Shader objects only depend on the program: the fixed-function state is set when recording, and they're not tied
+    // to a render pass (the layout stays, as its set layouts and push constants are baked in)
+    PipelineDesc program = desc;
+    PipelineDesc defaults;
+    program.topology = defaults.topology;
+    program.cullMode = defaults.cullMode;
+    program.blendEnable = defaults.blendEnable;
+    program.depthTestEnable = defaults.depthTestEnable;
+    program.depthWriteEnable = defaults.depthWriteEnable;
+    program.depthCompareOp = defaults.depthCompareOp;
+    program.renderPass = defaults.renderPass;
+    program.subpass = defaults.subpass;
+    return program;
+}
+//------------------------------------------------------------------------------
+PipelineManager::PipelineEntry * PipelineManager::findOrQueue(const PipelineDesc &desc)
+{
+    auto pipeline = m_pipelines.find(desc);
+    if (pipeline != m_pipelines.end())
+    {
+        return pipeline->second.get();
+    }
+
+    // Unknown variant: register it and queue its compilation
+    PipelineEntry * entry = m_pipelines.emplace(desc, std::make_unique<PipelineEntry>()).first->second.get();
+    m_jobs.push_back(desc);
+    m_jobAvailable.notify_one();
+
+    return entry;
+}
+//------------------------------------------------------------------------------
+const PipelineObjects * PipelineManager::findCompatible(const PipelineDesc &desc)
+{
+    const PipelineObjects * bestObjects = nullptr;
+    int                     bestScore = -1;
+
+    for (const auto &pipeline : m_pipelines)
+    {
+        const PipelineDesc &candidate = pipeline.first;
+        if (pipeline.second->state != PipelineState::Ready)
+        {
+            continue;
+        }
+
+        // Must be usable in place of the requested one: same render pass/subpass, layout, vertex stream and primitives
+        if (    candidate.renderPass != desc.renderPass || candidate.subpass != desc.subpass
+            ||  candidate.layout != desc.layout || candidate.vertexLayout != desc.vertexLayout
+            ||  candidate.topology != desc.topology || candidate.colourAttachmentCount != desc.colourAttachmentCount)
+        {
+            continue;
+        }
+
+        // Prefer what looks closest: same shaders (another specialization of them draws closest), then same depth
+        // behavior, then same blending
+        int score = 0;
+        score += (candidate.vertexShader == desc.vertexShader && candidate.fragmentShader == desc.fragmentShader
+                  && candidate.shaderDefines == desc.shaderDefines) ? 8 : 0;
+        score += (candidate.depthCompareOp == desc.depthCompareOp && candidate.depthWriteEnable == desc.depthWriteEnable) ? 4 : 0;
+        score += (candidate.blendEnable == desc.blendEnable) ? 2 : 0;
+        score += (candidate.cullMode == desc.cullMode) ? 1 : 0;
+        if (score > bestScore)
+        {
+            bestScore = score;
+            bestObjects = &pipeline.second->objects;
+        }
+    }
+
+    return bestObjects;
+}
+//------------------------------------------------------------------------------
+void PipelineManager::recordShaderObjectState(VkCommandBuffer commandBuffer, const PipelineDesc &desc, const PipelineObjects &objects)
+{
+    // Shaders of the graphics stages the device has (no fragment shader: depth-only)
+    const std::array<VkShaderStageFlagBits, 2> stages = { VK_SHADER_STAGE_VERTEX_BIT, VK_SHADER_STAGE_FRAGMENT_BIT };
+    const std::array<VkShaderEXT, 2> shaders = { objects.vertexShader, objects.fragmentShader };
+    m_shaderObjects.cmdBindShaders(commandBuffer, static_cast<uint32_t>(stages.size()), stages.data(), shaders.data());
+
+    // Everything a pipeline would have baked in (same state as compilePipeline)
+    // -- VERTEX INPUT --
+    VkVertexInputBindingDescription2EXT bindingDescription = {};
+    bindingDescription.sType = VK_STRUCTURE_TYPE_VERTEX_INPUT_BINDING_DESCRIPTION_2_EXT;
+    bindingDescription.binding = 0;
+    bindingDescription.stride = getVertexStride(desc.vertexLayout);
+    bindingDescription.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+    bindingDescription.divisor = 1;
+    m_shaderObjects.cmdSetVertexInput(commandBuffer, 1, &bindingDescription,
+        static_cast<uint32_t>(objects.vertexAttributes.size()), objects.vertexAttributes.data());
+
+    // -- INPUT ASSEMBLY --
+    m_shaderObjects.cmdSetPrimitiveTopology(commandBuffer, desc.topology);
+    m_shaderObjects.cmdSetPrimitiveRestartEnable(commandBuffer, VK_FALSE);
+
+    // -- RASTERIZER --
+    m_shaderObjects.cmdSetRasterizerDiscardEnable(commandBuffer, VK_FALSE);
+    m_shaderObjects.cmdSetPolygonMode(commandBuffer, VK_POLYGON_MODE_FILL);
+    m_shaderObjects.cmdSetCullMode(commandBuffer, desc.cullMode);
+    m_shaderObjects.cmdSetFrontFace(commandBuffer, VK_FRONT_FACE_COUNTER_CLOCKWISE);
+    m_shaderObjects.cmdSetDepthBiasEnable(commandBuffer, VK_FALSE);
+
+    // -- MULTISAMPLING --
+    VkSampleMask sampleMask = 0xFFFFFFFF;
+    m_shaderObjects.cmdSetRasterizationSamples(commandBuffer, VK_SAMPLE_COUNT_1_BIT);
+    m_shaderObjects.cmdSetSampleMask(commandBuffer, VK_SAMPLE_COUNT_1_BIT, &sampleMask);
+    m_shaderObjects.cmdSetAlphaToCoverageEnable(commandBuffer, VK_FALSE);
+
+    // -- BLENDING --
+    // Same state for every colour attachment bound (of the subpass, or of the dynamic rendering instance: depth-only
+    // programs there leave them untouched)
+    if (desc.colourAttachmentCount > 0)
+    {
+        VkColorBlendEquationEXT blendEquation = {};
+        blendEquation.srcColorBlendFactor = VK_BLEND_FACTOR_SRC_ALPHA;
+        blendEquation.dstColorBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+        blendEquation.colorBlendOp = VK_BLEND_OP_ADD;
+        blendEquation.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
+        blendEquation.dstAlphaBlendFactor = VK_BLEND_FACTOR_ZERO;
+        blendEquation.alphaBlendOp = VK_BLEND_OP_ADD;
+
+        std::vector<VkBool32> blendEnables(desc.colourAttachmentCount, desc.blendEnable ? VK_TRUE : VK_FALSE);
+        std::vector<VkColorBlendEquationEXT> blendEquations(desc.colourAttachmentCount, blendEquation);
+        std::vector<VkColorComponentFlags> writeMasks(desc.colourAttachmentCount, (objects.fragmentShader == 0) ? 0 :
+            VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT);
+        m_shaderObjects.cmdSetColorBlendEnable(commandBuffer, 0, desc.colourAttachmentCount, blendEnables.data());
+        m_shaderObjects.cmdSetColorBlendEquation(commandBuffer, 0, desc.colourAttachmentCount, blendEquations.data());
+        m_shaderObjects.cmdSetColorWriteMask(commandBuffer, 0, desc.colourAttachmentCount, writeMasks.data());
+    }
+
+    // -- DEPTH STENCIL TESTING --
+    m_shaderObjects.cmdSetDepthTestEnable(commandBuffer, desc.depthTestEnable ? VK_TRUE : VK_FALSE);
+    m_shaderObjects.cmdSetDepthWriteEnable(commandBuffer, desc.depthWriteEnable ? VK_TRUE : VK_FALSE);
+    m_shaderObjects.cmdSetDepthCompareOp(commandBuffer, desc.depthCompareOp);
+    m_shaderObjects.cmdSetStencilTestEnable(commandBuffer, VK_FALSE);
+}
+//------------------------------------------------------------------------------
+void PipelineManager::workerLoop()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+
+    while (true)
+    {
+        m_jobAvailable.wait(lock, [this]() { return m_stopping || !m_jobs.empty() || !m_reloadJobs.empty(); });
+        if (m_stopping)
+        {
+            return;
+        }
+
+        bool reload = m_jobs.empty();
+        std::deque<PipelineDesc> &jobs = reload ? m_reloadJobs : m_jobs;
+        PipelineDesc desc = jobs.front();
+        jobs.pop_front();
+
+        // Compile without holding the lock (this is the slow part)
+        lock.unlock();
+        PipelineObjects objects = compilePipeline(desc);
+        lock.lock();
+
+        PipelineEntry * entry = m_pipelines.at(desc).get();
+        if (reload)
+        {
+            // Swapped in by applyReloads(); a failed reload keeps the current pipeline
+            if (objects.isValid())
+            {
+                destroyObjects(entry->reloaded);                        // Superseded before it was ever used
+                entry->reloaded = std::move(objects);
+            }
+            continue;
+        }
+        completePipeline(entry, std::move(objects));
+        m_jobDone.notify_all();
+    }
+}
+//------------------------------------------------------------------------------
+void PipelineManager::completePipeline(PipelineEntry * entry, PipelineObjects &&objects)
+{
+    // A reload (of a shader modified during the compilation) may have been swapped in already: it's the newer one
+    if (entry->state != PipelineState::Pending)
+    {
+        destroyObjects(objects);
+        return;
+    }
+    entry->state = objects.isValid() ? PipelineState::Ready : PipelineState::Failed;
+    entry->objects = std::move(objects);
+}
+//------------------------------------------------------------------------------
+PipelineObjects PipelineManager::compilePipeline(const PipelineDesc &desc)
+{
+    // SPIR-V code of the shaders: mapped (from the asset archive if they're packed there, from their files otherwise),
+    // or compiled from their GLSL sources
+    // Vertex attributes are reflected from the vertex shader inputs: tightly packed in location order, they must fill
+    // exactly a vertex of the stream (e.g. pos, col, tex of Utilities::Vertex)
+    SpirvCode vertexShaderCode;
+    SpirvCode fragmentShaderCode;
+    ShaderReflection vertexInterface;
+    try
+    {
+        loadShader(desc.vertexShader, desc, &vertexShaderCode);
+        if (!desc.fragmentShader.empty())
+        {
+            loadShader(desc.fragmentShader, desc, &fragmentShaderCode);
+        }
+
+        vertexInterface.reflect(vertexShaderCode, desc.vertexShader);
+        uint32_t vertexSize = 0;
+        for (const ShaderVertexInput &input : vertexInterface.vertexInputs)
+        {
+            vertexSize += input.size;
+        }
+        if (vertexSize != getVertexStride(desc.vertexLayout))
+        {
+            throw std::runtime_error("Vertex inputs of '" + desc.vertexShader + "' don't match the layout of the vertex stream!");
+        }
+    }
+    catch (const std::runtime_error &e)
+    {
+        cout << "ERROR: " << e.what() << endl;
+        return PipelineObjects();
+    }
+
+    // Specialization constants (4 bytes each, constant_id i at offset 4 * i): the same for both stages, as a stage
+    // ignores the IDs its module doesn't declare. Drivers fold them while compiling, pruning the disabled features.
+    std::vector<VkSpecializationMapEntry> specializationEntries(desc.specializationConstants.size());
+    for (uint32_t i = 0; i < static_cast<uint32_t>(specializationEntries.size()); ++i)
+    {
+        specializationEntries[i].constantID = i;
+        specializationEntries[i].offset = i * sizeof(uint32_t);
+        specializationEntries[i].size = sizeof(uint32_t);                   // Also the size of a bool constant (VkBool32)
+    }
+
+    VkSpecializationInfo specializationInfo = {};
+    specializationInfo.mapEntryCount = static_cast<uint32_t>(specializationEntries.size());
+    specializationInfo.pMapEntries = specializationEntries.data();
+    specializationInfo.dataSize = desc.specializationConstants.size() * sizeof(uint32_t);
+    specializationInfo.pData = desc.specializationConstants.data();
+    const VkSpecializationInfo * pSpecializationInfo = specializationEntries.empty() ? nullptr : &specializationInfo;
+
+    if (m_backend == PipelineBackend::ShaderObjects)
+    {
+        return createShaderObjects(desc, vertexShaderCode, fragmentShaderCode, pSpecializationInfo, vertexInterface);
+    }
+
+    // |A| Create Shader Modules (ALWAYS keep sure to destroy them to avoid memory leaks)
+    VkShaderModule vertexShaderModule = createShaderModule(vertexShaderCode);
+    VkShaderModule fragmentShaderModule = desc.fragmentShader.empty() ? VK_NULL_HANDLE : createShaderModule(fragmentShaderCode);
+    if (vertexShaderModule == VK_NULL_HANDLE || (!desc.fragmentShader.empty() && fragmentShaderModule == VK_NULL_HANDLE))
+    {
+        if (fragmentShaderModule != VK_NULL_HANDLE)
+        {
+            vkDestroyShaderModule(m_device, fragmentShaderModule, nullptr);
+        }
+        if (vertexShaderModule != VK_NULL_HANDLE)
+        {
+            vkDestroyShaderModule(m_device, vertexShaderModule, nullptr);
+        }
+        return PipelineObjects();
+    }
+
+    // -- SHADER STAGE CREATION INFORMATION --
+    std::vector<VkPipelineShaderStageCreateInfo> shaderStages;
+
+    // Vertex Stage creation information
+    VkPipelineShaderStageCreateInfo vertexShaderCreateInfo = {};
+    vertexShaderCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    vertexShaderCreateInfo.stage = VK_SHADER_STAGE_VERTEX_BIT;          // Shader Stage name
+    vertexShaderCreateInfo.module = vertexShaderModule;                 // Shader module to be used by stage
+    vertexShaderCreateInfo.pName = "main";                              // Entry point function name (in the shader)
+    vertexShaderCreateInfo.pSpecializationInfo = pSpecializationInfo;   // Values of its specialization constants
+    shaderStages.push_back(vertexShaderCreateInfo);
+
+    // Fragment Stage creation information (optional, e.g. depth-only pipelines don't have it)
+    if (fragmentShaderModule != VK_NULL_HANDLE)
+    {
+        VkPipelineShaderStageCreateInfo fragmentShaderCreateInfo = {};
+        fragmentShaderCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+        fragmentShaderCreateInfo.stage = VK_SHADER_STAGE_FRAGMENT_BIT;  // Shader Stage name
+        fragmentShaderCreateInfo.module = fragmentShaderModule;         // Shader module to be used by stage
+        fragmentShaderCreateInfo.pName = "main";                        // Entry point function name (in the shader)
+        fragmentShaderCreateInfo.pSpecializationInfo = pSpecializationInfo;
+        shaderStages.push_back(fragmentShaderCreateInfo);
+    }
+
+    // -- VERTEX INPUT --
+    // Vertex binding description (including info such as position, colour, texture coords, normals, etc) as a whole
+    VkVertexInputBindingDescription bindingDescription = {};
+    bindingDescription.binding = 0;                                 // Can bind multiple streams of data, this defines which one
+    bindingDescription.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;     // How to move between data after each vertex.
+                                                                    // VK_VERTEX_INPUT_RATE_INDEX        : Move on to the next vertex
+                                                                    // VK_VERTEX_INPUT_RATE_INSTANCE    : Move to a vertex for the next instance
+
+    bindingDescription.stride = getVertexStride(desc.vertexLayout); // Size of a single vertex object
+
+    // How the data for an attribute is defined within a vertex (reflected from the shader inputs)
+    std::vector<VkVertexInputAttributeDescription> attributeDescriptions;
+    uint32_t attributeOffset = 0;
+    for (const ShaderVertexInput &input : vertexInterface.vertexInputs)
+    {
+        VkVertexInputAttributeDescription attributeDescription = {};
+        attributeDescription.binding = 0;                           // Which binding the data is at (should be same as above)
+        attributeDescription.location = input.location;             // Location in shader where data will be read from
+        attributeDescription.format = input.format;                 // Format the data will take (also helps define size of data)
+        attributeDescription.offset = attributeOffset;              // Where this attribute is defined in the data for a single vertex
+        attributeDescriptions.push_back(attributeDescription);
+        attributeOffset += input.size;
+    }
+
+    VkPipelineVertexInputStateCreateInfo vertexInputCreateInfo = {};
+    vertexInputCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+    vertexInputCreateInfo.vertexBindingDescriptionCount = 1;
+    vertexInputCreateInfo.pVertexBindingDescriptions = &bindingDescription;             // List of Vertex Binding Descriptions (data spacing/stride information)
+    vertexInputCreateInfo.vertexAttributeDescriptionCount = static_cast<uint32_t>(attributeDescriptions.size());
+    vertexInputCreateInfo.pVertexAttributeDescriptions = attributeDescriptions.data();  // List of Vertex Attribute Descriptions (data format and where to bind to/from)
+
+    // -- INPUT ASSEMBLY --
+    VkPipelineInputAssemblyStateCreateInfo inputAssembly = {};
+    inputAssembly.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
+    inputAssembly.topology = desc.topology;                         // Primitive type to assemble vertices as
+    inputAssembly.primitiveRestartEnable = VK_FALSE;                // Allow overriding of "strip" topology to start new primitives
+
+    // -- VIEWPORT & SCISSOR --
+    // Viewport State info struct (the actual Viewport and Scissor are dynamic, see below)
+    VkPipelineViewportStateCreateInfo viewportStateCreateInfo = {};
+    viewportStateCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
+    viewportStateCreateInfo.viewportCount = 1;
+    viewportStateCreateInfo.pViewports = nullptr;                   // Ignored: dynamic state
+    viewportStateCreateInfo.scissorCount = 1;
+    viewportStateCreateInfo.pScissors = nullptr;                    // Ignored: dynamic state
+
+    // -- DYNAMIC VIEWPORT STATES --
+    // Dynamic states to enable resizing without re-creating the pipelines (only the SwapChain and its attachments are re-created)
+    std::array<VkDynamicState, 2> dynamicStateEnables = {
+        VK_DYNAMIC_STATE_VIEWPORT,  // Dynamic Viewport : Can resize in command buffer with vkCmdSetViewport(commandbuffer, 0, 1, &viewport);
+        VK_DYNAMIC_STATE_SCISSOR    // Dynamic Scissor  : Can resize in command buffer with vkCmdSetScissor(commandbuffer, 0, 1, &scissor);
+    };
+
+    // Dynamic State creation info
+    VkPipelineDynamicStateCreateInfo dynamicStateCreateInfo = {};
+    dynamicStateCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
+    dynamicStateCreateInfo.dynamicStateCount = static_cast<uint32_t>(dynamicStateEnables.size());
+    dynamicStateCreateInfo.pDynamicStates = dynamicStateEnables.data();
+
+    // -- RASTERIZER --
+    VkPipelineRasterizationStateCreateInfo rasterizerCreateInfo = {};
+    rasterizerCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
+    rasterizerCreateInfo.depthClampEnable = VK_FALSE;                   // Change if fragments beyond near/far planes are clipped (default) or clamped to plane
+    rasterizerCreateInfo.rasterizerDiscardEnable = VK_FALSE;            // Whether to discard data and skip rasterizer. Never creates fragments, only suitable for pipeline without framebuffer output
+    rasterizerCreateInfo.polygonMode = VK_POLYGON_MODE_FILL;            // How to handle filling points between vertices (if not fill, check for the feature needed for that)
+    rasterizerCreateInfo.lineWidth = 1.0f;                              // How thick lines should be when drawn
+    rasterizerCreateInfo.cullMode = desc.cullMode;                      // Which face of a triangle to cull
+    rasterizerCreateInfo.frontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE;   // Winding to determine which side is front
+    rasterizerCreateInfo.depthBiasEnable = VK_FALSE;                    // Whether to add depth bias to fragments (good for stopping "shadow acne" in shadow mapping)
+
+    // -- MULTISAMPLING --
+    VkPipelineMultisampleStateCreateInfo multisamplingCreateInfo = {};
+    multisamplingCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
+    multisamplingCreateInfo.sampleShadingEnable = VK_FALSE;                 // Enable multisample shading or not
+    multisamplingCreateInfo.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;   // Number of samples to use per fragment
+
+    // -- BLENDING --
+    // Blending decides how to blend a new colour being written to a fragment, with the old value
+
+    // Blend Attachment State (how blending is handled)
+    VkPipelineColorBlendAttachmentState colourState = {};
+    colourState.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT    // Colours to apply blending to
+        | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
+    colourState.blendEnable = desc.blendEnable ? VK_TRUE : VK_FALSE;                    // Enable blending (opaque geometry shouldn't pay for it)
+
+    // Blending uses equation: (srcColorBlendFactor * new colour) colorBlendOp (dstColorBlendFactor * old colour)
+    colourState.srcColorBlendFactor = VK_BLEND_FACTOR_SRC_ALPHA;
+    colourState.dstColorBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+    colourState.colorBlendOp = VK_BLEND_OP_ADD;
+    // Summarised: (VK_BLEND_FACTOR_SRC_ALPHA * new colour) + (VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA * old colour)
+    //                      (new colour alpha * new colour) + ((1 - new colour alpha) * old colour)
+
+    colourState.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
+    colourState.dstAlphaBlendFactor = VK_BLEND_FACTOR_ZERO;
+    colourState.alphaBlendOp = VK_BLEND_OP_ADD;
+    // Summarised: (1 * new alpha) + (0 * old alpha) = new alpha
+
+    // Same state for every colour attachment of the subpass (none for depth-only subpasses)
+    std::vector<VkPipelineColorBlendAttachmentState> colourStates(desc.colourAttachmentCount, colourState);
+
+    VkPipelineColorBlendStateCreateInfo colourBlendingCreateInfo = {};
+    colourBlendingCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
+    colourBlendingCreateInfo.logicOpEnable = VK_FALSE;      // Alternative to calculations (colourState) is to use logical operations
+    colourBlendingCreateInfo.attachmentCount = static_cast<uint32_t>(colourStates.size());
+    colourBlendingCreateInfo.pAttachments = colourStates.data();
+
+    // -- DEPTH STENCIL TESTING --
+    VkPipelineDepthStencilStateCreateInfo depthStencilCreateInfo = {};
+    depthStencilCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
+    depthStencilCreateInfo.depthTestEnable = desc.depthTestEnable ? VK_TRUE : VK_FALSE;    // Enable checking depth to determine fragment write
+    depthStencilCreateInfo.depthWriteEnable = desc.depthWriteEnable ? VK_TRUE : VK_FALSE;  // Enable writing to depth buffer (to replace old values)
+    depthStencilCreateInfo.depthCompareOp = desc.depthCompareOp;                            // Comparison operation that allows an overwrite (if it's in front)
+    depthStencilCreateInfo.depthBoundsTestEnable = VK_FALSE;                                // Depth Bounds Test: Does the depth value exist between two bounds
+    depthStencilCreateInfo.stencilTestEnable = VK_FALSE;                                    // Enable Stencil test
+
+    // -- GRAPHICS PIPELINE CREATION --
+    VkGraphicsPipelineCreateInfo pipelineCreateInfo = {};
+    pipelineCreateInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+    pipelineCreateInfo.stageCount = static_cast<uint32_t>(shaderStages.size());    // Number of shader stages
+    pipelineCreateInfo.pStages = shaderStages.data();                               // List of shader stages
+    pipelineCreateInfo.pVertexInputState = &vertexInputCreateInfo;                  // All the fixed function pipeline states
+    pipelineCreateInfo.pInputAssemblyState = &inputAssembly;
+    pipelineCreateInfo.pViewportState = &viewportStateCreateInfo;
+    pipelineCreateInfo.pDynamicState = &dynamicStateCreateInfo;
+    pipelineCreateInfo.pRasterizationState = &rasterizerCreateInfo;
+    pipelineCreateInfo.pMultisampleState = &multisamplingCreateInfo;
+    pipelineCreateInfo.pColorBlendState = &colourBlendingCreateInfo;
+    pipelineCreateInfo.pDepthStencilState = &depthStencilCreateInfo;
+    pipelineCreateInfo.layout = desc.layout;                                        // Pipeline Layout pipeline should use
+    pipelineCreateInfo.renderPass = desc.renderPass;                                // Render pass the pipeline is compatible with
+    pipelineCreateInfo.subpass = desc.subpass;                                      // Subpass index of render pass to use with pipeline
+
+    // Pipeline Derivatives: can create multiple pipelines that derive from one another for optimisation
+    pipelineCreateInfo.basePipelineHandle = VK_NULL_HANDLE;             // Existing pipeline to derive from...
+    pipelineCreateInfo.basePipelineIndex = -1;                          // or index of pipeline being created to derive from (in case creating multiple at once)
+
+    // Create Graphics Pipeline
+    VkPipeline pipeline = VK_NULL_HANDLE;
+    VkResult result = vkCreateGraphicsPipelines(m_device, m_pipelineCache, 1, &pipelineCreateInfo, nullptr, &pipeline);
+    if (result != VK_SUCCESS)
+    {
+        cout << "ERROR: Failed to create a Graphics Pipeline! ('" << desc.vertexShader << "', '" << desc.fragmentShader << "')" << endl;
+        pipeline = VK_NULL_HANDLE;
+    }
+
+    // |B| Destroy Shader Modules, no longer needed after the Pipeline is created
+    if (fragmentShaderModule != VK_NULL_HANDLE)
+    {
+        vkDestroyShaderModule(m_device, fragmentShaderModule, nullptr);
+    }
+    vkDestroyShaderModule(m_device, vertexShaderModule, nullptr);
+
+    PipelineObjects objects;
+    objects.pipeline = pipeline;
+    return objects;
+}
+//------------------------------------------------------------------------------
+PipelineObjects PipelineManager::createShaderObjects(const PipelineDesc &desc, const SpirvCode &vertexShaderCode,
+                                                     const SpirvCode &fragmentShaderCode, const VkSpecializationInfo * specializationInfo,
+                                                     const ShaderReflection &vertexInterface)
+{
+    PipelineObjects objects;
+
+    // Shader objects take the set layouts and push constant range of the layout (there's no pipeline to hold it)
+    PipelineLayoutInfo layoutInfo;
+    try
+    {
+        layoutInfo = m_layoutCache->getPipelineLayoutInfo(desc.layout);
+    }
+    catch (const std::runtime_error &e)
+    {
+        cout << "ERROR: " << e.what() << endl;
+        return objects;
+    }
+
+    // Both stages are created together and linked, so the driver optimizes across them as it does for a pipeline
+    bool hasFragmentStage = !desc.fragmentShader.empty();
+
+    VkShaderCreateInfoEXT shaderCreateInfo = {};
+    shaderCreateInfo.sType = VK_STRUCTURE_TYPE_SHADER_CREATE_INFO_EXT;
+    shaderCreateInfo.flags = hasFragmentStage ? VK_SHADER_CREATE_LINK_STAGE_BIT_EXT : 0;
+    shaderCreateInfo.codeType = VK_SHADER_CODE_TYPE_SPIRV_EXT;
+    shaderCreateInfo.pName = "main";                                    // Entry point function name (in the shader)
+    shaderCreateInfo.setLayoutCount = static_cast<uint32_t>(layoutInfo.setLayouts.size());
+    shaderCreateInfo.pSetLayouts = layoutInfo.setLayouts.data();
+    shaderCreateInfo.pushConstantRangeCount = layoutInfo.pushConstantRange.size != 0 ? 1 : 0;
+    shaderCreateInfo.pPushConstantRanges = &layoutInfo.pushConstantRange;
+    shaderCreateInfo.pSpecializationInfo = specializationInfo;          // Values of its specialization constants
+
+    std::array<VkShaderCreateInfoEXT, 2> shaderCreateInfos = { shaderCreateInfo, shaderCreateInfo };
+    shaderCreateInfos[0].stage = VK_SHADER_STAGE_VERTEX_BIT;
+    shaderCreateInfos[0].nextStage = hasFragmentStage ? VK_SHADER_STAGE_FRAGMENT_BIT : 0;
+    shaderCreateInfos[0].codeSize = vertexShaderCode.getSize();
+    shaderCreateInfos[0].pCode = vertexShaderCode.getWords();
+    shaderCreateInfos[1].stage = VK_SHADER_STAGE_FRAGMENT_BIT;
+    shaderCreateInfos[1].nextStage = 0;
+    shaderCreateInfos[1].codeSize = fragmentShaderCode.getSize();
+    shaderCreateInfos[1].pCode = fragmentShaderCode.getWords();
+
+    std::array<VkShaderEXT, 2> shaders = {};
+    uint32_t shaderCount = hasFragmentStage ? 2 : 1;
+    VkResult result = m_shaderObjects.createShaders(m_device, shaderCount, shaderCreateInfos.data(), nullptr, shaders.data());
+    if (result != VK_SUCCESS)
+    {
+        // Some of them may have been created anyway
+        for (VkShaderEXT shader : shaders)
+        {
+            if (shader != VK_NULL_HANDLE)
+            {
+                m_shaderObjects.destroyShader(m_device, shader, nullptr);
+            }
+        }
+        cout << "ERROR: Failed to create Shader Objects! ('" << desc.vertexShader << "', '" << desc.fragmentShader << "')" << endl;
+        return objects;
+    }
+    objects.vertexShader = shaders[0];
+    objects.fragmentShader = shaders[1];
+
+    // How the data for an attribute is defined within a vertex (reflected from the shader inputs, tightly packed)
+    uint32_t attributeOffset = 0;
+    for (const ShaderVertexInput &input : vertexInterface.vertexInputs)
+    {
+        VkVertexInputAttributeDescription2EXT attributeDescription = {};
+        attributeDescription.sType = VK_STRUCTURE_TYPE_VERTEX_INPUT_ATTRIBUTE_DESCRIPTION_2_EXT;
+        attributeDescription.location = input.location;
+        attributeDescription.binding = 0;
+        attributeDescription.format = input.format;
+        attributeDescription.offset = attributeOffset;
+        objects.vertexAttributes.push_back(attributeDescription);
+        attributeOffset += input.size;
+    }
+
+    return objects;
+}
+//------------------------------------------------------------------------------
+void PipelineManager::loadShader(const std::string &filePath, const PipelineDesc &desc, SpirvCode * code)
+{
+    if (!ShaderCompiler::isGlslSource(filePath))
+    {
+        code->load(getShaderArchive(filePath), filePath);
+        return;
+    }
+    if (!m_shaderCompiler)
+    {
+        throw std::runtime_error("No shader compiler to compile '" + filePath + "'!");
+    }
+    code->assign(m_shaderCompiler->compile(filePath, desc.shaderDefines), filePath);
+}
+//------------------------------------------------------------------------------
+ShaderReflection PipelineManager::reflect(const PipelineDesc &desc)
+{
+    SpirvCode code;
+    ShaderReflection reflection;
+    loadShader(desc.vertexShader, desc, &code);
+    reflection.reflect(code, desc.vertexShader);
+    if (!desc.fragmentShader.empty())
+    {
+        ShaderReflection fragmentReflection;
+        loadShader(desc.fragmentShader, desc, &code);
+        fragmentReflection.reflect(code, desc.fragmentShader);
+        reflection.merge(fragmentReflection);
+    }
+    return reflection;
+}
+//------------------------------------------------------------------------------
+uint32_t PipelineManager::getVertexStride(VertexLayout vertexLayout)
+{
+    // Size of a single vertex object (position-only: see Mesh::getPositionBuffer)
+    return vertexLayout == VertexLayout::PositionOnly ? sizeof(glm::vec3) : sizeof(Vertex);
+}
+//------------------------------------------------------------------------------
+const AssetArchive * PipelineManager::getShaderArchive(const std::string &filePath)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_looseShaders.count(filePath) ? nullptr : m_assetArchive;
+}
+//------------------------------------------------------------------------------
+VkShaderModule PipelineManager::createShaderModule(const SpirvCode &code)
+{
+    // Shader Module creation information
+    VkShaderModuleCreateInfo shaderModuleCreateInfo = {};
+    shaderModuleCreateInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+    shaderModuleCreateInfo.codeSize = code.getSize();                               // Size of code
+    shaderModuleCreateInfo.pCode = code.getWords();                                 // Pointer to code (validated and 4 bytes aligned)
+
+    VkShaderModule shaderModule = VK_NULL_HANDLE;
+    VkResult result = vkCreateShaderModule(m_device, &shaderModuleCreateInfo, nullptr, &shaderModule);
+    if (result != VK_SUCCESS)
+    {
+        // No exceptions here: this runs on the worker threads
+        cout << "ERROR: Failed to create a shader module!" << endl;
+        return VK_NULL_HANDLE;
+    }
+
+    return shaderModule;
+}
@@ -0,0 +1,192 @@
+#ifndef PIPELINE_MANAGER_H
+#define PIPELINE_MANAGER_H
+
+// C++ STL
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+// Project includes
+#include "AssetArchive.h"
+#include "LayoutCache.h"
+#include "ShaderCompiler.h"
+#include "ShaderReflection.h"
+#include "SpirvCode.h"
+#include "Utilities.h"          // Utilities header includes GLFW [Graphics Library FrameWork] + Vulkan API
+
+// Vertex streams a pipeline can read
+enum class VertexLayout : uint32_t
+{
+    Full            = 0,    // Utilities::Vertex (position, colour, texture coordinates)
+    PositionOnly    = 1,    // glm::vec3 (tightly packed positions, e.g. for the depth pre-pass)
+};
+
+// How the pipeline descriptions are turned into GPU state
+enum class PipelineBackend : uint32_t
+{
+    Pipelines       = 0,    // Monolithic graphics pipelines: one per description
+    ShaderObjects   = 1,    // VK_EXT_shader_object: linked shaders per program, fixed-function state set when recording
+};
+
+// Description of a graphics pipeline: everything that makes two pipelines different is in here (and in its hash)
+struct PipelineDesc
+{
+    std::string         vertexShader;                                       // SPIR-V file (or GLSL source) of the vertex stage
+    std::string         fragmentShader;                                     // Same for the fragment stage (empty: no fragment stage)
+    std::vector<std::string>    shaderDefines;                              // Variant of the GLSL sources ("NAME" or "NAME=VALUE")
+    std::vector<uint32_t>       specializationConstants;                    // Values of constant_id 0, 1, ... (empty: shader defaults)
+    VertexLayout        vertexLayout            = VertexLayout::Full;       // Vertex stream layout
+    VkPrimitiveTopology topology                = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+    VkCullModeFlags     cullMode                = VK_CULL_MODE_BACK_BIT;
+    bool                blendEnable             = false;                    // Alpha blending (src alpha, 1 - src alpha)
+    bool                depthTestEnable         = true;
+    bool                depthWriteEnable        = true;
+    VkCompareOp         depthCompareOp          = VK_COMPARE_OP_LESS;
+    uint32_t            colourAttachmentCount   = 1;                        // Colour attachments of the subpass
+    VkPipelineLayout    layout                  = 0;
+    VkRenderPass        renderPass              = 0;
+    uint32_t            subpass                 = 0;
+
+    uint64_t    hash() const;
+    bool        operator==(const PipelineDesc &other) const;
+};
+
+// Hasher to use PipelineDesc as key of the STL unordered containers
+struct PipelineDescHasher
+{
+    size_t operator()(const PipelineDesc &desc) const { return static_cast<size_t>(desc.hash()); }
+};
+
+// What a description compiles to, depending on the backend
+struct PipelineObjects
+{
+    VkPipeline      pipeline = 0;                           // '0' instead of 'nullptr' for compatibility with 32bit version
+    VkShaderEXT     vertexShader = 0;                       // Shader objects, linked together
+    VkShaderEXT     fragmentShader = 0;                     // (none for depth-only descriptions)
+    std::vector<VkVertexInputAttributeDescription2EXT>  vertexAttributes;  // Vertex input is dynamic with shader objects
+
+    bool        isValid() const { return pipeline != 0 || vertexShader != 0; }
+};
+
+// Pipeline state cache: pipelines are created on demand from their description, and compiled on worker threads.
+// Viewport and Scissor are dynamic states (set in the command buffer), so a resize never needs new pipelines.
+// Until a variant is ready, bind() binds a compatible one that is (same render pass, subpass, layout, vertex layout
+// and topology), so the first use of a new variant never stalls the frame.
+// With the shader objects backend, only the programs (shaders, defines, specialization constants, vertex layout) are
+// compiled: culling, blending and depth state are set by bind() at record time, so a new state permutation of a known
+// program is ready right away.
+// Hot-reload: the pipelines of a modified shader are recompiled on the workers while the old ones keep drawing, and
+// swapped in at a frame boundary (a shader that doesn't compile anymore leaves the old pipelines in place).
+class PipelineManager
+{
+public:
+    PipelineManager();
+    ~PipelineManager();
+
+    void        create(VkDevice device, VkPipelineCache pipelineCache, const AssetArchive * assetArchive,
+                       ShaderCompiler * shaderCompiler, LayoutCache * layoutCache,
+                       PipelineBackend backend = PipelineBackend::Pipelines, uint32_t workerCount = 0);
+    void        destroy();
+
+    PipelineBackend getBackend() const { return m_backend; }
+
+    bool        bind(VkCommandBuffer commandBuffer, const PipelineDesc &desc);  // Never blocks: requested variant or a compatible one (false: none)
+    void        setViewport(VkCommandBuffer commandBuffer, const VkViewport &viewport, const VkRect2D &scissor);
+    void        requirePipeline(const PipelineDesc &desc);     // Blocks until the requested variant is ready
+    void        prepare(const PipelineDesc &desc);             // Queues the compilation of a variant (no-op if known)
+    bool        isReady(const PipelineDesc &desc);
+
+    void        reloadShader(const std::string &filePath);     // Recompiles its pipelines (from the loose file from now on)
+    std::vector<PipelineObjects> applyReloads();               // Swaps them in (render thread), returns the replaced ones
+    void        destroyObjects(const PipelineObjects &objects);
+
+    ShaderReflection    reflect(const PipelineDesc &desc);     // Interface of its shaders (stages merged), throws on errors
+
+private:
+    enum class PipelineState
+    {
+        Pending,
+        Ready,
+        Failed
+    };
+
+    struct PipelineEntry
+    {
+        PipelineState   state = PipelineState::Pending;
+        PipelineObjects objects;
+        PipelineObjects reloaded;                           // Recompiled, waiting for applyReloads()
+    };
+
+    // VK_EXT_shader_object commands (and the dynamic state ones it provides), loaded by create() for that backend
+    struct ShaderObjectFunctions
+    {
+        PFN_vkCreateShadersEXT                  createShaders = nullptr;
+        PFN_vkDestroyShaderEXT                  destroyShader = nullptr;
+        PFN_vkCmdBindShadersEXT                 cmdBindShaders = nullptr;
+        PFN_vkCmdSetViewportWithCountEXT        cmdSetViewportWithCount = nullptr;
+        PFN_vkCmdSetScissorWithCountEXT         cmdSetScissorWithCount = nullptr;
+        PFN_vkCmdSetVertexInputEXT              cmdSetVertexInput = nullptr;
+        PFN_vkCmdSetPrimitiveTopologyEXT        cmdSetPrimitiveTopology = nullptr;
+        PFN_vkCmdSetPrimitiveRestartEnableEXT   cmdSetPrimitiveRestartEnable = nullptr;
+        PFN_vkCmdSetRasterizerDiscardEnableEXT  cmdSetRasterizerDiscardEnable = nullptr;
+        PFN_vkCmdSetPolygonModeEXT              cmdSetPolygonMode = nullptr;
+        PFN_vkCmdSetCullModeEXT                 cmdSetCullMode = nullptr;
+        PFN_vkCmdSetFrontFaceEXT                cmdSetFrontFace = nullptr;
+        PFN_vkCmdSetDepthBiasEnableEXT          cmdSetDepthBiasEnable = nullptr;
+        PFN_vkCmdSetRasterizationSamplesEXT     cmdSetRasterizationSamples = nullptr;
+        PFN_vkCmdSetSampleMaskEXT               cmdSetSampleMask = nullptr;
+        PFN_vkCmdSetAlphaToCoverageEnableEXT    cmdSetAlphaToCoverageEnable = nullptr;
+        PFN_vkCmdSetColorBlendEnableEXT         cmdSetColorBlendEnable = nullptr;
+        PFN_vkCmdSetColorBlendEquationEXT       cmdSetColorBlendEquation = nullptr;
+        PFN_vkCmdSetColorWriteMaskEXT           cmdSetColorWriteMask = nullptr;
+        PFN_vkCmdSetDepthTestEnableEXT          cmdSetDepthTestEnable = nullptr;
+        PFN_vkCmdSetDepthWriteEnableEXT         cmdSetDepthWriteEnable = nullptr;
+        PFN_vkCmdSetDepthCompareOpEXT           cmdSetDepthCompareOp = nullptr;
+        PFN_vkCmdSetStencilTestEnableEXT        cmdSetStencilTestEnable = nullptr;
+    };
+
+    VkDevice                    m_device = nullptr;             // This is our Logical Device
+    VkPipelineCache             m_pipelineCache = 0;
+    const AssetArchive *        m_assetArchive = nullptr;       // Shaders packed in the archive (null: loose files only)
+    ShaderCompiler *            m_shaderCompiler = nullptr;     // GLSL stages (compiled at runtime, cached on disk)
+    LayoutCache *               m_layoutCache = nullptr;        // Set layouts and push constants of the shader objects
+    PipelineBackend             m_backend = PipelineBackend::Pipelines;
+    ShaderObjectFunctions       m_shaderObjects;
+
+    // Pipelines (guarded by m_mutex)
+    std::unordered_map<PipelineDesc, std::unique_ptr<PipelineEntry>, PipelineDescHasher> m_pipelines;
+
+    // Workers
+    std::mutex                  m_mutex;
+    std::condition_variable     m_jobAvailable;                 // Signaled when a compilation is queued (or on shutdown)
+    std::condition_variable     m_jobDone;                      // Signaled when a compilation finishes
+    std::deque<PipelineDesc>    m_jobs;
+    std::deque<PipelineDesc>    m_reloadJobs;                   // After the new variants (the old pipelines still draw)
+    std::unordered_set<std::string> m_looseShaders;             // Modified on disk: not read from the asset archive anymore
+    std::vector<std::thread>    m_workers;
+    bool                        m_stopping = false;
+
+    // Methods
+    PipelineDesc    getEntryDesc(const PipelineDesc &desc) const;   // What gets compiled (the program only for shader objects)
+    PipelineEntry * findOrQueue(const PipelineDesc &desc);      // Must be called with m_mutex locked
+    const PipelineObjects * findCompatible(const PipelineDesc &desc);   // Must be called with m_mutex locked
+    void            recordShaderObjectState(VkCommandBuffer commandBuffer, const PipelineDesc &desc, const PipelineObjects &objects);
+    void            workerLoop();
+    PipelineObjects compilePipeline(const PipelineDesc &desc);
+    void            completePipeline(PipelineEntry * entry, PipelineObjects &&objects);    // Must be called with m_mutex locked
+    PipelineObjects createShaderObjects(const PipelineDesc &desc, const SpirvCode &vertexShaderCode,
+                                        const SpirvCode &fragmentShaderCode, const VkSpecializationInfo * specializationInfo,
+                                        const ShaderReflection &vertexInterface);
+    void            loadShader(const std::string &filePath, const PipelineDesc &desc, SpirvCode * code);
+    const AssetArchive *    getShaderArchive(const std::string &filePath);
+    static uint32_t getVertexStride(VertexLayout vertexLayout);
+    VkShaderModule  createShaderModule(const SpirvCode &code);
+};
+
+#endif //PIPELINE_MANAGER_H
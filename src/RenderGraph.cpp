@@ -0,0 +1,1027 @@
+#include "RenderGraph.h"
+
+// C++ STL
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+
+using namespace Utilities;
+
+// Accesses that make the next use of an image wait for them (the reads only need an execution dependency)
+static const VkAccessFlags2 WRITE_ACCESS = VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT
+                                         | VK_ACCESS_2_SHADER_WRITE_BIT | VK_ACCESS_2_TRANSFER_WRITE_BIT;
+
+//------------------------------------------------------------------------------
+static bool isWrite(ImageAccess access)
+{
+    return access == ImageAccess::ColourWrite || access == ImageAccess::DepthWrite;
+}
+
+//------------------------------------------------------------------------------
+RenderGraph::RenderGraph()
+{
+}
+//------------------------------------------------------------------------------
+RenderGraph::~RenderGraph()
+{
+}
+//------------------------------------------------------------------------------
+void RenderGraph::create(VkPhysicalDevice physicalDevice, VkDevice device, bool synchronization2, bool dynamicRendering)
+{
+    m_physicalDevice = physicalDevice;
+    m_device = device;
+
+    // Extension commands: from the device (the loader doesn't export them)
+    m_cmdPipelineBarrier2 = synchronization2
+        ? reinterpret_cast<PFN_vkCmdPipelineBarrier2KHR>(vkGetDeviceProcAddr(device, "vkCmdPipelineBarrier2KHR"))
+        : nullptr;
+    m_cmdBeginRendering = dynamicRendering
+        ? reinterpret_cast<PFN_vkCmdBeginRenderingKHR>(vkGetDeviceProcAddr(device, "vkCmdBeginRenderingKHR"))
+        : nullptr;
+    m_cmdEndRendering = dynamicRendering
+        ? reinterpret_cast<PFN_vkCmdEndRenderingKHR>(vkGetDeviceProcAddr(device, "vkCmdEndRenderingKHR"))
+        : nullptr;
+}
+//------------------------------------------------------------------------------
+void RenderGraph::destroy()
+{
+    destroyFramebuffers();
+    destroyTransientImages();
+    for (PassGroup &group : m_groups)
+    {
+        if (group.renderPass != 0)
+        {
+            vkDestroyRenderPass(m_device, group.renderPass, nullptr);
+        }
+    }
+    m_groups.clear();
+    m_passes.clear();
+    m_images.clear();
+    m_finalBarriers.clear();
+}
+//------------------------------------------------------------------------------
+uint32_t RenderGraph::importImage(const std::string &name, VkFormat format, VkImageLayout finalLayout)
+{
+    Image image;
+    image.name = name;
+    image.format = format;
+    image.imported = true;
+    image.finalLayout = finalLayout;
+    m_images.push_back(image);
+    return static_cast<uint32_t>(m_images.size() - 1);
+}
+//------------------------------------------------------------------------------
+uint32_t RenderGraph::createImage(const std::string &name, VkFormat format)
+{
+    Image image;
+    image.name = name;
+    image.format = format;
+    m_images.push_back(image);
+    return static_cast<uint32_t>(m_images.size() - 1);
+}
+//------------------------------------------------------------------------------
+uint32_t RenderGraph::addPass(const std::string &name, RecordFunction record)
+{
+    Pass pass;
+    pass.name = name;
+    pass.record = std::move(record);
+    m_passes.push_back(std::move(pass));
+    return static_cast<uint32_t>(m_passes.size() - 1);
+}
+//------------------------------------------------------------------------------
+void RenderGraph::write(uint32_t pass, uint32_t image, ImageAccess access, const VkClearValue * clearValue)
+{
+    if (!isWrite(access))
+    {
+        throw std::runtime_error("Render graph: pass '" + m_passes.at(pass).name + "' writes '" + m_images.at(image).name
+                                 + "' with a read access!");
+    }
+
+    ImageUse use = { image, access };
+    use.clear = (clearValue != nullptr);
+    use.clearValue = use.clear ? *clearValue : VkClearValue();
+    addUse(pass, use);
+}
+//------------------------------------------------------------------------------
+void RenderGraph::read(uint32_t pass, uint32_t image, ImageAccess access)
+{
+    if (isWrite(access))
+    {
+        throw std::runtime_error("Render graph: pass '" + m_passes.at(pass).name + "' reads '" + m_images.at(image).name
+                                 + "' with a write access!");
+    }
+    addUse(pass, { image, access });
+}
+//------------------------------------------------------------------------------
+void RenderGraph::addUse(uint32_t pass, const ImageUse &use)
+{
+    Pass &graphPass = m_passes.at(pass);
+    Image &image = m_images.at(use.image);
+
+    // A single layout per image and pass
+    if (std::any_of(graphPass.uses.begin(), graphPass.uses.end(), [&use](const ImageUse &other) { return other.image == use.image; }))
+    {
+        throw std::runtime_error("Render graph: pass '" + graphPass.name + "' uses '" + image.name + "' twice!");
+    }
+    graphPass.uses.push_back(use);
+
+    // Transient images are created with the usages of their accesses
+    switch (use.access)
+    {
+    case ImageAccess::ColourWrite:  image.usage |= VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;            break;
+    case ImageAccess::DepthWrite:
+    case ImageAccess::DepthRead:    image.usage |= VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;    break;
+    case ImageAccess::SampledRead:  image.usage |= VK_IMAGE_USAGE_SAMPLED_BIT;                     break;
+    }
+}
+//------------------------------------------------------------------------------
+void RenderGraph::compile(const VkExtent2D &extent)
+{
+    m_extent = extent;
+    cullPasses();
+    groupPasses();
+    computeLifetimes();
+    computeLoadStoreOps();
+    createRenderPasses();
+    createTransientImages();
+    computeBarriers();      // After the memory assignment (aliased images wait for the previous ones)
+}
+//------------------------------------------------------------------------------
+void RenderGraph::resize(const VkExtent2D &extent)
+{
+    destroyFramebuffers();
+    destroyTransientImages();
+    m_extent = extent;
+    createTransientImages();
+    computeBarriers();
+}
+//------------------------------------------------------------------------------
+VkRenderPass RenderGraph::getRenderPass(uint32_t pass) const
+{
+    return m_groups.at(m_passes.at(pass).group).renderPass;
+}
+//------------------------------------------------------------------------------
+uint32_t RenderGraph::getSubpass(uint32_t pass) const
+{
+    return m_passes.at(pass).subpass;
+}
+//------------------------------------------------------------------------------
+uint32_t RenderGraph::getColourAttachmentCount(uint32_t pass) const
+{
+    // Dynamic rendering: all the colour attachments of the render pass, otherwise the ones of its subpass
+    const Pass &graphPass = m_passes.at(pass);
+    if (m_cmdBeginRendering != nullptr)
+    {
+        const std::vector<VkImageLayout> &layouts = m_groups.at(graphPass.group).layouts;
+        return static_cast<uint32_t>(std::count(layouts.begin(), layouts.end(), VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL));
+    }
+    return static_cast<uint32_t>(std::count_if(graphPass.uses.begin(), graphPass.uses.end(),
+        [](const ImageUse &use) { return use.access == ImageAccess::ColourWrite; }));
+}
+//------------------------------------------------------------------------------
+RenderGraphStats RenderGraph::getStats() const
+{
+    RenderGraphStats stats;
+    stats.passCount = static_cast<uint32_t>(m_passes.size());
+    stats.culledPassCount = static_cast<uint32_t>(std::count_if(m_passes.begin(), m_passes.end(),
+        [](const Pass &pass) { return pass.culled; }));
+    stats.renderPassCount = static_cast<uint32_t>(std::count_if(m_groups.begin(), m_groups.end(),
+        [](const PassGroup &group) { return !group.attachments.empty(); }));
+    stats.transientImageCount = static_cast<uint32_t>(std::count_if(m_images.begin(), m_images.end(),
+        [](const Image &image) { return !image.imported && image.used; }));
+    stats.transientAllocationCount = static_cast<uint32_t>(m_memoryBlocks.size());
+    for (const MemoryBlock &block : m_memoryBlocks)
+    {
+        stats.transientMemorySize += block.size;
+        if (block.lazy)
+        {
+            VkDeviceSize committedSize = 0;
+            vkGetDeviceMemoryCommitment(m_device, block.memory, &committedSize);
+            stats.lazyAllocationCount++;
+            stats.lazyMemorySize += block.size;
+            stats.lazyCommittedSize += committedSize;
+        }
+    }
+    return stats;
+}
+//------------------------------------------------------------------------------
+void RenderGraph::setImportedImage(uint32_t image, VkImage handle, VkImageView view)
+{
+    m_images.at(image).image = handle;
+    m_images.at(image).view = view;
+}
+//------------------------------------------------------------------------------
+void RenderGraph::execute(VkCommandBuffer commandBuffer)
+{
+    for (uint32_t groupIndex = 0; groupIndex < static_cast<uint32_t>(m_groups.size()); ++groupIndex)
+    {
+        const PassGroup &group = m_groups[groupIndex];
+        recordBarriers(commandBuffer, group.barriers);
+        if (group.attachments.empty())
+        {
+            for (uint32_t passIndex : group.passes)
+            {
+                m_passes[passIndex].record(commandBuffer);
+            }
+            continue;
+        }
+
+        if (m_cmdBeginRendering != nullptr)
+        {
+            beginRendering(commandBuffer, group);
+            for (uint32_t passIndex : group.passes)
+            {
+                m_passes[passIndex].record(commandBuffer);
+            }
+            m_cmdEndRendering(commandBuffer);
+            continue;
+        }
+
+        // Information about how to begin a render pass (only needed for graphical applications)
+        VkRenderPassBeginInfo renderPassBeginInfo = {};
+        renderPassBeginInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+        renderPassBeginInfo.renderPass = group.renderPass;                      // Render Pass to begin
+        renderPassBeginInfo.framebuffer = getFramebuffer(groupIndex);
+        renderPassBeginInfo.renderArea.offset = { 0, 0 };                       // Start point of render pass in pixels
+        renderPassBeginInfo.renderArea.extent = m_extent;                       // Size of region to run render pass on (starting at offset)
+        renderPassBeginInfo.clearValueCount = static_cast<uint32_t>(group.clearValues.size());
+        renderPassBeginInfo.pClearValues = group.clearValues.data();            // Array of clear values (used by the cleared attachments only)
+
+        vkCmdBeginRenderPass(commandBuffer, &renderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
+        for (size_t subpass = 0; subpass < group.passes.size(); ++subpass)
+        {
+            if (subpass > 0)
+            {
+                vkCmdNextSubpass(commandBuffer, VK_SUBPASS_CONTENTS_INLINE);
+            }
+            m_passes[group.passes[subpass]].record(commandBuffer);
+        }
+        vkCmdEndRenderPass(commandBuffer);
+    }
+
+    // Imported images to the layout they are used in after the frame (e.g. presentation)
+    recordBarriers(commandBuffer, m_finalBarriers);
+}
+//------------------------------------------------------------------------------
+void RenderGraph::cullPasses()
+{
+    // Walked backwards from the frame outputs (the imported images): a pass is live if it writes an image that a live
+    // pass after it (or the frame) needs. The images it reads or loads are needed before it, the ones it clears aren't.
+    std::vector<bool> needed(m_images.size());
+    for (size_t i = 0; i < m_images.size(); ++i)
+    {
+        needed[i] = m_images[i].imported;
+    }
+
+    for (auto pass = m_passes.rbegin(); pass != m_passes.rend(); ++pass)
+    {
+        pass->culled = std::none_of(pass->uses.begin(), pass->uses.end(),
+            [&needed](const ImageUse &use) { return isWrite(use.access) && needed[use.image]; });
+        if (pass->culled)
+        {
+            continue;
+        }
+
+        for (const ImageUse &use : pass->uses)
+        {
+            needed[use.image] = !use.clear;
+        }
+    }
+}
+//------------------------------------------------------------------------------
+void RenderGraph::groupPasses()
+{
+    // Live passes in order, each one in the render pass of the previous one when it can be a subpass of it
+    m_groups.clear();
+    for (uint32_t passIndex = 0; passIndex < static_cast<uint32_t>(m_passes.size()); ++passIndex)
+    {
+        Pass &pass = m_passes[passIndex];
+        if (pass.culled)
+        {
+            continue;
+        }
+
+        if (m_groups.empty() || !canJoinGroup(m_groups.back(), pass))
+        {
+            m_groups.emplace_back();
+        }
+        PassGroup &group = m_groups.back();
+        pass.group = static_cast<uint32_t>(m_groups.size() - 1);
+        pass.subpass = static_cast<uint32_t>(group.passes.size());
+        group.passes.push_back(passIndex);
+
+        for (const ImageUse &use : pass.uses)
+        {
+            std::vector<uint32_t> &images = (use.access == ImageAccess::SampledRead) ? group.sampledImages : group.attachments;
+            if (std::find(images.begin(), images.end(), use.image) != images.end())
+            {
+                continue;
+            }
+            images.push_back(use.image);
+            if (use.access != ImageAccess::SampledRead)
+            {
+                group.layouts.push_back(getAccessState(use.access).layout);
+                group.clearValues.push_back(use.clearValue);
+            }
+        }
+    }
+}
+//------------------------------------------------------------------------------
+bool RenderGraph::canJoinGroup(const PassGroup &group, const Pass &pass) const
+{
+    // Passes that draw nothing are recorded on their own, outside of render passes
+    if (group.attachments.empty() || std::all_of(pass.uses.begin(), pass.uses.end(),
+        [](const ImageUse &use) { return use.access == ImageAccess::SampledRead; }))
+    {
+        return false;
+    }
+
+    bool hasDepthAttachment = std::any_of(group.layouts.begin(), group.layouts.end(),
+        [](VkImageLayout layout) { return layout != VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL; });
+    for (const ImageUse &use : pass.uses)
+    {
+        auto attachment = std::find(group.attachments.begin(), group.attachments.end(), use.image);
+        bool sampledInGroup = std::find(group.sampledImages.begin(), group.sampledImages.end(), use.image) != group.sampledImages.end();
+
+        // Sampled images: not drawn to in the render pass (their barriers are recorded before it), and the other way
+        // around
+        if (use.access == ImageAccess::SampledRead)
+        {
+            if (attachment != group.attachments.end())
+            {
+                return false;
+            }
+            continue;
+        }
+        if (sampledInGroup)
+        {
+            return false;
+        }
+
+        // Attachments: the same layout in all the subpasses (transitions are graph barriers), cleared by their first one
+        // only. A single depth attachment.
+        if (attachment != group.attachments.end())
+        {
+            if (use.clear || group.layouts[attachment - group.attachments.begin()] != getAccessState(use.access).layout)
+            {
+                return false;
+            }
+        }
+        else if (use.access != ImageAccess::ColourWrite && hasDepthAttachment)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+//------------------------------------------------------------------------------
+void RenderGraph::computeLifetimes()
+{
+    for (Image &image : m_images)
+    {
+        image.used = false;
+    }
+
+    // Whole render passes: the attachments of one never share their memory
+    for (const PassGroup &group : m_groups)
+    {
+        for (uint32_t passIndex : group.passes)
+        {
+            for (const ImageUse &use : m_passes[passIndex].uses)
+            {
+                Image &image = m_images[use.image];
+                if (!image.used)
+                {
+                    image.firstPass = group.passes.front();
+                    image.used = true;
+                }
+                image.lastPass = group.passes.back();
+            }
+        }
+    }
+}
+//------------------------------------------------------------------------------
+void RenderGraph::computeLoadStoreOps()
+{
+    // Load what a previous render pass left (nothing to keep on the first use), store what a next one (or the frame)
+    // needs
+    for (PassGroup &group : m_groups)
+    {
+        group.loadOps.clear();
+        group.storeOps.clear();
+        for (uint32_t imageIndex : group.attachments)
+        {
+            const Image &image = m_images[imageIndex];
+            const ImageUse * firstUse = nullptr;
+            for (size_t subpass = 0; firstUse == nullptr; ++subpass)
+            {
+                firstUse = findUse(m_passes[group.passes[subpass]], imageIndex);
+            }
+
+            group.loadOps.push_back(firstUse->clear ? VK_ATTACHMENT_LOAD_OP_CLEAR
+                                  : (image.firstPass < group.passes.front() ? VK_ATTACHMENT_LOAD_OP_LOAD : VK_ATTACHMENT_LOAD_OP_DONT_CARE));
+            group.storeOps.push_back((image.imported || image.lastPass > group.passes.back()) ? VK_ATTACHMENT_STORE_OP_STORE
+                                                                                             : VK_ATTACHMENT_STORE_OP_DONT_CARE);
+        }
+    }
+}
+//------------------------------------------------------------------------------
+void RenderGraph::createRenderPasses()
+{
+    for (PassGroup &group : m_groups)
+    {
+        if (group.attachments.empty() || m_cmdBeginRendering != nullptr)
+        {
+            continue;
+        }
+
+        // Layout transitions are done by the graph barriers: the render pass keeps the layout it's given
+        std::vector<VkAttachmentDescription> attachmentDescriptions;
+        for (size_t attachment = 0; attachment < group.attachments.size(); ++attachment)
+        {
+            VkAttachmentDescription attachmentDescription = {};
+            attachmentDescription.format = m_images[group.attachments[attachment]].format;
+            attachmentDescription.samples = VK_SAMPLE_COUNT_1_BIT;
+            attachmentDescription.loadOp = group.loadOps[attachment];
+            attachmentDescription.storeOp = group.storeOps[attachment];
+            attachmentDescription.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+            attachmentDescription.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+            attachmentDescription.initialLayout = group.layouts[attachment];
+            attachmentDescription.finalLayout = group.layouts[attachment];
+            attachmentDescriptions.push_back(attachmentDescription);
+        }
+
+        // One subpass per pass, its colour attachments in declaration order (fragment output locations)
+        size_t subpassCount = group.passes.size();
+        std::vector<std::vector<VkAttachmentReference>> colourAttachmentReferences(subpassCount);
+        std::vector<VkAttachmentReference> depthAttachmentReferences(subpassCount, { VK_ATTACHMENT_UNUSED, VK_IMAGE_LAYOUT_UNDEFINED });
+        std::vector<std::vector<uint32_t>> preserveAttachments(subpassCount);
+        std::vector<VkSubpassDependency> subpassDependencies;
+        for (uint32_t subpass = 0; subpass < static_cast<uint32_t>(subpassCount); ++subpass)
+        {
+            const Pass &pass = m_passes[group.passes[subpass]];
+            for (const ImageUse &use : pass.uses)
+            {
+                if (use.access == ImageAccess::SampledRead)
+                {
+                    continue;
+                }
+
+                uint32_t attachment = static_cast<uint32_t>(std::find(group.attachments.begin(), group.attachments.end(), use.image)
+                                                            - group.attachments.begin());
+                VkAttachmentReference attachmentReference = { attachment, group.layouts[attachment] };
+                if (use.access == ImageAccess::ColourWrite)
+                {
+                    colourAttachmentReferences[subpass].push_back(attachmentReference);
+                }
+                else
+                {
+                    depthAttachmentReferences[subpass] = attachmentReference;
+                }
+
+                // After the previous subpass using it (same pixel only: BY_REGION, the attachments can stay on chip)
+                for (uint32_t previous = subpass; previous-- > 0; )
+                {
+                    const ImageUse * previousUse = findUse(m_passes[group.passes[previous]], use.image);
+                    if (previousUse == nullptr)
+                    {
+                        continue;
+                    }
+
+                    ImageState srcState = getAccessState(previousUse->access);
+                    ImageState dstState = getAccessState(use.access);
+                    if (((srcState.access | dstState.access) & WRITE_ACCESS) != 0)
+                    {
+                        VkSubpassDependency subpassDependency = {};
+                        subpassDependency.srcSubpass = previous;
+                        subpassDependency.srcStageMask = static_cast<VkPipelineStageFlags>(srcState.stages);
+                        subpassDependency.srcAccessMask = static_cast<VkAccessFlags>(srcState.access & WRITE_ACCESS);
+                        subpassDependency.dstSubpass = subpass;
+                        subpassDependency.dstStageMask = static_cast<VkPipelineStageFlags>(dstState.stages);
+                        subpassDependency.dstAccessMask = static_cast<VkAccessFlags>(dstState.access);
+                        subpassDependency.dependencyFlags = VK_DEPENDENCY_BY_REGION_BIT;
+                        subpassDependencies.push_back(subpassDependency);
+                    }
+                    break;
+                }
+            }
+
+            // Attachments it doesn't use, between two subpasses that do: their contents must be kept
+            for (uint32_t attachment = 0; attachment < static_cast<uint32_t>(group.attachments.size()); ++attachment)
+            {
+                auto usedBy = [this, &group, attachment](size_t other) {
+                    return findUse(m_passes[group.passes[other]], group.attachments[attachment]) != nullptr;
+                };
+                bool usedBefore = false;
+                bool usedAfter = false;
+                for (size_t other = 0; other < subpassCount; ++other)
+                {
+                    usedBefore |= (other < subpass && usedBy(other));
+                    usedAfter |= (other > subpass && usedBy(other));
+                }
+                if (!usedBy(subpass) && usedBefore && usedAfter)
+                {
+                    preserveAttachments[subpass].push_back(attachment);
+                }
+            }
+        }
+
+        std::vector<VkSubpassDescription> subpasses(subpassCount);
+        for (size_t subpass = 0; subpass < subpassCount; ++subpass)
+        {
+            subpasses[subpass].pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+            subpasses[subpass].colorAttachmentCount = static_cast<uint32_t>(colourAttachmentReferences[subpass].size());
+            subpasses[subpass].pColorAttachments = colourAttachmentReferences[subpass].data();
+            subpasses[subpass].pDepthStencilAttachment = (depthAttachmentReferences[subpass].attachment != VK_ATTACHMENT_UNUSED)
+                                                       ? &depthAttachmentReferences[subpass] : nullptr;
+            subpasses[subpass].preserveAttachmentCount = static_cast<uint32_t>(preserveAttachments[subpass].size());
+            subpasses[subpass].pPreserveAttachments = preserveAttachments[subpass].data();
+        }
+
+        VkRenderPassCreateInfo renderPassCreateInfo = {};
+        renderPassCreateInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+        renderPassCreateInfo.attachmentCount = static_cast<uint32_t>(attachmentDescriptions.size());
+        renderPassCreateInfo.pAttachments = attachmentDescriptions.data();
+        renderPassCreateInfo.subpassCount = static_cast<uint32_t>(subpasses.size());
+        renderPassCreateInfo.pSubpasses = subpasses.data();
+        renderPassCreateInfo.dependencyCount = static_cast<uint32_t>(subpassDependencies.size());
+        renderPassCreateInfo.pDependencies = subpassDependencies.data();
+
+        VkResult result = vkCreateRenderPass(m_device, &renderPassCreateInfo, nullptr, &group.renderPass);
+        if (result != VK_SUCCESS)
+        {
+            throw std::runtime_error("Failed to create a Render Pass! ('" + m_passes[group.passes.front()].name + "')");
+        }
+    }
+}
+//------------------------------------------------------------------------------
+void RenderGraph::computeBarriers()
+{
+    // First walk: the state each image ends the frame in
+    std::vector<ImageState> states(m_images.size());
+    trackImageStates(states, false);
+
+    // Where the images start the frame: undefined (their contents are not kept), after the last accesses to their
+    // memory. Imported images wait for the stages of their first use (e.g. the Swapchain acquire semaphore waits there).
+    // Transient ones for the last use of their memory: by the image using it before them in the frame, or by the last
+    // one of the previous frame (frames in flight share the transient images).
+    for (uint32_t imageIndex = 0; imageIndex < static_cast<uint32_t>(m_images.size()); ++imageIndex)
+    {
+        const Image &image = m_images[imageIndex];
+        states[imageIndex] = ImageState();
+        if (!image.used)
+        {
+            continue;
+        }
+
+        if (image.imported)
+        {
+            const ImageUse * firstUse = nullptr;
+            for (uint32_t passIndex = image.firstPass; firstUse == nullptr; ++passIndex)
+            {
+                firstUse = m_passes[passIndex].culled ? nullptr : findUse(m_passes[passIndex], imageIndex);
+            }
+            states[imageIndex].stages = getAccessState(firstUse->access).stages;
+            continue;
+        }
+
+        uint32_t previous = imageIndex;
+        for (uint32_t other : m_memoryBlocks[image.memoryBlock].images)
+        {
+            // Latest one before it in the frame, otherwise latest one of the frame (itself when alone)
+            bool otherBefore = m_images[other].lastPass < image.firstPass;
+            bool previousBefore = m_images[previous].lastPass < image.firstPass;
+            if (otherBefore != previousBefore ? otherBefore : m_images[other].lastPass > m_images[previous].lastPass)
+            {
+                previous = other;
+            }
+        }
+        states[imageIndex].stages = m_images[previous].endState.stages;
+        states[imageIndex].access = m_images[previous].endState.access & WRITE_ACCESS;
+    }
+
+    // Second walk: the barriers
+    trackImageStates(states, true);
+
+    m_finalBarriers.clear();
+    for (uint32_t imageIndex = 0; imageIndex < static_cast<uint32_t>(m_images.size()); ++imageIndex)
+    {
+        const Image &image = m_images[imageIndex];
+        if (image.imported && image.used && states[imageIndex].layout != image.finalLayout)
+        {
+            m_finalBarriers.push_back({ imageIndex, states[imageIndex].layout, image.finalLayout,
+                                        states[imageIndex].stages, states[imageIndex].access & WRITE_ACCESS,
+                                        VK_PIPELINE_STAGE_2_NONE, VK_ACCESS_2_NONE });
+        }
+    }
+}
+//------------------------------------------------------------------------------
+void RenderGraph::trackImageStates(std::vector<ImageState> &states, bool recordBarriers)
+{
+    for (PassGroup &group : m_groups)
+    {
+        if (recordBarriers)
+        {
+            group.barriers.clear();
+        }
+
+        // Images already used in the render pass: ordered by its subpass dependencies (or only read)
+        std::vector<uint32_t> groupImages;
+        for (uint32_t passIndex : group.passes)
+        {
+            for (const ImageUse &use : m_passes[passIndex].uses)
+            {
+                ImageState &state = states[use.image];
+                ImageState next = getAccessState(use.access);
+
+                // Reads after reads in the same layout need no barrier either: their stages add up, so that the next
+                // write waits for all of them
+                bool usedInGroup = std::find(groupImages.begin(), groupImages.end(), use.image) != groupImages.end();
+                if (    usedInGroup
+                    ||  (state.layout == next.layout && (state.access & WRITE_ACCESS) == 0 && (next.access & WRITE_ACCESS) == 0))
+                {
+                    state.stages |= next.stages;
+                    state.access |= next.access;
+                    continue;
+                }
+                groupImages.push_back(use.image);
+
+                // Cleared attachments don't need their previous contents (UNDEFINED: the transition doesn't keep them)
+                if (recordBarriers)
+                {
+                    group.barriers.push_back({ use.image, use.clear ? VK_IMAGE_LAYOUT_UNDEFINED : state.layout, next.layout,
+                                               state.stages, state.access & WRITE_ACCESS, next.stages, next.access });
+                }
+                state = next;
+            }
+        }
+    }
+
+    if (!recordBarriers)
+    {
+        for (size_t i = 0; i < m_images.size(); ++i)
+        {
+            m_images[i].endState = states[i];
+        }
+    }
+}
+//------------------------------------------------------------------------------
+void RenderGraph::createTransientImages()
+{
+    // Images of the live passes only (the ones of culled passes are never created)
+    std::vector<uint32_t> transientImages;
+    for (uint32_t imageIndex = 0; imageIndex < static_cast<uint32_t>(m_images.size()); ++imageIndex)
+    {
+        Image &image = m_images[imageIndex];
+        if (image.imported || !image.used)
+        {
+            continue;
+        }
+
+        // Transient attachments: never sampled nor copied, and whole lifetime in one render pass (never loaded nor
+        // stored, DONT_CARE ops): their contents can stay in tile memory
+        const VkImageUsageFlags attachmentUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
+        bool transientAttachment = (image.usage & ~attachmentUsage) == 0
+                                && m_passes[image.firstPass].group == m_passes[image.lastPass].group;
+
+        VkImageCreateInfo imageCreateInfo = {};
+        imageCreateInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+        imageCreateInfo.imageType = VK_IMAGE_TYPE_2D;
+        imageCreateInfo.extent.width = m_extent.width;
+        imageCreateInfo.extent.height = m_extent.height;
+        imageCreateInfo.extent.depth = 1;
+        imageCreateInfo.mipLevels = 1;
+        imageCreateInfo.arrayLayers = 1;
+        imageCreateInfo.format = image.format;
+        imageCreateInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+        imageCreateInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        imageCreateInfo.usage = image.usage | (transientAttachment ? VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT : 0);
+        imageCreateInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+        imageCreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+        VkResult result = vkCreateImage(m_device, &imageCreateInfo, nullptr, &image.image);
+        if (result != VK_SUCCESS)
+        {
+            throw std::runtime_error("Failed to create an Image! ('" + image.name + "')");
+        }
+        vkGetImageMemoryRequirements(m_device, image.image, &image.memoryRequirements);
+        image.lazy = transientAttachment && findMemoryTypeIndex(m_physicalDevice, image.memoryRequirements.memoryTypeBits,
+                                                                VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT) != std::numeric_limits<uint32_t>::max();
+        transientImages.push_back(imageIndex);
+    }
+
+    // Largest first, each in the first allocation whose images are all dead (or not born yet) during its lifetime.
+    // They are all bound at offset 0: an allocation is as large as its largest image. Lazily allocated images only share
+    // with each other.
+    std::stable_sort(transientImages.begin(), transientImages.end(), [this](uint32_t a, uint32_t b) {
+        return m_images[a].memoryRequirements.size > m_images[b].memoryRequirements.size;
+    });
+
+    m_memoryBlocks.clear();
+    for (uint32_t imageIndex : transientImages)
+    {
+        Image &image = m_images[imageIndex];
+        auto block = std::find_if(m_memoryBlocks.begin(), m_memoryBlocks.end(), [this, &image](const MemoryBlock &block) {
+            return block.lazy == image.lazy
+                && (block.memoryTypeBits & image.memoryRequirements.memoryTypeBits) != 0
+                && std::none_of(block.images.begin(), block.images.end(), [this, &image](uint32_t other) {
+                       return m_images[other].firstPass <= image.lastPass && image.firstPass <= m_images[other].lastPass;
+                   });
+        });
+        if (block == m_memoryBlocks.end())
+        {
+            MemoryBlock newBlock;
+            newBlock.memoryTypeBits = image.memoryRequirements.memoryTypeBits;
+            newBlock.lazy = image.lazy;
+            block = m_memoryBlocks.insert(m_memoryBlocks.end(), newBlock);
+        }
+
+        block->images.push_back(imageIndex);
+        block->size = std::max(block->size, image.memoryRequirements.size);
+        block->memoryTypeBits &= image.memoryRequirements.memoryTypeBits;
+        image.memoryBlock = static_cast<uint32_t>(block - m_memoryBlocks.begin());
+    }
+
+    for (MemoryBlock &block : m_memoryBlocks)
+    {
+        VkMemoryAllocateInfo memoryAllocInfo = {};
+        memoryAllocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+        memoryAllocInfo.allocationSize = block.size;
+        memoryAllocInfo.memoryTypeIndex = findMemoryTypeIndex(m_physicalDevice, block.memoryTypeBits,
+            block.lazy ? VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT : VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+        if (memoryAllocInfo.memoryTypeIndex == std::numeric_limits<uint32_t>::max())
+        {
+            throw std::runtime_error("No memory type for the transient images!");
+        }
+
+        VkResult result = vkAllocateMemory(m_device, &memoryAllocInfo, nullptr, &block.memory);
+        if (result != VK_SUCCESS)
+        {
+            throw std::runtime_error("Failed to allocate memory for the transient images!");
+        }
+
+        for (uint32_t imageIndex : block.images)
+        {
+            Image &image = m_images[imageIndex];
+            vkBindImageMemory(m_device, image.image, block.memory, 0);
+
+            // Depth images are viewed through their depth aspect (stencil is never used)
+            VkImageAspectFlags aspectMask = getAspectMask(image.format);
+            VkImageViewCreateInfo viewCreateInfo = {};
+            viewCreateInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+            viewCreateInfo.image = image.image;
+            viewCreateInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+            viewCreateInfo.format = image.format;
+            viewCreateInfo.components = { VK_COMPONENT_SWIZZLE_IDENTITY, VK_COMPONENT_SWIZZLE_IDENTITY,
+                                          VK_COMPONENT_SWIZZLE_IDENTITY, VK_COMPONENT_SWIZZLE_IDENTITY };
+            viewCreateInfo.subresourceRange.aspectMask = (aspectMask & VK_IMAGE_ASPECT_DEPTH_BIT) ? VK_IMAGE_ASPECT_DEPTH_BIT : aspectMask;
+            viewCreateInfo.subresourceRange.baseMipLevel = 0;
+            viewCreateInfo.subresourceRange.levelCount = 1;
+            viewCreateInfo.subresourceRange.baseArrayLayer = 0;
+            viewCreateInfo.subresourceRange.layerCount = 1;
+
+            result = vkCreateImageView(m_device, &viewCreateInfo, nullptr, &image.view);
+            if (result != VK_SUCCESS)
+            {
+                throw std::runtime_error("Failed to create an Image View! ('" + image.name + "')");
+            }
+        }
+    }
+}
+//------------------------------------------------------------------------------
+void RenderGraph::destroyTransientImages()
+{
+    for (Image &image : m_images)
+    {
+        if (image.imported)
+        {
+            continue;
+        }
+        if (image.view != 0)
+        {
+            vkDestroyImageView(m_device, image.view, nullptr);
+        }
+        if (image.image != 0)
+        {
+            vkDestroyImage(m_device, image.image, nullptr);
+        }
+        image.view = 0;
+        image.image = 0;
+    }
+
+    for (MemoryBlock &block : m_memoryBlocks)
+    {
+        vkFreeMemory(m_device, block.memory, nullptr);
+    }
+    m_memoryBlocks.clear();
+}
+//------------------------------------------------------------------------------
+void RenderGraph::destroyFramebuffers()
+{
+    for (auto &framebuffer : m_framebuffers)
+    {
+        vkDestroyFramebuffer(m_device, framebuffer.second, nullptr);
+    }
+    m_framebuffers.clear();
+}
+//------------------------------------------------------------------------------
+VkFramebuffer RenderGraph::getFramebuffer(uint32_t groupIndex)
+{
+    // One per combination of attachments (e.g. per Swapchain image), created on first use
+    const PassGroup &group = m_groups[groupIndex];
+    std::vector<VkImageView> attachments;
+    std::vector<uint64_t> key = { groupIndex };
+    for (uint32_t image : group.attachments)
+    {
+        attachments.push_back(m_images[image].view);
+        key.push_back(getHandleKey(m_images[image].view));
+    }
+
+    auto found = m_framebuffers.find(key);
+    if (found != m_framebuffers.end())
+    {
+        return found->second;
+    }
+
+    VkFramebufferCreateInfo framebufferCreateInfo = {};
+    framebufferCreateInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+    framebufferCreateInfo.renderPass = group.renderPass;                                // Render Pass layout the Framebuffer will be used with
+    framebufferCreateInfo.attachmentCount = static_cast<uint32_t>(attachments.size());
+    framebufferCreateInfo.pAttachments = attachments.data();                            // List of attachments (1:1 with Render Pass)
+    framebufferCreateInfo.width = m_extent.width;                                       // Framebuffer width
+    framebufferCreateInfo.height = m_extent.height;                                     // Framebuffer height
+    framebufferCreateInfo.layers = 1;                                                   // Framebuffer layers
+
+    VkFramebuffer framebuffer = 0;
+    VkResult result = vkCreateFramebuffer(m_device, &framebufferCreateInfo, nullptr, &framebuffer);
+    if (result != VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to create a Framebuffer! ('" + m_passes[group.passes.front()].name + "')");
+    }
+    m_framebuffers[key] = framebuffer;
+    return framebuffer;
+}
+//------------------------------------------------------------------------------
+void RenderGraph::recordBarriers(VkCommandBuffer commandBuffer, const std::vector<Barrier> &barriers)
+{
+    if (barriers.empty())
+    {
+        return;
+    }
+
+    if (m_cmdPipelineBarrier2 != nullptr)
+    {
+        // synchronization2: stages and accesses of each barrier on their own
+        std::vector<VkImageMemoryBarrier2> imageMemoryBarriers(barriers.size());
+        for (size_t i = 0; i < barriers.size(); ++i)
+        {
+            const Barrier &barrier = barriers[i];
+            const Image &image = m_images[barrier.image];
+            imageMemoryBarriers[i] = {};
+            imageMemoryBarriers[i].sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2;
+            imageMemoryBarriers[i].srcStageMask = barrier.srcStages;
+            imageMemoryBarriers[i].srcAccessMask = barrier.srcAccess;
+            imageMemoryBarriers[i].dstStageMask = barrier.dstStages;
+            imageMemoryBarriers[i].dstAccessMask = barrier.dstAccess;
+            imageMemoryBarriers[i].oldLayout = barrier.oldLayout;
+            imageMemoryBarriers[i].newLayout = barrier.newLayout;
+            imageMemoryBarriers[i].srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            imageMemoryBarriers[i].dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            imageMemoryBarriers[i].image = image.image;
+            imageMemoryBarriers[i].subresourceRange = { getAspectMask(image.format), 0, 1, 0, 1 };
+        }
+
+        VkDependencyInfo dependencyInfo = {};
+        dependencyInfo.sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO;
+        dependencyInfo.imageMemoryBarrierCount = static_cast<uint32_t>(imageMemoryBarriers.size());
+        dependencyInfo.pImageMemoryBarriers = imageMemoryBarriers.data();
+        m_cmdPipelineBarrier2(commandBuffer, &dependencyInfo);
+        return;
+    }
+
+    // Original synchronization: a single call with the stages of all the barriers merged (the stage and access flags
+    // used by the graph have the same values in both versions)
+    VkPipelineStageFlags srcStages = 0;
+    VkPipelineStageFlags dstStages = 0;
+    std::vector<VkImageMemoryBarrier> imageMemoryBarriers(barriers.size());
+    for (size_t i = 0; i < barriers.size(); ++i)
+    {
+        const Barrier &barrier = barriers[i];
+        const Image &image = m_images[barrier.image];
+        imageMemoryBarriers[i] = {};
+        imageMemoryBarriers[i].sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        imageMemoryBarriers[i].srcAccessMask = static_cast<VkAccessFlags>(barrier.srcAccess);
+        imageMemoryBarriers[i].dstAccessMask = static_cast<VkAccessFlags>(barrier.dstAccess);
+        imageMemoryBarriers[i].oldLayout = barrier.oldLayout;
+        imageMemoryBarriers[i].newLayout = barrier.newLayout;
+        imageMemoryBarriers[i].srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        imageMemoryBarriers[i].dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        imageMemoryBarriers[i].image = image.image;
+        imageMemoryBarriers[i].subresourceRange = { getAspectMask(image.format), 0, 1, 0, 1 };
+        srcStages |= static_cast<VkPipelineStageFlags>(barrier.srcStages);
+        dstStages |= static_cast<VkPipelineStageFlags>(barrier.dstStages);
+    }
+
+    vkCmdPipelineBarrier(
+        commandBuffer,
+        srcStages != 0 ? srcStages : VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,     // No previous access: nothing to wait for
+        dstStages != 0 ? dstStages : VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,  // No next access: nothing waits for it
+        0U,                                                                 // Dependency flags
+        0U, nullptr,                                                        // Memory Barrier count + data
+        0U, nullptr,                                                        // Buffer Memory Barrier count + data
+        static_cast<uint32_t>(imageMemoryBarriers.size()), imageMemoryBarriers.data()
+    );
+}
+//------------------------------------------------------------------------------
+void RenderGraph::beginRendering(VkCommandBuffer commandBuffer, const PassGroup &group)
+{
+    // Colour attachments in render pass order (fragment output locations), and the depth one
+    std::vector<VkRenderingAttachmentInfoKHR> colourAttachments;
+    VkRenderingAttachmentInfoKHR depthAttachment = {};
+    bool hasDepthAttachment = false;
+    for (size_t attachment = 0; attachment < group.attachments.size(); ++attachment)
+    {
+        VkRenderingAttachmentInfoKHR attachmentInfo = {};
+        attachmentInfo.sType = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO_KHR;
+        attachmentInfo.imageView = m_images[group.attachments[attachment]].view;
+        attachmentInfo.imageLayout = group.layouts[attachment];
+        attachmentInfo.resolveMode = VK_RESOLVE_MODE_NONE;
+        attachmentInfo.loadOp = group.loadOps[attachment];
+        attachmentInfo.storeOp = group.storeOps[attachment];
+        attachmentInfo.clearValue = group.clearValues[attachment];
+        if (group.layouts[attachment] == VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL)
+        {
+            colourAttachments.push_back(attachmentInfo);
+        }
+        else
+        {
+            depthAttachment = attachmentInfo;
+            hasDepthAttachment = true;
+        }
+    }
+
+    VkRenderingInfoKHR renderingInfo = {};
+    renderingInfo.sType = VK_STRUCTURE_TYPE_RENDERING_INFO_KHR;
+    renderingInfo.renderArea.offset = { 0, 0 };
+    renderingInfo.renderArea.extent = m_extent;
+    renderingInfo.layerCount = 1;
+    renderingInfo.colorAttachmentCount = static_cast<uint32_t>(colourAttachments.size());
+    renderingInfo.pColorAttachments = colourAttachments.data();
+    renderingInfo.pDepthAttachment = hasDepthAttachment ? &depthAttachment : nullptr;   // Stencil is never used
+    m_cmdBeginRendering(commandBuffer, &renderingInfo);
+}
+//------------------------------------------------------------------------------
+RenderGraph::ImageState RenderGraph::getAccessState(ImageAccess access)
+{
+    ImageState state;
+    switch (access)
+    {
+    case ImageAccess::ColourWrite:
+        state.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+        state.stages = VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT;
+        state.access = VK_ACCESS_2_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT;
+        break;
+    case ImageAccess::DepthWrite:
+        state.layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+        state.stages = VK_PIPELINE_STAGE_2_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_2_LATE_FRAGMENT_TESTS_BIT;
+        state.access = VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+        break;
+    case ImageAccess::DepthRead:
+        state.layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL;
+        state.stages = VK_PIPELINE_STAGE_2_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_2_LATE_FRAGMENT_TESTS_BIT;
+        state.access = VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_READ_BIT;
+        break;
+    case ImageAccess::SampledRead:
+        state.layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+        state.stages = VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT;
+        state.access = VK_ACCESS_2_SHADER_READ_BIT;
+        break;
+    }
+    return state;
+}
+//------------------------------------------------------------------------------
+const RenderGraph::ImageUse * RenderGraph::findUse(const Pass &pass, uint32_t image)
+{
+    auto use = std::find_if(pass.uses.begin(), pass.uses.end(), [image](const ImageUse &use) { return use.image == image; });
+    return use != pass.uses.end() ? &*use : nullptr;
+}
+//------------------------------------------------------------------------------
+VkImageAspectFlags RenderGraph::getAspectMask(VkFormat format)
+{
+    // Layout transitions of depth/stencil images must include both aspects
+    switch (format)
+    {
+    case VK_FORMAT_D16_UNORM:
+    case VK_FORMAT_X8_D24_UNORM_PACK32:
+    case VK_FORMAT_D32_SFLOAT:
+        return VK_IMAGE_ASPECT_DEPTH_BIT;
+    case VK_FORMAT_D16_UNORM_S8_UINT:
+    case VK_FORMAT_D24_UNORM_S8_UINT:
+    case VK_FORMAT_D32_SFLOAT_S8_UINT:
+        return VK_IMAGE_ASPECT_DEPTH_BIT | VK_IMAGE_ASPECT_STENCIL_BIT;
+    case VK_FORMAT_S8_UINT:
+        return VK_IMAGE_ASPECT_STENCIL_BIT;
+    default:
+        return VK_IMAGE_ASPECT_COLOR_BIT;
+    }
+}
@@ -0,0 +1,196 @@
+#ifndef RENDER_GRAPH_H
+#define RENDER_GRAPH_H
+
+// C++ STL
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+
+// Project includes
+#include "Utilities.h"          // Utilities header includes GLFW [Graphics Library FrameWork] + Vulkan API
+
+// How a pass uses an image
+enum class ImageAccess : uint32_t
+{
+    ColourWrite     = 0,    // Colour attachment (written, and read by blending)
+    DepthWrite      = 1,    // Depth attachment, tested and written
+    DepthRead       = 2,    // Depth attachment, tested only
+    SampledRead     = 3,    // Sampled by the fragment shaders (e.g. a shadow map or a post-processing input)
+};
+
+// Summary of the compiled graph
+struct RenderGraphStats
+{
+    uint32_t        passCount = 0;
+    uint32_t        culledPassCount = 0;
+    uint32_t        renderPassCount = 0;            // Less than the live passes when some of them are merged as subpasses
+    uint32_t        transientImageCount = 0;
+    uint32_t        transientAllocationCount = 0;   // Less than the images when some of them alias
+    VkDeviceSize    transientMemorySize = 0;        // [bytes]
+    uint32_t        lazyAllocationCount = 0;        // Lazily allocated (attachments living in a single render pass)
+    VkDeviceSize    lazyMemorySize = 0;             // [bytes] Reserved for them
+    VkDeviceSize    lazyCommittedSize = 0;          // [bytes] Actually backed by memory (0 when kept on chip)
+};
+
+// Frame graph: the frame is declared as passes writing and reading images, compile() derives the rest:
+// - passes that don't contribute to an imported image (the frame outputs) are culled;
+// - consecutive passes drawing to compatible attachments (same layouts, nothing sampled that another one draws to)
+//   are merged as the subpasses of a single render pass, with by-region dependencies: their attachments can stay in
+//   tile memory between them. Load and store ops come from the uses before and after the render pass;
+// - the barriers (and layout transitions) between the render passes are derived from their accesses, and batched in
+//   a single call before each one (vkCmdPipelineBarrier2 when synchronization2 is enabled on the device);
+// - transient images (owned by the graph) whose lifetimes don't overlap share their memory. The ones only used as
+//   attachments of a single render pass (never loaded nor stored) are created with
+//   VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT, in lazily allocated memory when the device has such a memory type
+//   (tile-based GPUs: no memory is committed while they stay in tile memory).
+// With dynamic rendering (the shader objects backend needs it), each render pass is a vkCmdBeginRendering instance
+// instead: its passes draw one after the other with all its attachments bound (the rasterization order keeps their
+// attachment accesses ordered), and there are no VkRenderPass nor Framebuffers.
+// Passes run in declaration order. Imported images start each frame undefined (e.g. the Swapchain images) and end it
+// in their final layout. resize() re-creates the transient images only: the render passes (and the pipelines created
+// for them) stay valid. Render thread only.
+class RenderGraph
+{
+public:
+    using RecordFunction = std::function<void(VkCommandBuffer commandBuffer)>;
+
+    RenderGraph();
+    ~RenderGraph();
+
+    void        create(VkPhysicalDevice physicalDevice, VkDevice device, bool synchronization2, bool dynamicRendering);
+    void        destroy();
+
+    // Declaration
+    uint32_t    importImage(const std::string &name, VkFormat format, VkImageLayout finalLayout);  // Set each frame with setImportedImage()
+    uint32_t    createImage(const std::string &name, VkFormat format);  // Transient (sized as the graph), returns its index
+    uint32_t    addPass(const std::string &name, RecordFunction record);
+    void        write(uint32_t pass, uint32_t image, ImageAccess access, const VkClearValue * clearValue = nullptr);  // Cleared when the pass begins if given
+    void        read(uint32_t pass, uint32_t image, ImageAccess access);
+    void        compile(const VkExtent2D &extent);
+
+    void        resize(const VkExtent2D &extent);
+    VkRenderPass        getRenderPass(uint32_t pass) const;     // For the pipelines of the pass (with getSubpass()), none with dynamic rendering
+    uint32_t            getSubpass(uint32_t pass) const;
+    uint32_t            getColourAttachmentCount(uint32_t pass) const;  // Bound while the pass draws
+    RenderGraphStats    getStats() const;
+
+    // Execution
+    void        setImportedImage(uint32_t image, VkImage handle, VkImageView view);
+    void        execute(VkCommandBuffer commandBuffer);
+
+private:
+    struct ImageUse
+    {
+        uint32_t        image;
+        ImageAccess     access;
+        bool            clear = false;
+        VkClearValue    clearValue = {};
+    };
+
+    struct Barrier
+    {
+        uint32_t                image;
+        VkImageLayout           oldLayout;
+        VkImageLayout           newLayout;
+        VkPipelineStageFlags2   srcStages;
+        VkAccessFlags2          srcAccess;
+        VkPipelineStageFlags2   dstStages;
+        VkAccessFlags2          dstAccess;
+    };
+
+    struct Pass
+    {
+        std::string             name;
+        RecordFunction          record;
+        std::vector<ImageUse>   uses;                       // One per image
+        bool                    culled = false;
+        uint32_t                group = 0;                  // Render pass it is recorded in
+        uint32_t                subpass = 0;                // Index in it
+    };
+
+    // Consecutive live passes recorded in the same render pass, one subpass each
+    struct PassGroup
+    {
+        std::vector<uint32_t>   passes;
+        VkRenderPass            renderPass = 0;             // None with dynamic rendering
+        std::vector<uint32_t>   attachments;                // Images, in render pass attachment order (none: recorded outside of render passes)
+        std::vector<VkImageLayout>  layouts;                // Same order (the same in all the subpasses)
+        std::vector<VkClearValue>   clearValues;            // Same order
+        std::vector<VkAttachmentLoadOp>     loadOps;        // Same order
+        std::vector<VkAttachmentStoreOp>    storeOps;       // Same order
+        std::vector<uint32_t>   sampledImages;              // Read by its passes (never one of the attachments)
+        std::vector<Barrier>    barriers;                   // Recorded before the render pass
+    };
+
+    // Where an image is at (layout and last accesses) while the passes are walked
+    struct ImageState
+    {
+        VkImageLayout           layout = VK_IMAGE_LAYOUT_UNDEFINED;
+        VkPipelineStageFlags2   stages = VK_PIPELINE_STAGE_2_NONE;
+        VkAccessFlags2          access = VK_ACCESS_2_NONE;
+    };
+
+    struct Image
+    {
+        std::string             name;
+        VkFormat                format = VK_FORMAT_UNDEFINED;
+        bool                    imported = false;
+        VkImageLayout           finalLayout = VK_IMAGE_LAYOUT_UNDEFINED;    // Imported: at the end of the frame
+        VkImageUsageFlags       usage = 0;                  // Transient: derived from the accesses
+        bool                    lazy = false;               // Transient: in lazily allocated memory
+        VkImage                 image = 0;
+        VkImageView             view = 0;
+        uint32_t                firstPass = 0;              // Lifetime (live passes, from the first to the last pass
+        uint32_t                lastPass = 0;               // of the render passes using it)
+        bool                    used = false;               // By a live pass
+        ImageState              endState;                   // After its last use in the frame
+        VkMemoryRequirements    memoryRequirements = {};
+        uint32_t                memoryBlock = 0;            // Transient: allocation it is bound to
+    };
+
+    struct MemoryBlock
+    {
+        VkDeviceMemory          memory = 0;
+        VkDeviceSize            size = 0;
+        uint32_t                memoryTypeBits = 0;
+        bool                    lazy = false;               // VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT
+        std::vector<uint32_t>   images;                     // With disjoint lifetimes
+    };
+
+    VkPhysicalDevice            m_physicalDevice = nullptr;
+    VkDevice                    m_device = nullptr;         // This is our Logical Device
+    PFN_vkCmdPipelineBarrier2KHR    m_cmdPipelineBarrier2 = nullptr;    // synchronization2 (null: vkCmdPipelineBarrier)
+    PFN_vkCmdBeginRenderingKHR      m_cmdBeginRendering = nullptr;      // Dynamic rendering (null: render passes)
+    PFN_vkCmdEndRenderingKHR        m_cmdEndRendering = nullptr;
+
+    std::vector<Image>          m_images;
+    std::vector<Pass>           m_passes;
+    std::vector<PassGroup>      m_groups;                   // Live passes, by render pass
+    std::vector<Barrier>        m_finalBarriers;            // To the final layouts of the imported images
+    std::vector<MemoryBlock>    m_memoryBlocks;
+    VkExtent2D                  m_extent = {};
+    std::map<std::vector<uint64_t>, VkFramebuffer>  m_framebuffers;     // By render pass and attachment views
+
+    // Methods
+    void        addUse(uint32_t pass, const ImageUse &use);
+    void        cullPasses();
+    void        groupPasses();
+    bool        canJoinGroup(const PassGroup &group, const Pass &pass) const;
+    void        computeLifetimes();
+    void        computeLoadStoreOps();
+    void        createRenderPasses();
+    void        computeBarriers();
+    void        trackImageStates(std::vector<ImageState> &states, bool recordBarriers);
+    void        createTransientImages();
+    void        destroyTransientImages();
+    void        destroyFramebuffers();
+    VkFramebuffer   getFramebuffer(uint32_t groupIndex);
+    void        recordBarriers(VkCommandBuffer commandBuffer, const std::vector<Barrier> &barriers);
+    void        beginRendering(VkCommandBuffer commandBuffer, const PassGroup &group);
+    static ImageState           getAccessState(ImageAccess access);
+    static const ImageUse *     findUse(const Pass &pass, uint32_t image);     // Null if the pass doesn't use it
+    static VkImageAspectFlags   getAspectMask(VkFormat format);
+};
+
+#endif //RENDER_GRAPH_H
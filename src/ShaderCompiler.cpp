@@ -0,0 +1,500 @@
+#include "ShaderCompiler.h"
+
+// C++ STL
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+
+// Project includes
+#include "Utilities.h"          // Utilities header includes GLFW [Graphics Library FrameWork] + Vulkan API
+
+#if SHADER_COMPILER_SHADERC
+    #include <shaderc/shaderc.hpp>
+#endif
+
+#ifdef _WIN32
+    #define popen   _popen
+    #define pclose  _pclose
+#endif
+
+using namespace Utilities;
+using std::cout;
+using std::endl;
+
+// Compiled modules of the previous runs
+static const char * SHADER_CACHE_DIR = "ShaderCache";
+static const uint32_t SHADER_CACHE_VERSION = 1;         // Bump to invalidate the cached modules (e.g. new compile options)
+static const uint32_t MAX_INCLUDE_DEPTH = 32;
+
+// glslangValidator in the Vulkan SDK (the directory is lower case on Linux and macOS)
+#ifdef _WIN32
+static const char * SDK_COMPILER_PATH = "/Bin/glslangValidator.exe";
+#else
+static const char * SDK_COMPILER_PATH = "/bin/glslangValidator";
+#endif
+
+// Stages by file extension (as glslangValidator infers them)
+static const char * GLSL_EXTENSIONS[] = { ".vert", ".frag", ".comp", ".geom", ".tesc", ".tese" };
+
+//------------------------------------------------------------------------------
+static bool readTextFile(const std::string &filePath, std::string * text)
+{
+    std::ifstream file(filePath, std::ios::binary);
+    if (!file.is_open())
+    {
+        return false;
+    }
+    std::ostringstream stream;
+    stream << file.rdbuf();
+    *text = stream.str();
+    return true;
+}
+
+#if SHADER_COMPILER_SHADERC
+//------------------------------------------------------------------------------
+static shaderc_shader_kind getShaderKind(const std::string &sourcePath)
+{
+    std::string extension = std::filesystem::path(sourcePath).extension().string();
+    if (extension == ".vert") return shaderc_vertex_shader;
+    if (extension == ".frag") return shaderc_fragment_shader;
+    if (extension == ".comp") return shaderc_compute_shader;
+    if (extension == ".geom") return shaderc_geometry_shader;
+    if (extension == ".tesc") return shaderc_tess_control_shader;
+    return shaderc_tess_evaluation_shader;
+}
+
+// #include "file" (relative to the including file) and #include <file> (relative to Shaders/)
+class ShaderIncluder : public shaderc::CompileOptions::IncluderInterface
+{
+public:
+    shaderc_include_result * GetInclude(const char * requestedSource, shaderc_include_type type,
+                                        const char * requestingSource, size_t /*includeDepth*/) override
+    {
+        Include * include = new Include;
+        std::filesystem::path path = (type == shaderc_include_type_relative)
+            ? std::filesystem::path(requestingSource).parent_path() / requestedSource
+            : std::filesystem::path("Shaders") / requestedSource;
+        include->name = path.generic_string();
+        if (!readTextFile(include->name, &include->content))
+        {
+            include->content = "Can't open the include file '" + include->name + "'";
+            include->name.clear();      // Empty name: the content is the error message
+        }
+        include->result = { include->name.data(), include->name.size(), include->content.data(), include->content.size(), include };
+        return &include->result;
+    }
+
+    void ReleaseInclude(shaderc_include_result * data) override
+    {
+        delete static_cast<Include *>(data->user_data);
+    }
+
+private:
+    struct Include
+    {
+        std::string             name;
+        std::string             content;
+        shaderc_include_result  result;
+    };
+};
+
+//------------------------------------------------------------------------------
+static shaderc::CompileOptions getCompileOptions(const std::vector<std::string> &defines)
+{
+    shaderc::CompileOptions options;
+    options.SetTargetEnvironment(shaderc_target_env_vulkan, shaderc_env_version_vulkan_1_0);
+    options.SetOptimizationLevel(shaderc_optimization_level_performance);
+    options.SetIncluder(std::make_unique<ShaderIncluder>());
+    for (const std::string &define : defines)
+    {
+        size_t equal = define.find('=');
+        if (equal == std::string::npos)
+        {
+            options.AddMacroDefinition(define);
+        }
+        else
+        {
+            options.AddMacroDefinition(define.substr(0, equal), define.substr(equal + 1));
+        }
+    }
+    return options;
+}
+#else
+//------------------------------------------------------------------------------
+static void expandIncludes(const std::string &filePath, uint32_t depth, std::string * text)
+{
+    std::string source;
+    if (depth > MAX_INCLUDE_DEPTH || !readTextFile(filePath, &source))
+    {
+        throw std::runtime_error("Can't read the shader source '" + filePath + "' (or too many nested includes)");
+    }
+
+    // Includes resolved (what the key depends on), the rest is left to glslangValidator
+    std::istringstream lines(source);
+    std::string line;
+    while (std::getline(lines, line))
+    {
+        size_t directive = line.find_first_not_of(" \t");
+        size_t open = line.find_first_of("\"<");
+        if (directive != std::string::npos && line.compare(directive, 8, "#include") == 0 && open != std::string::npos)
+        {
+            size_t close = line.find_first_of("\">", open + 1);
+            std::string name = line.substr(open + 1, close - open - 1);
+            std::filesystem::path path = (line[open] == '"') ? std::filesystem::path(filePath).parent_path() / name
+                                                             : std::filesystem::path("Shaders") / name;
+            expandIncludes(path.generic_string(), depth + 1, text);
+            continue;
+        }
+        text->append(line).append("\n");
+    }
+}
+#endif
+
+//------------------------------------------------------------------------------
+ShaderCompiler::ShaderCompiler()
+{
+}
+//------------------------------------------------------------------------------
+ShaderCompiler::~ShaderCompiler()
+{
+}
+//------------------------------------------------------------------------------
+void ShaderCompiler::create(uint32_t workerCount)
+{
+    // Without shaderc: from the Vulkan SDK if it's installed, otherwise from the PATH
+    const char * sdkPath = std::getenv("VULKAN_SDK");
+    std::error_code errorCode;
+    m_compilerPath = "glslangValidator";
+    if (sdkPath && std::filesystem::exists(std::string(sdkPath) + SDK_COMPILER_PATH, errorCode))
+    {
+        m_compilerPath = std::string(sdkPath) + SDK_COMPILER_PATH;
+    }
+    m_stop = false;
+
+    std::filesystem::create_directories(SHADER_CACHE_DIR, errorCode);
+
+    if (workerCount == 0)
+    {
+        workerCount = std::max(std::thread::hardware_concurrency(), 1U);
+    }
+    for (uint32_t i = 0; i < workerCount; ++i)
+    {
+        m_workers.emplace_back(&ShaderCompiler::workerLoop, this);
+    }
+}
+//------------------------------------------------------------------------------
+void ShaderCompiler::destroy()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_jobMutex);
+        m_stop = true;
+        m_jobs.clear();
+    }
+    m_jobAvailable.notify_all();
+    for (std::thread &worker : m_workers)
+    {
+        worker.join();
+    }
+    m_workers.clear();
+
+    std::lock_guard<std::mutex> lock(m_resultMutex);
+    m_results.clear();
+    m_variantKeys.clear();
+}
+//------------------------------------------------------------------------------
+bool ShaderCompiler::isGlslSource(const std::string &filePath)
+{
+    std::string extension = std::filesystem::path(filePath).extension().string();
+    return std::find(std::begin(GLSL_EXTENSIONS), std::end(GLSL_EXTENSIONS), extension) != std::end(GLSL_EXTENSIONS);
+}
+//------------------------------------------------------------------------------
+std::vector<uint32_t> ShaderCompiler::compile(const std::string &sourcePath, const std::vector<std::string> &defines)
+{
+    // Key: what the compiler actually sees, and how it compiles it
+    std::string preprocessed = preprocess(sourcePath, defines);
+    uint64_t key = hashFnv1a(preprocessed.data(), preprocessed.size());
+    key = hashCombine(key, SHADER_CACHE_VERSION);
+    key = hashCombine(key, SHADER_COMPILER_SHADERC);    // The two compilers don't produce the same code
+    key = hashCombine(key, std::filesystem::path(sourcePath).extension().string());
+    std::string variantName = sourcePath;
+    for (const std::string &define : defines)
+    {
+        key = hashCombine(key, define);
+        variantName += "\n" + define;
+    }
+
+    // First request of the variant: load or compile it, the others wait for it
+    std::promise<std::vector<uint32_t>> promise;
+    std::shared_future<std::vector<uint32_t>> result;
+    bool first = false;
+    {
+        std::lock_guard<std::mutex> lock(m_resultMutex);
+
+        // The previous source of the variant is never requested again (requests in flight keep their result)
+        uint64_t &variantKey = m_variantKeys[variantName];
+        if (variantKey != key)
+        {
+            m_results.erase(variantKey);
+            variantKey = key;
+        }
+
+        auto variant = m_results.find(key);
+        if (variant != m_results.end())
+        {
+            result = variant->second;
+        }
+        else
+        {
+            result = promise.get_future().share();
+            m_results.emplace(key, result);
+            first = true;
+        }
+    }
+
+    if (first)
+    {
+        try
+        {
+            std::string cacheFilePath = getCacheFilePath(key);
+            std::vector<uint32_t> words;
+            if (!loadCached(cacheFilePath, &words))
+            {
+                words = compileSource(sourcePath, preprocessed, defines, cacheFilePath);
+            }
+            promise.set_value(std::move(words));
+        }
+        catch (...)
+        {
+            promise.set_exception(std::current_exception());   // Same source, same errors: not retried
+        }
+    }
+
+    return result.get();
+}
+//------------------------------------------------------------------------------
+void ShaderCompiler::prepare(const std::string &sourcePath, const std::vector<std::string> &defines)
+{
+    queue({ sourcePath, defines, "" });
+}
+//------------------------------------------------------------------------------
+void ShaderCompiler::compileToFile(const std::string &sourcePath, const std::string &spirvPath, const std::vector<std::string> &defines)
+{
+    queue({ sourcePath, defines, spirvPath });
+}
+//------------------------------------------------------------------------------
+void ShaderCompiler::queue(Job &&job)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_jobMutex);
+        auto sameJob = [&job](const Job &other) {
+            return other.sourcePath == job.sourcePath && other.defines == job.defines && other.spirvPath == job.spirvPath;
+        };
+        if (std::find_if(m_jobs.begin(), m_jobs.end(), sameJob) != m_jobs.end())
+        {
+            return;     // Already queued (e.g. saved twice in a row)
+        }
+        m_jobs.push_back(std::move(job));
+    }
+    m_jobAvailable.notify_one();
+}
+//------------------------------------------------------------------------------
+void ShaderCompiler::workerLoop()
+{
+    std::unique_lock<std::mutex> lock(m_jobMutex);
+
+    while (true)
+    {
+        m_jobAvailable.wait(lock, [this]() { return m_stop || !m_jobs.empty(); });
+        if (m_stop)
+        {
+            return;
+        }
+
+        Job job = std::move(m_jobs.front());
+        m_jobs.pop_front();
+
+        lock.unlock();
+        try
+        {
+            std::vector<uint32_t> words = compile(job.sourcePath, job.defines);
+            if (!job.spirvPath.empty() && !writeFile(job.spirvPath, words))
+            {
+                cout << "ERROR: Failed to write '" << job.spirvPath << "'" << endl;
+            }
+        }
+        catch (const std::runtime_error &e)
+        {
+            cout << "ERROR: " << e.what() << endl;
+        }
+        lock.lock();
+    }
+}
+//------------------------------------------------------------------------------
+std::string ShaderCompiler::preprocess(const std::string &sourcePath, const std::vector<std::string> &defines)
+{
+#if SHADER_COMPILER_SHADERC
+    std::string source;
+    if (!readTextFile(sourcePath, &source))
+    {
+        throw std::runtime_error("Can't read the shader source '" + sourcePath + "'");
+    }
+
+    shaderc::Compiler compiler;
+    shaderc::PreprocessedSourceCompilationResult result =
+        compiler.PreprocessGlsl(source, getShaderKind(sourcePath), sourcePath.c_str(), getCompileOptions(defines));
+    if (result.GetCompilationStatus() != shaderc_compilation_status_success)
+    {
+        throw std::runtime_error("Failed to preprocess '" + sourcePath + "':\n" + result.GetErrorMessage());
+    }
+    return std::string(result.cbegin(), result.cend());
+#else
+    // Sources with their includes, and the defines right after #version (nothing else may precede it): the text is
+    // complete, it's what glslangValidator compiles
+    std::string text;
+    expandIncludes(sourcePath, 0, &text);
+
+    std::string defineLines;
+    for (const std::string &define : defines)
+    {
+        std::string line = define;
+        size_t equal = line.find('=');
+        if (equal != std::string::npos)
+        {
+            line[equal] = ' ';      // -DNAME=VALUE syntax
+        }
+        defineLines.append("#define ").append(line).append("\n");
+    }
+    size_t version = text.find("#version");
+    size_t insert = (version != std::string::npos) ? text.find('\n', version) : std::string::npos;
+    text.insert((insert != std::string::npos) ? insert + 1 : 0, defineLines);
+    return text;
+#endif
+}
+//------------------------------------------------------------------------------
+std::vector<uint32_t> ShaderCompiler::compileSource(const std::string &sourcePath, const std::string &preprocessed,
+                                                    const std::vector<std::string> &defines, const std::string &cacheFilePath)
+{
+#if SHADER_COMPILER_SHADERC
+    shaderc::Compiler compiler;
+    shaderc::SpvCompilationResult result =
+        compiler.CompileGlslToSpv(preprocessed, getShaderKind(sourcePath), sourcePath.c_str(), getCompileOptions(defines));
+    if (result.GetCompilationStatus() != shaderc_compilation_status_success)
+    {
+        throw std::runtime_error("Failed to compile '" + sourcePath + "':\n" + result.GetErrorMessage());
+    }
+    std::vector<uint32_t> words(result.cbegin(), result.cend());
+    writeFile(cacheFilePath, words);    // A failed write only costs a compilation on the next run
+    return words;
+#else
+    (void)defines;          // Already in the preprocessed text
+
+    // The hashed text is compiled (not the file, which may have been saved again since): written next to the cache
+    // entry with the stage extension of the source, compiled there, then the module is renamed in place
+    std::string tempPath = cacheFilePath + ".tmp";
+    std::string tempSourcePath = cacheFilePath + std::filesystem::path(sourcePath).extension().string();
+    {
+        std::ofstream file(tempSourcePath, std::ios::binary | std::ios::trunc);
+        file.write(preprocessed.data(), static_cast<std::streamsize>(preprocessed.size()));
+        if (!file.good())
+        {
+            throw std::runtime_error("Can't write '" + tempSourcePath + "'");
+        }
+    }
+    std::string command = "\"" + m_compilerPath + "\" -V --target-env vulkan1.0";
+    command += " \"" + tempSourcePath + "\" -o \"" + tempPath + "\" 2>&1";
+#ifdef _WIN32
+    command = "\"" + command + "\"";    // cmd.exe strips the outer quotes
+#endif
+
+    std::string output;
+    FILE * pipe = popen(command.c_str(), "r");
+    if (!pipe)
+    {
+        throw std::runtime_error("Can't run '" + m_compilerPath + "'");
+    }
+    char buffer[256];
+    while (fgets(buffer, sizeof(buffer), pipe))
+    {
+        output += buffer;
+    }
+
+    std::error_code errorCode;
+    std::vector<uint32_t> words;
+    int status = pclose(pipe);
+    std::filesystem::remove(tempSourcePath, errorCode);
+    if (status != 0)
+    {
+        std::filesystem::remove(tempPath, errorCode);
+        throw std::runtime_error("Failed to compile '" + sourcePath + "':\n" + output);
+    }
+    std::filesystem::rename(tempPath, cacheFilePath, errorCode);
+    if (errorCode || !loadCached(cacheFilePath, &words))
+    {
+        std::filesystem::remove(tempPath, errorCode);
+        throw std::runtime_error("Failed to read the compiled '" + sourcePath + "'");
+    }
+    return words;
+#endif
+}
+//------------------------------------------------------------------------------
+std::string ShaderCompiler::getCacheFilePath(uint64_t key)
+{
+    std::ostringstream path;
+    path << SHADER_CACHE_DIR << "/" << std::hex << std::setfill('0') << std::setw(16) << key << ".spv";
+    return path.str();
+}
+//------------------------------------------------------------------------------
+bool ShaderCompiler::loadCached(const std::string &cacheFilePath, std::vector<uint32_t> * words)
+{
+    std::ifstream file(cacheFilePath, std::ios::binary | std::ios::ate);
+    if (!file.is_open())
+    {
+        return false;
+    }
+    size_t size = static_cast<size_t>(file.tellg());
+    if (size == 0 || size % sizeof(uint32_t) != 0)
+    {
+        return false;   // Not a module (compiled again, and replaced)
+    }
+
+    words->resize(size / sizeof(uint32_t));
+    file.seekg(0);
+    file.read(reinterpret_cast<char *>(words->data()), size);
+    return file.good();
+}
+//------------------------------------------------------------------------------
+bool ShaderCompiler::writeFile(const std::string &filePath, const std::vector<uint32_t> &words)
+{
+    // Temporary file renamed over the previous one: never a truncated module, even for concurrent instances
+    std::error_code errorCode;
+    std::string tempFilePath = filePath + ".tmp";
+    {
+        std::ofstream file(tempFilePath, std::ios::binary | std::ios::trunc);
+        if (!file.is_open())
+        {
+            return false;
+        }
+        file.write(reinterpret_cast<const char *>(words.data()), words.size() * sizeof(uint32_t));
+        file.flush();
+        if (!file.good())
+        {
+            file.close();
+            std::filesystem::remove(tempFilePath, errorCode);
+            return false;
+        }
+    }
+
+    std::filesystem::rename(tempFilePath, filePath, errorCode);
+    if (errorCode)
+    {
+        std::filesystem::remove(tempFilePath, errorCode);
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,79 @@
+#ifndef SHADER_COMPILER_H
+#define SHADER_COMPILER_H
+
+// C++ STL
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <future>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+// Optional library (in the Vulkan SDK): build with UseShaderc=true, which defines USE_SHADERC and links
+// shaderc_shared.lib
+#ifdef USE_SHADERC
+    #define SHADER_COMPILER_SHADERC 1   // In-process compilation
+#else
+    #define SHADER_COMPILER_SHADERC 0   // glslangValidator processes (as compile_shaders.bat)
+#endif
+
+// GLSL to SPIR-V compilation service. compile() is thread safe (the pipeline workers call it concurrently, and
+// concurrent requests of a same variant share one compilation), and queued jobs run on a worker per core.
+// Modules are cached on disk (ShaderCache/), keyed by the hash of the preprocessed source (includes resolved, defines
+// applied) and of the compile options: a variant is compiled once, and later runs only preprocess and load it.
+class ShaderCompiler
+{
+public:
+    ShaderCompiler();
+    ~ShaderCompiler();
+
+    void        create(uint32_t workerCount = 0);       // 0: one per core
+    void        destroy();                              // Waits for the compilations in progress (queued jobs are dropped)
+
+    static bool isGlslSource(const std::string &filePath);     // Stage from the extension (.vert, .frag, .comp, ...)
+
+    // SPIR-V words of a variant (defines: "NAME" or "NAME=VALUE"). Throws with the compiler messages on errors.
+    std::vector<uint32_t>   compile(const std::string &sourcePath, const std::vector<std::string> &defines = {});
+
+    // Queued on the workers: warm the cache up (e.g. all the variants at init), or also write the module to a file
+    // (renamed over it once complete: readers never see a partial file; on errors the previous module stays)
+    void        prepare(const std::string &sourcePath, const std::vector<std::string> &defines = {});
+    void        compileToFile(const std::string &sourcePath, const std::string &spirvPath,
+                              const std::vector<std::string> &defines = {});
+
+private:
+    struct Job
+    {
+        std::string                 sourcePath;
+        std::vector<std::string>    defines;
+        std::string                 spirvPath;          // Empty: prepare only
+    };
+
+    std::string                 m_compilerPath;         // glslangValidator (without shaderc)
+    std::vector<std::thread>    m_workers;
+    std::mutex                  m_jobMutex;
+    std::condition_variable     m_jobAvailable;
+    std::deque<Job>             m_jobs;
+    bool                        m_stop = false;
+
+    // Variants of this run (key: cache key), compiled or in flight. Only the current source of each variant is kept:
+    // an edit supersedes the result (and the errors) of the previous one
+    std::mutex                  m_resultMutex;
+    std::unordered_map<uint64_t, std::shared_future<std::vector<uint32_t>>>  m_results;
+    std::unordered_map<std::string, uint64_t>   m_variantKeys;  // Current cache key (key: source path and defines)
+
+    // Methods
+    void        workerLoop();
+    void        queue(Job &&job);
+    std::string preprocess(const std::string &sourcePath, const std::vector<std::string> &defines);
+    std::vector<uint32_t>   compileSource(const std::string &sourcePath, const std::string &preprocessed,
+                                          const std::vector<std::string> &defines, const std::string &cacheFilePath);
+    static std::string      getCacheFilePath(uint64_t key);
+    static bool             loadCached(const std::string &cacheFilePath, std::vector<uint32_t> * words);
+    static bool             writeFile(const std::string &filePath, const std::vector<uint32_t> &words);
+};
+
+#endif //SHADER_COMPILER_H
@@ -0,0 +1,444 @@
+#include "ShaderReflection.h"
+
+// C++ STL
+#include <algorithm>
+#include <stdexcept>
+#include <unordered_map>
+
+// SPIR-V module words: header (magic number, version, generator, bound, schema), then the instructions
+static const size_t SPIRV_HEADER_WORDS = 5;
+
+// Opcodes (SPIR-V specification, 3.52)
+static const uint32_t OP_ENTRY_POINT = 15;
+static const uint32_t OP_TYPE_INT = 21;
+static const uint32_t OP_TYPE_FLOAT = 22;
+static const uint32_t OP_TYPE_VECTOR = 23;
+static const uint32_t OP_TYPE_MATRIX = 24;
+static const uint32_t OP_TYPE_IMAGE = 25;
+static const uint32_t OP_TYPE_SAMPLER = 26;
+static const uint32_t OP_TYPE_SAMPLED_IMAGE = 27;
+static const uint32_t OP_TYPE_ARRAY = 28;
+static const uint32_t OP_TYPE_RUNTIME_ARRAY = 29;
+static const uint32_t OP_TYPE_STRUCT = 30;
+static const uint32_t OP_TYPE_POINTER = 32;
+static const uint32_t OP_CONSTANT = 43;
+static const uint32_t OP_SPEC_CONSTANT = 50;            // Array sizes may be specialization constants: default value
+static const uint32_t OP_VARIABLE = 59;
+static const uint32_t OP_DECORATE = 71;
+static const uint32_t OP_MEMBER_DECORATE = 72;
+
+// Decorations (3.20)
+static const uint32_t DECORATION_BUFFER_BLOCK = 3;
+static const uint32_t DECORATION_ARRAY_STRIDE = 6;
+static const uint32_t DECORATION_MATRIX_STRIDE = 7;
+static const uint32_t DECORATION_BUILT_IN = 11;
+static const uint32_t DECORATION_LOCATION = 30;
+static const uint32_t DECORATION_BINDING = 33;
+static const uint32_t DECORATION_DESCRIPTOR_SET = 34;
+static const uint32_t DECORATION_OFFSET = 35;
+
+// Storage classes (3.7)
+static const uint32_t STORAGE_UNIFORM_CONSTANT = 0;
+static const uint32_t STORAGE_INPUT = 1;
+static const uint32_t STORAGE_UNIFORM = 2;
+static const uint32_t STORAGE_PUSH_CONSTANT = 9;
+static const uint32_t STORAGE_STORAGE_BUFFER = 12;
+
+// Image dimensionalities (3.8) and execution models (3.3)
+static const uint32_t DIM_BUFFER = 5;
+static const uint32_t DIM_SUBPASS_DATA = 6;
+static const uint32_t EXECUTION_MODEL_VERTEX = 0;
+static const VkShaderStageFlagBits EXECUTION_MODEL_STAGES[] = {
+    VK_SHADER_STAGE_VERTEX_BIT, VK_SHADER_STAGE_TESSELLATION_CONTROL_BIT, VK_SHADER_STAGE_TESSELLATION_EVALUATION_BIT,
+    VK_SHADER_STAGE_GEOMETRY_BIT, VK_SHADER_STAGE_FRAGMENT_BIT, VK_SHADER_STAGE_COMPUTE_BIT
+};
+
+// Declarations of a module, by result ID
+struct SpirvDeclarations
+{
+    struct Variable
+    {
+        uint32_t    id;
+        uint32_t    pointerType;
+        uint32_t    storageClass;
+    };
+
+    uint32_t    executionModel = UINT32_MAX;
+    std::unordered_map<uint32_t, std::vector<uint32_t>> types;      // Opcode, then the operands after the result ID
+    std::unordered_map<uint32_t, uint32_t>  constants;              // Scalar constants (low word)
+    std::unordered_map<uint64_t, uint32_t>  decorations;            // (ID, decoration) -> first literal (0 if none)
+    std::unordered_map<uint64_t, uint32_t>  memberDecorations;      // (struct ID, member, decoration) -> first literal
+    std::vector<Variable>                   variables;              // Global ones
+    std::string                             filePath;
+
+    static uint64_t decorationKey(uint32_t id, uint32_t decoration) { return (uint64_t(id) << 32) | decoration; }
+    static uint64_t memberKey(uint32_t id, uint32_t member, uint32_t decoration)
+    {
+        return (uint64_t(id) << 32) | (uint64_t(member) << 16) | decoration;
+    }
+
+    const std::vector<uint32_t> &   getType(uint32_t id) const;
+    const uint32_t *    findDecoration(uint32_t id, uint32_t decoration) const;
+    const uint32_t *    findMemberDecoration(uint32_t id, uint32_t member, uint32_t decoration) const;
+    uint32_t            getArrayLength(const std::vector<uint32_t> &arrayType) const;
+    uint32_t            getTypeSize(uint32_t id, uint32_t matrixStride = 0) const;
+    [[noreturn]] void   fail(const std::string &message) const;
+};
+
+//------------------------------------------------------------------------------
+const std::vector<uint32_t> & SpirvDeclarations::getType(uint32_t id) const
+{
+    auto type = types.find(id);
+    if (type == types.end())
+    {
+        fail("Undeclared type");
+    }
+    return type->second;
+}
+//------------------------------------------------------------------------------
+const uint32_t * SpirvDeclarations::findDecoration(uint32_t id, uint32_t decoration) const
+{
+    auto found = decorations.find(decorationKey(id, decoration));
+    return found != decorations.end() ? &found->second : nullptr;
+}
+//------------------------------------------------------------------------------
+const uint32_t * SpirvDeclarations::findMemberDecoration(uint32_t id, uint32_t member, uint32_t decoration) const
+{
+    auto found = memberDecorations.find(memberKey(id, member, decoration));
+    return found != memberDecorations.end() ? &found->second : nullptr;
+}
+//------------------------------------------------------------------------------
+uint32_t SpirvDeclarations::getArrayLength(const std::vector<uint32_t> &arrayType) const
+{
+    // OpTypeArray: element type, length (ID of a constant)
+    auto length = constants.find(arrayType[2]);
+    if (length == constants.end())
+    {
+        fail("Array length is not a constant");
+    }
+    return length->second;
+}
+//------------------------------------------------------------------------------
+uint32_t SpirvDeclarations::getTypeSize(uint32_t id, uint32_t matrixStride) const
+{
+    // Size in a block with explicit layout (offsets and strides are decorated, as std140/std430 require)
+    const std::vector<uint32_t> &type = getType(id);
+    switch (type[0])
+    {
+    case OP_TYPE_INT:
+    case OP_TYPE_FLOAT:
+        return type[1] / 8;                                             // Width [bits]
+    case OP_TYPE_VECTOR:
+        return type[2] * getTypeSize(type[1]);                          // Components
+    case OP_TYPE_MATRIX:
+        return type[2] * (matrixStride != 0 ? matrixStride : getTypeSize(type[1]));     // Columns
+    case OP_TYPE_ARRAY:
+    {
+        const uint32_t * arrayStride = findDecoration(id, DECORATION_ARRAY_STRIDE);
+        return getArrayLength(type) * (arrayStride ? *arrayStride : getTypeSize(type[1], matrixStride));
+    }
+    case OP_TYPE_STRUCT:
+    {
+        uint32_t size = 0;
+        for (uint32_t member = 0; member + 1 < type.size(); ++member)
+        {
+            const uint32_t * offset = findMemberDecoration(id, member, DECORATION_OFFSET);
+            const uint32_t * memberMatrixStride = findMemberDecoration(id, member, DECORATION_MATRIX_STRIDE);
+            uint32_t end = (offset ? *offset : size) + getTypeSize(type[member + 1], memberMatrixStride ? *memberMatrixStride : 0);
+            size = std::max(size, end);
+        }
+        return size;
+    }
+    default:
+        fail("Unsupported type in a block");
+    }
+    return 0;
+}
+//------------------------------------------------------------------------------
+void SpirvDeclarations::fail(const std::string &message) const
+{
+    throw std::runtime_error("Failed to reflect a SPIR-V module: " + message + "! ('" + filePath + "')");
+}
+
+//------------------------------------------------------------------------------
+static VkDescriptorType getDescriptorType(const SpirvDeclarations &declarations, uint32_t typeId, uint32_t storageClass,
+                                          uint32_t * count)
+{
+    // Arrays of resources: one binding, as many descriptors
+    *count = 1;
+    const std::vector<uint32_t> * type = &declarations.getType(typeId);
+    while ((*type)[0] == OP_TYPE_ARRAY || (*type)[0] == OP_TYPE_RUNTIME_ARRAY)
+    {
+        if ((*type)[0] == OP_TYPE_RUNTIME_ARRAY)
+        {
+            declarations.fail("Unsized descriptor arrays are not supported");
+        }
+        *count *= declarations.getArrayLength(*type);
+        typeId = (*type)[1];
+        type = &declarations.getType(typeId);
+    }
+
+    if (storageClass == STORAGE_STORAGE_BUFFER)
+    {
+        return VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    }
+    if (storageClass == STORAGE_UNIFORM)
+    {
+        // "buffer" blocks of SPIR-V 1.0-1.2 are Uniform with the BufferBlock decoration
+        return declarations.findDecoration(typeId, DECORATION_BUFFER_BLOCK) ? VK_DESCRIPTOR_TYPE_STORAGE_BUFFER
+                                                                           : VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+    }
+
+    switch ((*type)[0])
+    {
+    case OP_TYPE_SAMPLED_IMAGE:
+        return VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    case OP_TYPE_SAMPLER:
+        return VK_DESCRIPTOR_TYPE_SAMPLER;
+    case OP_TYPE_IMAGE:
+    {
+        // OpTypeImage: sampled type, dim, depth, arrayed, MS, sampled (1: with a sampler, 2: storage), format
+        uint32_t dim = (*type)[2];
+        bool storage = (*type)[6] == 2;
+        if (dim == DIM_SUBPASS_DATA)
+        {
+            return VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT;
+        }
+        if (dim == DIM_BUFFER)
+        {
+            return storage ? VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER : VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER;
+        }
+        return storage ? VK_DESCRIPTOR_TYPE_STORAGE_IMAGE : VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+    }
+    default:
+        declarations.fail("Unsupported resource type");
+    }
+    return VK_DESCRIPTOR_TYPE_MAX_ENUM;
+}
+//------------------------------------------------------------------------------
+static VkFormat getVertexFormat(const SpirvDeclarations &declarations, uint32_t typeId, uint32_t * size)
+{
+    // 32 bit scalars and vectors (as the vertex streams store them)
+    const std::vector<uint32_t> * type = &declarations.getType(typeId);
+    uint32_t componentCount = 1;
+    if ((*type)[0] == OP_TYPE_VECTOR)
+    {
+        componentCount = (*type)[2];
+        type = &declarations.getType((*type)[1]);
+    }
+    if (((*type)[0] != OP_TYPE_FLOAT && (*type)[0] != OP_TYPE_INT) || (*type)[1] != 32 || componentCount > 4)
+    {
+        declarations.fail("Unsupported vertex input type");
+    }
+    *size = componentCount * sizeof(uint32_t);
+
+    static const VkFormat FLOAT_FORMATS[] = { VK_FORMAT_R32_SFLOAT, VK_FORMAT_R32G32_SFLOAT, VK_FORMAT_R32G32B32_SFLOAT, VK_FORMAT_R32G32B32A32_SFLOAT };
+    static const VkFormat SINT_FORMATS[] = { VK_FORMAT_R32_SINT, VK_FORMAT_R32G32_SINT, VK_FORMAT_R32G32B32_SINT, VK_FORMAT_R32G32B32A32_SINT };
+    static const VkFormat UINT_FORMATS[] = { VK_FORMAT_R32_UINT, VK_FORMAT_R32G32_UINT, VK_FORMAT_R32G32B32_UINT, VK_FORMAT_R32G32B32A32_UINT };
+    if ((*type)[0] == OP_TYPE_FLOAT)
+    {
+        return FLOAT_FORMATS[componentCount - 1];
+    }
+    return (*type)[2] != 0 ? SINT_FORMATS[componentCount - 1] : UINT_FORMATS[componentCount - 1];     // Signedness
+}
+
+//------------------------------------------------------------------------------
+// ShaderReflection //
+//------------------------------------------------------------------------------
+void ShaderReflection::reflect(const SpirvCode &code, const std::string &filePath)
+{
+    *this = ShaderReflection();
+
+    // Collect the declarations (entry point, types, constants, decorations and global variables)
+    SpirvDeclarations declarations;
+    declarations.filePath = filePath;
+    const uint32_t * words = code.getWords();
+    size_t wordCount = code.getSize() / sizeof(uint32_t);
+    for (size_t i = SPIRV_HEADER_WORDS; i < wordCount; )
+    {
+        uint32_t opcode = words[i] & 0xFFFF;
+        uint32_t length = words[i] >> 16;           // Words, including this one
+        if (length == 0 || i + length > wordCount)
+        {
+            declarations.fail("Malformed instruction");
+        }
+        const uint32_t * operands = words + i + 1;
+
+        switch (opcode)
+        {
+        case OP_ENTRY_POINT:
+            if (declarations.executionModel == UINT32_MAX && length >= 3)
+            {
+                declarations.executionModel = operands[0];
+            }
+            break;
+        case OP_TYPE_INT:
+        case OP_TYPE_FLOAT:
+        case OP_TYPE_VECTOR:
+        case OP_TYPE_MATRIX:
+        case OP_TYPE_IMAGE:
+        case OP_TYPE_SAMPLER:
+        case OP_TYPE_SAMPLED_IMAGE:
+        case OP_TYPE_ARRAY:
+        case OP_TYPE_RUNTIME_ARRAY:
+        case OP_TYPE_STRUCT:
+        case OP_TYPE_POINTER:
+            if (length >= 2)
+            {
+                std::vector<uint32_t> &type = declarations.types[operands[0]];
+                type.assign(operands + 1, operands + length - 1);
+                type.insert(type.begin(), opcode);
+            }
+            break;
+        case OP_CONSTANT:
+        case OP_SPEC_CONSTANT:
+            if (length >= 4)
+            {
+                declarations.constants[operands[1]] = operands[2];
+            }
+            break;
+        case OP_VARIABLE:
+            if (length >= 4)
+            {
+                declarations.variables.push_back({ operands[1], operands[0], operands[2] });
+            }
+            break;
+        case OP_DECORATE:
+            if (length >= 3)
+            {
+                declarations.decorations[SpirvDeclarations::decorationKey(operands[0], operands[1])] = length >= 4 ? operands[2] : 0;
+            }
+            break;
+        case OP_MEMBER_DECORATE:
+            if (length >= 4)
+            {
+                declarations.memberDecorations[SpirvDeclarations::memberKey(operands[0], operands[1], operands[2])] = length >= 5 ? operands[3] : 0;
+            }
+            break;
+        default:
+            break;
+        }
+        i += length;
+    }
+
+    if (declarations.executionModel >= std::size(EXECUTION_MODEL_STAGES))
+    {
+        declarations.fail("No graphics or compute entry point");
+    }
+    VkShaderStageFlagBits stage = EXECUTION_MODEL_STAGES[declarations.executionModel];
+    stages = stage;
+
+    // Interface variables
+    for (const SpirvDeclarations::Variable &variable : declarations.variables)
+    {
+        const std::vector<uint32_t> &pointer = declarations.getType(variable.pointerType);
+        uint32_t typeId = pointer[2];               // OpTypePointer: storage class, pointee type
+
+        switch (variable.storageClass)
+        {
+        case STORAGE_INPUT:
+        {
+            // Vertex attributes (built-ins, e.g. gl_VertexIndex, are not fed by the vertex streams)
+            if (declarations.executionModel != EXECUTION_MODEL_VERTEX || declarations.findDecoration(variable.id, DECORATION_BUILT_IN))
+            {
+                break;
+            }
+            const uint32_t * location = declarations.findDecoration(variable.id, DECORATION_LOCATION);
+            if (!location)
+            {
+                declarations.fail("Vertex input without a location");
+            }
+            ShaderVertexInput input = {};
+            input.location = *location;
+            input.format = getVertexFormat(declarations, typeId, &input.size);
+            vertexInputs.push_back(input);
+            break;
+        }
+        case STORAGE_PUSH_CONSTANT:
+            pushConstantRange.stageFlags = stage;
+            pushConstantRange.offset = 0;
+            pushConstantRange.size = declarations.getTypeSize(typeId);
+            break;
+        case STORAGE_UNIFORM_CONSTANT:
+        case STORAGE_UNIFORM:
+        case STORAGE_STORAGE_BUFFER:
+        {
+            const uint32_t * set = declarations.findDecoration(variable.id, DECORATION_DESCRIPTOR_SET);
+            const uint32_t * binding = declarations.findDecoration(variable.id, DECORATION_BINDING);
+            if (!set || !binding)
+            {
+                declarations.fail("Resource without a descriptor set or binding");
+            }
+            VkDescriptorSetLayoutBinding layoutBinding = {};
+            layoutBinding.binding = *binding;
+            layoutBinding.descriptorType = getDescriptorType(declarations, typeId, variable.storageClass, &layoutBinding.descriptorCount);
+            layoutBinding.stageFlags = stage;
+            layoutBinding.pImmutableSamplers = nullptr;
+            descriptorSets[*set].push_back(layoutBinding);
+            break;
+        }
+        default:
+            break;
+        }
+    }
+
+    // Sorted: same declarations, same layouts (whatever the declaration order)
+    for (auto &set : descriptorSets)
+    {
+        std::sort(set.second.begin(), set.second.end(),
+            [](const VkDescriptorSetLayoutBinding &a, const VkDescriptorSetLayoutBinding &b) { return a.binding < b.binding; });
+    }
+    std::sort(vertexInputs.begin(), vertexInputs.end(),
+        [](const ShaderVertexInput &a, const ShaderVertexInput &b) { return a.location < b.location; });
+}
+//------------------------------------------------------------------------------
+void ShaderReflection::merge(const ShaderReflection &other)
+{
+    stages |= other.stages;
+
+    // Bindings declared by both stages must match: they are visible to both
+    for (const auto &otherSet : other.descriptorSets)
+    {
+        std::vector<VkDescriptorSetLayoutBinding> &bindings = descriptorSets[otherSet.first];
+        for (const VkDescriptorSetLayoutBinding &otherBinding : otherSet.second)
+        {
+            auto binding = std::find_if(bindings.begin(), bindings.end(),
+                [&otherBinding](const VkDescriptorSetLayoutBinding &b) { return b.binding == otherBinding.binding; });
+            if (binding == bindings.end())
+            {
+                bindings.push_back(otherBinding);
+                continue;
+            }
+            if (binding->descriptorType != otherBinding.descriptorType || binding->descriptorCount != otherBinding.descriptorCount)
+            {
+                throw std::runtime_error("Conflicting declarations of set " + std::to_string(otherSet.first) + ", binding "
+                                         + std::to_string(otherBinding.binding) + " in the shader stages!");
+            }
+            binding->stageFlags |= otherBinding.stageFlags;
+        }
+        std::sort(bindings.begin(), bindings.end(),
+            [](const VkDescriptorSetLayoutBinding &a, const VkDescriptorSetLayoutBinding &b) { return a.binding < b.binding; });
+    }
+
+    // A single range covering the blocks of all the stages (vkCmdPushConstants then takes the merged stage flags)
+    if (other.pushConstantRange.size != 0)
+    {
+        if (pushConstantRange.size == 0)
+        {
+            pushConstantRange = other.pushConstantRange;
+        }
+        else
+        {
+            uint32_t end = std::max(pushConstantRange.offset + pushConstantRange.size, other.pushConstantRange.offset + other.pushConstantRange.size);
+            pushConstantRange.offset = std::min(pushConstantRange.offset, other.pushConstantRange.offset);
+            pushConstantRange.size = end - pushConstantRange.offset;
+            pushConstantRange.stageFlags |= other.pushConstantRange.stageFlags;
+        }
+    }
+
+    // Only the vertex stage has some
+    if (vertexInputs.empty())
+    {
+        vertexInputs = other.vertexInputs;
+    }
+}
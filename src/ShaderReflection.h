@@ -0,0 +1,35 @@
+#ifndef SHADER_REFLECTION_H
+#define SHADER_REFLECTION_H
+
+// C++ STL
+#include <map>
+#include <string>
+#include <vector>
+
+// Project includes
+#include "SpirvCode.h"
+#include "Utilities.h"          // Utilities header includes GLFW [Graphics Library FrameWork] + Vulkan API
+
+// Vertex shader input (one attribute), as declared in the shader
+struct ShaderVertexInput
+{
+    uint32_t    location;
+    VkFormat    format;
+    uint32_t    size;                                   // [bytes]
+};
+
+// Interface of shader modules, read from their SPIR-V: descriptor bindings, push constants and vertex inputs. The
+// pipeline layouts and vertex input states are built from it, so they can't drift from the shader declarations.
+// Reflected from the declarations (decorations and types), whether the code uses them or not.
+struct ShaderReflection
+{
+    VkShaderStageFlags      stages = 0;
+    std::map<uint32_t, std::vector<VkDescriptorSetLayoutBinding>>   descriptorSets;     // By set, bindings sorted
+    VkPushConstantRange     pushConstantRange = {};     // Size 0: no push constants (stages merged in a single range)
+    std::vector<ShaderVertexInput>  vertexInputs;       // Vertex stage only, sorted by location
+
+    void        reflect(const SpirvCode &code, const std::string &filePath);     // Throws on unsupported declarations
+    void        merge(const ShaderReflection &other);   // Another stage of the pipeline (throws on conflicting bindings)
+};
+
+#endif //SHADER_REFLECTION_H
@@ -0,0 +1,102 @@
+#include "SpirvCode.h"
+
+// C++ STL
+#include <cstring>
+#include <stdexcept>
+
+// SPIR-V header: magic number, version, generator, bound, schema (5 words)
+static const uint32_t SPIRV_MAGIC = 0x07230203;
+static const uint32_t SPIRV_MAGIC_SWAPPED = 0x03022307;
+static const size_t SPIRV_HEADER_SIZE = 5 * sizeof(uint32_t);
+
+//------------------------------------------------------------------------------
+SpirvCode::SpirvCode()
+{
+}
+//------------------------------------------------------------------------------
+SpirvCode::~SpirvCode()
+{
+}
+//------------------------------------------------------------------------------
+void SpirvCode::load(const AssetArchive * archive, const std::string &filePath)
+{
+    m_file.close();
+    m_storage.clear();
+    m_words = {};
+
+    // Packed uncompressed (the AssetCooker never compresses shaders): straight from the archive mapping
+    if (archive)
+    {
+        std::span<const uint8_t> mapped = archive->find(filePath);
+        if (!mapped.empty())
+        {
+            setCode(mapped, true, filePath);
+            return;
+        }
+        std::vector<uint8_t> inflated;
+        std::span<const uint8_t> code;
+        if (archive->read(filePath, &inflated, &code))
+        {
+            setCode(code, false, filePath);
+            return;
+        }
+    }
+
+    // Loose file: mapped (page aligned)
+    if (!m_file.open(filePath))
+    {
+        throw std::runtime_error("Failed to open a SPIR-V file! ('" + filePath + "')");
+    }
+    setCode(std::span<const uint8_t>(m_file.getData(), m_file.getSize()), true, filePath);
+}
+//------------------------------------------------------------------------------
+void SpirvCode::assign(std::vector<uint32_t> &&words, const std::string &filePath)
+{
+    m_file.close();
+    m_storage = std::move(words);
+    m_words = {};
+
+    // Validated as the loaded ones (the storage is word aligned: used in place)
+    setCode(std::span<const uint8_t>(reinterpret_cast<const uint8_t *>(m_storage.data()), m_storage.size() * sizeof(uint32_t)),
+            true, filePath);
+}
+//------------------------------------------------------------------------------
+const uint32_t * SpirvCode::getWords() const
+{
+    return m_words.data();
+}
+//------------------------------------------------------------------------------
+size_t SpirvCode::getSize() const
+{
+    return m_words.size_bytes();
+}
+//------------------------------------------------------------------------------
+void SpirvCode::setCode(std::span<const uint8_t> code, bool mapped, const std::string &filePath)
+{
+    if (code.size() < SPIRV_HEADER_SIZE || code.size() % sizeof(uint32_t) != 0)
+    {
+        throw std::runtime_error("'" + filePath + "' is not a SPIR-V module (size " + std::to_string(code.size()) + ")!");
+    }
+    uint32_t magic;
+    memcpy(&magic, code.data(), sizeof(magic));
+    if (magic == SPIRV_MAGIC_SWAPPED)
+    {
+        throw std::runtime_error("SPIR-V module '" + filePath + "' has the wrong endianness!");
+    }
+    if (magic != SPIRV_MAGIC)
+    {
+        throw std::runtime_error("'" + filePath + "' is not a SPIR-V module (bad magic number)!");
+    }
+
+    // Mappings (page or archive blob aligned) are used in place, temporaries and misaligned data are copied
+    if (mapped && reinterpret_cast<uintptr_t>(code.data()) % alignof(uint32_t) == 0)
+    {
+        m_words = std::span<const uint32_t>(reinterpret_cast<const uint32_t *>(code.data()), code.size() / sizeof(uint32_t));
+    }
+    else
+    {
+        m_storage.resize(code.size() / sizeof(uint32_t));
+        memcpy(m_storage.data(), code.data(), code.size());
+        m_words = m_storage;
+    }
+}
@@ -0,0 +1,39 @@
+#ifndef SPIRV_CODE_H
+#define SPIRV_CODE_H
+
+// C++ STL
+#include <cstdint>
+#include <span>
+#include <string>
+#include <vector>
+
+// Project includes
+#include "AssetArchive.h"
+#include "MappedFile.h"
+
+// SPIR-V module code, validated (magic number, endianness, whole words) and 4 bytes aligned for vkCreateShaderModule.
+// Mapped without any copy from the asset archive or from the .spv file; only compressed archive entries (and,
+// defensively, misaligned data) are copied, into word storage. The code stays valid as long as this object lives.
+// Modules compiled at runtime (ShaderCompiler) are taken over as they are.
+class SpirvCode
+{
+public:
+    SpirvCode();
+    ~SpirvCode();
+
+    void            load(const AssetArchive * archive, const std::string &filePath);    // Throws on missing/invalid modules ('archive' may be null)
+    void            assign(std::vector<uint32_t> &&words, const std::string &filePath);  // Throws on invalid modules
+
+    const uint32_t *    getWords() const;
+    size_t          getSize() const;            // [bytes]
+
+private:
+    MappedFile                  m_file;
+    std::vector<uint32_t>       m_storage;
+    std::span<const uint32_t>   m_words;
+
+    // Methods
+    void            setCode(std::span<const uint8_t> code, bool mapped, const std::string &filePath);
+};
+
+#endif //SPIRV_CODE_H
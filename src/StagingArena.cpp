@@ -0,0 +1,211 @@
+#include "StagingArena.h"
+
+// C++ STL
+#include <atomic>
+#include <cstdlib>
+#include <stdexcept>
+
+using namespace Utilities;
+
+// Allocations alignment (texel blocks are 16 bytes at most, and copy offsets must be multiple of 4)
+static const VkDeviceSize STAGING_ALIGNMENT = 16;
+
+// Arena used by the stb_image allocation hooks, and size of the image being decoded on this thread (0: no decode scope)
+static std::atomic<StagingArena *>  sg_pStagingArena { nullptr };
+static thread_local size_t          st_decodeImageSize = 0;
+
+//------------------------------------------------------------------------------
+// stb_image allocation hooks (see STBI_MALLOC in Utilities.h) //
+//------------------------------------------------------------------------------
+void * stbiStagingMalloc(size_t size)
+{
+    // Decoded image (JPEG output has a trailing spare byte)
+    StagingArena * pArena = sg_pStagingArena.load(std::memory_order_acquire);
+    if (pArena && st_decodeImageSize > 0 && (size == st_decodeImageSize || size == st_decodeImageSize + 1))
+    {
+        void * data = pArena->allocate(size);
+        if (data)
+        {
+            return data;
+        }
+    }
+    return malloc(size);
+}
+//------------------------------------------------------------------------------
+void * stbiStagingRealloc(void * data, size_t size)
+{
+    StagingArena * pArena = sg_pStagingArena.load(std::memory_order_acquire);
+    if (pArena && data && pArena->contains(data))
+    {
+        // Not expected for the final image, but keep it correct: move it to the heap
+        void * newData = malloc(size);
+        if (newData)
+        {
+            memcpy(newData, data, static_cast<size_t>(std::min<VkDeviceSize>(pArena->getAllocationSize(data), size)));
+            pArena->release(data);
+        }
+        return newData;
+    }
+    return realloc(data, size);
+}
+//------------------------------------------------------------------------------
+void stbiStagingFree(void * data)
+{
+    StagingArena * pArena = sg_pStagingArena.load(std::memory_order_acquire);
+    if (pArena && data && pArena->contains(data))
+    {
+        pArena->release(data);
+        return;
+    }
+    free(data);
+}
+
+//------------------------------------------------------------------------------
+// StagingDecodeScope //
+//------------------------------------------------------------------------------
+StagingDecodeScope::StagingDecodeScope(size_t imageSize)
+{
+    st_decodeImageSize = imageSize;
+}
+//------------------------------------------------------------------------------
+StagingDecodeScope::~StagingDecodeScope()
+{
+    st_decodeImageSize = 0;
+}
+
+//------------------------------------------------------------------------------
+// StagingArena //
+//------------------------------------------------------------------------------
+StagingArena::StagingArena()
+{
+}
+//------------------------------------------------------------------------------
+StagingArena::~StagingArena()
+{
+}
+//------------------------------------------------------------------------------
+void StagingArena::create(VkPhysicalDevice physicalDevice, VkDevice device, VkDeviceSize capacity)
+{
+    m_device = device;
+    m_capacity = capacity;
+
+    createBuffer(physicalDevice, device, capacity, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+        &m_buffer, &m_memory);
+
+    // Mapped once, for the whole lifetime of the arena
+    void * data;
+    VkResult result = vkMapMemory(m_device, m_memory, 0, capacity, 0, &data);
+    if (result != VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to map the Staging Arena memory!");
+    }
+    m_mappedData = static_cast<uint8_t *>(data);
+
+    m_freeBlocks.clear();
+    m_allocations.clear();
+    m_freeBlocks[0] = capacity;
+
+    sg_pStagingArena.store(this, std::memory_order_release);
+}
+//------------------------------------------------------------------------------
+void StagingArena::destroy()
+{
+    sg_pStagingArena.store(nullptr, std::memory_order_release);
+
+    if (m_mappedData)
+    {
+        vkUnmapMemory(m_device, m_memory);
+        m_mappedData = nullptr;
+    }
+    vkDestroyBuffer(m_device, m_buffer, nullptr);
+    vkFreeMemory(m_device, m_memory, nullptr);
+    m_buffer = 0;
+    m_memory = 0;
+
+    m_freeBlocks.clear();
+    m_allocations.clear();
+}
+//------------------------------------------------------------------------------
+void * StagingArena::allocate(VkDeviceSize size)
+{
+    size = (size + STAGING_ALIGNMENT - 1) & ~(STAGING_ALIGNMENT - 1);
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    // First fit (free blocks always start and end aligned)
+    for (auto it = m_freeBlocks.begin(); it != m_freeBlocks.end(); ++it)
+    {
+        if (it->second < size)
+        {
+            continue;
+        }
+
+        VkDeviceSize offset = it->first;
+        VkDeviceSize remaining = it->second - size;
+        m_freeBlocks.erase(it);
+        if (remaining > 0)
+        {
+            m_freeBlocks[offset + size] = remaining;
+        }
+        m_allocations[offset] = size;
+
+        return m_mappedData + offset;
+    }
+    return nullptr;
+}
+//------------------------------------------------------------------------------
+void StagingArena::release(const void * data)
+{
+    VkDeviceSize offset = getOffset(data);
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto allocation = m_allocations.find(offset);
+    if (allocation == m_allocations.end())
+    {
+        return;
+    }
+    VkDeviceSize size = allocation->second;
+    m_allocations.erase(allocation);
+
+    // Merge with the following and the previous free blocks
+    auto next = m_freeBlocks.find(offset + size);
+    if (next != m_freeBlocks.end())
+    {
+        size += next->second;
+        m_freeBlocks.erase(next);
+    }
+    auto inserted = m_freeBlocks.emplace(offset, size).first;
+    if (inserted != m_freeBlocks.begin())
+    {
+        auto previous = std::prev(inserted);
+        if (previous->first + previous->second == offset)
+        {
+            previous->second += size;
+            m_freeBlocks.erase(inserted);
+        }
+    }
+}
+//------------------------------------------------------------------------------
+bool StagingArena::contains(const void * data)
+{
+    const uint8_t * bytes = static_cast<const uint8_t *>(data);
+    return m_mappedData != nullptr && bytes >= m_mappedData && bytes < m_mappedData + m_capacity;
+}
+//------------------------------------------------------------------------------
+VkDeviceSize StagingArena::getOffset(const void * data)
+{
+    return static_cast<VkDeviceSize>(static_cast<const uint8_t *>(data) - m_mappedData);
+}
+//------------------------------------------------------------------------------
+VkDeviceSize StagingArena::getAllocationSize(const void * data)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto allocation = m_allocations.find(getOffset(data));
+    return (allocation != m_allocations.end()) ? allocation->second : 0;
+}
+//------------------------------------------------------------------------------
+VkBuffer StagingArena::getBuffer()
+{
+    return m_buffer;
+}
@@ -0,0 +1,52 @@
+#ifndef STAGING_ARENA_H
+#define STAGING_ARENA_H
+
+// C++ STL
+#include <map>
+#include <mutex>
+#include <unordered_map>
+
+// Project includes
+#include "Utilities.h"          // Utilities header includes GLFW [Graphics Library FrameWork] + Vulkan API
+
+// Host visible staging buffer, persistently mapped and sub-allocated (thread safe) by the texture decoders:
+// stb_image writes the decoded pixels straight into it, and the upload copies from it to the image (no memcpy).
+class StagingArena
+{
+public:
+    StagingArena();
+    ~StagingArena();
+
+    void            create(VkPhysicalDevice physicalDevice, VkDevice device, VkDeviceSize capacity);
+    void            destroy();
+
+    void *          allocate(VkDeviceSize size);        // nullptr when there's no room (callers fall back to the heap)
+    void            release(const void * data);
+    bool            contains(const void * data);
+    VkDeviceSize    getOffset(const void * data);       // Offset in the buffer
+    VkDeviceSize    getAllocationSize(const void * data);
+
+    VkBuffer        getBuffer();
+
+private:
+    VkDevice                    m_device = nullptr;             // This is our Logical Device
+    VkBuffer                    m_buffer = 0;                   // '0' instead of 'nullptr' for compatibility with 32bit version
+    VkDeviceMemory              m_memory = 0;
+    uint8_t *                   m_mappedData = nullptr;
+    VkDeviceSize                m_capacity = 0;
+
+    std::mutex                                      m_mutex;
+    std::map<VkDeviceSize, VkDeviceSize>            m_freeBlocks;   // Offset -> size (sorted, to merge neighbours)
+    std::unordered_map<VkDeviceSize, VkDeviceSize>  m_allocations;  // Offset -> size
+};
+
+// While in scope, the stb_image allocations (on this thread) of 'imageSize' bytes - i.e. the decoded image -
+// are placed in the staging arena. Everything else (and everything when the arena is full) stays on the heap.
+class StagingDecodeScope
+{
+public:
+    StagingDecodeScope(size_t imageSize);
+    ~StagingDecodeScope();
+};
+
+#endif //STAGING_ARENA_H
@@ -0,0 +1,142 @@
+#include "TextureAtlas.h"
+
+// C++ STL
+#include <algorithm>
+
+using namespace Utilities;
+
+// Origins and padded sizes are multiples of the footprint of a texel of the coarsest page level
+static const uint32_t RECT_ALIGNMENT = 1U << (TextureAtlas::MIP_LEVELS - 1);
+
+//------------------------------------------------------------------------------
+TextureAtlas::TextureAtlas()
+{
+}
+//------------------------------------------------------------------------------
+TextureAtlas::~TextureAtlas()
+{
+}
+//------------------------------------------------------------------------------
+bool TextureAtlas::isPackable(VkFormat format, uint32_t width, uint32_t height)
+{
+    return format == VK_FORMAT_R8G8B8A8_UNORM && width <= MAX_TEXTURE_SIZE && height <= MAX_TEXTURE_SIZE;
+}
+//------------------------------------------------------------------------------
+bool TextureAtlas::add(int textureId, uint32_t width, uint32_t height, AtlasPlacement * placement)
+{
+    uint32_t paddedWidth = getPaddedSize(width);
+    uint32_t paddedHeight = getPaddedSize(height);
+
+    // First page with room, then a new one
+    uint32_t page = 0;
+    uint32_t x, y;
+    while (page < m_pages.size() && !allocate(m_pages[page], paddedWidth, paddedHeight, &x, &y))
+    {
+        ++page;
+    }
+    if (page == m_pages.size())
+    {
+        if (m_pages.size() == MAX_PAGES)
+        {
+            return false;
+        }
+        m_pages.emplace_back();
+        allocate(m_pages.back(), paddedWidth, paddedHeight, &x, &y);
+    }
+
+    placement->page = page;
+    placement->x = x;
+    placement->y = y;
+    placement->uvScaleOffset = glm::vec4(static_cast<float>(width), static_cast<float>(height),
+                                         static_cast<float>(x + PADDING), static_cast<float>(y + PADDING)) / static_cast<float>(PAGE_SIZE);
+    m_placements[textureId] = *placement;
+    return true;
+}
+//------------------------------------------------------------------------------
+void TextureAtlas::remove(int textureId)
+{
+    m_placements.erase(textureId);
+}
+//------------------------------------------------------------------------------
+const AtlasPlacement * TextureAtlas::find(int textureId)
+{
+    auto it = m_placements.find(textureId);
+    return it != m_placements.end() ? &it->second : nullptr;
+}
+//------------------------------------------------------------------------------
+uint32_t TextureAtlas::getPageCount()
+{
+    return static_cast<uint32_t>(m_pages.size());
+}
+//------------------------------------------------------------------------------
+void TextureAtlas::clear()
+{
+    m_pages.clear();
+    m_placements.clear();
+}
+//------------------------------------------------------------------------------
+std::vector<uint8_t> TextureAtlas::buildPaddedLevels(const uint8_t * pixels, uint32_t width, uint32_t height,
+                                                     const AtlasPlacement &placement, std::vector<VkBufferImageCopy> * regions)
+{
+    const uint32_t channels = 4;
+    uint32_t paddedWidth = getPaddedSize(width);
+    uint32_t paddedHeight = getPaddedSize(height);
+
+    // Texture in the middle, borders extruded from its edges (clamped coordinates)
+    std::vector<uint8_t> padded(static_cast<size_t>(paddedWidth) * paddedHeight * channels);
+    for (uint32_t y = 0; y < paddedHeight; ++y)
+    {
+        uint32_t srcY = static_cast<uint32_t>(std::clamp(static_cast<int>(y) - static_cast<int>(PADDING), 0, static_cast<int>(height) - 1));
+        for (uint32_t x = 0; x < paddedWidth; ++x)
+        {
+            uint32_t srcX = static_cast<uint32_t>(std::clamp(static_cast<int>(x) - static_cast<int>(PADDING), 0, static_cast<int>(width) - 1));
+            memcpy(&padded[(static_cast<size_t>(y) * paddedWidth + x) * channels],
+                   &pixels[(static_cast<size_t>(srcY) * width + srcX) * channels], channels);
+        }
+    }
+
+    // Aligned sizes: every level halves exactly, then the regions are moved to the rectangle in the page
+    std::vector<uint8_t> levels = buildMipChainRgba8(padded.data(), paddedWidth, paddedHeight, MIP_LEVELS, regions);
+    for (VkBufferImageCopy &region : *regions)
+    {
+        uint32_t level = region.imageSubresource.mipLevel;
+        region.imageOffset = { static_cast<int32_t>(placement.x >> level), static_cast<int32_t>(placement.y >> level), 0 };
+    }
+    return levels;
+}
+//------------------------------------------------------------------------------
+uint32_t TextureAtlas::getPaddedSize(uint32_t size)
+{
+    return (size + 2 * PADDING + RECT_ALIGNMENT - 1) & ~(RECT_ALIGNMENT - 1);
+}
+//------------------------------------------------------------------------------
+bool TextureAtlas::allocate(Page &page, uint32_t width, uint32_t height, uint32_t * x, uint32_t * y)
+{
+    // Best fitting shelf (least height wasted), unless it wastes more than half the rectangle height and a new shelf fits
+    Shelf * bestShelf = nullptr;
+    for (Shelf &shelf : page.shelves)
+    {
+        if (shelf.height >= height && shelf.usedWidth + width <= PAGE_SIZE &&
+            (!bestShelf || shelf.height < bestShelf->height))
+        {
+            bestShelf = &shelf;
+        }
+    }
+
+    bool newShelfFits = page.usedHeight + height <= PAGE_SIZE;
+    if (!bestShelf || (bestShelf->height - height > height / 2 && newShelfFits))
+    {
+        if (!newShelfFits)
+        {
+            return false;
+        }
+        page.shelves.push_back({ page.usedHeight, height, 0 });
+        page.usedHeight += height;
+        bestShelf = &page.shelves.back();
+    }
+
+    *x = bestShelf->usedWidth;
+    *y = bestShelf->y;
+    bestShelf->usedWidth += width;
+    return true;
+}
@@ -0,0 +1,70 @@
+#ifndef TEXTURE_ATLAS_H
+#define TEXTURE_ATLAS_H
+
+// C++ STL
+#include <unordered_map>
+#include <vector>
+
+// Project includes
+#include "Utilities.h"          // Utilities header includes GLFW [Graphics Library FrameWork] + Vulkan API
+
+// Where a texture lives in the atlas
+struct AtlasPlacement
+{
+    uint32_t        page            = 0;
+    uint32_t        x               = 0;        // Padded rectangle origin [texels, level 0]
+    uint32_t        y               = 0;
+    glm::vec4       uvScaleOffset   = {};       // Texture UVs to atlas UVs: uv * xy + zw
+};
+
+// Small textures packed in shared RGBA8 pages (one descriptor set per page instead of one per texture).
+// Rectangles are packed on shelves at load time. Each one is padded with its extruded edges, and both its origin and its
+// padded size are multiples of 2^(MIP_LEVELS - 1): every level of a rectangle covers whole texels, so the 2x2
+// downsampling never mixes two textures and bilinear/trilinear filtering stays inside the padding.
+// N.B.: atlased textures can't wrap (REPEAT addressing), and their space isn't reclaimed when they're removed.
+class TextureAtlas
+{
+public:
+    static constexpr uint32_t   PAGE_SIZE           = 2048;     // Page width and height [texels]
+    static constexpr uint32_t   MAX_PAGES           = 4;
+    static constexpr uint32_t   MIP_LEVELS          = 4;        // Page levels (finer ones would bleed through the padding)
+    static constexpr uint32_t   MAX_TEXTURE_SIZE    = 256;      // Larger textures get an image of their own
+    static constexpr uint32_t   PADDING             = 8;        // Extruded border on each side [texels, level 0]
+
+    TextureAtlas();
+    ~TextureAtlas();
+
+    static bool     isPackable(VkFormat format, uint32_t width, uint32_t height);
+
+    bool            add(int textureId, uint32_t width, uint32_t height, AtlasPlacement * placement);   // False: no room left
+    void            remove(int textureId);
+    const AtlasPlacement *  find(int textureId);
+    uint32_t        getPageCount();
+    void            clear();
+
+    // Padded (edge extruded) copy of a RGBA8 image with its mip levels, and the copy regions into its atlas page
+    static std::vector<uint8_t> buildPaddedLevels(const uint8_t * pixels, uint32_t width, uint32_t height,
+                                                  const AtlasPlacement &placement, std::vector<VkBufferImageCopy> * regions);
+
+private:
+    struct Shelf
+    {
+        uint32_t    y;
+        uint32_t    height;
+        uint32_t    usedWidth;
+    };
+    struct Page
+    {
+        std::vector<Shelf>  shelves;
+        uint32_t            usedHeight = 0;
+    };
+
+    std::vector<Page>                           m_pages;
+    std::unordered_map<int, AtlasPlacement>     m_placements;   // Key: texture ID (descriptor index)
+
+    // Methods
+    static uint32_t getPaddedSize(uint32_t size);
+    bool            allocate(Page &page, uint32_t width, uint32_t height, uint32_t * x, uint32_t * y);
+};
+
+#endif //TEXTURE_ATLAS_H
@@ -0,0 +1,178 @@
+#include "TextureCache.h"
+
+// C++ STL
+#include <algorithm>
+#include <cctype>
+#include <filesystem>
+
+using namespace Utilities;
+
+//------------------------------------------------------------------------------
+TextureCache::TextureCache()
+{
+}
+//------------------------------------------------------------------------------
+TextureCache::~TextureCache()
+{
+}
+//------------------------------------------------------------------------------
+std::string TextureCache::canonicalPath(const std::string &filePath)
+{
+    // weakly_canonical resolves '.', '..' and symlinks of the existing part of the path (and doesn't throw on missing files)
+    std::error_code error;
+    std::filesystem::path path = std::filesystem::weakly_canonical(std::filesystem::path(filePath), error);
+    if (error)
+    {
+        path = std::filesystem::absolute(std::filesystem::path(filePath), error).lexically_normal();
+    }
+
+    std::string canonical = path.generic_string();
+#ifdef _WIN32
+    // NTFS paths are case insensitive
+    std::transform(canonical.begin(), canonical.end(), canonical.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+#endif
+    return canonical;
+}
+//------------------------------------------------------------------------------
+uint64_t TextureCache::hashFileContent(const std::string &filePath)
+{
+    std::vector<char> fileData = readBinaryFile(filePath);
+    return hashCombine(hashFnv1a(fileData.data(), fileData.size()), fileData.size());
+}
+//------------------------------------------------------------------------------
+void TextureCache::setContentHashing(bool enabled)
+{
+    m_contentHashing = enabled;
+}
+//------------------------------------------------------------------------------
+bool TextureCache::isContentHashingEnabled()
+{
+    return m_contentHashing;
+}
+//------------------------------------------------------------------------------
+int TextureCache::acquire(const std::string &canonicalPath)
+{
+    auto lookup = m_pathLookup.find(canonicalPath);
+    if (lookup == m_pathLookup.end())
+    {
+        return -1;
+    }
+
+    ++m_entries[lookup->second].refCount;
+    return lookup->second;
+}
+//------------------------------------------------------------------------------
+int TextureCache::find(const std::string &canonicalPath)
+{
+    auto lookup = m_pathLookup.find(canonicalPath);
+    return (lookup != m_pathLookup.end()) ? lookup->second : -1;
+}
+//------------------------------------------------------------------------------
+int TextureCache::acquireByContent(const std::string &canonicalPath, uint64_t contentHash)
+{
+    auto lookup = m_contentLookup.find(contentHash);
+    if (lookup == m_contentLookup.end())
+    {
+        return -1;
+    }
+
+    // Same file under another name (copy, hard link): next time the path alone is enough
+    TextureCacheEntry &entry = m_entries[lookup->second];
+    entry.paths.push_back(canonicalPath);
+    m_pathLookup[canonicalPath] = lookup->second;
+
+    ++entry.refCount;
+    return lookup->second;
+}
+//------------------------------------------------------------------------------
+void TextureCache::insert(const std::string &canonicalPath, uint64_t contentHash, int imageIndex, int descriptorIndex)
+{
+    TextureCacheEntry &entry = m_entries[descriptorIndex];
+    entry.paths = { canonicalPath };
+    entry.contentHash = contentHash;
+    entry.imageIndex = imageIndex;
+    entry.descriptorIndex = descriptorIndex;
+    entry.refCount = 1;
+
+    m_pathLookup[canonicalPath] = descriptorIndex;
+    if (contentHash != 0)
+    {
+        m_contentLookup[contentHash] = descriptorIndex;
+    }
+}
+//------------------------------------------------------------------------------
+bool TextureCache::release(int descriptorIndex, int * imageIndex)
+{
+    auto it = m_entries.find(descriptorIndex);
+    if (it == m_entries.end() || --it->second.refCount > 0)
+    {
+        return false;
+    }
+
+    // Last reference: forget every key of the entry
+    for (const std::string &path : it->second.paths)
+    {
+        m_pathLookup.erase(path);
+    }
+    if (it->second.contentHash != 0)
+    {
+        m_contentLookup.erase(it->second.contentHash);
+    }
+    *imageIndex = it->second.imageIndex;
+
+    m_entries.erase(it);
+    return true;
+}
+//------------------------------------------------------------------------------
+void TextureCache::setLoadTicket(int descriptorIndex, uint64_t ticket)
+{
+    auto it = m_entries.find(descriptorIndex);
+    if (it != m_entries.end())
+    {
+        it->second.loadTicket = ticket;
+    }
+}
+//------------------------------------------------------------------------------
+bool TextureCache::isLoadPending(int descriptorIndex, uint64_t ticket)
+{
+    auto it = m_entries.find(descriptorIndex);
+    return it != m_entries.end() && it->second.loadTicket == ticket;
+}
+//------------------------------------------------------------------------------
+void TextureCache::completeLoad(int descriptorIndex, uint64_t ticket, int imageIndex)
+{
+    auto it = m_entries.find(descriptorIndex);
+    if (it != m_entries.end() && it->second.loadTicket == ticket)
+    {
+        it->second.imageIndex = imageIndex;
+        it->second.loadTicket = 0;
+    }
+}
+//------------------------------------------------------------------------------
+void TextureCache::setImageIndex(int descriptorIndex, int imageIndex)
+{
+    auto it = m_entries.find(descriptorIndex);
+    if (it != m_entries.end())
+    {
+        it->second.imageIndex = imageIndex;
+    }
+}
+//------------------------------------------------------------------------------
+int TextureCache::getImageIndex(int descriptorIndex)
+{
+    auto it = m_entries.find(descriptorIndex);
+    return (it != m_entries.end()) ? it->second.imageIndex : -1;
+}
+//------------------------------------------------------------------------------
+void TextureCache::clear()
+{
+    m_entries.clear();
+    m_pathLookup.clear();
+    m_contentLookup.clear();
+}
+//------------------------------------------------------------------------------
+size_t TextureCache::size()
+{
+    return m_entries.size();
+}
@@ -0,0 +1,63 @@
+#ifndef TEXTURE_CACHE_H
+#define TEXTURE_CACHE_H
+
+// C++ STL
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Project includes
+#include "Utilities.h"          // Utilities header includes GLFW [Graphics Library FrameWork] + Vulkan API
+
+// A resident texture, shared by all the paths (and contents) that resolve to it
+struct TextureCacheEntry
+{
+    std::vector<std::string>    paths;                  // Canonical paths (more than one when found by content)
+    uint64_t                    contentHash     = 0;    // 0 when content hashing is disabled
+    int                         imageIndex      = -1;   // Index in the renderer texture images/views (-1 while loading)
+    uint64_t                    loadTicket      = 0;    // Asynchronous load in progress (0: none)
+    int                         descriptorIndex = -1;   // Index in the renderer sampler descriptor sets
+    uint32_t                    refCount        = 0;
+};
+
+// Reference counted cache of the resident textures, keyed by canonical path and (optionally) by content hash.
+// It only does the bookkeeping: the renderer owns the Vulkan objects and destroys them when release() says so.
+class TextureCache
+{
+public:
+    TextureCache();
+    ~TextureCache();
+
+    static std::string  canonicalPath(const std::string &filePath);
+    static uint64_t     hashFileContent(const std::string &filePath);  // Throws if the file can't be read
+
+    void        setContentHashing(bool enabled);
+    bool        isContentHashingEnabled();
+
+    // Return the descriptor index of a resident texture (adding a reference), -1 on miss
+    int         acquire(const std::string &canonicalPath);
+    int         acquireByContent(const std::string &canonicalPath, uint64_t contentHash);   // Aliases the path on hit
+    int         find(const std::string &canonicalPath);    // Descriptor index without adding a reference, -1 on miss
+
+    void        insert(const std::string &canonicalPath, uint64_t contentHash, int imageIndex, int descriptorIndex);
+    bool        release(int descriptorIndex, int * imageIndex);    // True when the last reference is gone (entry removed)
+    void        clear();
+
+    // Asynchronous loads (completions of released/replaced entries don't match the ticket anymore)
+    void        setLoadTicket(int descriptorIndex, uint64_t ticket);
+    bool        isLoadPending(int descriptorIndex, uint64_t ticket);
+    void        completeLoad(int descriptorIndex, uint64_t ticket, int imageIndex);
+    void        setImageIndex(int descriptorIndex, int imageIndex);    // The image was rebuilt (e.g. streaming)
+    int         getImageIndex(int descriptorIndex);                    // -1: loading, failed, or in an atlas page
+
+    size_t      size();
+
+private:
+    bool                                        m_contentHashing = false;
+
+    std::unordered_map<int, TextureCacheEntry>  m_entries;          // Key: descriptor index
+    std::unordered_map<std::string, int>        m_pathLookup;       // Canonical path -> descriptor index
+    std::unordered_map<uint64_t, int>           m_contentLookup;    // Content hash -> descriptor index
+};
+
+#endif //TEXTURE_CACHE_H
@@ -0,0 +1,323 @@
+#include "TextureDiskCache.h"
+
+// C++ STL
+#include <algorithm>
+#include <filesystem>
+#include <iomanip>
+#include <sstream>
+#include <thread>
+
+// Project includes
+#include "MappedFile.h"
+#include "TextureCache.h"
+
+using namespace Utilities;
+using std::cout;
+using std::endl;
+
+// Directory (relative to the Current Working Directory) where the processed textures are stored
+static const char * TEXTURE_DISK_CACHE_DIR = "TextureDiskCache";
+static const char * TEXTURE_DISK_CACHE_EXT = ".tex";
+// Entry header identification ('TXDC'), bump the version when the processing (decoders, encoders) changes its output
+static const uint32_t ENTRY_MAGIC = 0x43445854;
+static const uint32_t ENTRY_VERSION = 1;
+// Texel data offset alignment (block compressed levels and staging copies)
+static const uint64_t ENTRY_DATA_ALIGNMENT = 16;
+
+// Entry file: header | regions | texel data (all the levels in the regions)
+struct EntryHeader
+{
+    uint32_t    magic;
+    uint32_t    version;
+    uint64_t    processingKey;
+    uint64_t    sourceSize;
+    int64_t     sourceTime;         // Last write time (file clock ticks)
+    uint64_t    sourceHash;         // Content hash (checked when only the time changed)
+    uint32_t    format;             // VkFormat
+    uint32_t    width;
+    uint32_t    height;
+    uint32_t    mipLevels;
+    uint32_t    regionCount;
+    uint32_t    reserved;
+    uint64_t    dataOffset;
+    uint64_t    dataSize;
+};
+struct EntryRegion
+{
+    uint64_t    bufferOffset;       // In the texel data
+    uint32_t    mipLevel;
+    uint32_t    width;
+    uint32_t    height;
+    uint32_t    reserved;
+};
+
+//------------------------------------------------------------------------------
+static bool getRegionSize(VkFormat format, uint32_t width, uint32_t height, uint64_t * size)
+{
+    // Formats the renderer stores: RGBA8, or 4x4 blocks of 8 (BC1) or 16 (BC7) bytes
+    uint64_t blocks = ((static_cast<uint64_t>(width) + 3) / 4) * ((static_cast<uint64_t>(height) + 3) / 4);
+    switch (format)
+    {
+    case VK_FORMAT_R8G8B8A8_UNORM:          *size = static_cast<uint64_t>(width) * height * 4;  return true;
+    case VK_FORMAT_BC1_RGB_UNORM_BLOCK:     *size = blocks * 8;                                 return true;
+    case VK_FORMAT_BC7_UNORM_BLOCK:         *size = blocks * 16;                                return true;
+    default:                                                                                    return false;
+    }
+}
+//------------------------------------------------------------------------------
+static bool isRegionValid(const EntryHeader &header, const EntryRegion &region)
+{
+    // An existing level, whose texels all lie in the texel data
+    uint64_t size = 0;
+    return region.mipLevel < header.mipLevels && region.width > 0 && region.height > 0
+        && region.width <= std::max(header.width >> region.mipLevel, 1U) && region.height <= std::max(header.height >> region.mipLevel, 1U)
+        && getRegionSize(static_cast<VkFormat>(header.format), region.width, region.height, &size)
+        && region.bufferOffset < header.dataSize && size <= header.dataSize - region.bufferOffset;
+}
+//------------------------------------------------------------------------------
+TextureDiskCache::TextureDiskCache()
+{
+}
+//------------------------------------------------------------------------------
+TextureDiskCache::~TextureDiskCache()
+{
+}
+//------------------------------------------------------------------------------
+void TextureDiskCache::create(VkDeviceSize maxSize)
+{
+    m_maxSize = maxSize;
+
+    std::error_code errorCode;
+    std::filesystem::create_directories(TEXTURE_DISK_CACHE_DIR, errorCode);
+
+    // The limit may have been lowered since the last run
+    trim();
+}
+//------------------------------------------------------------------------------
+void TextureDiskCache::clear()
+{
+    std::lock_guard<std::mutex> lock(m_trimMutex);
+    std::error_code errorCode;
+    for (const auto &entry : std::filesystem::directory_iterator(TEXTURE_DISK_CACHE_DIR, errorCode))
+    {
+        if (entry.path().extension() == TEXTURE_DISK_CACHE_EXT)
+        {
+            std::filesystem::remove(entry.path(), errorCode);
+        }
+    }
+}
+//------------------------------------------------------------------------------
+bool TextureDiskCache::load(const std::string &sourcePath, uint64_t processingKey, TextureData * texture, StagingArena * stagingArena)
+{
+    std::error_code errorCode;
+    uint64_t sourceSize = std::filesystem::file_size(sourcePath, errorCode);
+    int64_t sourceTime = std::filesystem::last_write_time(sourcePath, errorCode).time_since_epoch().count();
+    std::string entryPath = getEntryPath(sourcePath, processingKey);
+
+    MappedFile entry;
+    if (errorCode || !entry.open(entryPath))
+    {
+        ++m_missCount;
+        return false;
+    }
+
+    // Written by this version with the same options, and complete
+    EntryHeader header;
+    bool valid = entry.getSize() >= sizeof(EntryHeader);
+    if (valid)
+    {
+        memcpy(&header, entry.getData(), sizeof(EntryHeader));
+        valid = header.magic == ENTRY_MAGIC && header.version == ENTRY_VERSION && header.processingKey == processingKey
+            && header.width > 0 && header.height > 0 && header.mipLevels > 0 && header.mipLevels <= 32
+            && header.regionCount > 0 && header.regionCount <= header.mipLevels
+            && sizeof(EntryHeader) + header.regionCount * sizeof(EntryRegion) <= header.dataOffset
+            && header.dataOffset <= entry.getSize() && header.dataSize <= entry.getSize() - header.dataOffset;
+    }
+
+    // Every region inside the texel data (a corrupted entry must not make the upload read past it)
+    std::vector<EntryRegion> entryRegions(valid ? header.regionCount : 0);
+    for (uint32_t i = 0; i < entryRegions.size() && valid; ++i)
+    {
+        memcpy(&entryRegions[i], entry.getData() + sizeof(EntryHeader) + i * sizeof(EntryRegion), sizeof(EntryRegion));
+        valid = isRegionValid(header, entryRegions[i]);
+    }
+
+    // Produced from the current source: same size, and same modification time (or same content if only the time changed)
+    valid = valid && header.sourceSize == sourceSize
+        && (header.sourceTime == sourceTime || header.sourceHash == TextureCache::hashFileContent(sourcePath));
+    if (!valid)
+    {
+        entry.close();
+        std::filesystem::remove(entryPath, errorCode);
+        ++m_missCount;
+        return false;
+    }
+
+    texture->format = static_cast<VkFormat>(header.format);
+    texture->width = header.width;
+    texture->height = header.height;
+    texture->mipLevels = header.mipLevels;
+    texture->regions.clear();
+    for (const EntryRegion &entryRegion : entryRegions)
+    {
+        VkBufferImageCopy region = {};
+        region.bufferOffset = entryRegion.bufferOffset;
+        region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        region.imageSubresource.mipLevel = entryRegion.mipLevel;
+        region.imageSubresource.baseArrayLayer = 0;
+        region.imageSubresource.layerCount = 1;
+        region.imageOffset = { 0, 0, 0 };
+        region.imageExtent = { entryRegion.width, entryRegion.height, 1 };
+        texture->regions.push_back(region);
+    }
+
+    // Mapped pages copied straight into the staging arena (to the heap if there's no room, or no arena)
+    const uint8_t * texels = entry.getData() + header.dataOffset;
+    void * stagingData = stagingArena ? stagingArena->allocate(header.dataSize) : nullptr;
+    if (stagingData)
+    {
+        memcpy(stagingData, texels, static_cast<size_t>(header.dataSize));
+        texture->stagingData = static_cast<const uint8_t *>(stagingData);
+    }
+    else
+    {
+        texture->data.assign(texels, texels + header.dataSize);
+    }
+    entry.close();
+
+    // Most recently used (the eviction order)
+    std::filesystem::last_write_time(entryPath, std::filesystem::file_time_type::clock::now(), errorCode);
+
+    ++m_hitCount;
+    return true;
+}
+//------------------------------------------------------------------------------
+void TextureDiskCache::store(const std::string &sourcePath, uint64_t processingKey, const TextureData &texture,
+                             const uint8_t * data, size_t dataSize)
+{
+    std::error_code errorCode;
+    EntryHeader header = {};
+    header.magic = ENTRY_MAGIC;
+    header.version = ENTRY_VERSION;
+    header.processingKey = processingKey;
+    header.sourceSize = std::filesystem::file_size(sourcePath, errorCode);
+    header.sourceTime = std::filesystem::last_write_time(sourcePath, errorCode).time_since_epoch().count();
+    if (errorCode)
+    {
+        return;     // Source gone
+    }
+    header.sourceHash = TextureCache::hashFileContent(sourcePath);
+    header.format = static_cast<uint32_t>(texture.format);
+    header.width = texture.width;
+    header.height = texture.height;
+    header.mipLevels = texture.mipLevels;
+    header.regionCount = static_cast<uint32_t>(texture.regions.size());
+    header.dataOffset = (sizeof(EntryHeader) + header.regionCount * sizeof(EntryRegion) + ENTRY_DATA_ALIGNMENT - 1) & ~(ENTRY_DATA_ALIGNMENT - 1);
+    header.dataSize = dataSize;
+    if (header.dataOffset + header.dataSize > m_maxSize)
+    {
+        return;     // It would evict everything else
+    }
+
+    std::vector<uint8_t> headerData(static_cast<size_t>(header.dataOffset), 0);
+    memcpy(headerData.data(), &header, sizeof(EntryHeader));
+    for (uint32_t i = 0; i < header.regionCount; ++i)
+    {
+        const VkBufferImageCopy &region = texture.regions[i];
+        EntryRegion entryRegion = { region.bufferOffset, region.imageSubresource.mipLevel, region.imageExtent.width, region.imageExtent.height, 0 };
+        memcpy(headerData.data() + sizeof(EntryHeader) + i * sizeof(EntryRegion), &entryRegion, sizeof(EntryRegion));
+    }
+
+    // Write to a temporary file (one per thread), then rename it over the previous entry: readers never see a partial one
+    std::string entryPath = getEntryPath(sourcePath, processingKey);
+    std::ostringstream tempFilePath;
+    tempFilePath << entryPath << "." << std::hash<std::thread::id>()(std::this_thread::get_id()) << ".tmp";
+    {
+        std::ofstream file(tempFilePath.str(), std::ios::binary | std::ios::trunc);
+        if (!file.is_open())
+        {
+            cout << "Failed to write the Texture Disk Cache entry '" << tempFilePath.str() << "'" << endl;
+            return;
+        }
+        file.write(reinterpret_cast<const char *>(headerData.data()), headerData.size());
+        file.write(reinterpret_cast<const char *>(data), dataSize);
+        file.flush();
+        if (!file.good())
+        {
+            file.close();
+            std::filesystem::remove(tempFilePath.str(), errorCode);
+            return;
+        }
+    }
+
+    std::filesystem::rename(tempFilePath.str(), entryPath, errorCode);
+    if (errorCode)
+    {
+        std::filesystem::remove(tempFilePath.str(), errorCode);
+        return;
+    }
+
+    trim();
+}
+//------------------------------------------------------------------------------
+TextureDiskCacheStats TextureDiskCache::getStats()
+{
+    TextureDiskCacheStats stats;
+    stats.hitCount = m_hitCount.load();
+    stats.missCount = m_missCount.load();
+    return stats;
+}
+//------------------------------------------------------------------------------
+std::string TextureDiskCache::getEntryPath(const std::string &sourcePath, uint64_t processingKey)
+{
+    // <hash of canonical source path + processing key>.tex
+    uint64_t key = hashCombine(hashCombine(FNV_OFFSET_BASIS, TextureCache::canonicalPath(sourcePath)), processingKey);
+    std::ostringstream path;
+    path << TEXTURE_DISK_CACHE_DIR << "/" << std::hex << std::setfill('0') << std::setw(16) << key << TEXTURE_DISK_CACHE_EXT;
+    return path.str();
+}
+//------------------------------------------------------------------------------
+void TextureDiskCache::trim()
+{
+    struct EntryFile
+    {
+        std::filesystem::path               path;
+        uint64_t                            size;
+        std::filesystem::file_time_type     lastUsed;
+    };
+
+    std::lock_guard<std::mutex> lock(m_trimMutex);
+    std::error_code errorCode;
+    std::vector<EntryFile> entries;
+    uint64_t totalSize = 0;
+    for (const auto &entry : std::filesystem::directory_iterator(TEXTURE_DISK_CACHE_DIR, errorCode))
+    {
+        if (entry.path().extension() == TEXTURE_DISK_CACHE_EXT)
+        {
+            EntryFile entryFile = { entry.path(), entry.file_size(errorCode), entry.last_write_time(errorCode) };
+            if (!errorCode)
+            {
+                totalSize += entryFile.size;
+                entries.push_back(entryFile);
+            }
+        }
+    }
+    if (totalSize <= m_maxSize)
+    {
+        return;
+    }
+
+    // Least recently used first
+    std::sort(entries.begin(), entries.end(), [](const EntryFile &a, const EntryFile &b) { return a.lastUsed < b.lastUsed; });
+    for (const EntryFile &entryFile : entries)
+    {
+        if (totalSize <= m_maxSize)
+        {
+            break;
+        }
+        if (std::filesystem::remove(entryFile.path, errorCode))
+        {
+            totalSize -= entryFile.size;
+        }
+    }
+}
@@ -0,0 +1,53 @@
+#ifndef TEXTURE_DISK_CACHE_H
+#define TEXTURE_DISK_CACHE_H
+
+// C++ STL
+#include <atomic>
+#include <mutex>
+#include <string>
+
+// Project includes
+#include "AssetLoader.h"
+#include "StagingArena.h"
+#include "Utilities.h"          // Utilities header includes GLFW [Graphics Library FrameWork] + Vulkan API
+
+struct TextureDiskCacheStats
+{
+    uint32_t        hitCount        = 0;        // Textures mapped from the cache (decode skipped)
+    uint32_t        missCount       = 0;        // Textures decoded (and stored)
+};
+
+// On-disk cache of processed textures (decoded, mip-generated and block compressed, as the options ask), so that the
+// next runs skip the image decode: entries are memory mapped and copied straight into the staging arena.
+// One entry per source file and processing options. An entry is valid while the source size and modification time match
+// (or, when only the time changed, its content hash): stale, incompatible and corrupted entries (levels outside of their
+// texel data) are deleted when they're found.
+// The total size is kept under a limit, evicting the least recently used entries first. Thread safe.
+class TextureDiskCache
+{
+public:
+    TextureDiskCache();
+    ~TextureDiskCache();
+
+    void            create(VkDeviceSize maxSize);
+    void            clear();                            // Deletes every entry
+
+    // 'processingKey' hashes the options the texture data depends on (format, quality, mip levels...)
+    bool            load(const std::string &sourcePath, uint64_t processingKey, TextureData * texture, StagingArena * stagingArena);
+    void            store(const std::string &sourcePath, uint64_t processingKey, const TextureData &texture,
+                          const uint8_t * data, size_t dataSize);
+
+    TextureDiskCacheStats   getStats();
+
+private:
+    VkDeviceSize            m_maxSize = 0;
+    std::mutex              m_trimMutex;                // Size limit enforcement (one writer at a time)
+    std::atomic<uint32_t>   m_hitCount { 0 };
+    std::atomic<uint32_t>   m_missCount { 0 };
+
+    // Methods
+    std::string     getEntryPath(const std::string &sourcePath, uint64_t processingKey);
+    void            trim();
+};
+
+#endif //TEXTURE_DISK_CACHE_H
@@ -0,0 +1,284 @@
+#include "TextureStreamer.h"
+
+// C++ STL
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+// Textures start with the levels up to this size [texels] (quick to load, good enough until the object gets close)
+static const uint32_t INITIAL_RESIDENT_SIZE = 64;
+// Bytes uploaded per frame to raise the residency (one change is always allowed, to make progress)
+static const VkDeviceSize MAX_STREAMED_BYTES_PER_FRAME = 8 * 1024 * 1024;
+// Share of the device heap budget the textures can take (headroom for the other allocations)
+static const double DEVICE_BUDGET_SHARE = 0.9;
+
+//------------------------------------------------------------------------------
+TextureStreamer::TextureStreamer()
+{
+}
+//------------------------------------------------------------------------------
+TextureStreamer::~TextureStreamer()
+{
+}
+//------------------------------------------------------------------------------
+void TextureStreamer::create(VkPhysicalDevice physicalDevice, bool memoryBudgetSupported, VkDeviceSize budget)
+{
+    m_physicalDevice = physicalDevice;
+    m_memoryBudgetSupported = memoryBudgetSupported;
+    m_budget = budget;
+}
+//------------------------------------------------------------------------------
+uint32_t TextureStreamer::getInitialBase(const TextureData &texture)
+{
+    uint32_t base = 0;
+    while (base + 1 < static_cast<uint32_t>(texture.regions.size()) &&
+           std::max(texture.width >> base, texture.height >> base) > INITIAL_RESIDENT_SIZE)
+    {
+        ++base;
+    }
+    return base;
+}
+//------------------------------------------------------------------------------
+void TextureStreamer::add(int textureId, TextureData &&source, int imageIndex, uint32_t residentBase)
+{
+    // Only the levels that aren't resident stay in host memory (the others are on the device, read back when evicted)
+    StreamedTexture &texture = m_textures[textureId];
+    texture.format = source.format;
+    texture.width = source.width;
+    texture.height = source.height;
+    texture.regions = std::move(source.regions);
+    texture.size = source.data.size();
+    texture.hostLevels.assign(texture.regions.size(), {});
+    for (uint32_t level = 0; level < residentBase; ++level)
+    {
+        auto begin = source.data.begin() + static_cast<size_t>(texture.regions[level].bufferOffset);
+        texture.hostLevels[level].assign(begin, begin + static_cast<size_t>(getLevelSize(texture, level)));
+    }
+    source.data = {};
+    texture.transitId = 0;
+    texture.imageIndex = imageIndex;
+    texture.residentBase = residentBase;
+    texture.desiredBase = residentBase;
+    texture.lastUsedFrame = 0;
+
+    m_residentBytes += getResidentSize(texture, residentBase);
+}
+//------------------------------------------------------------------------------
+void TextureStreamer::remove(int textureId)
+{
+    auto it = m_textures.find(textureId);
+    if (it != m_textures.end())
+    {
+        m_residentBytes -= getResidentSize(it->second, it->second.residentBase);
+        m_textures.erase(it);
+    }
+}
+//------------------------------------------------------------------------------
+StreamedTexture * TextureStreamer::find(int textureId)
+{
+    auto it = m_textures.find(textureId);
+    return (it != m_textures.end()) ? &it->second : nullptr;
+}
+//------------------------------------------------------------------------------
+void TextureStreamer::requestScreenSize(int textureId, float screenSize, uint64_t frameNumber)
+{
+    StreamedTexture * texture = find(textureId);
+    if (!texture)
+    {
+        return;     // Still loading (or not streamed)
+    }
+
+    // One texel per pixel: level = log2(texture size / screen size)
+    uint32_t lastLevel = static_cast<uint32_t>(texture->regions.size()) - 1;
+    float textureSize = static_cast<float>(std::max(texture->width, texture->height));
+    float level = std::floor(std::log2(textureSize / std::max(screenSize, 1.0f)));
+    uint32_t desiredBase = std::min(static_cast<uint32_t>(std::max(level, 0.0f)), lastLevel);
+
+    // The largest object using the texture wins
+    if (texture->lastUsedFrame != frameNumber)
+    {
+        texture->desiredBase = desiredBase;
+        texture->lastUsedFrame = frameNumber;
+    }
+    else
+    {
+        texture->desiredBase = std::min(texture->desiredBase, desiredBase);
+    }
+}
+//------------------------------------------------------------------------------
+std::vector<ResidencyChange> TextureStreamer::update(uint64_t frameNumber)
+{
+    VkDeviceSize budget = getBudget();
+
+    std::vector<StreamedTexture *> textures;
+    std::vector<int> textureIds;
+    for (auto &it : m_textures)
+    {
+        if (it.second.transitId != 0)
+        {
+            continue;   // Its levels are still moving: changed again once the GPU is done with them
+        }
+        textures.push_back(&it.second);
+        textureIds.push_back(it.first);
+    }
+    std::vector<size_t> order(textures.size());
+    for (size_t i = 0; i < order.size(); ++i)
+    {
+        order[i] = i;
+    }
+
+    // New resident base of each texture (starts from the current one)
+    std::vector<uint32_t> newBase(textures.size());
+    for (size_t i = 0; i < textures.size(); ++i)
+    {
+        newBase[i] = textures[i]->residentBase;
+    }
+    VkDeviceSize residentBytes = m_residentBytes;
+
+    // 1. Over budget: drop the finest level of the least recently used textures (at least the last level stays)
+    std::sort(order.begin(), order.end(), [&textures](size_t a, size_t b) {
+        return textures[a]->lastUsedFrame < textures[b]->lastUsedFrame;
+    });
+    for (size_t i : order)
+    {
+        uint32_t lastLevel = static_cast<uint32_t>(textures[i]->regions.size()) - 1;
+        while (residentBytes > budget && newBase[i] < lastLevel)
+        {
+            residentBytes -= getResidentSize(*textures[i], newBase[i]) - getResidentSize(*textures[i], newBase[i] + 1);
+            ++newBase[i];
+            ++m_evictedLevels;
+        }
+    }
+
+    // 2. Stream in one finer level for the textures needing it (most recently used first), if it fits in the budget
+    VkDeviceSize streamedBytes = 0;
+    for (auto it = order.rbegin(); it != order.rend(); ++it)
+    {
+        size_t i = *it;
+        StreamedTexture &texture = *textures[i];
+        if (newBase[i] != texture.residentBase || texture.desiredBase >= texture.residentBase ||
+            texture.lastUsedFrame != frameNumber)
+        {
+            continue;
+        }
+
+        VkDeviceSize uploadSize = getLevelSize(texture, texture.residentBase - 1);  // Only the new level (the others are copied on the GPU)
+        if (residentBytes + uploadSize > budget)
+        {
+            continue;
+        }
+        if (streamedBytes > 0 && streamedBytes + uploadSize > MAX_STREAMED_BYTES_PER_FRAME)
+        {
+            break;
+        }
+
+        newBase[i] = texture.residentBase - 1;
+        residentBytes += uploadSize;
+        streamedBytes += uploadSize;
+    }
+    m_streamedBytes += streamedBytes;
+
+    std::vector<ResidencyChange> changes;
+    for (size_t i = 0; i < textures.size(); ++i)
+    {
+        if (newBase[i] != textures[i]->residentBase)
+        {
+            changes.push_back({ textureIds[i], newBase[i] });
+        }
+    }
+    return changes;
+}
+//------------------------------------------------------------------------------
+void TextureStreamer::setResident(int textureId, int imageIndex, uint32_t residentBase)
+{
+    StreamedTexture * texture = find(textureId);
+    if (!texture)
+    {
+        return;
+    }
+
+    m_residentBytes -= getResidentSize(*texture, texture->residentBase);
+    m_residentBytes += getResidentSize(*texture, residentBase);
+    texture->imageIndex = imageIndex;
+    texture->residentBase = residentBase;
+}
+//------------------------------------------------------------------------------
+uint64_t TextureStreamer::beginTransit(int textureId)
+{
+    StreamedTexture * texture = find(textureId);
+    if (!texture)
+    {
+        return 0;
+    }
+
+    texture->transitId = m_nextTransitId++;
+    return texture->transitId;
+}
+//------------------------------------------------------------------------------
+StreamedTexture * TextureStreamer::findTransit(int textureId, uint64_t transitId)
+{
+    StreamedTexture * texture = find(textureId);
+    return (texture && texture->transitId == transitId) ? texture : nullptr;
+}
+//------------------------------------------------------------------------------
+VkDeviceSize TextureStreamer::getBudget()
+{
+    VkDeviceSize budget = (m_budget > 0) ? m_budget : std::numeric_limits<VkDeviceSize>::max();
+    if (!m_memoryBudgetSupported)
+    {
+        return budget;
+    }
+
+    // Device local heaps: what the driver says we can use, minus what isn't textures
+    VkPhysicalDeviceMemoryBudgetPropertiesEXT memoryBudget = {};
+    memoryBudget.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_BUDGET_PROPERTIES_EXT;
+    VkPhysicalDeviceMemoryProperties2 memoryProperties = {};
+    memoryProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_PROPERTIES_2;
+    memoryProperties.pNext = &memoryBudget;
+    vkGetPhysicalDeviceMemoryProperties2(m_physicalDevice, &memoryProperties);
+
+    VkDeviceSize heapBudget = 0, heapUsage = 0;
+    for (uint32_t i = 0; i < memoryProperties.memoryProperties.memoryHeapCount; ++i)
+    {
+        if (memoryProperties.memoryProperties.memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT)
+        {
+            heapBudget += memoryBudget.heapBudget[i];
+            heapUsage += memoryBudget.heapUsage[i];
+        }
+    }
+    VkDeviceSize otherUsage = (heapUsage > m_residentBytes) ? heapUsage - m_residentBytes : 0;
+    VkDeviceSize available = (heapBudget > otherUsage) ? heapBudget - otherUsage : 0;
+
+    return std::min(budget, static_cast<VkDeviceSize>(available * DEVICE_BUDGET_SHARE));
+}
+//------------------------------------------------------------------------------
+TextureStreamingStats TextureStreamer::getStats()
+{
+    TextureStreamingStats stats;
+    stats.textureCount = static_cast<uint32_t>(m_textures.size());
+    stats.residentBytes = m_residentBytes;
+    stats.budget = getBudget();
+    stats.streamedBytes = m_streamedBytes;
+    for (const auto &it : m_textures)
+    {
+        for (const std::vector<uint8_t> &level : it.second.hostLevels)
+        {
+            stats.hostBytes += level.size();
+        }
+    }
+    stats.evictedLevels = m_evictedLevels;
+    stats.memoryBudgetExt = m_memoryBudgetSupported;
+    return stats;
+}
+//------------------------------------------------------------------------------
+VkDeviceSize TextureStreamer::getResidentSize(const StreamedTexture &texture, uint32_t base)
+{
+    // Levels are stored finest first: the resident ones are the tail of the full chain
+    return texture.size - texture.regions[base].bufferOffset;
+}
+//------------------------------------------------------------------------------
+VkDeviceSize TextureStreamer::getLevelSize(const StreamedTexture &texture, uint32_t level)
+{
+    VkDeviceSize end = (level + 1 < texture.regions.size()) ? texture.regions[level + 1].bufferOffset : texture.size;
+    return end - texture.regions[level].bufferOffset;
+}
@@ -0,0 +1,91 @@
+#ifndef TEXTURE_STREAMER_H
+#define TEXTURE_STREAMER_H
+
+// C++ STL
+#include <unordered_map>
+#include <vector>
+
+// Project includes
+#include "AssetLoader.h"
+#include "Utilities.h"          // Utilities header includes GLFW [Graphics Library FrameWork] + Vulkan API
+
+// A streamed texture: levels [residentBase, mipLevels) are on the device, the finer ones are kept in host memory
+struct StreamedTexture
+{
+    VkFormat        format          = VK_FORMAT_UNDEFINED;
+    uint32_t        width           = 0;        // Level 0 size
+    uint32_t        height          = 0;
+    std::vector<VkBufferImageCopy>  regions;    // Every level (level 0 first), offsets in the full chain
+    VkDeviceSize    size            = 0;        // Full chain
+    std::vector<std::vector<uint8_t>>   hostLevels; // Texels of the non resident levels (empty for the resident ones)
+    uint64_t        transitId       = 0;        // Residency change in progress (0: none), left alone by update()
+    int             imageIndex      = -1;       // Index in the renderer texture images
+    uint32_t        residentBase    = 0;        // Finest resident level
+    uint32_t        desiredBase     = 0;        // Finest level needed by the objects using the texture (this frame)
+    uint64_t        lastUsedFrame   = 0;        // LRU key
+};
+
+// A texture to rebuild with a different resident range
+struct ResidencyChange
+{
+    int             textureId;
+    uint32_t        newBase;
+};
+
+struct TextureStreamingStats
+{
+    uint32_t        textureCount    = 0;
+    VkDeviceSize    residentBytes   = 0;
+    VkDeviceSize    budget          = 0;
+    VkDeviceSize    streamedBytes   = 0;        // Uploaded to raise the residency (initial low mips excluded)
+    VkDeviceSize    hostBytes       = 0;        // Non resident levels, kept in host memory
+    uint32_t        evictedLevels   = 0;
+    bool            memoryBudgetExt = false;    // VK_EXT_memory_budget in use
+};
+
+// Texture mip residency: textures start with their low mips only, finer levels are streamed in when the screen-space
+// size of the objects using them asks for them, and levels are evicted in LRU order to stay under the VRAM budget.
+// The budget is the configured one, further limited by the device heap budget when VK_EXT_memory_budget is available.
+// It only does the bookkeeping: the renderer (re)builds the images for the ResidencyChanges returned by update(), moving
+// the levels between the host and the device, and marks the textures in transit until the GPU is done with them.
+class TextureStreamer
+{
+public:
+    TextureStreamer();
+    ~TextureStreamer();
+
+    void            create(VkPhysicalDevice physicalDevice, bool memoryBudgetSupported, VkDeviceSize budget);
+
+    uint32_t        getInitialBase(const TextureData &texture);
+    void            add(int textureId, TextureData &&source, int imageIndex, uint32_t residentBase);
+    void            remove(int textureId);
+    StreamedTexture * find(int textureId);
+
+    void            requestScreenSize(int textureId, float screenSize, uint64_t frameNumber);  // Size in pixels
+    std::vector<ResidencyChange>    update(uint64_t frameNumber);
+    void            setResident(int textureId, int imageIndex, uint32_t residentBase);
+
+    uint64_t        beginTransit(int textureId);
+    StreamedTexture * findTransit(int textureId, uint64_t transitId);  // nullptr: removed (or reloaded) since
+
+    static VkDeviceSize getLevelSize(const StreamedTexture &texture, uint32_t level);
+
+    VkDeviceSize    getBudget();
+    TextureStreamingStats getStats();
+
+private:
+    VkPhysicalDevice    m_physicalDevice = nullptr;
+    bool                m_memoryBudgetSupported = false;
+    VkDeviceSize        m_budget = 0;                   // Configured budget (0: no limit but the device one)
+
+    std::unordered_map<int, StreamedTexture>    m_textures;    // Key: texture ID (descriptor index)
+    VkDeviceSize        m_residentBytes = 0;
+    VkDeviceSize        m_streamedBytes = 0;
+    uint32_t            m_evictedLevels = 0;
+    uint64_t            m_nextTransitId = 1;
+
+    // Methods
+    static VkDeviceSize getResidentSize(const StreamedTexture &texture, uint32_t base);
+};
+
+#endif //TEXTURE_STREAMER_H
@@ -33,11 +33,20 @@
     #endif
     #include <cstdio>
 #endif
+#include <algorithm>
+#include <cstring>
 #include <string>
 #include <vector>
 
 // This is the first file included by "main", so we define here the STB implementation (for "stb_image.h")
 #define STB_IMAGE_IMPLEMENTATION
+// stb_image allocations go through the staging arena hooks (StagingArena.cpp): decodes can land in mapped staging memory
+void *  stbiStagingMalloc(size_t size);
+void *  stbiStagingRealloc(void * data, size_t size);
+void    stbiStagingFree(void * data);
+#define STBI_MALLOC(size)           stbiStagingMalloc(size)
+#define STBI_REALLOC(data, size)    stbiStagingRealloc(data, size)
+#define STBI_FREE(data)             stbiStagingFree(data)
 
 // Disable warning about Vulkan unscoped enums for this entire file
 #pragma warning( push )
@@ -76,6 +85,11 @@ namespace Utilities
     const int MAX_FRAME_DRAWS = 3;
     //        MAX_FRAME_DRAWS should be less (or equal at max) to swapchain images
     const int MAX_OBJECTS = 2;
+    // Textures alive at once (loaded or loading, with a descriptor slot each)
+    const int MAX_TEXTURES = 1024;
+    // Texture descriptor sets: one per texture, plus the ones retired (but still in flight) by the swaps, which a texture
+    // does at most once per frame (at the frame boundary)
+    const int MAX_TEXTURE_DESCRIPTOR_SETS = MAX_TEXTURES * (1 + MAX_FRAME_DRAWS);
 
     //////////////////////////////
     // GLFW main Utilities
@@ -114,7 +128,7 @@ namespace Utilities
         // To use the Vulkan API we have to specify NO_API to GLFW library (to NOT work with OpenGL)
         // https://www.glfw.org/docs/3.3/window_guide.html#window_hints
         glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
-        glfwWindowHint(GLFW_RESIZABLE, GLFW_FALSE);
+        glfwWindowHint(GLFW_RESIZABLE, GLFW_TRUE);     // The renderer re-creates the Swapchain on resize
 
         pWindow = glfwCreateWindow(width, height, name.c_str(), nullptr, nullptr);
         if (nullptr == pWindow)
@@ -140,6 +154,14 @@ namespace Utilities
         VK_KHR_SWAPCHAIN_EXTENSION_NAME
     };
 
+    // Optional: shader objects pipeline backend (and the extensions VK_EXT_shader_object depends on)
+    const std::vector<const char*> shaderObjectExtensions = {
+        VK_EXT_SHADER_OBJECT_EXTENSION_NAME,
+        VK_KHR_DYNAMIC_RENDERING_EXTENSION_NAME,
+        VK_KHR_DEPTH_STENCIL_RESOLVE_EXTENSION_NAME,
+        VK_KHR_CREATE_RENDERPASS_2_EXTENSION_NAME
+    };
+
     // Vertex data representation
     struct Vertex
     {
@@ -354,8 +376,22 @@ namespace Utilities
         endAndSubmitCommandBuffer(device, transferCommandPool, transferQueue, transferCommandBuffer);
     }
 
+    // Copy more regions (e.g. mip levels) at once
+    static void copyImageBuffer(VkDevice device, VkQueue transferQueue, VkCommandPool transferCommandPool,
+                                VkBuffer srcBuffer, VkImage image, const std::vector<VkBufferImageCopy> &imageRegions)
+    {
+        // Create buffer
+        VkCommandBuffer transferCommandBuffer = beginCommandBuffer(device, transferCommandPool);
+
+        // Copy buffer to given image
+        vkCmdCopyBufferToImage(transferCommandBuffer, srcBuffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                               static_cast<uint32_t>(imageRegions.size()), imageRegions.data());
+
+        endAndSubmitCommandBuffer(device, transferCommandPool, transferQueue, transferCommandBuffer);
+    }
+
     static void transitionImageLayout(VkDevice device, VkQueue queue, VkCommandPool commandPool,
-                                      VkImage image, VkImageLayout oldLayout, VkImageLayout newLayout)
+                                      VkImage image, VkImageLayout oldLayout, VkImageLayout newLayout, uint32_t mipLevels = 1)
     {
         // Create buffer
         VkCommandBuffer commandBuffer = beginCommandBuffer(device, commandPool);
@@ -369,7 +405,7 @@ namespace Utilities
         imageMemoryBarrier.image = image;                                           // Image being accessed and modified as part of barrier
         imageMemoryBarrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT; // Aspect of image being altered
         imageMemoryBarrier.subresourceRange.baseMipLevel = 0;                       // First mip level to start alterations on
-        imageMemoryBarrier.subresourceRange.levelCount = 1;                         // Number of mip levels to alter starting from baseMipLevel
+        imageMemoryBarrier.subresourceRange.levelCount = mipLevels;                 // Number of mip levels to alter starting from baseMipLevel
         imageMemoryBarrier.subresourceRange.baseArrayLayer = 0;                     // First layer to start alterations on
         imageMemoryBarrier.subresourceRange.layerCount = 1;                         // Number of layers to alter starting from baseArrayLayer
 
@@ -394,6 +430,15 @@ namespace Utilities
             srcStage = VK_PIPELINE_STAGE_TRANSFER_BIT;
             dstStage = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
         }
+        // If transitioning from shader readable back to transfer destination (update of an image in use, contents kept)...
+        else if (oldLayout == VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL && newLayout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL)
+        {
+            imageMemoryBarrier.srcAccessMask = VK_ACCESS_SHADER_READ_BIT;       // Sampling by the frames already submitted...
+            imageMemoryBarrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;    // ...completes before the copy writes
+
+            srcStage = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+            dstStage = VK_PIPELINE_STAGE_TRANSFER_BIT;
+        }
 
         vkCmdPipelineBarrier(
             commandBuffer,
@@ -407,6 +452,81 @@ namespace Utilities
         endAndSubmitCommandBuffer(device, commandPool, queue, commandBuffer);
     }
 
+    // Number of mip levels of a full mip chain (down to 1x1)
+    static uint32_t getMipLevelCount(uint32_t width, uint32_t height)
+    {
+        uint32_t mipLevels = 1;
+        for (uint32_t size = std::max(width, height); size > 1; size >>= 1)
+        {
+            ++mipLevels;
+        }
+        return mipLevels;
+    }
+
+    // Build a full mip chain of a RGBA8 image on the CPU (2x2 box filter), with the buffer-to-image copy regions of each level.
+    // Fallback for formats that don't support linear filtering in vkCmdBlitImage (bump TEXTURE_COOKER_VERSION if it changes).
+    static std::vector<uint8_t> buildMipChainRgba8(const uint8_t * pixels, uint32_t width, uint32_t height, uint32_t mipLevels,
+                                                   std::vector<VkBufferImageCopy> * imageRegions)
+    {
+        const uint32_t channels = 4;
+
+        // Levels are tightly packed one after the other
+        std::vector<VkDeviceSize> levelOffsets(mipLevels);
+        VkDeviceSize totalSize = 0;
+        for (uint32_t level = 0; level < mipLevels; ++level)
+        {
+            levelOffsets[level] = totalSize;
+            totalSize += static_cast<VkDeviceSize>(std::max(width >> level, 1U)) * std::max(height >> level, 1U) * channels;
+        }
+
+        std::vector<uint8_t> mipChain(static_cast<size_t>(totalSize));
+        memcpy(mipChain.data(), pixels, static_cast<size_t>(width) * height * channels);
+
+        imageRegions->clear();
+        for (uint32_t level = 0; level < mipLevels; ++level)
+        {
+            uint32_t levelWidth = std::max(width >> level, 1U);
+            uint32_t levelHeight = std::max(height >> level, 1U);
+
+            // Downsample from the previous level (odd sizes clamp to the last row/column)
+            if (level > 0)
+            {
+                uint32_t srcWidth = std::max(width >> (level - 1), 1U);
+                uint32_t srcHeight = std::max(height >> (level - 1), 1U);
+                const uint8_t * src = mipChain.data() + levelOffsets[level - 1];
+                uint8_t * dst = mipChain.data() + levelOffsets[level];
+
+                for (uint32_t y = 0; y < levelHeight; ++y)
+                {
+                    const uint8_t * row0 = src + static_cast<size_t>(std::min(y * 2, srcHeight - 1)) * srcWidth * channels;
+                    const uint8_t * row1 = src + static_cast<size_t>(std::min(y * 2 + 1, srcHeight - 1)) * srcWidth * channels;
+                    for (uint32_t x = 0; x < levelWidth; ++x)
+                    {
+                        uint32_t x0 = std::min(x * 2, srcWidth - 1) * channels;
+                        uint32_t x1 = std::min(x * 2 + 1, srcWidth - 1) * channels;
+                        for (uint32_t c = 0; c < channels; ++c)
+                        {
+                            uint32_t sum = row0[x0 + c] + row0[x1 + c] + row1[x0 + c] + row1[x1 + c];
+                            dst[(static_cast<size_t>(y) * levelWidth + x) * channels + c] = static_cast<uint8_t>((sum + 2) / 4);
+                        }
+                    }
+                }
+            }
+
+            VkBufferImageCopy imageRegion = {};
+            imageRegion.bufferOffset = levelOffsets[level];                         // Offset into data
+            imageRegion.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;    // Which aspect of image to copy
+            imageRegion.imageSubresource.mipLevel = level;                          // Mipmap level to copy
+            imageRegion.imageSubresource.baseArrayLayer = 0;                        // Starting array layer (if array)
+            imageRegion.imageSubresource.layerCount = 1;                            // Number of layers to copy starting at baseArrayLayer
+            imageRegion.imageOffset = { 0, 0, 0 };                                  // VkOffset3D into image (as opposed to raw data in bufferOffset)
+            imageRegion.imageExtent = { levelWidth, levelHeight, 1 };               // Size of region to copy as (x, y, z) values
+            imageRegions->push_back(imageRegion);
+        }
+
+        return mipChain;
+    }
+
     static std::string getVersionString(uint32_t versionBitmask)
     {
         static const int MAX_STR_LENGTH = 64;
@@ -428,6 +548,44 @@ namespace Utilities
     // Macro to calculates the number of elements inside a C-style array (old fashioned)
     #define ARRAY_SIZE(a)   (sizeof(a) / sizeof(a[0]))
 
+    // FNV-1a 64bit hash (http://www.isthe.com/chongo/tech/comp/fnv/) - not cryptographic, but fast and well spread
+    constexpr uint64_t FNV_OFFSET_BASIS = 14695981039346656037ULL;
+    constexpr uint64_t FNV_PRIME = 1099511628211ULL;
+
+    static uint64_t hashFnv1a(const void* data, size_t size, uint64_t hash = FNV_OFFSET_BASIS)
+    {
+        const uint8_t* bytes = static_cast<const uint8_t*>(data);
+        for (size_t i = 0; i < size; ++i)
+        {
+            hash ^= bytes[i];
+            hash *= FNV_PRIME;
+        }
+        return hash;
+    }
+
+    // Hash a value (trivially copyable) into a running hash
+    template <typename T>
+    static uint64_t hashCombine(uint64_t hash, const T& value)
+    {
+        return hashFnv1a(&value, sizeof(T), hash);
+    }
+
+    // Hash a string into a running hash (its size too, so that "ab"+"c" differs from "a"+"bc")
+    static uint64_t hashCombine(uint64_t hash, const std::string& value)
+    {
+        hash = hashCombine(hash, value.size());
+        return hashFnv1a(value.data(), value.size(), hash);
+    }
+
+    // Key of a non-dispatchable handle (pointers on 64 bit platforms and uint64_t on 32 bit ones)
+    template <typename T>
+    static uint64_t getHandleKey(T handle)
+    {
+        uint64_t key = 0;
+        memcpy(&key, &handle, sizeof(handle));
+        return key;
+    }
+
     // Current working directory
     static std::string getCurrentWorkingDirectory()
     {
@@ -2,11 +2,33 @@
 
 // C++ STL
 #include <chrono>
+#include <cmath>
+#include <filesystem>
 #include <thread>
 
 using std::cout;
 using std::endl;
 
+// Staging memory the texture decoders write into (decodes that don't fit fall back to the heap)
+static const VkDeviceSize STAGING_ARENA_SIZE = 64 * 1024 * 1024;
+// Texture bytes uploaded per frame (one texture is always allowed, to make progress): bursts are spread on the next frames
+static const VkDeviceSize MAX_UPLOADED_BYTES_PER_FRAME = 8 * 1024 * 1024;
+
+// GLSL sources, and the SPIR-V modules Shaders/compile_shaders.bat builds from them (read when not compiling at runtime)
+struct ShaderSource
+{
+    const char *    source;
+    const char *    spirv;
+};
+static const ShaderSource SHADER_SOURCES[] = {
+    { "Shaders/shader.vert",    "Shaders/vert.spv"  },
+    { "Shaders/shader.frag",    "Shaders/frag.spv"  },
+    { "Shaders/depth.vert",     "Shaders/depth.spv" },
+};
+
+// Texture sources the AssetCooker cooks into <name>.ktx2 (same path): the cooked file is loaded instead, if there is one
+static const char * const COOKED_TEXTURE_SOURCES[] = { ".jpg", ".jpeg", ".png", ".tga", ".bmp" };
+
 ////////////
 // Public //
 ////////////
@@ -25,6 +47,10 @@ int VulkanRenderer::init(GLFWwindow* newWindow)
 {
     m_pWindow = newWindow;
 
+    // Get notified when the window (framebuffer) is resized, to re-create the Swapchain
+    glfwSetWindowUserPointer(m_pWindow, this);
+    glfwSetFramebufferSizeCallback(m_pWindow, framebufferResizeCbk);
+
     try
     {
         createInstance();
@@ -32,34 +58,55 @@ int VulkanRenderer::init(GLFWwindow* newWindow)
         createSurface();
         getPhysicalDevice();
         createLogicalDevice();
+        m_renderGraph.create(m_mainDevice.physicalDevice, m_mainDevice.logicalDevice, m_synchronization2Supported,
+                             m_pipelineBackend == PipelineBackend::ShaderObjects);     // Shader objects draw in dynamic rendering
+        m_pipelineCache.create(m_mainDevice.physicalDevice, m_mainDevice.logicalDevice);
+        if (!m_assetArchivePath.empty() && !m_assetArchive.open(m_assetArchivePath))
+        {
+            cout << "Asset archive '" << m_assetArchivePath << "' not found (or not valid): loading the loose files" << endl;
+        }
+        m_shaderCompiler.create();
+        m_layoutCache.create(m_mainDevice.logicalDevice);
+        m_pipelineManager.create(m_mainDevice.logicalDevice, m_pipelineCache.getHandle(), &m_assetArchive, &m_shaderCompiler,
+                                 &m_layoutCache, m_pipelineBackend);
+        m_ktx2Loader.create(m_mainDevice.physicalDevice);
+        m_stagingArena.create(m_mainDevice.physicalDevice, m_mainDevice.logicalDevice, STAGING_ARENA_SIZE);
+        m_textureStreamer.create(m_mainDevice.physicalDevice, m_memoryBudgetSupported, m_textureBudget);
+        if (m_textureDiskCacheEnabled)
+        {
+            m_textureDiskCache.create(m_textureDiskCacheSize);
+        }
         createSwapchain();
-        createRenderPass();
-        createDescriptorSetLayout();
-        createPushConstantRange();
+        createRenderGraph();
         createGraphicsPipeline();
-        createDepthBufferImage();
-        createFramebuffers();
         createCommandPool();
         createCommandBuffers();
         createTextureSampler();
         //allocateDynamicBufferTransferSpace();
         createUniformBuffers();
         createDescriptorPool();
+        createSamplerDescriptorPool();
         createDescriptorSets();
         createSynchronisation();
+        createPlaceholderTexture();
+        m_workerPool.create(std::max(std::thread::hardware_concurrency(), 2U) - 1);
+        m_blockCompressor.setWorkerPool(&m_workerPool);
+        m_assetLoader.create([this](const std::string &fileName, std::span<const uint8_t> fileData, TextureData * texture) {
+            decodeTexture(fileName, fileData, texture);
+        }, &m_workerPool);
+        if (m_hotReload)
+        {
+            m_fileWatcher.create({ "Shaders", "Textures" });
+        }
 
         //======================================================================
         //------------------------------
         // Model-View-Projection setup
         //------------------------------
-        m_uboViewProjection.projection = glm::perspective(
-            glm::radians(45.0f), static_cast<float>(m_swapChainExtent.width) / static_cast<float>(m_swapChainExtent.height), 0.1f, 100.0f);
-        //               FOV-Y ,                                       Aspect Ratio                                        ,zNear, zFar
+        updateProjection();
         m_uboViewProjection.view = glm::lookAt(glm::vec3(0.0f, 0.0f, 2.0f), glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
         //                                 Eye              ,           Center           ,           Up
 
-        m_uboViewProjection.projection[1][1] *= -1; // Vulkan inverts Y coordinates compared to OpenGL (and GLM is based upon OpenGL coordinate system)
-
         //------------------------------
         // Create meshes
         //------------------------------
@@ -127,6 +174,155 @@ bool VulkanRenderer::updateModel(uint32_t modelId, glm::mat4 modelMatrix)
     return true;
 }
 //------------------------------------------------------------------------------
+int VulkanRenderer::addMesh(const std::string &meshFile, const std::string &textureFile)
+{
+    // Cooked by the AssetCooker tool: uploaded as it is (textures count towards MAX_TEXTURES)
+    std::string filePath = "Models/" + meshFile;
+    std::vector<uint8_t> fileStorage;
+    std::span<const uint8_t> fileData;
+    AssetArchive::readAsset(&m_assetArchive, filePath, &fileStorage, &fileData);
+    MeshPackage package;
+    package.read(fileData, filePath);
+
+    Mesh mesh = Mesh(m_mainDevice.physicalDevice, m_mainDevice.logicalDevice,
+        m_graphicsQueue, m_graphicsCommandPool,
+        &package, createTexture(textureFile));
+    m_meshList.push_back(mesh);
+
+    return static_cast<int>(m_meshList.size() - 1);
+}
+//------------------------------------------------------------------------------
+bool VulkanRenderer::setMaterial(uint32_t modelId, const Material &material)
+{
+    if (modelId >= m_meshList.size()) { return false; }
+
+    m_meshList[modelId].setMaterial(material);
+
+    // Queue its variants now: until they are ready, the mesh is drawn with another specialization of the shaders
+    if (m_meshList[modelId].isTransparent())
+    {
+        m_pipelineManager.prepare(getMaterialPipelineDesc(m_transparentPipelineDesc, material));
+    }
+    else
+    {
+        m_pipelineManager.prepare(getMaterialPipelineDesc(m_opaquePipelineDesc, material));
+        if (!material.alphaTested)
+        {
+            m_pipelineManager.prepare(getMaterialPipelineDesc(m_opaqueEqualPipelineDesc, material));
+        }
+    }
+    return true;
+}
+//------------------------------------------------------------------------------
+void VulkanRenderer::setDepthPrepassEnabled(bool enabled)
+{
+    // Command buffers are recorded every frame, so the new mode applies from the next draw() on
+    m_depthPrepassEnabled = enabled;
+}
+//------------------------------------------------------------------------------
+bool VulkanRenderer::isDepthPrepassEnabled()
+{
+    return m_depthPrepassEnabled;
+}
+//------------------------------------------------------------------------------
+void VulkanRenderer::setTextureCompression(TextureCompression compression, CompressionQuality quality)
+{
+    // Applies to the JPG/PNG textures loaded from now on (KTX2 textures are already block compressed)
+    m_textureCompression = compression;
+    m_compressionQuality = quality;
+}
+//------------------------------------------------------------------------------
+void VulkanRenderer::setTextureContentHashing(bool enabled)
+{
+    // Costs a read of every texture file on cache misses, to find the same content under another path
+    m_textureCache.setContentHashing(enabled);
+}
+//------------------------------------------------------------------------------
+void VulkanRenderer::setTextureStreaming(bool enabled, VkDeviceSize budget)
+{
+    // Streamed textures keep all their levels in host memory, and only the ones needed (and fitting) on the device
+    m_textureStreaming = enabled;
+    m_textureBudget = budget;
+}
+//------------------------------------------------------------------------------
+TextureStreamingStats VulkanRenderer::getTextureStreamingStats()
+{
+    return m_textureStreamer.getStats();
+}
+//------------------------------------------------------------------------------
+void VulkanRenderer::setTextureAtlas(bool enabled)
+{
+    // Small RGBA8 textures share a few atlas pages (and descriptor sets): they're decoded uncompressed and not streamed
+    m_textureAtlasEnabled = enabled;
+}
+//------------------------------------------------------------------------------
+void VulkanRenderer::setTextureDiskCache(bool enabled, VkDeviceSize maxSize)
+{
+    // JPG/PNG textures are stored after their processing (decode, mip levels, compression) and mapped on the next runs
+    m_textureDiskCacheEnabled = enabled;
+    m_textureDiskCacheSize = maxSize;
+}
+//------------------------------------------------------------------------------
+TextureDiskCacheStats VulkanRenderer::getTextureDiskCacheStats()
+{
+    return m_textureDiskCache.getStats();
+}
+//------------------------------------------------------------------------------
+void VulkanRenderer::setAssetArchive(const std::string &filePath)
+{
+    // Textures, models and shaders packed in the archive are mapped from it, the others are still read from their files
+    m_assetArchivePath = filePath;
+}
+//------------------------------------------------------------------------------
+void VulkanRenderer::setRuntimeShaderCompilation(bool enabled)
+{
+    // GLSL sources compiled in process (cached on disk) instead of the modules built offline
+    m_runtimeShaderCompilation = enabled;
+}
+//------------------------------------------------------------------------------
+void VulkanRenderer::setHotReload(bool enabled)
+{
+    // Modified shaders (GLSL sources or SPIR-V modules) and textures are swapped in without a restart
+    m_hotReload = enabled;
+}
+//------------------------------------------------------------------------------
+void VulkanRenderer::setShaderObjects(bool enabled)
+{
+    // VK_EXT_shader_object instead of pipelines: no monolithic compilation, the fixed-function state is set when recording
+    m_shaderObjectsEnabled = enabled;
+}
+//------------------------------------------------------------------------------
+PipelineBackend VulkanRenderer::getPipelineBackend()
+{
+    return m_pipelineBackend;
+}
+//------------------------------------------------------------------------------
+RenderGraphStats VulkanRenderer::getRenderGraphStats()
+{
+    return m_renderGraph.getStats();
+}
+//------------------------------------------------------------------------------
+void VulkanRenderer::releaseTexture(int textureId)
+{
+    int textureImageLoc;
+    if (!m_textureCache.release(textureId, &textureImageLoc))
+    {
+        return;     // Still referenced (or unknown)
+    }
+    m_textureStreamer.remove(textureId);
+    m_textureAtlas.remove(textureId);       // Its rectangle isn't reused
+
+    // The frames in flight may still use the texture: destroy it (and reuse its slot) once they are done
+    deferRelease([this, textureId, textureImageLoc]() {
+        if (textureImageLoc >= 0)   // -1: still loading (or failed), bound to the placeholder
+        {
+            destroyTextureImage(textureImageLoc);
+        }
+        m_freeSamplerDescriptorSets.push_back(m_samplerDescriptorSets[textureId]);
+        m_freeTextureDescriptors.push_back(textureId);
+    });
+}
+//------------------------------------------------------------------------------
 void VulkanRenderer::draw(double frameDuration)
 {
     // Check if the window is iconified
@@ -138,13 +334,32 @@ void VulkanRenderer::draw(double frameDuration)
 
     // Wait for given fence to signal (open) from last draw before continuing
     vkWaitForFences(m_mainDevice.logicalDevice, 1, &m_drawFences[m_currentFrame], VK_TRUE, std::numeric_limits<uint64_t>::max());
-    // Manually reset (close) fences
-    vkResetFences(m_mainDevice.logicalDevice, 1, &m_drawFences[m_currentFrame]);
+
+    // Frame boundary: destroy what the completed frames were using, and swap in the textures (and the reloaded
+    // pipelines) that are ready
+    runDeferredReleases();
+    processHotReload();
+    processAssetUploads();
+    updateTextureStreaming();
 
     // -- GET NEXT IMAGE --
     // Get index of next image to be drawn to, and signal semaphore when ready to be drawn to
     uint32_t imageIndex;
-    vkAcquireNextImageKHR(m_mainDevice.logicalDevice, m_swapChain, std::numeric_limits<uint64_t>::max(), m_imageAvailable[m_currentFrame], VK_NULL_HANDLE, &imageIndex);
+    VkResult result = vkAcquireNextImageKHR(m_mainDevice.logicalDevice, m_swapChain, std::numeric_limits<uint64_t>::max(),
+                                            m_imageAvailable[m_currentFrame], VK_NULL_HANDLE, &imageIndex);
+    if (result == VK_ERROR_OUT_OF_DATE_KHR)
+    {
+        // Swapchain no longer matches the surface (e.g. resized): re-create it and skip this frame
+        recreateSwapchain();
+        return;
+    }
+    else if (result != VK_SUCCESS && result != VK_SUBOPTIMAL_KHR)
+    {
+        throw std::runtime_error("Failed to acquire a Swapchain Image!");
+    }
+
+    // Manually reset (close) fences, only once we know we're going to submit work with it (otherwise next wait would never end)
+    vkResetFences(m_mainDevice.logicalDevice, 1, &m_drawFences[m_currentFrame]);
 
     recordCommands(imageIndex);
 
@@ -167,11 +382,12 @@ void VulkanRenderer::draw(double frameDuration)
     submitInfo.pSignalSemaphores = &m_renderFinished[m_currentFrame];   // Semaphores to signal when command buffer finishes
 
     // Submit command buffer to queue (N.B.: queues are like conveyor belts, always running)
-    VkResult result = vkQueueSubmit(m_graphicsQueue, 1, &submitInfo, m_drawFences[m_currentFrame]);
+    result = vkQueueSubmit(m_graphicsQueue, 1, &submitInfo, m_drawFences[m_currentFrame]);
     if (result != VK_SUCCESS)
     {
         throw std::runtime_error("Failed to submit Command Buffer to Queue!");
     }
+    ++m_frameNumber;
 
 
     // -- PRESENT RENDERED IMAGE TO SCREEN --
@@ -185,7 +401,12 @@ void VulkanRenderer::draw(double frameDuration)
 
     // Present image (to screen - render the processed image)
     result = vkQueuePresentKHR(m_presentationQueue, &presentInfo);
-    if (result != VK_SUCCESS)
+    if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR || m_framebufferResized)
+    {
+        // Image presented (or dropped), the next frame will use the new Swapchain
+        recreateSwapchain();
+    }
+    else if (result != VK_SUCCESS)
     {
         throw std::runtime_error("Failed to present Image!");
     }
@@ -196,15 +417,31 @@ void VulkanRenderer::draw(double frameDuration)
 //------------------------------------------------------------------------------
 void VulkanRenderer::cleanup()
 {
+    // Stop the asset loader decodes (they read the KTX2 loader and the block compressor), and the file watcher
+    m_assetLoader.destroy();
+    m_workerPool.destroy();
+    if (m_hotReload)
+    {
+        m_fileWatcher.destroy();
+    }
+
     // Wait until no actions being run on device before destroying
     vkDeviceWaitIdle(m_mainDevice.logicalDevice);
+    runDeferredReleases(true);
+    for (auto &completion : m_completedAssets)
+    {
+        releaseTextureData(completion->texture);
+    }
+    m_completedAssets.clear();
+    m_textureUploads.clear();
+    m_residencyCopies.clear();
+    m_stagingArena.destroy();
 
     // Free the aligned memory used for Dynamic Uniform Buffers
     //_aligned_free(m_pModelTransferSpace);
 
     // Destroy Textures (Descriptors + Sampler)
     vkDestroyDescriptorPool(m_mainDevice.logicalDevice, m_samplerDescriptorPool, nullptr);
-    vkDestroyDescriptorSetLayout(m_mainDevice.logicalDevice, m_samplerSetLayout, nullptr);
 
     vkDestroySampler(m_mainDevice.logicalDevice, m_textureSampler, nullptr);
 
@@ -215,15 +452,14 @@ void VulkanRenderer::cleanup()
         vkDestroyImage(m_mainDevice.logicalDevice, m_textureImages[i], nullptr);
         vkFreeMemory(m_mainDevice.logicalDevice, m_textureImageMemory[i], nullptr);
     }
+    m_textureCache.clear();
+    m_textureAtlas.clear();
+    m_atlasPages.clear();
+    m_freeTextureDescriptors.clear();
+    m_freeTextureImages.clear();
 
-    // Destroy Depth Buffer ImageView, Image and related video memory
-    vkDestroyImageView(m_mainDevice.logicalDevice, m_depthBufferImageView, nullptr);
-    vkDestroyImage(m_mainDevice.logicalDevice, m_depthBufferImage, nullptr);
-    vkFreeMemory(m_mainDevice.logicalDevice, m_depthBufferImageMemory, nullptr);
-
-    // Destroy Descriptor Pool and Descriptor SetLayout
+    // Destroy Descriptor Pool
     vkDestroyDescriptorPool(m_mainDevice.logicalDevice, m_descriptorPool, nullptr);
-    vkDestroyDescriptorSetLayout(m_mainDevice.logicalDevice, m_descriptorSetLayout, nullptr);
     // Destroy Uniform Buffers and free related memory
     for (size_t i = 0; i < m_vpUniformBuffer.size(); ++i)
     {
@@ -249,22 +485,23 @@ void VulkanRenderer::cleanup()
 
     vkDestroyCommandPool(m_mainDevice.logicalDevice, m_graphicsCommandPool, nullptr);
 
-    // Destroy Swapchain buffers
-    for (auto framebuffer : m_swapChainFramebuffers)
-    {
-        vkDestroyFramebuffer(m_mainDevice.logicalDevice, framebuffer, nullptr);
-    }
+    // Destroy the Swapchain image views
+    destroySwapchainAttachments();
 
-    // Destroy Pipeline and RenderPass
-    vkDestroyPipeline(m_mainDevice.logicalDevice, m_graphicsPipeline, nullptr);
-    vkDestroyPipelineLayout(m_mainDevice.logicalDevice, m_pipelineLayout, nullptr);
-    vkDestroyRenderPass(m_mainDevice.logicalDevice, m_renderPass, nullptr);
+    // Destroy Pipelines (waits for the compilations in flight, they may use the shader compiler), their Layouts (and the
+    // Descriptor Set Layouts) and the Render Graph (Render Passes, Framebuffers and transient images)
+    m_pipelineManager.destroy();
+    m_shaderCompiler.destroy();
+    m_layoutCache.destroy();
+    m_renderGraph.destroy();
 
-    // Destroy the image views, Swapchain and Surface
-    for (auto &image : m_swapchainImages)
-    {
-        vkDestroyImageView(m_mainDevice.logicalDevice, image.imageView, nullptr);
-    }
+    // Save the Pipeline Cache to disk (for the next run) and destroy it
+    m_pipelineCache.destroy();
+
+    // Unmap the asset archive (no reader left: loader workers and pipeline compilations are done)
+    m_assetArchive.close();
+
+    // Destroy the Swapchain and Surface
     vkDestroySwapchainKHR(m_mainDevice.logicalDevice, m_swapChain, nullptr);
     vkDestroySurfaceKHR(m_pInstance, m_surface, nullptr);
 
@@ -389,8 +626,61 @@ void VulkanRenderer::createLogicalDevice()
     deviceCreateInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
     deviceCreateInfo.queueCreateInfoCount = static_cast<uint32_t>(queueCreateInfos.size());     // Number of Queue Create Infos
     deviceCreateInfo.pQueueCreateInfos = queueCreateInfos.data();                               // List of Queue create infos so device can create required queues
-    deviceCreateInfo.enabledExtensionCount = static_cast<uint32_t>(deviceExtensions.size());    // Number of enabled Logical Device Extensions
-    deviceCreateInfo.ppEnabledExtensionNames = deviceExtensions.data();                         // List of enabled Logical Device Extensions
+    // Required extensions, plus the optional ones this device has
+    std::vector<const char*> enabledExtensions = deviceExtensions;
+    m_memoryBudgetSupported = isDeviceExtensionSupported(m_mainDevice.physicalDevice, VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+    if (m_memoryBudgetSupported)
+    {
+        enabledExtensions.push_back(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);     // Heap budget/usage (texture streaming)
+    }
+
+    // Shader objects backend: the extensions, and the shaderObject and dynamicRendering features (shader objects only
+    // draw in dynamic rendering instances, the render graph records those then; pipelines otherwise)
+    VkPhysicalDeviceShaderObjectFeaturesEXT shaderObjectFeatures = {};
+    shaderObjectFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SHADER_OBJECT_FEATURES_EXT;
+    VkPhysicalDeviceDynamicRenderingFeaturesKHR dynamicRenderingFeatures = {};
+    dynamicRenderingFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DYNAMIC_RENDERING_FEATURES_KHR;
+    m_pipelineBackend = PipelineBackend::Pipelines;
+    if (m_shaderObjectsEnabled && std::all_of(shaderObjectExtensions.begin(), shaderObjectExtensions.end(),
+        [this](const char * extensionName) { return isDeviceExtensionSupported(m_mainDevice.physicalDevice, extensionName); }))
+    {
+        VkPhysicalDeviceFeatures2 features = {};
+        features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+        features.pNext = &shaderObjectFeatures;
+        shaderObjectFeatures.pNext = &dynamicRenderingFeatures;
+        vkGetPhysicalDeviceFeatures2(m_mainDevice.physicalDevice, &features);
+        if (shaderObjectFeatures.shaderObject == VK_TRUE && dynamicRenderingFeatures.dynamicRendering == VK_TRUE)
+        {
+            m_pipelineBackend = PipelineBackend::ShaderObjects;
+            enabledExtensions.insert(enabledExtensions.end(), shaderObjectExtensions.begin(), shaderObjectExtensions.end());
+            dynamicRenderingFeatures.pNext = const_cast<void *>(deviceCreateInfo.pNext);
+            shaderObjectFeatures.pNext = &dynamicRenderingFeatures;
+            deviceCreateInfo.pNext = &shaderObjectFeatures;         // Enables the shaderObject and dynamicRendering features
+        }
+    }
+    cout << "Pipeline backend: " << (m_pipelineBackend == PipelineBackend::ShaderObjects
+        ? "shader objects (VK_EXT_shader_object)" : "graphics pipelines") << endl;
+
+    // synchronization2: the render graph barriers (vkCmdPipelineBarrier otherwise)
+    VkPhysicalDeviceSynchronization2FeaturesKHR synchronization2Features = {};
+    synchronization2Features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SYNCHRONIZATION_2_FEATURES_KHR;
+    m_synchronization2Supported = false;
+    if (isDeviceExtensionSupported(m_mainDevice.physicalDevice, VK_KHR_SYNCHRONIZATION_2_EXTENSION_NAME))
+    {
+        VkPhysicalDeviceFeatures2 features = {};
+        features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+        features.pNext = &synchronization2Features;
+        vkGetPhysicalDeviceFeatures2(m_mainDevice.physicalDevice, &features);
+        if (synchronization2Features.synchronization2 == VK_TRUE)
+        {
+            m_synchronization2Supported = true;
+            enabledExtensions.push_back(VK_KHR_SYNCHRONIZATION_2_EXTENSION_NAME);
+            synchronization2Features.pNext = const_cast<void *>(deviceCreateInfo.pNext);
+            deviceCreateInfo.pNext = &synchronization2Features;     // Enables the synchronization2 feature
+        }
+    }
+    deviceCreateInfo.enabledExtensionCount = static_cast<uint32_t>(enabledExtensions.size());   // Number of enabled Logical Device Extensions
+    deviceCreateInfo.ppEnabledExtensionNames = enabledExtensions.data();                        // List of enabled Logical Device Extensions
 
     // Physical Device Features the Logical Device will be using
     VkPhysicalDeviceFeatures deviceFeatures = {};
@@ -481,7 +771,8 @@ void VulkanRenderer::createSwapchain()
     }
 
     // If old swap chain has been destroyed and this one replaces it, then link the old one to quickly hand over responsibilities
-    swapChainCreateInfo.oldSwapchain = VK_NULL_HANDLE;
+    VkSwapchainKHR oldSwapchain = m_swapChain;                      // VK_NULL_HANDLE at first creation
+    swapChainCreateInfo.oldSwapchain = oldSwapchain;
 
     // Create Swapchain
     VkResult result = vkCreateSwapchainKHR(m_mainDevice.logicalDevice, &swapChainCreateInfo, nullptr, &m_swapChain);
@@ -490,6 +781,12 @@ void VulkanRenderer::createSwapchain()
         throw std::runtime_error("Failed to create Swapchain!");
     }
 
+    // The old Swapchain is retired now (its images can't be acquired anymore)
+    if (oldSwapchain != VK_NULL_HANDLE)
+    {
+        vkDestroySwapchainKHR(m_mainDevice.logicalDevice, oldSwapchain, nullptr);
+    }
+
     // Store useful (working) values for later reference
     m_swapChainImageFormat = surfaceFormat.format;
     m_swapChainExtent = extent;
@@ -501,6 +798,7 @@ void VulkanRenderer::createSwapchain()
     vkGetSwapchainImagesKHR(m_mainDevice.logicalDevice, m_swapChain, &swapchainImageCount, images.data());
 
     // Store each Swapchain image reference in our data member
+    m_swapchainImages.clear();
     for (VkImage image : images)
     {
         // Store image handle
@@ -512,427 +810,140 @@ void VulkanRenderer::createSwapchain()
     }
 }
 //------------------------------------------------------------------------------
-void VulkanRenderer::createRenderPass()
+void VulkanRenderer::createRenderGraph()
 {
-    // Colour attachment of render pass (index: 0)
-    VkAttachmentDescription colourAttachment = {};
-    colourAttachment.format = m_swapChainImageFormat;                   // Format to use for attachment
-    colourAttachment.samples = VK_SAMPLE_COUNT_1_BIT;                   // Number of samples to write for multisampling
-    colourAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;              // Describes what to do with attachment before rendering
-    colourAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;            // Describes what to do with attachment after rendering
-    colourAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;   // Describes what to do with stencil before rendering
-    colourAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE; // Describes what to do with stencil after rendering
+    // Frame output: the Swapchain image (set each frame), presented after the frame
+    m_swapchainResource = m_renderGraph.importImage("Swapchain", m_swapChainImageFormat, VK_IMAGE_LAYOUT_PRESENT_SRC_KHR);
 
-    // Framebuffer data will be stored as an image, but images can be given different data layouts
-    // to give optimal use for certain operations
-    colourAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;         // Image data layout before render pass starts
-    colourAttachment.finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;     // Image data layout after render pass (to change to)
-
-    // Depth attachment of render pass
-    VkAttachmentDescription depthAttachment = {};
-    depthAttachment.format = chooseSupportedFormat(
+    // Depth Buffer: transient (owned by the graph, re-created with the Swapchain extent). The pre-pass and the main
+    // pass share one render pass, so it never leaves it: a lazily allocated transient attachment where supported
+    VkFormat depthFormat = chooseSupportedFormat(
         { VK_FORMAT_D32_SFLOAT_S8_UINT, VK_FORMAT_D32_SFLOAT, VK_FORMAT_D24_UNORM_S8_UINT, VK_FORMAT_D16_UNORM_S8_UINT },
         VK_IMAGE_TILING_OPTIMAL,
         VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT);
-    depthAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
-    depthAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
-    depthAttachment.storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-    depthAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
-    depthAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-    depthAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-    depthAttachment.finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
-
-    // Attachment reference uses an attachment index that refers to index in the attachment array passed to renderPassCreateInfo
-    VkAttachmentReference colourAttachmentReference = {};
-    colourAttachmentReference.attachment = 0;                           // Colour attachment index
-    colourAttachmentReference.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
-
-    // Depth Attachment Reference
-    VkAttachmentReference depthAttachmentReference = {};
-    depthAttachmentReference.attachment = 1;                            // Depth attachment index
-    depthAttachmentReference.layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
-
-    // Information about a particular subpass the Render Pass is using
-    VkSubpassDescription subpass = {};
-    subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;        // Pipeline type subpass is to be bound to
-    subpass.colorAttachmentCount = 1;
-    subpass.pColorAttachments = &colourAttachmentReference;
-    subpass.pDepthStencilAttachment = &depthAttachmentReference;
-
-    // Need to determine when layout transitions occur using subpass dependencies
-    std::array<VkSubpassDependency, 2> subpassDependencies = {};
-
-    // Conversion from VK_IMAGE_LAYOUT_UNDEFINED to VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL
-    // Transition must happen after (source moment)...
-    subpassDependencies[0].srcSubpass = VK_SUBPASS_EXTERNAL;                        // Subpass index (VK_SUBPASS_EXTERNAL = Special value meaning outside of renderpass)
-    subpassDependencies[0].srcStageMask = VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;     // Pipeline stage
-    subpassDependencies[0].srcAccessMask = VK_ACCESS_MEMORY_READ_BIT;               // Stage access mask (memory access)
-    // But must happen before (destination moment)...
-    subpassDependencies[0].dstSubpass = 0;
-    subpassDependencies[0].dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-    subpassDependencies[0].dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
-    subpassDependencies[0].dependencyFlags = 0;
-
-    // Conversion from VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL to VK_IMAGE_LAYOUT_PRESENT_SRC_KHR
-    // Transition must happen after...
-    subpassDependencies[1].srcSubpass = 0;
-    subpassDependencies[1].srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-    subpassDependencies[1].srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;;
-    // But must happen before...
-    subpassDependencies[1].dstSubpass = VK_SUBPASS_EXTERNAL;
-    subpassDependencies[1].dstStageMask = VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
-    subpassDependencies[1].dstAccessMask = VK_ACCESS_MEMORY_READ_BIT;
-    subpassDependencies[1].dependencyFlags = 0;
-
-    std::array<VkAttachmentDescription, 2> renderPassAttachments = { colourAttachment, depthAttachment };
-
-    // Create info for Render Pass
-    VkRenderPassCreateInfo renderPassCreateInfo = {};
-    renderPassCreateInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
-    renderPassCreateInfo.attachmentCount = static_cast<uint32_t>(renderPassAttachments.size());
-    renderPassCreateInfo.pAttachments = renderPassAttachments.data();
-    renderPassCreateInfo.subpassCount = 1;
-    renderPassCreateInfo.pSubpasses = &subpass;
-    renderPassCreateInfo.dependencyCount = static_cast<uint32_t>(subpassDependencies.size());
-    renderPassCreateInfo.pDependencies = subpassDependencies.data();
-
-    VkResult result = vkCreateRenderPass(m_mainDevice.logicalDevice, &renderPassCreateInfo, nullptr, &m_renderPass);
-    if (result != VK_SUCCESS)
-    {
-        throw std::runtime_error("Failed to create a Render Pass!");
-    }
-}
-//------------------------------------------------------------------------------
-void VulkanRenderer::createDescriptorSetLayout()
-{
-    // UNIFORM VALUES DESCRIPTOR SET LAYOUT
-    // VP (View-Projection) Binding Info
-    VkDescriptorSetLayoutBinding vpLayoutBinding = {};
-    vpLayoutBinding.binding = 0;                                           // Binding point in shader (designated by binding number in shader)
-    vpLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;    // Type of descriptor (uniform, dynamic uniform, image sampler, etc)
-    vpLayoutBinding.descriptorCount = 1;                                   // Number of descriptors (in the shader) for binding
-    vpLayoutBinding.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;               // Shader stage to bind to (vertex shader in this case)
-    vpLayoutBinding.pImmutableSamplers = nullptr;                          // For Texture: Can make sampler data unchangeable (immutable) by specifying in layout
-    // N.B.: This is Set 0, Binding 0
-
-    // M (Model) Binding Info
-    //VkDescriptorSetLayoutBinding modelLayoutBinding = {};
-    //modelLayoutBinding.binding = 1;
-    //modelLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
-    //modelLayoutBinding.descriptorCount = 1;
-    //modelLayoutBinding.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
-    //modelLayoutBinding.pImmutableSamplers = nullptr;
-
-    std::vector<VkDescriptorSetLayoutBinding> layoutBindings = { vpLayoutBinding };
-
-    // Create Descriptor Set Layout with given bindings
-    VkDescriptorSetLayoutCreateInfo layoutCreateInfo = {};
-    layoutCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
-    layoutCreateInfo.bindingCount = static_cast<uint32_t>(layoutBindings.size());   // Number of binding infos
-    layoutCreateInfo.pBindings = layoutBindings.data();                             // Array of binding infos
-
-    // Create Descriptor Set Layout
-    VkResult result = vkCreateDescriptorSetLayout(m_mainDevice.logicalDevice, &layoutCreateInfo, nullptr, &m_descriptorSetLayout);
-    if (result != VK_SUCCESS)
-    {
-        throw std::runtime_error("Failed to create a Descriptor Set Layout!");
-    }
-
-    // CREATE TEXTURE SAMPLER DESCRIPTOR SET LAYOUT
-    // Texture binding info
-    VkDescriptorSetLayoutBinding samplerLayoutBinding = {};
-    samplerLayoutBinding.binding = 0;                                                   // Binding point in shader (designated by binding number in shader)
-    samplerLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;    // Type of descriptor (uniform, dynamic uniform, image sampler, etc)
-    samplerLayoutBinding.descriptorCount = 1;                                           // Number of descriptors (in the shader) for binding
-    samplerLayoutBinding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;                     // Shader stage to bind to (vertex shader in this case)
-    samplerLayoutBinding.pImmutableSamplers = nullptr;                                  // For Texture: Can make sampler data unchangeable (immutable) by specifying in layout
-    // N.B.: This is Set 1, Binding 0
-
-    // Create a Descriptor Set Layout with given bindings for texture
-    VkDescriptorSetLayoutCreateInfo textureLayoutCreateInfo = {};
-    textureLayoutCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
-    textureLayoutCreateInfo.bindingCount = 1;
-    textureLayoutCreateInfo.pBindings = &samplerLayoutBinding;
-
-    // Create Descriptor Set Layout
-    result = vkCreateDescriptorSetLayout(m_mainDevice.logicalDevice, &textureLayoutCreateInfo, nullptr, &m_samplerSetLayout);
-    if (result != VK_SUCCESS)
-    {
-        throw std::runtime_error("Failed to create a Descriptor Set Layout!");
-    }
-}
-//------------------------------------------------------------------------------
-void VulkanRenderer::createPushConstantRange()
-{
-    // Define push constant value (no 'create' needed!)
-    m_pushConstantRange.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;    // Shader stage push constant will go to
-    m_pushConstantRange.offset = 0;                                 // Offset of the start of data
-    m_pushConstantRange.size = sizeof(Model);
+    uint32_t depthBuffer = m_renderGraph.createImage("Depth", depthFormat);
+
+    //{ 0.59f, 0.69f, 0.53f, 1.0f }     // Light green
+    //{ 0.37f, 0.43f, 0.22f, 1.0f }     // Olive Green
+    //{ 0.6f, 0.65f, 0.4f, 1.0f }       // Light olive green
+    //{ 1.0f, 0.86, 0.72f, 1.0f }       // Light orange
+    //{ 0.92f, 0.56, 0.24f, 1.0f }      // Orange
+    VkClearValue colourClearValue = {};
+    colourClearValue.color = { 0.37f, 0.43f, 0.22f, 1.0f };             // Color clear RGBA (Red, Green, Blue, Alpha)
+    VkClearValue depthClearValue = {};
+    depthClearValue.depthStencil.depth = 1.0f;                          // Depth clear value (1.0f is the farthest from camera)
+
+    // Depth pre-pass (depth only, empty when the pre-pass is disabled): clears the Depth Buffer
+    m_depthPrepassPass = m_renderGraph.addPass("Depth pre-pass", [this](VkCommandBuffer commandBuffer) { recordDepthPrepass(commandBuffer); });
+    m_renderGraph.write(m_depthPrepassPass, depthBuffer, ImageAccess::DepthWrite, &depthClearValue);
+
+    // Main pass (colour + depth, tested against the pre-pass one): merged with the pre-pass as its second subpass
+    m_mainPass = m_renderGraph.addPass("Main", [this](VkCommandBuffer commandBuffer) { recordMainPass(commandBuffer); });
+    m_renderGraph.write(m_mainPass, m_swapchainResource, ImageAccess::ColourWrite, &colourClearValue);
+    m_renderGraph.write(m_mainPass, depthBuffer, ImageAccess::DepthWrite);
+
+    // Render passes, barriers and transient images
+    m_renderGraph.compile(m_swapChainExtent);
+
+    RenderGraphStats stats = m_renderGraph.getStats();
+    cout << "Render graph: " << (stats.passCount - stats.culledPassCount) << "/" << stats.passCount << " passes in "
+         << stats.renderPassCount << " render passes, "
+         << stats.transientImageCount << " transient images in " << stats.transientAllocationCount << " allocations ("
+         << stats.transientMemorySize / 1024 << " KiB, " << stats.lazyAllocationCount << " lazily allocated), barriers: "
+         << (m_synchronization2Supported ? "synchronization2" : "vkCmdPipelineBarrier") << endl;
 }
 //------------------------------------------------------------------------------
 void VulkanRenderer::createGraphicsPipeline()
 {
-    // TODO: compile shaders in another ad hoc method and call it just in debug configuration
-    // Read in the SPIR-V binary code of the shaders
-    auto vertexShaderCode = readBinaryFile("Shaders/vert.spv");
-    auto fragmentShaderCode = readBinaryFile("Shaders/frag.spv");
-
-    // |A| Create Shader Modules (ALWAYS keep sure to destroy them to avoid memory leaks)
-    VkShaderModule vertexShaderModule = createShaderModule(vertexShaderCode);
-    VkShaderModule fragmentShaderModule = createShaderModule(fragmentShaderCode);
-
-    // -- SHADER STAGE CREATION INFORMATION --
-    // Vertex Stage creation information
-    VkPipelineShaderStageCreateInfo vertexShaderCreateInfo = {};
-    vertexShaderCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
-    vertexShaderCreateInfo.stage = VK_SHADER_STAGE_VERTEX_BIT;          // Shader Stage name
-    vertexShaderCreateInfo.module = vertexShaderModule;                 // Shader module to be used by stage
-    vertexShaderCreateInfo.pName = "main";                              // Entry point function name (in the shader)
-
-    // Fragment Stage creation information
-    VkPipelineShaderStageCreateInfo fragmentShaderCreateInfo = {};
-    fragmentShaderCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
-    fragmentShaderCreateInfo.stage = VK_SHADER_STAGE_FRAGMENT_BIT;      // Shader Stage name
-    fragmentShaderCreateInfo.module = fragmentShaderModule;             // Shader module to be used by stage
-    fragmentShaderCreateInfo.pName = "main";                            // Entry point function name (in the shader)
-
-    // Put shader stage creation info in to array
-    // Graphics Pipeline creation info requires array of shader stage creates
-    VkPipelineShaderStageCreateInfo shaderStages[] = { vertexShaderCreateInfo, fragmentShaderCreateInfo };
-
-    // CREATE GRAPHICS PIPELINE
-    // Vertex binding description (including info such as position, colour, texture coords, normals, etc) as a whole
-    VkVertexInputBindingDescription bindingDescription = {};
-    bindingDescription.binding = 0;                                 // Can bind multiple streams of data, this defines which one
-    bindingDescription.stride = sizeof(Vertex);                     // Size of a single vertex object
-    bindingDescription.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;     // How to move between data after each vertex.
-                                                                    // VK_VERTEX_INPUT_RATE_INDEX        : Move on to the next vertex
-                                                                    // VK_VERTEX_INPUT_RATE_INSTANCE    : Move to a vertex for the next instance
-
-    // How the data for an attribute is defined within a vertex
-    std::array<VkVertexInputAttributeDescription, 3> attributeDescriptions = {};
-
-    // Vertex Position Attribute
-    attributeDescriptions[0].binding = 0;                           // Which binding the data is at (should be same as above)
-    attributeDescriptions[0].location = 0;                          // Location in shader where data will be read from
-    attributeDescriptions[0].format = VK_FORMAT_R32G32B32_SFLOAT;   // Format the data will take (also helps define size of data)
-    attributeDescriptions[0].offset = offsetof(Vertex, pos);        // Where this attribute is defined in the data for a single vertex
-
-    // Vertex Colour Attribute
-    attributeDescriptions[1].binding = 0;                            
-    attributeDescriptions[1].location = 1;                            
-    attributeDescriptions[1].format = VK_FORMAT_R32G32B32_SFLOAT;    
-    attributeDescriptions[1].offset = offsetof(Vertex, col);
-
-    // Vertex Texture Attribute
-    attributeDescriptions[2].binding = 0;
-    attributeDescriptions[2].location = 2;
-    attributeDescriptions[2].format = VK_FORMAT_R32G32_SFLOAT;
-    attributeDescriptions[2].offset = offsetof(Vertex, tex);
-
-    // -- VERTEX INPUT --
-    VkPipelineVertexInputStateCreateInfo vertexInputCreateInfo = {};
-    vertexInputCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
-    vertexInputCreateInfo.vertexBindingDescriptionCount = 1;
-    vertexInputCreateInfo.pVertexBindingDescriptions = &bindingDescription;             // List of Vertex Binding Descriptions (data spacing/stride information)
-    vertexInputCreateInfo.vertexAttributeDescriptionCount = static_cast<uint32_t>(attributeDescriptions.size());
-    vertexInputCreateInfo.pVertexAttributeDescriptions = attributeDescriptions.data();  // List of Vertex Attribute Descriptions (data format and where to bind to/from)
-
-
-    // -- INPUT ASSEMBLY --
-    VkPipelineInputAssemblyStateCreateInfo inputAssembly = {};
-    inputAssembly.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
-    inputAssembly.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;   // Primitive type to assemble vertices as
-    inputAssembly.primitiveRestartEnable = VK_FALSE;                // Allow overriding of "strip" topology to start new primitives
-
-
-    // -- VIEWPORT & SCISSOR --
-    // Create a viewport info struct
-    VkViewport viewport = {};
-    viewport.x = 0.0f;                                              // x start coordinate
-    viewport.y = 0.0f;                                              // y start coordinate
-    viewport.width = static_cast<float>(m_swapChainExtent.width);   // width of viewport
-    viewport.height = static_cast<float>(m_swapChainExtent.height); // height of viewport
-    viewport.minDepth = 0.0f;                                       // min framebuffer depth
-    viewport.maxDepth = 1.0f;                                       // max framebuffer depth
-
-    // Create a scissor info struct
-    VkRect2D scissor = {};
-    scissor.offset = { 0,0 };                                       // Offset to use region from
-    scissor.extent = m_swapChainExtent;                             // Extent to describe region to use, starting at offset
-
-    // Viewport State info struct
-    VkPipelineViewportStateCreateInfo viewportStateCreateInfo = {};
-    viewportStateCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
-    viewportStateCreateInfo.viewportCount = 1;
-    viewportStateCreateInfo.pViewports = &viewport;
-    viewportStateCreateInfo.scissorCount = 1;
-    viewportStateCreateInfo.pScissors = &scissor;
-
-    // -- DYNAMIC VIEWPORT STATES --
-    // Dynamic states to enable resizing. Remember to also delete and re-create a SwapChain for the new resolution!
-    //std::vector<VkDynamicState> dynamicStateEnables;
-    //dynamicStateEnables.push_back(VK_DYNAMIC_STATE_VIEWPORT); // Dynamic Viewport : Can resize in command buffer with vkCmdSetViewport(commandbuffer, 0, 1, &viewport);
-    //dynamicStateEnables.push_back(VK_DYNAMIC_STATE_SCISSOR);  // Dynamic Scissor  : Can resize in command buffer with vkCmdSetScissor(commandbuffer, 0, 1, &scissor);
-
-    // Dynamic State creation info
-    //VkPipelineDynamicStateCreateInfo dynamicStateCreateInfo = {};
-    //dynamicStateCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
-    //dynamicStateCreateInfo.dynamicStateCount = static_cast<uint32_t>(dynamicStateEnables.size());
-    //dynamicStateCreateInfo.pDynamicStates = dynamicStateEnables.data();
-
-
-    // -- RASTERIZER --
-    VkPipelineRasterizationStateCreateInfo rasterizerCreateInfo = {};
-    rasterizerCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
-    rasterizerCreateInfo.depthClampEnable = VK_FALSE;                   // Change if fragments beyond near/far planes are clipped (default) or clamped to plane
-    rasterizerCreateInfo.rasterizerDiscardEnable = VK_FALSE;            // Whether to discard data and skip rasterizer. Never creates fragments, only suitable for pipeline without framebuffer output
-    rasterizerCreateInfo.polygonMode = VK_POLYGON_MODE_FILL;            // How to handle filling points between vertices (if not fill, check for the feature needed for that)
-    rasterizerCreateInfo.lineWidth = 1.0f;                              // How thick lines should be when drawn
-    rasterizerCreateInfo.cullMode = VK_CULL_MODE_BACK_BIT;              // Which face of a triangle to cull
-    rasterizerCreateInfo.frontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE;   // Winding to determine which side is front
-    rasterizerCreateInfo.depthBiasEnable = VK_FALSE;                    // Whether to add depth bias to fragments (good for stopping "shadow acne" in shadow mapping)
-
-
-    // -- MULTISAMPLING --
-    VkPipelineMultisampleStateCreateInfo multisamplingCreateInfo = {};
-    multisamplingCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
-    multisamplingCreateInfo.sampleShadingEnable = VK_FALSE;                 // Enable multisample shading or not
-    multisamplingCreateInfo.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;   // Number of samples to use per fragment
-
-
-    // -- BLENDING --
-    // Blending decides how to blend a new colour being written to a fragment, with the old value
-
-    // Blend Attachment State (how blending is handled)
-    VkPipelineColorBlendAttachmentState colourState = {};
-    colourState.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT    // Colours to apply blending to
-        | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
-    colourState.blendEnable = VK_TRUE;                                                  // Enable blending
-
-    // Blending uses equation: (srcColorBlendFactor * new colour) colorBlendOp (dstColorBlendFactor * old colour)
-    colourState.srcColorBlendFactor = VK_BLEND_FACTOR_SRC_ALPHA;
-    colourState.dstColorBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
-    colourState.colorBlendOp = VK_BLEND_OP_ADD;
-    // Summarised: (VK_BLEND_FACTOR_SRC_ALPHA * new colour) + (VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA * old colour)
-    //                      (new colour alpha * new colour) + ((1 - new colour alpha) * old colour)
-
-    colourState.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
-    colourState.dstAlphaBlendFactor = VK_BLEND_FACTOR_ZERO;
-    colourState.alphaBlendOp = VK_BLEND_OP_ADD;
-    // Summarised: (1 * new alpha) + (0 * old alpha) = new alpha
-
-    VkPipelineColorBlendStateCreateInfo colourBlendingCreateInfo = {};
-    colourBlendingCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
-    colourBlendingCreateInfo.logicOpEnable = VK_FALSE;      // Alternative to calculations (colourState) is to use logical operations
-    colourBlendingCreateInfo.attachmentCount = 1;
-    colourBlendingCreateInfo.pAttachments = &colourState;
-
-    // -- PIPELINE LAYOUT --
-    std::array<VkDescriptorSetLayout, 2> descriptorSetLayouts = { m_descriptorSetLayout, m_samplerSetLayout };
-
-    VkPipelineLayoutCreateInfo pipelineLayoutCreateInfo = {};
-    pipelineLayoutCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-    pipelineLayoutCreateInfo.setLayoutCount = static_cast<uint32_t>(descriptorSetLayouts.size());
-    pipelineLayoutCreateInfo.pSetLayouts = descriptorSetLayouts.data();
-    pipelineLayoutCreateInfo.pushConstantRangeCount = 1;
-    pipelineLayoutCreateInfo.pPushConstantRanges = &m_pushConstantRange;
-
-    // Create Pipeline Layout
-    VkResult result = vkCreatePipelineLayout(m_mainDevice.logicalDevice, &pipelineLayoutCreateInfo, nullptr, &m_pipelineLayout);
-    if (result != VK_SUCCESS)
-    {
-        throw std::runtime_error("Failed to create Pipeline Layout!");
-    }
-
-
-    // -- DEPTH STENCIL TESTING --
-    VkPipelineDepthStencilStateCreateInfo depthStencilCreateInfo = {};
-    depthStencilCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
-    depthStencilCreateInfo.depthTestEnable = VK_TRUE;               // Enable checking depth to determine fragment write
-    depthStencilCreateInfo.depthWriteEnable = VK_TRUE;              // Enable writing to depth buffer (to replace old values)
-    depthStencilCreateInfo.depthCompareOp = VK_COMPARE_OP_LESS;     // Comparison operation that allows an overwrite (if it's in front)
-    depthStencilCreateInfo.depthBoundsTestEnable = VK_FALSE;        // Depth Bounds Test: Does the depth value exist between two bounds
-    depthStencilCreateInfo.stencilTestEnable = VK_FALSE;            // Enable Stencil test
-
-
-    // -- GRAPHICS PIPELINE CREATION --
-    VkGraphicsPipelineCreateInfo pipelineCreateInfo = {};
-    pipelineCreateInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
-    pipelineCreateInfo.stageCount = ARRAY_SIZE(shaderStages);           // Number of shader stages
-    pipelineCreateInfo.pStages = shaderStages;                          // List of shader stages
-    pipelineCreateInfo.pVertexInputState = &vertexInputCreateInfo;      // All the fixed function pipeline states
-    pipelineCreateInfo.pInputAssemblyState = &inputAssembly;
-    pipelineCreateInfo.pViewportState = &viewportStateCreateInfo;
-    pipelineCreateInfo.pDynamicState = nullptr;
-    pipelineCreateInfo.pRasterizationState = &rasterizerCreateInfo;
-    pipelineCreateInfo.pMultisampleState = &multisamplingCreateInfo;
-    pipelineCreateInfo.pColorBlendState = &colourBlendingCreateInfo;
-    pipelineCreateInfo.pDepthStencilState = &depthStencilCreateInfo;
-    pipelineCreateInfo.layout = m_pipelineLayout;                       // Pipeline Layout pipeline should use
-    pipelineCreateInfo.renderPass = m_renderPass;                       // Render pass the pipeline is compatible with
-    pipelineCreateInfo.subpass = 0;                                     // Subpass index of render pass to use with pipeline
-
-    // Pipeline Derivatives: can create multiple pipelines that derive from one another for optimisation
-    pipelineCreateInfo.basePipelineHandle = VK_NULL_HANDLE;             // Existing pipeline to derive from...
-    pipelineCreateInfo.basePipelineIndex = -1;                          // or index of pipeline being created to derive from (in case creating multiple at once)
-
-    // Create Graphics Pipeline
-    result = vkCreateGraphicsPipelines(m_mainDevice.logicalDevice, VK_NULL_HANDLE, 1, &pipelineCreateInfo, nullptr, &m_graphicsPipeline);
-    if (result != VK_SUCCESS)
+    // Runtime compilation: all the shaders at once, on every core (the reflection and the pipeline workers wait for
+    // the ones they need)
+    if (m_runtimeShaderCompilation)
     {
-        throw std::runtime_error("Failed to create a Graphics Pipeline!");
+        for (const ShaderSource &shader : SHADER_SOURCES)
+        {
+            m_shaderCompiler.prepare(shader.source);
+        }
     }
 
-    // |B| Destroy Shader Modules, no longer needed after the Pipeline is created
-    vkDestroyShaderModule(m_mainDevice.logicalDevice, fragmentShaderModule, nullptr);
-    vkDestroyShaderModule(m_mainDevice.logicalDevice, vertexShaderModule, nullptr);
+    // -- PIPELINE LAYOUT --
+    // Reflected from the shaders: Set 0 (View-Projection uniform buffer), Set 1 (texture sampler) and the push
+    // constants. The depth pre-pass layout (Set 0 only) shares the same Set 0 layout and push constant range.
+    m_opaquePipelineDesc.vertexShader = getShaderFile("Shaders/shader.vert");
+    m_opaquePipelineDesc.fragmentShader = getShaderFile("Shaders/shader.frag");
+    ShaderReflection mainInterface = m_pipelineManager.reflect(m_opaquePipelineDesc);
+    m_descriptorSetLayout = m_layoutCache.getSetLayout(mainInterface, 0);
+    m_samplerSetLayout = m_layoutCache.getSetLayout(mainInterface, 1);
+    m_pushConstantRange = mainInterface.pushConstantRange;
+    m_pipelineLayout = m_layoutCache.getPipelineLayout(mainInterface);
+    if (m_pushConstantRange.size < sizeof(Model) + sizeof(glm::vec4))
+    {
+        throw std::runtime_error("Push constants of the shaders don't match the ones of the meshes!");   // Model matrix + UV scale/offset
+    }
+
+    // -- PIPELINE DESCRIPTIONS --
+    // Opaque Pipeline: opaque fragments overwrite the colour attachment, so blending would only waste fill rate and ROP bandwidth
+    m_opaquePipelineDesc.blendEnable = false;
+    m_opaquePipelineDesc.depthWriteEnable = true;
+    m_opaquePipelineDesc.depthCompareOp = VK_COMPARE_OP_LESS;       // Comparison operation that allows an overwrite (if it's in front)
+    m_opaquePipelineDesc.layout = m_pipelineLayout;
+    m_opaquePipelineDesc.renderPass = m_renderGraph.getRenderPass(m_mainPass);
+    m_opaquePipelineDesc.subpass = m_renderGraph.getSubpass(m_mainPass);   // Subpass index of render pass to use with pipeline
+    m_opaquePipelineDesc.colourAttachmentCount = m_renderGraph.getColourAttachmentCount(m_mainPass);
+    m_opaquePipelineDesc.specializationConstants = getMaterialPipelineDesc(m_opaquePipelineDesc, Material()).specializationConstants;
+
+    // Transparent geometry is tested against the opaque depth, but must not occlude what is drawn behind it
+    m_transparentPipelineDesc = m_opaquePipelineDesc;
+    m_transparentPipelineDesc.blendEnable = true;
+    m_transparentPipelineDesc.depthWriteEnable = false;
+
+    // Opaque Pipeline used after the pre-pass: depth already holds the nearest surface, so only one fragment
+    // per pixel passes the EQUAL test and runs the (expensive) fragment shader. Nothing left to write.
+    m_opaqueEqualPipelineDesc = m_opaquePipelineDesc;
+    m_opaqueEqualPipelineDesc.depthWriteEnable = false;
+    m_opaqueEqualPipelineDesc.depthCompareOp = VK_COMPARE_OP_EQUAL;
+
+    // Depth Pre-pass Pipeline: vertex stage only (no fragment shader), position-only vertex stream, no colour attachments
+    m_depthPrepassPipelineDesc = m_opaquePipelineDesc;
+    m_depthPrepassPipelineDesc.vertexShader = getShaderFile("Shaders/depth.vert");
+    m_depthPrepassPipelineDesc.fragmentShader.clear();
+    m_depthPrepassPipelineDesc.specializationConstants.clear();     // Material features are all in the fragment stage
+    m_depthPrepassPipelineDesc.vertexLayout = VertexLayout::PositionOnly;
+    m_depthPrepassPipelineDesc.colourAttachmentCount = m_renderGraph.getColourAttachmentCount(m_depthPrepassPass);  // None, but the main pass one with dynamic rendering
+    m_depthPrepassPipelineDesc.renderPass = m_renderGraph.getRenderPass(m_depthPrepassPass);
+    m_depthPrepassPipelineDesc.subpass = m_renderGraph.getSubpass(m_depthPrepassPass);
+    m_depthPrepassPipelineDesc.layout = m_layoutCache.getPipelineLayout(m_pipelineManager.reflect(m_depthPrepassPipelineDesc));
+
+    // Queue all the variants (compiled in parallel on the worker threads), then wait just for the ones
+    // needed to draw the first frame: the pre-pass ones are picked up as soon as they are ready
+    m_pipelineManager.prepare(m_opaquePipelineDesc);
+    m_pipelineManager.prepare(m_transparentPipelineDesc);
+    m_pipelineManager.prepare(m_depthPrepassPipelineDesc);
+    m_pipelineManager.prepare(m_opaqueEqualPipelineDesc);
+    m_pipelineManager.requirePipeline(m_opaquePipelineDesc);
+    m_pipelineManager.requirePipeline(m_transparentPipelineDesc);
 }
 //------------------------------------------------------------------------------
-void VulkanRenderer::createDepthBufferImage()
+PipelineDesc VulkanRenderer::getMaterialPipelineDesc(const PipelineDesc &base, const Material &material)
 {
-    // Get supported format for depth buffer
-    VkFormat depthFormat = chooseSupportedFormat(
-        { VK_FORMAT_D32_SFLOAT_S8_UINT, VK_FORMAT_D32_SFLOAT, VK_FORMAT_D24_UNORM_S8_UINT, VK_FORMAT_D16_UNORM_S8_UINT },
-        VK_IMAGE_TILING_OPTIMAL,
-        VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT);
-
-    // Create Depth Buffer Image
-    m_depthBufferImage = createImage(m_swapChainExtent.width, m_swapChainExtent.height, depthFormat, VK_IMAGE_TILING_OPTIMAL,
-        VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, &m_depthBufferImageMemory);
-
-    // Create Depth Buffer Image View
-    m_depthBufferImageView = createImageView(m_depthBufferImage, depthFormat, VK_IMAGE_ASPECT_DEPTH_BIT);
+    // Values of the constant_id of "shader.frag", in order (same SPIR-V, one pipeline per combination)
+    PipelineDesc desc = base;
+    desc.specializationConstants = { static_cast<VkBool32>(material.textured), static_cast<VkBool32>(material.alphaTested) };
+    return desc;
 }
 //------------------------------------------------------------------------------
-void VulkanRenderer::createFramebuffers()
+std::string VulkanRenderer::getShaderFile(const std::string &source)
 {
-    // Resize framebuffer count to equal swap chain image count
-    m_swapChainFramebuffers.resize(m_swapchainImages.size());
-
-    // Create a framebuffer for each swap chain image
-    for (size_t i = 0; i < m_swapChainFramebuffers.size(); ++i)
+    if (!m_runtimeShaderCompilation)
     {
-        std::array<VkImageView, 2> attachments = {
-            m_swapchainImages[i].imageView,
-            m_depthBufferImageView
-        };
-
-        VkFramebufferCreateInfo framebufferCreateInfo = {};
-        framebufferCreateInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
-        framebufferCreateInfo.renderPass = m_renderPass;                                    // Render Pass layout the Framebuffer will be used with
-        framebufferCreateInfo.attachmentCount = static_cast<uint32_t>(attachments.size());
-        framebufferCreateInfo.pAttachments = attachments.data();                            // List of attachments (1:1 with Render Pass)
-        framebufferCreateInfo.width = m_swapChainExtent.width;                              // Framebuffer width
-        framebufferCreateInfo.height = m_swapChainExtent.height;                            // Framebuffer height
-        framebufferCreateInfo.layers = 1;                                                   // Framebuffer layers
-
-        VkResult result = vkCreateFramebuffer(m_mainDevice.logicalDevice, &framebufferCreateInfo, nullptr, &m_swapChainFramebuffers[i]);
-        if (result != VK_SUCCESS)
+        for (const ShaderSource &shader : SHADER_SOURCES)
         {
-            throw std::runtime_error("Failed to create a Framebuffer!");
+            if (source == shader.source)
+            {
+                return shader.spirv;
+            }
         }
     }
+    return source;
 }
 //------------------------------------------------------------------------------
 void VulkanRenderer::createCommandPool()
@@ -955,8 +966,8 @@ void VulkanRenderer::createCommandPool()
 //------------------------------------------------------------------------------
 void VulkanRenderer::createCommandBuffers()
 {
-    // Resize command buffer count to have one for each framebuffer
-    m_commandBuffers.resize(m_swapChainFramebuffers.size());
+    // Resize command buffer count to have one for each Swapchain image
+    m_commandBuffers.resize(m_swapchainImages.size());
 
     // N.B.: Not a Create but Allocate, because CommandBuffers are already there, we are just allocating them
     VkCommandBufferAllocateInfo cbAllocateInfo = {};
@@ -1016,7 +1027,7 @@ void VulkanRenderer::createTextureSampler()
     samplerCreateInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;       // Mipmap interpolation mode
     samplerCreateInfo.mipLodBias = 0.0f;                                // Level of Details bias for mip level
     samplerCreateInfo.minLod = 0.0f;                                    // Minimum Level of Detail to pick mip level
-    samplerCreateInfo.maxLod = 0.0f;                                    // Maximum Level of Detail to pick mip level
+    samplerCreateInfo.maxLod = VK_LOD_CLAMP_NONE;                       // Maximum Level of Detail to pick mip level (clamped to the levels of each image view)
     samplerCreateInfo.anisotropyEnable = VK_TRUE;                       // Enable Anisotropy
     samplerCreateInfo.maxAnisotropy = 16;                               // Anisotropy sample level
 
@@ -1083,20 +1094,23 @@ void VulkanRenderer::createDescriptorPool()
     {
         throw std::runtime_error("Failed to create a Descriptor Pool!");
     }
-
+}
+//------------------------------------------------------------------------------
+void VulkanRenderer::createSamplerDescriptorPool()
+{
     // CREATE SAMPLER DESCRIPTOR POOL
     // Texture sampler pool
     VkDescriptorPoolSize samplerPoolSize = {};
     samplerPoolSize.type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-    samplerPoolSize.descriptorCount = MAX_OBJECTS;
+    samplerPoolSize.descriptorCount = MAX_TEXTURE_DESCRIPTOR_SETS + TextureAtlas::MAX_PAGES;
 
     VkDescriptorPoolCreateInfo samplerPoolCreateInfo = {};
     samplerPoolCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
-    samplerPoolCreateInfo.maxSets = MAX_OBJECTS;
+    samplerPoolCreateInfo.maxSets = MAX_TEXTURE_DESCRIPTOR_SETS + TextureAtlas::MAX_PAGES;
     samplerPoolCreateInfo.poolSizeCount = 1;
     samplerPoolCreateInfo.pPoolSizes = &samplerPoolSize;
 
-    result = vkCreateDescriptorPool(m_mainDevice.logicalDevice, &samplerPoolCreateInfo, nullptr, &m_samplerDescriptorPool);
+    VkResult result = vkCreateDescriptorPool(m_mainDevice.logicalDevice, &samplerPoolCreateInfo, nullptr, &m_samplerDescriptorPool);
     if (result != VK_SUCCESS)
     {
         throw std::runtime_error("Failed to create a Descriptor Pool!");
@@ -1196,87 +1210,156 @@ void VulkanRenderer::updateUniformBuffers(uint32_t imageIndex)
     /**/
 }
 
+//------------------------------------------------------------------------------
+void VulkanRenderer::updateProjection()
+{
+    m_uboViewProjection.projection = glm::perspective(
+        glm::radians(45.0f), static_cast<float>(m_swapChainExtent.width) / static_cast<float>(m_swapChainExtent.height), 0.1f, 100.0f);
+    //               FOV-Y ,                                       Aspect Ratio                                        ,zNear, zFar
+
+    m_uboViewProjection.projection[1][1] *= -1; // Vulkan inverts Y coordinates compared to OpenGL (and GLM is based upon OpenGL coordinate system)
+}
+//------------------------------------------------------------------------------
+void VulkanRenderer::recreateSwapchain()
+{
+    // A minimized window has a zero-sized framebuffer: no Swapchain can be created, try again on a later frame
+    int width = 0, height = 0;
+    glfwGetFramebufferSize(m_pWindow, &width, &height);
+    if (width == 0 || height == 0)
+    {
+        return;
+    }
+    m_framebufferResized = false;
+
+    // Wait until no actions being run on device before destroying
+    vkDeviceWaitIdle(m_mainDevice.logicalDevice);
+
+    // Only what depends on the Swapchain images and extent is re-created: Render Passes, Pipelines (dynamic Viewport
+    // and Scissor), Descriptor Set Layouts and Textures stay. The surface format doesn't change for the same surface.
+    size_t previousImageCount = m_swapchainImages.size();
+    destroySwapchainAttachments();
+    createSwapchain();
+    m_renderGraph.resize(m_swapChainExtent);        // Transient images and Framebuffers
+
+    // Per-image resources must follow the number of Swapchain images (rarely, it can change)
+    if (m_swapchainImages.size() != previousImageCount)
+    {
+        vkFreeCommandBuffers(m_mainDevice.logicalDevice, m_graphicsCommandPool,
+                             static_cast<uint32_t>(m_commandBuffers.size()), m_commandBuffers.data());
+        createCommandBuffers();
+
+        vkDestroyDescriptorPool(m_mainDevice.logicalDevice, m_descriptorPool, nullptr);     // Frees its Descriptor Sets too
+        for (size_t i = 0; i < m_vpUniformBuffer.size(); ++i)
+        {
+            vkDestroyBuffer(m_mainDevice.logicalDevice, m_vpUniformBuffer[i], nullptr);
+            vkFreeMemory(m_mainDevice.logicalDevice, m_vpUniformBufferMemory[i], nullptr);
+        }
+        createUniformBuffers();
+        createDescriptorPool();
+        createDescriptorSets();
+    }
+
+    // New aspect ratio
+    updateProjection();
+}
+//------------------------------------------------------------------------------
+void VulkanRenderer::destroySwapchainAttachments()
+{
+    // Destroy the Swapchain image views (the images belong to the Swapchain)
+    for (auto &image : m_swapchainImages)
+    {
+        vkDestroyImageView(m_mainDevice.logicalDevice, image.imageView, nullptr);
+    }
+    m_swapchainImages.clear();
+}
+//------------------------------------------------------------------------------
+void VulkanRenderer::framebufferResizeCbk(GLFWwindow* window, int width, int height)
+{
+    // Drivers don't always report VK_ERROR_OUT_OF_DATE_KHR on resize: remember it to re-create the Swapchain anyway
+    auto renderer = reinterpret_cast<VulkanRenderer *>(glfwGetWindowUserPointer(window));
+    if (renderer != nullptr)
+    {
+        renderer->m_framebufferResized = true;
+    }
+}
+
 //------------------------------------------------------------------------------
 void VulkanRenderer::recordCommands(uint32_t currentImageIdx)
 {
+    VkCommandBuffer commandBuffer = m_commandBuffers[currentImageIdx];
+
+    // Opaque meshes front-to-back (maximizes early depth rejection), then transparent ones back-to-front
+    m_frameDraws.imageIndex = currentImageIdx;
+    m_frameDraws.opaqueDraws.clear();
+    m_frameDraws.transparentDraws.clear();
+    sortDrawOrder(m_frameDraws.opaqueDraws, m_frameDraws.transparentDraws);
+
+    // Pipelines still compiling are replaced by a compatible variant (or skipped, if there is none yet).
+    // The pre-pass is used only when both its pipelines are ready: the EQUAL test needs the pre-pass depth.
+    m_frameDraws.depthPrepass = m_depthPrepassEnabled
+        && m_pipelineManager.isReady(m_depthPrepassPipelineDesc) && m_pipelineManager.isReady(m_opaqueEqualPipelineDesc);
+
+    // Pipeline description of each material variant drawn (built once per frame, empty shaders: not drawn).
+    // Alpha-tested meshes skip the pre-pass, which has no fragment shader to discard with: they are tested LESS
+    // and write their depth in the main pass.
+    m_frameDraws.opaquePipelineDescs.fill(PipelineDesc());
+    m_frameDraws.transparentPipelineDescs.fill(PipelineDesc());
+    for (size_t meshIdx : m_frameDraws.opaqueDraws)
+    {
+        Material material = m_meshList[meshIdx].getMaterial();
+        if (m_frameDraws.opaquePipelineDescs[material.getVariant()].vertexShader.empty())
+        {
+            bool equalTest = m_frameDraws.depthPrepass && !material.alphaTested;
+            m_frameDraws.opaquePipelineDescs[material.getVariant()] =
+                getMaterialPipelineDesc(equalTest ? m_opaqueEqualPipelineDesc : m_opaquePipelineDesc, material);
+        }
+    }
+    for (size_t meshIdx : m_frameDraws.transparentDraws)
+    {
+        Material material = m_meshList[meshIdx].getMaterial();
+        if (m_frameDraws.transparentPipelineDescs[material.getVariant()].vertexShader.empty())
+        {
+            m_frameDraws.transparentPipelineDescs[material.getVariant()] = getMaterialPipelineDesc(m_transparentPipelineDesc, material);
+        }
+    }
+
+    m_renderGraph.setImportedImage(m_swapchainResource, m_swapchainImages[currentImageIdx].image, m_swapchainImages[currentImageIdx].imageView);
+
     // Information about how to begin each command buffer
     VkCommandBufferBeginInfo bufferBeginInfo = {};
     bufferBeginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
     bufferBeginInfo.flags = VK_COMMAND_BUFFER_USAGE_SIMULTANEOUS_USE_BIT;   // Buffer can be resubmitted when it has already been submitted and is awaiting execution
 
-    // Information about how to begin a render pass (only needed for graphical applications)
-    VkRenderPassBeginInfo renderPassBeginInfo = {};
-    renderPassBeginInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
-    renderPassBeginInfo.renderPass = m_renderPass;                          // Render Pass to begin
-    renderPassBeginInfo.renderArea.offset = { 0, 0 };                       // Start point of render pass in pixels
-    renderPassBeginInfo.renderArea.extent = m_swapChainExtent;              // Size of region to run render pass on (starting at offset)
-        //{ 0.59f, 0.69f, 0.53f, 1.0f }     // Light green
-        //{ 0.37f, 0.43f, 0.22f, 1.0f }     // Olive Green
-        //{ 0.6f, 0.65f, 0.4f, 1.0f }       // Light olive green
-        //{ 1.0f, 0.86, 0.72f, 1.0f }       // Light orange
-        //{ 0.92f, 0.56, 0.24f, 1.0f }      // Orange
-        std::array<VkClearValue, 2> clearValues = {};                       // Clear Color values
-        clearValues[0].color = { 0.37f, 0.43f, 0.22f, 1.0f };               // Color clear RGBA (Red, Green, Blue, Alpha)
-        clearValues[1].depthStencil.depth = 1.0f;                           // Depth clear value (1.0f is the farthest from camera)
-    renderPassBeginInfo.pClearValues = clearValues.data();                  // Array of clear values
-    renderPassBeginInfo.clearValueCount = static_cast<uint32_t>(clearValues.size());
-
-    renderPassBeginInfo.framebuffer = m_swapChainFramebuffers[currentImageIdx];
-
     // Start recording commands to command buffer!
-    VkResult result = vkBeginCommandBuffer(m_commandBuffers[currentImageIdx], &bufferBeginInfo);
+    VkResult result = vkBeginCommandBuffer(commandBuffer, &bufferBeginInfo);
     if (result != VK_SUCCESS)
     {
         throw std::runtime_error("Failed to START recording a Command Buffer!");
     }
 
-        // Begin Render Pass
-        vkCmdBeginRenderPass(m_commandBuffers[currentImageIdx], &renderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
+    // Texture uploads and residency changes (before any pass samples their images)
+    recordTextureUploads(commandBuffer);
+    recordResidencyCopies(commandBuffer);
 
-            // Bind Pipeline to be used in render pass
-            vkCmdBindPipeline(m_commandBuffers[currentImageIdx], VK_PIPELINE_BIND_POINT_GRAPHICS, m_graphicsPipeline);
+        // Dynamic Viewport and Scissor (whole Swapchain extent, valid for all the passes and pipelines below)
+        VkViewport viewport = {};
+        viewport.x = 0.0f;                                              // x start coordinate
+        viewport.y = 0.0f;                                              // y start coordinate
+        viewport.width = static_cast<float>(m_swapChainExtent.width);   // width of viewport
+        viewport.height = static_cast<float>(m_swapChainExtent.height); // height of viewport
+        viewport.minDepth = 0.0f;                                       // min framebuffer depth
+        viewport.maxDepth = 1.0f;                                       // max framebuffer depth
 
-            // Loop Mesh list
-            for (size_t meshIdx = 0; meshIdx < m_meshList.size(); ++meshIdx)
-            {
-                // Bind mesh Vertex buffers
-                VkBuffer vertexBuffers[] = { m_meshList[meshIdx].getVertexBuffer() };   // Buffers to bind
-                VkDeviceSize offsets[] = { 0 };                                         // Offsets into buffers being bound
-                vkCmdBindVertexBuffers(m_commandBuffers[currentImageIdx], 0, 1, vertexBuffers, offsets);  // Command to bind vertex buffer before drawing with them
-
-                // Bind mesh Index buffer (with 0 offset and using the uint32 type)
-                vkCmdBindIndexBuffer(m_commandBuffers[currentImageIdx], m_meshList[meshIdx].getIndexBuffer(), 0, VK_INDEX_TYPE_UINT32);
-
-                // Dynamic Uniform Buffer offset amount
-                //uint32_t dynamicOffset = static_cast<uint32_t>(m_modelUniformAlignment * meshIdx);
-
-                // Push constants to given shader stage directly (no buffer is used)
-                Model model = m_meshList[meshIdx].getModel();
-                vkCmdPushConstants(
-                    m_commandBuffers[currentImageIdx],
-                    m_pipelineLayout,
-                    VK_SHADER_STAGE_VERTEX_BIT, // Shader stage where to push constants
-                    0,                          // Offset of push constants to update
-                    sizeof(Model),              // Size of data being pushed
-                    &model);                    // Actual data being pushed (can be an array)
-
-                // Group of Descriptor sets for the textures                    
-                std::array<VkDescriptorSet, 2> descriptorSetGroup = { m_descriptorSets[currentImageIdx],
-                    m_samplerDescriptorSets[m_meshList[meshIdx].getTextureIdx()] };
-                
-                // Bind Descriptor Sets
-                vkCmdBindDescriptorSets(m_commandBuffers[currentImageIdx], VK_PIPELINE_BIND_POINT_GRAPHICS, m_pipelineLayout,
-                    0, static_cast<uint32_t>(descriptorSetGroup.size()), descriptorSetGroup.data(), 0, nullptr);
-
-                // Execute pipeline
-                vkCmdDrawIndexed(m_commandBuffers[currentImageIdx], m_meshList[meshIdx].getIndexCount(), 1, 0, 0, 0);
-            }
+        VkRect2D scissor = {};
+        scissor.offset = { 0,0 };                                       // Offset to use region from
+        scissor.extent = m_swapChainExtent;                             // Extent to describe region to use, starting at offset
+        m_pipelineManager.setViewport(commandBuffer, viewport, scissor);
 
-        // End Render Pass
-        vkCmdEndRenderPass(m_commandBuffers[currentImageIdx]);
+        // Passes (each in its render pass) with the barriers between them
+        m_renderGraph.execute(commandBuffer);
 
     // Stop recording to command buffer
-    result = vkEndCommandBuffer(m_commandBuffers[currentImageIdx]);
+    result = vkEndCommandBuffer(commandBuffer);
     if (result != VK_SUCCESS)
     {
         throw std::runtime_error("Failed to STOP recording a Command Buffer!");
@@ -1284,50 +1367,212 @@ void VulkanRenderer::recordCommands(uint32_t currentImageIdx)
 }
 
 //------------------------------------------------------------------------------
-void VulkanRenderer::getPhysicalDevice()
+void VulkanRenderer::recordDepthPrepass(VkCommandBuffer commandBuffer)
 {
-    // Enumerate Physical devices the vkInstance can access
-    uint32_t deviceCount = 0;
-    vkEnumeratePhysicalDevices(m_pInstance, &deviceCount, nullptr);
-
-    // If no devices available, then none support Vulkan
-    if (deviceCount == 0)
+    // Opaque meshes only, positions only, no fragment shading
+    if (!m_frameDraws.depthPrepass || m_frameDraws.opaqueDraws.empty() || !m_pipelineManager.bind(commandBuffer, m_depthPrepassPipelineDesc))
     {
-        throw std::runtime_error("Can't find GPUs that support Vulkan API!");
+        return;
     }
 
-    // Get list of Physical devices
-    std::vector<VkPhysicalDevice> deviceList(deviceCount);
-    vkEnumeratePhysicalDevices(m_pInstance, &deviceCount, deviceList.data());
-
-    // Check for a suitable device
-    for (const auto &device : deviceList)
+    // Bind only the View-Projection Descriptor Set (no texture is sampled), once for all the draws
+    vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_depthPrepassPipelineDesc.layout,
+        0, 1, &m_descriptorSets[m_frameDraws.imageIndex], 0, nullptr);
+    for (size_t meshIdx : m_frameDraws.opaqueDraws)
     {
-        if (checkDeviceSuitable(device))
+        if (!m_meshList[meshIdx].getMaterial().alphaTested)
         {
-            m_mainDevice.physicalDevice = device;
-            break;
+            recordMeshDepthDraw(commandBuffer, m_frameDraws.imageIndex, meshIdx);
         }
     }
-
-    // Get properties from our Physical device
-    VkPhysicalDeviceProperties deviceProperties;
-    vkGetPhysicalDeviceProperties(m_mainDevice.physicalDevice, &deviceProperties);
-
-    //m_minUniformBufferOffset = deviceProperties.limits.minUniformBufferOffsetAlignment;
-
-    cout << "Highest Supported Vulkan Version (by Physical Device): " << getVersionString(deviceProperties.apiVersion) << endl;
 }
 
 //------------------------------------------------------------------------------
-void VulkanRenderer::allocateDynamicBufferTransferSpace()
+void VulkanRenderer::recordMainPass(VkCommandBuffer commandBuffer)
 {
-    /*/ Calculate alignment of model data
-    m_modelUniformAlignment =   (sizeof(Model) + (m_minUniformBufferOffset - 1))
-                                & ~(m_minUniformBufferOffset - 1);
+    // View-Projection Descriptor Set bound once: all the main pass pipelines share a compatible layout, so it stays
+    // bound across their switches (the draws only bind the texture Set when it changes)
+    vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_pipelineLayout,
+        0, 1, &m_descriptorSets[m_frameDraws.imageIndex], 0, nullptr);
+
+    // Texture Descriptor Set bound last (meshes in the same atlas page don't re-bind it)
+    VkDescriptorSet boundTextureSet = VK_NULL_HANDLE;
+
+    // Draw the opaque meshes (depth EQUAL test and no depth writes after the pre-pass), then the transparent ones
+    // (blended over the opaque ones). Pipelines are re-bound only when the material variant changes.
+    const PipelineDesc * boundPipelineDesc = nullptr;
+    bool pipelineBound = false;
+    for (size_t meshIdx : m_frameDraws.opaqueDraws)
+    {
+        const PipelineDesc &pipelineDesc = m_frameDraws.opaquePipelineDescs[m_meshList[meshIdx].getMaterial().getVariant()];
+        if (&pipelineDesc != boundPipelineDesc)
+        {
+            pipelineBound = m_pipelineManager.bind(commandBuffer, pipelineDesc);
+            boundPipelineDesc = &pipelineDesc;
+        }
+        if (!pipelineBound)
+        {
+            continue;   // No compatible variant ready yet
+        }
+        recordMeshDraw(commandBuffer, m_frameDraws.imageIndex, meshIdx, &boundTextureSet);
+    }
 
-    // Create space in memory to hold dynamic buffer that is aligned to our required alignment and holds MAX_OBJECTS
-    m_pModelTransferSpace = (Model*)_aligned_malloc(m_modelUniformAlignment * MAX_OBJECTS, m_modelUniformAlignment);
+    for (size_t meshIdx : m_frameDraws.transparentDraws)
+    {
+        const PipelineDesc &pipelineDesc = m_frameDraws.transparentPipelineDescs[m_meshList[meshIdx].getMaterial().getVariant()];
+        if (&pipelineDesc != boundPipelineDesc)
+        {
+            pipelineBound = m_pipelineManager.bind(commandBuffer, pipelineDesc);
+            boundPipelineDesc = &pipelineDesc;
+        }
+        if (!pipelineBound)
+        {
+            continue;   // No compatible variant ready yet
+        }
+        recordMeshDraw(commandBuffer, m_frameDraws.imageIndex, meshIdx, &boundTextureSet);
+    }
+}
+
+//------------------------------------------------------------------------------
+void VulkanRenderer::recordMeshDraw(VkCommandBuffer commandBuffer, uint32_t imageIndex, size_t meshIdx, VkDescriptorSet * boundTextureSet)
+{
+    // Bind mesh Vertex buffers
+    VkBuffer vertexBuffers[] = { m_meshList[meshIdx].getVertexBuffer() };   // Buffers to bind
+    VkDeviceSize offsets[] = { 0 };                                         // Offsets into buffers being bound
+    vkCmdBindVertexBuffers(commandBuffer, 0, 1, vertexBuffers, offsets);    // Command to bind vertex buffer before drawing with them
+
+    // Bind mesh Index buffer (with 0 offset and using the uint32 type)
+    vkCmdBindIndexBuffer(commandBuffer, m_meshList[meshIdx].getIndexBuffer(), 0, VK_INDEX_TYPE_UINT32);
+
+    // Dynamic Uniform Buffer offset amount
+    //uint32_t dynamicOffset = static_cast<uint32_t>(m_modelUniformAlignment * meshIdx);
+
+    // Texture of its own (identity UV transform), or rectangle in an atlas page
+    int textureIdx = m_meshList[meshIdx].getTextureIdx();
+    VkDescriptorSet textureSet = m_samplerDescriptorSets[textureIdx];
+    glm::vec4 uvScaleOffset(1.0f, 1.0f, 0.0f, 0.0f);
+    if (const AtlasPlacement * placement = m_textureAtlas.find(textureIdx))
+    {
+        textureSet = m_atlasPages[placement->page].descriptorSet;
+        uvScaleOffset = placement->uvScaleOffset;
+    }
+
+    // Push constants to given shader stage directly (no buffer is used)
+    Model model = m_meshList[meshIdx].getModel();
+    vkCmdPushConstants(
+        commandBuffer,
+        m_pipelineLayout,
+        m_pushConstantRange.stageFlags, // Shader stages where to push constants (all the stages of the range)
+        0,                          // Offset of push constants to update
+        sizeof(Model),              // Size of data being pushed
+        &model);                    // Actual data being pushed (can be an array)
+    vkCmdPushConstants(commandBuffer, m_pipelineLayout, m_pushConstantRange.stageFlags, sizeof(Model), sizeof(glm::vec4), &uvScaleOffset);
+
+    // Bind the texture Descriptor Set (Set 1), only when it changes: the View-Projection one (Set 0) stays bound
+    if (textureSet != *boundTextureSet)
+    {
+        vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_pipelineLayout,
+            1, 1, &textureSet, 0, nullptr);
+        *boundTextureSet = textureSet;
+    }
+
+    // Execute pipeline
+    vkCmdDrawIndexed(commandBuffer, m_meshList[meshIdx].getIndexCount(), 1, 0, 0, 0);
+}
+
+//------------------------------------------------------------------------------
+void VulkanRenderer::recordMeshDepthDraw(VkCommandBuffer commandBuffer, uint32_t imageIndex, size_t meshIdx)
+{
+    // Bind mesh Position buffer (position-only vertex stream)
+    VkBuffer vertexBuffers[] = { m_meshList[meshIdx].getPositionBuffer() };
+    VkDeviceSize offsets[] = { 0 };
+    vkCmdBindVertexBuffers(commandBuffer, 0, 1, vertexBuffers, offsets);
+
+    // Bind mesh Index buffer (with 0 offset and using the uint32 type)
+    vkCmdBindIndexBuffer(commandBuffer, m_meshList[meshIdx].getIndexBuffer(), 0, VK_INDEX_TYPE_UINT32);
+
+    // Push constants to given shader stage directly (no buffer is used)
+    Model model = m_meshList[meshIdx].getModel();
+    vkCmdPushConstants(commandBuffer, m_depthPrepassPipelineDesc.layout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(Model), &model);
+
+    // Execute pipeline
+    vkCmdDrawIndexed(commandBuffer, m_meshList[meshIdx].getIndexCount(), 1, 0, 0, 0);
+}
+
+//------------------------------------------------------------------------------
+void VulkanRenderer::sortDrawOrder(std::vector<size_t> &opaqueDraws, std::vector<size_t> &transparentDraws)
+{
+    // View-space depth of each mesh origin (the camera looks down -Z, so the distance grows with -z)
+    std::vector<float> viewDepths(m_meshList.size());
+    for (size_t meshIdx = 0; meshIdx < m_meshList.size(); ++meshIdx)
+    {
+        glm::vec4 viewPosition = m_uboViewProjection.view * m_meshList[meshIdx].getModel().model[3];
+        viewDepths[meshIdx] = -viewPosition.z;
+
+        if (m_meshList[meshIdx].isTransparent())
+        {
+            transparentDraws.push_back(meshIdx);
+        }
+        else
+        {
+            opaqueDraws.push_back(meshIdx);
+        }
+    }
+
+    // Opaque: front-to-back, so occluded fragments are rejected by the early depth test before shading
+    std::stable_sort(opaqueDraws.begin(), opaqueDraws.end(),
+        [&viewDepths](size_t a, size_t b) { return viewDepths[a] < viewDepths[b]; });
+
+    // Transparent: back-to-front, so blending composites each layer over what is behind it
+    std::stable_sort(transparentDraws.begin(), transparentDraws.end(),
+        [&viewDepths](size_t a, size_t b) { return viewDepths[a] > viewDepths[b]; });
+}
+
+//------------------------------------------------------------------------------
+void VulkanRenderer::getPhysicalDevice()
+{
+    // Enumerate Physical devices the vkInstance can access
+    uint32_t deviceCount = 0;
+    vkEnumeratePhysicalDevices(m_pInstance, &deviceCount, nullptr);
+
+    // If no devices available, then none support Vulkan
+    if (deviceCount == 0)
+    {
+        throw std::runtime_error("Can't find GPUs that support Vulkan API!");
+    }
+
+    // Get list of Physical devices
+    std::vector<VkPhysicalDevice> deviceList(deviceCount);
+    vkEnumeratePhysicalDevices(m_pInstance, &deviceCount, deviceList.data());
+
+    // Check for a suitable device
+    for (const auto &device : deviceList)
+    {
+        if (checkDeviceSuitable(device))
+        {
+            m_mainDevice.physicalDevice = device;
+            break;
+        }
+    }
+
+    // Get properties from our Physical device
+    VkPhysicalDeviceProperties deviceProperties;
+    vkGetPhysicalDeviceProperties(m_mainDevice.physicalDevice, &deviceProperties);
+
+    //m_minUniformBufferOffset = deviceProperties.limits.minUniformBufferOffsetAlignment;
+
+    cout << "Highest Supported Vulkan Version (by Physical Device): " << getVersionString(deviceProperties.apiVersion) << endl;
+}
+
+//------------------------------------------------------------------------------
+void VulkanRenderer::allocateDynamicBufferTransferSpace()
+{
+    /*/ Calculate alignment of model data
+    m_modelUniformAlignment =   (sizeof(Model) + (m_minUniformBufferOffset - 1))
+                                & ~(m_minUniformBufferOffset - 1);
+
+    // Create space in memory to hold dynamic buffer that is aligned to our required alignment and holds MAX_OBJECTS
+    m_pModelTransferSpace = (Model*)_aligned_malloc(m_modelUniformAlignment * MAX_OBJECTS, m_modelUniformAlignment);
     /**/
 }
 
@@ -1421,6 +1666,23 @@ bool VulkanRenderer::checkDeviceExtensionSupport(VkPhysicalDevice device)
     return true;
 }
 //------------------------------------------------------------------------------
+bool VulkanRenderer::isDeviceExtensionSupported(VkPhysicalDevice device, const char * extensionName)
+{
+    uint32_t extensionsCount = 0;
+    vkEnumerateDeviceExtensionProperties(device, nullptr, &extensionsCount, nullptr);
+    std::vector<VkExtensionProperties> extensions(extensionsCount);
+    vkEnumerateDeviceExtensionProperties(device, nullptr, &extensionsCount, extensions.data());
+
+    for (const auto &extension : extensions)
+    {
+        if (strcmp(extensionName, extension.extensionName) == 0)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+//------------------------------------------------------------------------------
 bool VulkanRenderer::checkValidationLayerSupport()
 {
     uint32_t validationLayerCount;
@@ -1675,7 +1937,7 @@ VkFormat VulkanRenderer::chooseSupportedFormat(const std::vector<VkFormat>& form
 //------------------------------------------------------------------------------
 VkImage VulkanRenderer::createImage(uint32_t width, uint32_t height, VkFormat format, VkImageTiling tiling,
                                     VkImageUsageFlags useFlags, VkMemoryPropertyFlags propFlags,
-                                    VkDeviceMemory* imageMemory)
+                                    VkDeviceMemory* imageMemory, uint32_t mipLevels)
 {
     // CREATE IMAGE
     // Image Creation Info
@@ -1685,7 +1947,7 @@ VkImage VulkanRenderer::createImage(uint32_t width, uint32_t height, VkFormat fo
     imageCreateInfo.extent.width = width;                           // Width of image extent
     imageCreateInfo.extent.height = height;                         // Height of image extent
     imageCreateInfo.extent.depth = 1;                               // Depth of image (just 1, no 3D aspect)
-    imageCreateInfo.mipLevels = 1;                                  // Number of mipmap levels
+    imageCreateInfo.mipLevels = mipLevels;                          // Number of mipmap levels
     imageCreateInfo.arrayLayers = 1;                                // Number of levels in image array
     imageCreateInfo.format = format;                                // Format type of image
     imageCreateInfo.tiling = tiling;                                // How image data should be "tiled" (arranged for optimal reading)
@@ -1726,7 +1988,7 @@ VkImage VulkanRenderer::createImage(uint32_t width, uint32_t height, VkFormat fo
     return image;
 }
 //------------------------------------------------------------------------------
-VkImageView VulkanRenderer::createImageView(VkImage image, VkFormat format, VkImageAspectFlags aspectFlags)
+VkImageView VulkanRenderer::createImageView(VkImage image, VkFormat format, VkImageAspectFlags aspectFlags, uint32_t mipLevels)
 {
     VkImageViewCreateInfo viewCreateInfo = {};
     viewCreateInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
@@ -1741,7 +2003,7 @@ VkImageView VulkanRenderer::createImageView(VkImage image, VkFormat format, VkIm
     // Subresources allows the view to view only part of an image
     viewCreateInfo.subresourceRange.aspectMask = aspectFlags;       // Which aspect of image to view (e.g. COLOR_BIT, etc.)
     viewCreateInfo.subresourceRange.baseMipLevel = 0;               // Start mipmap level to view from
-    viewCreateInfo.subresourceRange.levelCount = 1;                 // Number of mipmap levels to view
+    viewCreateInfo.subresourceRange.levelCount = mipLevels;         // Number of mipmap levels to view
     viewCreateInfo.subresourceRange.baseArrayLayer = 0;             // Start layer to view from
     viewCreateInfo.subresourceRange.layerCount = 1;                 // Number of array levels to view
 
@@ -1755,114 +2017,1021 @@ VkImageView VulkanRenderer::createImageView(VkImage image, VkFormat format, VkIm
     return imageView;
 }
 //------------------------------------------------------------------------------
-VkShaderModule VulkanRenderer::createShaderModule(const std::vector<char>& code)
+int VulkanRenderer::createTexture(std::string fileName)
 {
-    // Shader Module creation information
-    VkShaderModuleCreateInfo shaderModuleCreateInfo = {};
-    shaderModuleCreateInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
-    shaderModuleCreateInfo.codeSize = code.size();                                  // Size of code
-    shaderModuleCreateInfo.pCode = reinterpret_cast<const uint32_t *>(code.data()); // Pointer to code (of uint32_t pointer type)
+    // Already resident (or loading)? Share it (same canonical path, or same content if hashing is enabled)
+    std::string filePath = "Textures/" + fileName;
+    std::string cacheKey = TextureCache::canonicalPath(filePath);
+    int descriptorLoc = m_textureCache.acquire(cacheKey);
+    if (descriptorLoc >= 0)
+    {
+        return descriptorLoc;
+    }
 
-    VkShaderModule shaderModule;
-    VkResult result = vkCreateShaderModule(m_mainDevice.logicalDevice, &shaderModuleCreateInfo, nullptr, &shaderModule);
-    if (result != VK_SUCCESS)
+    // Cooked version first (decoded as it is: no mip generation or compression at load time), then the source
+    std::string loadName = resolveTextureFile(fileName);
+    std::string loadPath = "Textures/" + loadName;
+    if (m_assetArchive.isOpen() && !m_assetArchive.contains(loadPath))
     {
-        throw std::runtime_error("Failed to create a shader module!");
+        cout << "'" << loadPath << "' isn't in the asset archive: loading the loose file" << endl;
     }
 
-    return shaderModule;
+    uint64_t contentHash = 0;
+    if (m_textureCache.isContentHashingEnabled())
+    {
+        contentHash = m_assetArchive.contains(loadPath) ? m_assetArchive.getContentHash(loadPath) : TextureCache::hashFileContent(loadPath);
+        descriptorLoc = m_textureCache.acquireByContent(cacheKey, contentHash);
+        if (descriptorLoc >= 0)
+        {
+            return descriptorLoc;
+        }
+    }
+
+    // Bound to the placeholder until the real image is resident (see processAssetUploads)
+    descriptorLoc = createTextureDescriptor(m_textureImageViews[m_placeholderTextureLoc]);
+    m_textureCache.insert(cacheKey, contentHash, -1, descriptorLoc);
+
+    // Asynchronous read (loose files only, packed ones are mapped), then decode on the asset loader workers
+    uint64_t ticket = m_assetLoader.requestTexture(descriptorLoc, loadName, m_assetArchive.contains(loadPath) ? "" : loadPath);
+    m_textureCache.setLoadTicket(descriptorLoc, ticket);
+
+    // Return the location of the descriptor set with texture
+    return descriptorLoc;
 }
+//------------------------------------------------------------------------------
+std::string VulkanRenderer::resolveTextureFile(const std::string &fileName)
+{
+    // <name>.ktx2 cooked from the source (packed, or next to it), otherwise the source itself
+    std::filesystem::path cookedName = std::filesystem::path(fileName).replace_extension(".ktx2");
+    std::string extension = std::filesystem::path(fileName).extension().string();
+    std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    if (std::find(std::begin(COOKED_TEXTURE_SOURCES), std::end(COOKED_TEXTURE_SOURCES), extension) == std::end(COOKED_TEXTURE_SOURCES))
+    {
+        return fileName;
+    }
 
+    std::string cookedPath = "Textures/" + cookedName.generic_string();
+    std::error_code errorCode;
+    if (m_assetArchive.contains(cookedPath) || std::filesystem::exists(cookedPath, errorCode))
+    {
+        return cookedName.generic_string();
+    }
+    return fileName;
+}
 //------------------------------------------------------------------------------
-int VulkanRenderer::createTexture(std::string fileName)
+void VulkanRenderer::createPlaceholderTexture()
+{
+    // 1x1 opaque white texel: meshes are drawn plain white while their texture is loading
+    TextureData placeholder;
+    placeholder.format = VK_FORMAT_R8G8B8A8_UNORM;
+    placeholder.width = 1;
+    placeholder.height = 1;
+    placeholder.data = { 255, 255, 255, 255 };
+
+    VkBufferImageCopy region = {};
+    region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    region.imageSubresource.layerCount = 1;
+    region.imageExtent = { 1, 1, 1 };
+    placeholder.regions.push_back(region);
+
+    m_placeholderTextureLoc = uploadTexture(placeholder);
+    m_textureImageViews[m_placeholderTextureLoc] = createImageView(m_textureImages[m_placeholderTextureLoc], placeholder.format,
+                                                                   VK_IMAGE_ASPECT_COLOR_BIT);
+}
+//------------------------------------------------------------------------------
+void VulkanRenderer::processAssetUploads()
 {
-    // Create Texture Image and get its location in array
-    int textureImageLoc = createTextureImage(fileName);
+    for (auto &completion : m_assetLoader.takeCompleted())
+    {
+        m_completedAssets.push_back(std::move(completion));
+    }
 
-    // Create Image View and add to list
-    VkImageView imageView = createImageView(m_textureImages[textureImageLoc], VK_FORMAT_R8G8B8A8_UNORM, VK_IMAGE_ASPECT_COLOR_BIT);
-    m_textureImageViews.push_back(imageView);
+    // The uploads are recorded in the frame command buffer (nothing waits for the GPU here)
+    VkDeviceSize uploadedBytes = 0;
+    while (!m_completedAssets.empty() && uploadedBytes < MAX_UPLOADED_BYTES_PER_FRAME)
+    {
+        std::unique_ptr<AssetCompletion> completion = std::move(m_completedAssets.front());
+        m_completedAssets.pop_front();
 
-    // Create Texture Descriptor
-    int descriptorLoc = createTextureDescriptor(imageView);
+        // Released (or replaced by another texture) while it was loading
+        if (!m_textureCache.isLoadPending(completion->textureId, completion->ticket))
+        {
+            releaseTextureData(completion->texture);
+            continue;
+        }
+        int oldTextureImageLoc = m_textureCache.getImageIndex(completion->textureId);   // >= 0: reloaded
+        if (!completion->error.empty())
+        {
+            cout << "ERROR: " << completion->error << endl;     // Keep the placeholder (or the previous image)
+            m_textureCache.completeLoad(completion->textureId, completion->ticket, oldTextureImageLoc);
+            continue;
+        }
 
-    // Return the location of the descriptor set with texture
-    return descriptorLoc;
+        const TextureData &texture = completion->texture;
+        uploadedBytes += texture.stagingData ? static_cast<VkDeviceSize>(texture.width) * texture.height * 4 : texture.data.size();
+
+        // Reloaded: the previous version leaves the atlas and the streamer (its image is retired by the swap below)
+        m_textureAtlas.remove(completion->textureId);
+        m_textureStreamer.remove(completion->textureId);
+
+        // Small textures: copied in a rectangle of an atlas page (the texture slot keeps the placeholder set, unused).
+        // A reloaded texture that has an image of its own keeps one: the slot set would still reference the old image.
+        if (m_textureAtlasEnabled && oldTextureImageLoc < 0 && packTextureInAtlas(completion->textureId, completion->texture))
+        {
+            releaseTextureData(completion->texture);
+            m_textureCache.completeLoad(completion->textureId, completion->ticket, -1);
+            continue;
+        }
+
+        // Streamed if all the levels were decoded (not the case of atlas candidates that didn't fit: too small to stream)
+        int textureImageLoc;
+        if (m_textureStreaming && completion->texture.regions.size() == completion->texture.mipLevels)
+        {
+            // Low mips first: the finer ones are streamed in by updateTextureStreaming(), when needed
+            uint32_t residentBase = m_textureStreamer.getInitialBase(completion->texture);
+            textureImageLoc = uploadTextureLevels(completion->texture, residentBase);
+            m_textureStreamer.add(completion->textureId, std::move(completion->texture), textureImageLoc, residentBase);
+        }
+        else
+        {
+            textureImageLoc = uploadTexture(completion->texture);
+
+            // The frame copies from the staging arena: its texels are freed once it's done
+            TextureData uploaded;
+            uploaded.stagingData = completion->texture.stagingData;
+            deferRelease([this, uploaded]() {
+                releaseTextureData(uploaded);
+            });
+        }
+
+        // The placeholder image is shared: it's never released with the slot (-1)
+        swapTextureImage(completion->textureId, textureImageLoc, oldTextureImageLoc);
+        m_textureCache.completeLoad(completion->textureId, completion->ticket, textureImageLoc);
+    }
 }
+//------------------------------------------------------------------------------
+void VulkanRenderer::recordTextureUploads(VkCommandBuffer commandBuffer)
+{
+    VkImageMemoryBarrier barrier = {};
+    barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    barrier.subresourceRange.baseMipLevel = 0;
+    barrier.subresourceRange.baseArrayLayer = 0;
+    barrier.subresourceRange.layerCount = 1;
+
+    // One upload after the other: an atlas page can be created and get its first rectangles in the same frame
+    for (const TextureUpload &upload : m_textureUploads)
+    {
+        // Transfer destination (all the levels), once the frames already submitted are done sampling it
+        barrier.image = upload.image;
+        barrier.subresourceRange.levelCount = upload.mipLevels;
+        barrier.oldLayout = upload.initialized ? VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL : VK_IMAGE_LAYOUT_UNDEFINED;
+        barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+        barrier.srcAccessMask = upload.initialized ? VK_ACCESS_SHADER_READ_BIT : VK_ACCESS_NONE;
+        barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0,
+                             0, nullptr, 0, nullptr, 1, &barrier);
+
+        if (!upload.regions.empty())
+        {
+            vkCmdCopyBufferToImage(commandBuffer, upload.buffer, upload.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                                   static_cast<uint32_t>(upload.regions.size()), upload.regions.data());
+        }
 
+        if (upload.gpuMipmaps)
+        {
+            // Generate the other levels, and transition all of them to be shader readable
+            generateMipmaps(commandBuffer, upload.image, upload.width, upload.height, upload.mipLevels);
+        }
+        else
+        {
+            barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+            barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+            barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+            barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+            vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0,
+                                 0, nullptr, 0, nullptr, 1, &barrier);
+        }
+    }
+
+    m_textureUploads.clear();
+}
 //------------------------------------------------------------------------------
-int VulkanRenderer::createTextureImage(std::string fileName)
+void VulkanRenderer::processHotReload()
 {
+    if (!m_hotReload)
+    {
+        return;
+    }
+
+    for (const std::string &filePath : m_fileWatcher.takeChanged())
+    {
+        if (std::filesystem::path(filePath).extension() == ".spv")
+        {
+            cout << "Reloading the pipelines of '" << filePath << "'" << endl;
+            m_pipelineManager.reloadShader(filePath);
+        }
+        else if (filePath.rfind("Textures/", 0) == 0)
+        {
+            reloadTexture(filePath);
+        }
+        else if (m_runtimeShaderCompilation)
+        {
+            // GLSL source read by the pipelines: compiled again by their reload (new content, new cache key)
+            m_pipelineManager.reloadShader(filePath);
+        }
+        else
+        {
+            // GLSL source: its module is rewritten (and reloaded, as a modified .spv) once it compiles
+            for (const ShaderSource &shader : SHADER_SOURCES)
+            {
+                if (filePath == shader.source)
+                {
+                    m_shaderCompiler.compileToFile(shader.source, shader.spirv);
+                }
+            }
+        }
+    }
+
+    // Recompiled pipelines are used from this frame on, the frames in flight may still use the replaced ones
+    for (PipelineObjects &objects : m_pipelineManager.applyReloads())
+    {
+        deferRelease([this, objects]() {
+            m_pipelineManager.destroyObjects(objects);
+        });
+    }
+}
+//------------------------------------------------------------------------------
+void VulkanRenderer::reloadTexture(const std::string &filePath)
+{
+    // A cooked texture is used under the name of its source
+    int descriptorLoc = m_textureCache.find(TextureCache::canonicalPath(filePath));
+    if (descriptorLoc < 0 && std::filesystem::path(filePath).extension() == ".ktx2")
+    {
+        for (const char * extension : COOKED_TEXTURE_SOURCES)
+        {
+            if (descriptorLoc < 0)
+            {
+                descriptorLoc = m_textureCache.find(TextureCache::canonicalPath(std::filesystem::path(filePath).replace_extension(extension).string()));
+            }
+        }
+    }
+    if (descriptorLoc < 0)
+    {
+        return;     // Not used
+    }
+
+    // Read from the modified file (even if it's packed), decoded on the asset loader workers; the current image keeps
+    // being drawn until processAssetUploads() swaps the new one in. A newer request supersedes a reload in progress.
+    cout << "Reloading '" << filePath << "'" << endl;
+    std::string fileName = filePath.substr(std::string("Textures/").size());
+    uint64_t ticket = m_assetLoader.requestTexture(descriptorLoc, fileName, filePath);
+    m_textureCache.setLoadTicket(descriptorLoc, ticket);
+}
+//------------------------------------------------------------------------------
+void VulkanRenderer::updateTextureStreaming()
+{
+    if (!m_textureStreaming)
+    {
+        return;
+    }
+
+    // Screen-space size of the meshes (bounding sphere diameter, in pixels) drives the finest level of their textures
+    const glm::mat4 &view = m_uboViewProjection.view;
+    float pixelsPerUnit = std::fabs(m_uboViewProjection.projection[1][1]) * 0.5f * m_swapChainExtent.height;   // At distance 1
+    for (auto &mesh : m_meshList)
+    {
+        glm::mat4 model = mesh.getModel().model;
+        glm::vec4 center = view * model * glm::vec4(mesh.getBoundsCenter(), 1.0f);
+        float scale = std::max({ glm::length(glm::vec3(model[0])), glm::length(glm::vec3(model[1])), glm::length(glm::vec3(model[2])) });
+        float radius = mesh.getBoundsRadius() * scale;
+        if (center.z - radius > 0.0f)
+        {
+            continue;   // Behind the camera (looking down -Z): not used
+        }
+
+        if (!mesh.getMaterial().textured)
+        {
+            continue;   // Vertex coloured: its texture is not sampled
+        }
+
+        float distance = std::max(-center.z, 0.1f);
+        m_textureStreamer.requestScreenSize(mesh.getTextureIdx(), 2.0f * radius * pixelsPerUnit / distance, m_frameNumber);
+    }
+
+    // New images with the new resident levels (evictions and streamed in levels), filled by the GPU during this frame
+    for (const ResidencyChange &change : m_textureStreamer.update(m_frameNumber))
+    {
+        StreamedTexture * texture = m_textureStreamer.find(change.textureId);
+        int textureImageLoc = changeTextureResidency(change.textureId, *texture, change.newBase);
+        swapTextureImage(change.textureId, textureImageLoc, texture->imageIndex);
+
+        m_textureStreamer.setResident(change.textureId, textureImageLoc, change.newBase);
+        m_textureCache.setImageIndex(change.textureId, textureImageLoc);
+    }
+}
+//------------------------------------------------------------------------------
+int VulkanRenderer::changeTextureResidency(int textureId, StreamedTexture &texture, uint32_t newBase)
+{
+    // Only the levels changing residency move between the host and the device, the others are copied from the current
+    // image. Nothing waits: the copies are recorded in the next frame, the host side is completed once it's done.
+    uint32_t mipLevels = static_cast<uint32_t>(texture.regions.size());
+    uint32_t oldBase = texture.residentBase;
+
+    ResidencyCopy copy;
+    copy.oldImage = m_textureImages[texture.imageIndex];
+    copy.oldMipLevels = mipLevels - oldBase;
+    copy.newMipLevels = mipLevels - newBase;
+    copy.readback = newBase > oldBase;
+
+    VkDeviceMemory imageMemory;
+    copy.newImage = createImage(std::max(texture.width >> newBase, 1U), std::max(texture.height >> newBase, 1U), texture.format,
+        VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, &imageMemory, copy.newMipLevels);
+    int textureImageLoc = addTextureImage(copy.newImage, imageMemory, texture.format, copy.newMipLevels);
+
+    // Levels resident before and after: GPU to GPU
+    for (uint32_t level = std::max(oldBase, newBase); level < mipLevels; ++level)
+    {
+        VkImageCopy region = {};
+        region.srcSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, level - oldBase, 0, 1 };
+        region.dstSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, level - newBase, 0, 1 };
+        region.extent = texture.regions[level].imageExtent;
+        copy.imageCopies.push_back(region);
+    }
+
+    // Levels [newBase, oldBase) are uploaded (and leave the host memory), levels [oldBase, newBase) are read back
+    uint32_t firstLevel = std::min(oldBase, newBase);
+    uint32_t lastLevel = std::max(oldBase, newBase);
+    VkDeviceSize firstOffset = texture.regions[firstLevel].bufferOffset;
+    VkDeviceSize bufferSize = texture.regions[lastLevel].bufferOffset - firstOffset;
+    VkDeviceMemory bufferMemory;
+    createBuffer(m_mainDevice.physicalDevice, m_mainDevice.logicalDevice, bufferSize,
+        copy.readback ? VK_BUFFER_USAGE_TRANSFER_DST_BIT : VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+        &copy.buffer, &bufferMemory);
+
+    void *data = nullptr;
+    if (!copy.readback)
+    {
+        vkMapMemory(m_mainDevice.logicalDevice, bufferMemory, 0, bufferSize, 0, &data);
+    }
+    for (uint32_t level = firstLevel; level < lastLevel; ++level)
+    {
+        VkBufferImageCopy region = texture.regions[level];
+        region.bufferOffset -= firstOffset;
+        region.imageSubresource.mipLevel = level - (copy.readback ? oldBase : newBase);
+        copy.bufferCopies.push_back(region);
+
+        if (!copy.readback)
+        {
+            memcpy(static_cast<uint8_t *>(data) + region.bufferOffset, texture.hostLevels[level].data(), texture.hostLevels[level].size());
+            texture.hostLevels[level] = {};
+        }
+    }
+    if (!copy.readback)
+    {
+        vkUnmapMemory(m_mainDevice.logicalDevice, bufferMemory);
+    }
+
+    // Once the frame is done: the evicted levels are back in host memory, the texture can change again
+    uint64_t transitId = m_textureStreamer.beginTransit(textureId);
+    bool readback = copy.readback;
+    VkBuffer buffer = copy.buffer;
+    deferRelease([this, textureId, transitId, readback, buffer, bufferMemory, bufferSize, firstLevel, lastLevel]() {
+        StreamedTexture * texture = m_textureStreamer.findTransit(textureId, transitId);
+        if (texture && readback)
+        {
+            void *data;
+            vkMapMemory(m_mainDevice.logicalDevice, bufferMemory, 0, bufferSize, 0, &data);
+            for (uint32_t level = firstLevel; level < lastLevel; ++level)
+            {
+                const uint8_t * levelData = static_cast<const uint8_t *>(data) +
+                    (texture->regions[level].bufferOffset - texture->regions[firstLevel].bufferOffset);
+                texture->hostLevels[level].assign(levelData, levelData + TextureStreamer::getLevelSize(*texture, level));
+            }
+            vkUnmapMemory(m_mainDevice.logicalDevice, bufferMemory);
+        }
+        if (texture)
+        {
+            texture->transitId = 0;
+        }
+        vkDestroyBuffer(m_mainDevice.logicalDevice, buffer, nullptr);
+        vkFreeMemory(m_mainDevice.logicalDevice, bufferMemory, nullptr);
+    });
+
+    m_residencyCopies.push_back(std::move(copy));
+    return textureImageLoc;
+}
+//------------------------------------------------------------------------------
+void VulkanRenderer::recordResidencyCopies(VkCommandBuffer commandBuffer)
+{
+    if (m_residencyCopies.empty())
+    {
+        return;
+    }
+
+    VkImageMemoryBarrier barrier = {};
+    barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    barrier.subresourceRange.baseMipLevel = 0;
+    barrier.subresourceRange.baseArrayLayer = 0;
+    barrier.subresourceRange.layerCount = 1;
+
+    // Current images become copy sources once the frames already submitted are done sampling them
+    std::vector<VkImageMemoryBarrier> barriers;
+    for (const ResidencyCopy &copy : m_residencyCopies)
+    {
+        barrier.image = copy.oldImage;
+        barrier.subresourceRange.levelCount = copy.oldMipLevels;
+        barrier.oldLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+        barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+        barrier.srcAccessMask = VK_ACCESS_SHADER_READ_BIT;
+        barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+        barriers.push_back(barrier);
+
+        barrier.image = copy.newImage;
+        barrier.subresourceRange.levelCount = copy.newMipLevels;
+        barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+        barrier.srcAccessMask = VK_ACCESS_NONE;
+        barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barriers.push_back(barrier);
+    }
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0,
+                         0, nullptr, 0, nullptr, static_cast<uint32_t>(barriers.size()), barriers.data());
+
+    for (const ResidencyCopy &copy : m_residencyCopies)
+    {
+        if (!copy.imageCopies.empty())
+        {
+            vkCmdCopyImage(commandBuffer, copy.oldImage, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                           copy.newImage, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                           static_cast<uint32_t>(copy.imageCopies.size()), copy.imageCopies.data());
+        }
+        if (copy.readback)
+        {
+            vkCmdCopyImageToBuffer(commandBuffer, copy.oldImage, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, copy.buffer,
+                                   static_cast<uint32_t>(copy.bufferCopies.size()), copy.bufferCopies.data());
+        }
+        else
+        {
+            vkCmdCopyBufferToImage(commandBuffer, copy.buffer, copy.newImage, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                                   static_cast<uint32_t>(copy.bufferCopies.size()), copy.bufferCopies.data());
+        }
+    }
+
+    // New images shader readable for this frame's passes (the current ones are retired as they are), readbacks visible
+    // to the host once the frame fence is signalled
+    barriers.clear();
+    for (const ResidencyCopy &copy : m_residencyCopies)
+    {
+        barrier.image = copy.newImage;
+        barrier.subresourceRange.levelCount = copy.newMipLevels;
+        barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+        barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+        barriers.push_back(barrier);
+    }
+    VkMemoryBarrier readbackBarrier = {};
+    readbackBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    readbackBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    readbackBarrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                         VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_HOST_BIT, 0,
+                         1, &readbackBarrier, 0, nullptr, static_cast<uint32_t>(barriers.size()), barriers.data());
+
+    m_residencyCopies.clear();
+}
+//------------------------------------------------------------------------------
+void VulkanRenderer::swapTextureImage(int textureId, int textureImageLoc, int oldTextureImageLoc)
+{
+    m_textureImageViews[textureImageLoc] = createImageView(m_textureImages[textureImageLoc], m_textureFormats[textureImageLoc],
+                                                           VK_IMAGE_ASPECT_COLOR_BIT, m_textureMipLevels[textureImageLoc]);
+
+    // Descriptor slot swap: frames in flight keep reading the old set (and image), retired once they are done
+    VkDescriptorSet oldSet = m_samplerDescriptorSets[textureId];
+    m_samplerDescriptorSets[textureId] = allocateTextureDescriptorSet(m_textureImageViews[textureImageLoc]);
+    deferRelease([this, oldSet, oldTextureImageLoc]() {
+        m_freeSamplerDescriptorSets.push_back(oldSet);
+        if (oldTextureImageLoc >= 0)
+        {
+            destroyTextureImage(oldTextureImageLoc);
+        }
+    });
+}
+//------------------------------------------------------------------------------
+void VulkanRenderer::destroyTextureImage(int textureImageLoc)
+{
+    vkDestroyImageView(m_mainDevice.logicalDevice, m_textureImageViews[textureImageLoc], nullptr);
+    vkDestroyImage(m_mainDevice.logicalDevice, m_textureImages[textureImageLoc], nullptr);
+    vkFreeMemory(m_mainDevice.logicalDevice, m_textureImageMemory[textureImageLoc], nullptr);
+    m_textureImageViews[textureImageLoc] = 0;
+    m_textureImages[textureImageLoc] = 0;
+    m_textureImageMemory[textureImageLoc] = 0;
+
+    m_freeTextureImages.push_back(textureImageLoc);
+}
+//------------------------------------------------------------------------------
+void VulkanRenderer::deferRelease(std::function<void()> release)
+{
+    // Frames submitted so far may still use the resource
+    m_deferredReleases.push_back({ m_frameNumber, release });
+}
+//------------------------------------------------------------------------------
+void VulkanRenderer::runDeferredReleases(bool all)
+{
+    // After waiting the fence of the current frame, all the frames up to (m_frameNumber - MAX_FRAME_DRAWS) are complete
+    while (!m_deferredReleases.empty() && (all || m_deferredReleases.front().frameNumber + MAX_FRAME_DRAWS <= m_frameNumber))
+    {
+        m_deferredReleases.front().release();
+        m_deferredReleases.pop_front();
+    }
+}
+//------------------------------------------------------------------------------
+void VulkanRenderer::decodeTexture(const std::string &fileName, std::span<const uint8_t> fileData, TextureData * texture)
+{
+    // N.B.: runs on the asset loader workers (physical device queries, KTX2 loader and block compressor are thread safe)
+
+    // Block compressed textures (already with their mip levels)
+    if (fileName.size() > 5 && fileName.compare(fileName.size() - 5, 5, ".ktx2") == 0)
+    {
+        std::string filePath = "Textures/" + fileName;
+        std::vector<uint8_t> fileStorage;
+        if (fileData.empty())
+        {
+            AssetArchive::readAsset(&m_assetArchive, filePath, &fileStorage, &fileData);
+        }
+        Ktx2Texture ktx2;
+        m_ktx2Loader.load(fileData, filePath, &ktx2);
+
+        texture->format = ktx2.format;
+        texture->width = ktx2.width;
+        texture->height = ktx2.height;
+        texture->mipLevels = static_cast<uint32_t>(ktx2.levels.size());
+        texture->regions.resize(ktx2.levels.size());
+        for (uint32_t level = 0; level < texture->mipLevels; ++level)
+        {
+            VkBufferImageCopy &region = texture->regions[level];
+            region = {};
+            region.bufferOffset = ktx2.levels[level].offset;
+            region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+            region.imageSubresource.mipLevel = level;
+            region.imageSubresource.baseArrayLayer = 0;
+            region.imageSubresource.layerCount = 1;
+            region.imageOffset = { 0, 0, 0 };
+            region.imageExtent = { ktx2.levels[level].width, ktx2.levels[level].height, 1 };
+        }
+        texture->data = std::move(ktx2.data);
+        return;
+    }
+
+    // Level 0 is uploaded as it is (mip chain blitted on the GPU) only for uncompressed textures: decode those in the
+    // staging arena. The others are re-encoded on the CPU anyway, so their decode stays on the heap.
+    int width, height, channels;
+    size_t stagingImageSize = 0;
+    std::string fileLoc = "Textures/" + fileName;
+    std::vector<uint8_t> packedStorage;
+    bool packed = fileData.empty() && m_assetArchive.read(fileLoc, &packedStorage, &fileData);  // Decoded from the mapping
+    VkFormat compressedFormat = BlockCompressor::getFormat(m_textureCompression);
+    bool compress = m_textureCompression != TextureCompression::None && m_ktx2Loader.isFormatSupported(compressedFormat);
+    bool gpuMipmaps = !m_textureStreaming && isLinearBlitSupported(VK_FORMAT_R8G8B8A8_UNORM);  // Streaming (opt-in) needs every level
+    bool infoRead = (m_textureAtlasEnabled || (!compress && gpuMipmaps)) &&
+        (!fileData.empty() ? stbi_info_from_memory(fileData.data(), static_cast<int>(fileData.size()), &width, &height, &channels)
+                : stbi_info(fileLoc.c_str(), &width, &height, &channels));
+
+    // Atlas candidates: uncompressed level 0 only (the atlas builds its own padded levels, the GPU the others if it's full)
+    if (infoRead && m_textureAtlasEnabled &&
+        TextureAtlas::isPackable(VK_FORMAT_R8G8B8A8_UNORM, static_cast<uint32_t>(width), static_cast<uint32_t>(height)))
+    {
+        compress = false;
+        gpuMipmaps = isLinearBlitSupported(VK_FORMAT_R8G8B8A8_UNORM);
+    }
+    if (infoRead && !compress && gpuMipmaps)
+    {
+        stagingImageSize = static_cast<size_t>(width) * height * STBI_rgb_alpha;
+    }
+
+    // Processed before with the same options: copied from the mapped cache entry into the staging arena, no decode
+    // (streamed textures keep their levels on the heap). Entries are keyed on loose files: packed textures aren't cached.
+    uint64_t processingKey = 0;
+    if (m_textureDiskCacheEnabled && !packed)
+    {
+        processingKey = hashCombine(FNV_OFFSET_BASIS, compress ? compressedFormat : VK_FORMAT_R8G8B8A8_UNORM);
+        processingKey = hashCombine(processingKey, compress ? m_compressionQuality : CompressionQuality::Fast);
+        processingKey = hashCombine(processingKey, gpuMipmaps);     // Level 0 only, or every level
+        if (m_textureDiskCache.load(fileLoc, processingKey, texture, (gpuMipmaps || !m_textureStreaming) ? &m_stagingArena : nullptr))
+        {
+            return;
+        }
+    }
+
     // Load image file
-    int width, height;
     VkDeviceSize imageSize;
-    stbi_uc * imageData = loadTextureFile(fileName, &width, &height, &imageSize);
+    stbi_uc * imageData = nullptr;
+    {
+        StagingDecodeScope decodeScope(stagingImageSize);
+        imageData = loadTextureFile(fileName, &width, &height, &imageSize, fileData);
+    }
 
-    // Create staging buffer to hold loaded data, ready to copy to device
-    VkBuffer        imageStagingBuffer;
-    VkDeviceMemory  imageStagingBufferMemory;
-    createBuffer(m_mainDevice.physicalDevice, m_mainDevice.logicalDevice, imageSize,
-        VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-        &imageStagingBuffer, &imageStagingBufferMemory);
+    // Full mip chain: minified textures sample smaller levels (less bandwidth, better texture cache hit rate)
+    texture->width = static_cast<uint32_t>(width);
+    texture->height = static_cast<uint32_t>(height);
+    texture->mipLevels = getMipLevelCount(texture->width, texture->height);
+    texture->format = VK_FORMAT_R8G8B8A8_UNORM;
 
-    // Copy image data to staging buffer
-    void *data;
-    vkMapMemory(m_mainDevice.logicalDevice, imageStagingBufferMemory, 0, imageSize, 0, &data);
-    memcpy(data, imageData, static_cast<size_t>(imageSize));
-    vkUnmapMemory(m_mainDevice.logicalDevice, imageStagingBufferMemory);
+    // Block compression at load time (4x/8x less memory and bandwidth than RGBA8), if the device can sample the format
+    if (compress)
+    {
+        // Mip chain built on the CPU (the GPU can't blit block compressed formats), then every level is compressed
+        std::vector<uint8_t> mipChain = buildMipChainRgba8(imageData, texture->width, texture->height, texture->mipLevels,
+                                                           &texture->regions);
+        for (VkBufferImageCopy &region : texture->regions)
+        {
+            std::vector<uint8_t> blocks = m_blockCompressor.compress(mipChain.data() + region.bufferOffset,
+                region.imageExtent.width, region.imageExtent.height, m_textureCompression, m_compressionQuality);
+
+            // Levels tightly packed (block sizes are 8 or 16 bytes, so offsets stay block aligned)
+            region.bufferOffset = texture->data.size();
+            texture->data.insert(texture->data.end(), blocks.begin(), blocks.end());
+        }
+        texture->format = compressedFormat;
+    }
+    // Mip levels are generated on the GPU (blit) if the format supports linear filtering, otherwise on the CPU
+    else if (gpuMipmaps)
+    {
+        // Decoded straight into the staging arena: uploaded from there, without any copy
+        if (m_stagingArena.contains(imageData))
+        {
+            texture->stagingData = imageData;
+            imageData = nullptr;
+        }
+        else
+        {
+            texture->data.assign(imageData, imageData + imageSize);
+        }
+
+        VkBufferImageCopy region = {};
+        region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        region.imageSubresource.mipLevel = 0;
+        region.imageSubresource.baseArrayLayer = 0;
+        region.imageSubresource.layerCount = 1;
+        region.imageExtent = { texture->width, texture->height, 1 };
+        texture->regions.push_back(region);
+    }
+    else
+    {
+        texture->data = buildMipChainRgba8(imageData, texture->width, texture->height, texture->mipLevels, &texture->regions);
+    }
 
-    // Free original image data
-    stbi_image_free(imageData);
+    // Free original image data (unless it's now owned by the texture)
+    if (imageData)
+    {
+        stbi_image_free(imageData);
+    }
 
-    // Create the VkImage on the device to hold the final texture
-    VkImage texImage;
+    // Stored for the next runs (level 0 in the staging arena is the only level)
+    if (m_textureDiskCacheEnabled && !packed)
+    {
+        const uint8_t * data = texture->stagingData ? texture->stagingData : texture->data.data();
+        size_t dataSize = texture->stagingData ? static_cast<size_t>(imageSize) : texture->data.size();
+        m_textureDiskCache.store(fileLoc, processingKey, *texture, data, dataSize);
+    }
+}
+//------------------------------------------------------------------------------
+int VulkanRenderer::uploadTexture(const TextureData &texture, bool copySource)
+{
+    // Levels without a copy region are generated from level 0 (blits)
+    bool gpuMipmaps = texture.regions.size() < texture.mipLevels;
+    VkDeviceSize imageSize = texture.data.size();
+
+    TextureUpload upload;
+    upload.regions = texture.regions;
+    if (texture.stagingData)
+    {
+        // Already in the staging arena: copy from there (the caller frees it once the frame is done)
+        upload.buffer = m_stagingArena.getBuffer();
+        for (VkBufferImageCopy &region : upload.regions)
+        {
+            region.bufferOffset += m_stagingArena.getOffset(texture.stagingData);
+        }
+    }
+    else
+    {
+        // Create staging buffer to hold loaded data, ready to copy to device
+        VkDeviceMemory imageStagingBufferMemory;
+        createBuffer(m_mainDevice.physicalDevice, m_mainDevice.logicalDevice, imageSize,
+            VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+            &upload.buffer, &imageStagingBufferMemory);
+
+        // Copy image data (all the levels in the regions) to staging buffer
+        void *data;
+        vkMapMemory(m_mainDevice.logicalDevice, imageStagingBufferMemory, 0, imageSize, 0, &data);
+        memcpy(data, texture.data.data(), static_cast<size_t>(imageSize));
+        vkUnmapMemory(m_mainDevice.logicalDevice, imageStagingBufferMemory);
+
+        // Destroyed once the frame that copies from it is done
+        VkBuffer imageStagingBuffer = upload.buffer;
+        deferRelease([this, imageStagingBuffer, imageStagingBufferMemory]() {
+            vkDestroyBuffer(m_mainDevice.logicalDevice, imageStagingBuffer, nullptr);
+            vkFreeMemory(m_mainDevice.logicalDevice, imageStagingBufferMemory, nullptr);
+        });
+    }
+
+    // Create the VkImage on the device to hold the final texture (source of blits too, for the mip chain generation)
+    VkImageUsageFlags usage = VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+    if (gpuMipmaps || copySource)
+    {
+        usage |= VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+    }
     VkDeviceMemory texImageMemory;
-    texImage = createImage(width, height, VK_FORMAT_R8G8B8A8_UNORM, VK_IMAGE_TILING_OPTIMAL,
-        VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, &texImageMemory);
+    VkImage texImage = createImage(texture.width, texture.height, texture.format, VK_IMAGE_TILING_OPTIMAL,
+        usage, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, &texImageMemory, texture.mipLevels);
 
     //--------------------------------------------
-    // COPY DATA TO IMAGE
-    // Transition image to be DST (DeSTination) for the copy operation
-    transitionImageLayout(m_mainDevice.logicalDevice, m_graphicsQueue, m_graphicsCommandPool, 
-        texImage, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+    // COPY DATA TO IMAGE (and generate the other levels): recorded at the start of the next frame
+    upload.image = texImage;
+    upload.width = texture.width;
+    upload.height = texture.height;
+    upload.mipLevels = texture.mipLevels;
+    upload.gpuMipmaps = gpuMipmaps;
+    m_textureUploads.push_back(std::move(upload));
+
+    // Add texture data to vector for reference (the Image View is created by the caller)
+    int textureImageLoc = addTextureImage(texImage, texImageMemory, texture.format, texture.mipLevels);
 
-    // Copy image data
-    copyImageBuffer(m_mainDevice.logicalDevice, m_graphicsQueue, m_graphicsCommandPool, imageStagingBuffer, texImage, width, height);
+    // Return an index of the new texture image
+    return textureImageLoc;
+}
+//------------------------------------------------------------------------------
+int VulkanRenderer::addTextureImage(VkImage image, VkDeviceMemory imageMemory, VkFormat format, uint32_t mipLevels)
+{
+    // Reuse a free slot if any
+    int textureImageLoc;
+    if (!m_freeTextureImages.empty())
+    {
+        textureImageLoc = m_freeTextureImages.back();
+        m_freeTextureImages.pop_back();
+        m_textureImages[textureImageLoc] = image;
+        m_textureImageMemory[textureImageLoc] = imageMemory;
+        m_textureImageViews[textureImageLoc] = 0;
+        m_textureMipLevels[textureImageLoc] = mipLevels;
+        m_textureFormats[textureImageLoc] = format;
+    }
+    else
+    {
+        m_textureImages.push_back(image);
+        m_textureImageMemory.push_back(imageMemory);
+        m_textureImageViews.push_back(0);
+        m_textureMipLevels.push_back(mipLevels);
+        m_textureFormats.push_back(format);
+        textureImageLoc = static_cast<int>(m_textureImages.size() - 1);
+    }
 
-    // Transition image to be shader readable for shader usage
-    transitionImageLayout(m_mainDevice.logicalDevice, m_graphicsQueue, m_graphicsCommandPool,
-        texImage, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+    return textureImageLoc;
+}
+//------------------------------------------------------------------------------
+bool VulkanRenderer::packTextureInAtlas(int textureId, const TextureData &texture)
+{
+    AtlasPlacement placement;
+    if (!TextureAtlas::isPackable(texture.format, texture.width, texture.height) ||
+        !m_textureAtlas.add(textureId, texture.width, texture.height, &placement))
+    {
+        return false;
+    }
+    while (m_atlasPages.size() < m_textureAtlas.getPageCount())
+    {
+        createAtlasPage();
+    }
 
-    // Add texture data to vector for reference
-    m_textureImages.push_back(texImage);
-    m_textureImageMemory.push_back(texImageMemory);
+    // Padded levels of the rectangle, from level 0 of the texture (in the staging arena, or on the heap)
+    const uint8_t * pixels = (texture.stagingData ? texture.stagingData : texture.data.data()) + texture.regions[0].bufferOffset;
+    std::vector<VkBufferImageCopy> imageRegions;
+    std::vector<uint8_t> levels = TextureAtlas::buildPaddedLevels(pixels, texture.width, texture.height, placement, &imageRegions);
+    VkDeviceSize levelsSize = levels.size();
 
-    // Destroy staging buffers
-    vkDestroyBuffer(m_mainDevice.logicalDevice, imageStagingBuffer, nullptr);
-    vkFreeMemory(m_mainDevice.logicalDevice, imageStagingBufferMemory, nullptr);
+    VkBuffer        stagingBuffer;
+    VkDeviceMemory  stagingBufferMemory;
+    createBuffer(m_mainDevice.physicalDevice, m_mainDevice.logicalDevice, levelsSize,
+        VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+        &stagingBuffer, &stagingBufferMemory);
 
-    // Return an index of the new texture image
-    return static_cast<int>(m_textureImages.size() - 1);
+    void *data;
+    vkMapMemory(m_mainDevice.logicalDevice, stagingBufferMemory, 0, levelsSize, 0, &data);
+    memcpy(data, levels.data(), static_cast<size_t>(levelsSize));
+    vkUnmapMemory(m_mainDevice.logicalDevice, stagingBufferMemory);
+
+    // The page is in use: the upload barrier waits for the frames in flight to be done sampling it, the rest of it is
+    // preserved
+    TextureUpload upload;
+    upload.image = m_textureImages[m_atlasPages[placement.page].imageLoc];
+    upload.mipLevels = TextureAtlas::MIP_LEVELS;
+    upload.initialized = true;
+    upload.buffer = stagingBuffer;
+    upload.regions = std::move(imageRegions);
+    m_textureUploads.push_back(std::move(upload));
+
+    deferRelease([this, stagingBuffer, stagingBufferMemory]() {
+        vkDestroyBuffer(m_mainDevice.logicalDevice, stagingBuffer, nullptr);
+        vkFreeMemory(m_mainDevice.logicalDevice, stagingBufferMemory, nullptr);
+    });
+    return true;
+}
+//------------------------------------------------------------------------------
+void VulkanRenderer::createAtlasPage()
+{
+    // Empty page (texels outside the rectangles are never sampled), shader readable between the rectangle copies
+    VkDeviceMemory pageMemory;
+    VkImage pageImage = createImage(TextureAtlas::PAGE_SIZE, TextureAtlas::PAGE_SIZE, VK_FORMAT_R8G8B8A8_UNORM, VK_IMAGE_TILING_OPTIMAL,
+        VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, &pageMemory, TextureAtlas::MIP_LEVELS);
+    TextureUpload upload;
+    upload.image = pageImage;
+    upload.mipLevels = TextureAtlas::MIP_LEVELS;
+    m_textureUploads.push_back(std::move(upload));
+
+    AtlasPage page;
+    page.imageLoc = addTextureImage(pageImage, pageMemory, VK_FORMAT_R8G8B8A8_UNORM, TextureAtlas::MIP_LEVELS);
+    m_textureImageViews[page.imageLoc] = createImageView(pageImage, VK_FORMAT_R8G8B8A8_UNORM, VK_IMAGE_ASPECT_COLOR_BIT,
+                                                         TextureAtlas::MIP_LEVELS);
+    page.descriptorSet = allocateTextureDescriptorSet(m_textureImageViews[page.imageLoc]);
+    m_atlasPages.push_back(page);
+}
+//------------------------------------------------------------------------------
+int VulkanRenderer::uploadTextureLevels(const TextureData &texture, uint32_t baseLevel)
+{
+    // Levels [baseLevel, mipLevels) as an image of their own (levels are stored finest first: they're the tail of the data).
+    // Streamed textures only: their next residency change copies the levels it keeps from this image.
+    TextureData levels;
+    levels.format = texture.format;
+    levels.width = std::max(texture.width >> baseLevel, 1U);
+    levels.height = std::max(texture.height >> baseLevel, 1U);
+    levels.mipLevels = texture.mipLevels - baseLevel;
+
+    VkDeviceSize baseOffset = texture.regions[baseLevel].bufferOffset;
+    levels.data.assign(texture.data.begin() + static_cast<size_t>(baseOffset), texture.data.end());
+    for (size_t level = baseLevel; level < texture.regions.size(); ++level)
+    {
+        VkBufferImageCopy region = texture.regions[level];
+        region.bufferOffset -= baseOffset;
+        region.imageSubresource.mipLevel -= baseLevel;
+        levels.regions.push_back(region);
+    }
+
+    return uploadTexture(levels, true);
+}
+//------------------------------------------------------------------------------
+void VulkanRenderer::releaseTextureData(const TextureData &texture)
+{
+    // Texels decoded in the staging arena are owned by the texture data
+    if (texture.stagingData)
+    {
+        stbi_image_free(const_cast<uint8_t *>(texture.stagingData));
+    }
+}
+//------------------------------------------------------------------------------
+bool VulkanRenderer::isLinearBlitSupported(VkFormat format)
+{
+    // vkCmdBlitImage with VK_FILTER_LINEAR needs the format to be a blit source/destination and linearly filterable
+    VkFormatProperties formatProperties;
+    vkGetPhysicalDeviceFormatProperties(m_mainDevice.physicalDevice, format, &formatProperties);
+
+    const VkFormatFeatureFlags requiredFeatures =
+        VK_FORMAT_FEATURE_BLIT_SRC_BIT | VK_FORMAT_FEATURE_BLIT_DST_BIT | VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT;
+    return (formatProperties.optimalTilingFeatures & requiredFeatures) == requiredFeatures;
+}
+//------------------------------------------------------------------------------
+void VulkanRenderer::generateMipmaps(VkCommandBuffer commandBuffer, VkImage image, uint32_t width, uint32_t height,
+                                     uint32_t mipLevels)
+{
+    // Level 0 has been copied (all the levels are transfer destinations): each level is blitted from the previous one
+    VkImageMemoryBarrier barrier = {};
+    barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.image = image;
+    barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    barrier.subresourceRange.baseArrayLayer = 0;
+    barrier.subresourceRange.layerCount = 1;
+    barrier.subresourceRange.levelCount = 1;
+
+    int32_t levelWidth = static_cast<int32_t>(width);
+    int32_t levelHeight = static_cast<int32_t>(height);
+    for (uint32_t level = 1; level < mipLevels; ++level)
+    {
+        // Previous level has been written (copy or blit): make it the source of this blit
+        barrier.subresourceRange.baseMipLevel = level - 1;
+        barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+        barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+        vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0,
+                             0, nullptr, 0, nullptr, 1, &barrier);
+
+        // Downsample (half size, linear filter) the previous level into this one
+        int32_t nextWidth = std::max(levelWidth / 2, 1);
+        int32_t nextHeight = std::max(levelHeight / 2, 1);
+
+        VkImageBlit blit = {};
+        blit.srcOffsets[0] = { 0, 0, 0 };
+        blit.srcOffsets[1] = { levelWidth, levelHeight, 1 };
+        blit.srcSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        blit.srcSubresource.mipLevel = level - 1;
+        blit.srcSubresource.baseArrayLayer = 0;
+        blit.srcSubresource.layerCount = 1;
+        blit.dstOffsets[0] = { 0, 0, 0 };
+        blit.dstOffsets[1] = { nextWidth, nextHeight, 1 };
+        blit.dstSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        blit.dstSubresource.mipLevel = level;
+        blit.dstSubresource.baseArrayLayer = 0;
+        blit.dstSubresource.layerCount = 1;
+        vkCmdBlitImage(commandBuffer, image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                       1, &blit, VK_FILTER_LINEAR);
+
+        levelWidth = nextWidth;
+        levelHeight = nextHeight;
+    }
+
+    // Batch the final transitions to shader readable in a single barrier call:
+    // levels [0, mipLevels - 1) are blit sources, the last level is still a transfer destination
+    std::array<VkImageMemoryBarrier, 2> finalBarriers = { barrier, barrier };
+    finalBarriers[0].subresourceRange.baseMipLevel = 0;
+    finalBarriers[0].subresourceRange.levelCount = mipLevels - 1;
+    finalBarriers[0].oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+    finalBarriers[0].newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    finalBarriers[0].srcAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+    finalBarriers[0].dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+
+    finalBarriers[1].subresourceRange.baseMipLevel = mipLevels - 1;
+    finalBarriers[1].subresourceRange.levelCount = 1;
+    finalBarriers[1].oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    finalBarriers[1].newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    finalBarriers[1].srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    finalBarriers[1].dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+
+    // A single level image has no blit sources
+    const uint32_t firstBarrier = (mipLevels > 1) ? 0 : 1;
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0,
+                         0, nullptr, 0, nullptr, 2 - firstBarrier, finalBarriers.data() + firstBarrier);
 }
 
 //------------------------------------------------------------------------------
 int VulkanRenderer::createTextureDescriptor(VkImageView textureImageView)
 {
-    VkDescriptorSet descriptorSet;
+    // The sampler descriptor pool is sized for MAX_TEXTURES slots
+    if (m_freeTextureDescriptors.empty() && m_samplerDescriptorSets.size() >= static_cast<size_t>(MAX_TEXTURES))
+    {
+        throw std::runtime_error("Too many textures! (MAX_TEXTURES: " + std::to_string(MAX_TEXTURES) + ")");
+    }
+    VkDescriptorSet descriptorSet = allocateTextureDescriptorSet(textureImageView);
 
-    // Descriptor Set Allocation Info
-    VkDescriptorSetAllocateInfo setAllocInfo = {};
-    setAllocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
-    setAllocInfo.descriptorPool = m_samplerDescriptorPool;
-    setAllocInfo.descriptorSetCount = 1;
-    setAllocInfo.pSetLayouts = &m_samplerSetLayout;
+    // Reuse the slot of a released texture, if any
+    if (!m_freeTextureDescriptors.empty())
+    {
+        int descriptorLoc = m_freeTextureDescriptors.back();
+        m_freeTextureDescriptors.pop_back();
+        m_samplerDescriptorSets[descriptorLoc] = descriptorSet;
+        return descriptorLoc;
+    }
 
-    // Allocate Descriptor Sets
-    VkResult result = vkAllocateDescriptorSets(m_mainDevice.logicalDevice, &setAllocInfo, &descriptorSet);
-    if (result != VK_SUCCESS)
+    // Add descriptor set to list
+    m_samplerDescriptorSets.push_back(descriptorSet);
+
+    // Return descriptor set location
+    return static_cast<int>(m_samplerDescriptorSets.size() - 1);
+}
+//------------------------------------------------------------------------------
+VkDescriptorSet VulkanRenderer::allocateTextureDescriptorSet(VkImageView textureImageView)
+{
+    VkDescriptorSet descriptorSet;
+
+    if (!m_freeSamplerDescriptorSets.empty())
     {
-        throw std::runtime_error("Failed to allocate Texture Descriptor Sets!");
+        // Recycle a retired set (no frame in flight uses it anymore)
+        descriptorSet = m_freeSamplerDescriptorSets.back();
+        m_freeSamplerDescriptorSets.pop_back();
+    }
+    else
+    {
+        // Descriptor Set Allocation Info
+        VkDescriptorSetAllocateInfo setAllocInfo = {};
+        setAllocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+        setAllocInfo.descriptorPool = m_samplerDescriptorPool;
+        setAllocInfo.descriptorSetCount = 1;
+        setAllocInfo.pSetLayouts = &m_samplerSetLayout;
+
+        // Allocate Descriptor Sets
+        VkResult result = vkAllocateDescriptorSets(m_mainDevice.logicalDevice, &setAllocInfo, &descriptorSet);
+        if (result != VK_SUCCESS)
+        {
+            throw std::runtime_error("Failed to allocate Texture Descriptor Sets!");
+        }
     }
 
     // Texture Image Info
@@ -1884,22 +3053,21 @@ int VulkanRenderer::createTextureDescriptor(VkImageView textureImageView)
     // Update new descriptor set
     vkUpdateDescriptorSets(m_mainDevice.logicalDevice, 1, &descriptorWrite, 0, nullptr);
 
-    // Add descriptor set to list
-    m_samplerDescriptorSets.push_back(descriptorSet);
-
-    // Return descriptor set location
-    return static_cast<int>(m_samplerDescriptorSets.size() - 1);
+    return descriptorSet;
 }
 
 //------------------------------------------------------------------------------
-stbi_uc* VulkanRenderer::loadTextureFile(std::string fileName, int* width, int* height, VkDeviceSize* imageSize)
+stbi_uc* VulkanRenderer::loadTextureFile(std::string fileName, int* width, int* height, VkDeviceSize* imageSize,
+                                         std::span<const uint8_t> fileData)
 {
     // Number of channels image uses
     int channels;
 
-    // Load pixel data for image
+    // Load pixel data for image (from memory if the file was already read, or is packed in the asset archive)
     std::string fileLoc = "Textures/" + fileName;
-    stbi_uc * image = stbi_load(fileLoc.c_str(), width, height, &channels, STBI_rgb_alpha);
+    stbi_uc * image = fileData.empty()
+        ? stbi_load(fileLoc.c_str(), width, height, &channels, STBI_rgb_alpha)
+        : stbi_load_from_memory(fileData.data(), static_cast<int>(fileData.size()), width, height, &channels, STBI_rgb_alpha);
     if (!image)
     {
         throw std::runtime_error("Failed to load a Texture file! ('Textures/" + fileName + "')");
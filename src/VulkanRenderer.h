@@ -4,8 +4,11 @@
 // C++ STL
 #include <algorithm>
 #include <array>
+#include <deque>
+#include <functional>
 #include <iostream>
 #include <set>
+#include <span>
 #include <stdexcept>
 #include <vector>
 
@@ -13,9 +16,25 @@
 #include "stb_image.h"
 
 // Project includes
+#include "AssetArchive.h"
+#include "AssetLoader.h"
+#include "BlockCompressor.h"
+#include "FileWatcher.h"
+#include "Ktx2Loader.h"
+#include "LayoutCache.h"
 #include "Mesh.h"
+#include "PipelineCache.h"
+#include "PipelineManager.h"
+#include "RenderGraph.h"
+#include "ShaderCompiler.h"
+#include "StagingArena.h"
+#include "TextureAtlas.h"
+#include "TextureCache.h"
+#include "TextureDiskCache.h"
+#include "TextureStreamer.h"
 #include "Utilities.h"          // Utilities header includes GLFW [Graphics Library FrameWork] + Vulkan API
 #include "VulkanValidation.h"
+#include "WorkerPool.h"
 
 using namespace Utilities;
 // Utilities::SwapchainImage,   Utilities::SwapchainDetails, Utilities::QueueFamilyIndices,
@@ -33,6 +52,26 @@ public:
     bool        isWindowIconified();
     
     bool        updateModel(uint32_t modelId, glm::mat4 modelMatrix);
+    int         addMesh(const std::string &meshFile, const std::string &textureFile);   // Cooked mesh (Models/), returns its model ID
+    bool        setMaterial(uint32_t modelId, const Material &material);   // Shader features (pipeline variant) of a mesh
+
+    void        setDepthPrepassEnabled(bool enabled);
+    bool        isDepthPrepassEnabled();
+
+    void        setTextureCompression(TextureCompression compression, CompressionQuality quality);   // Call before init()
+    void        setTextureContentHashing(bool enabled);     // Also share textures with the same content (different paths)
+    void        releaseTexture(int textureId);              // Drop a reference taken by createTexture()
+    void        setTextureStreaming(bool enabled, VkDeviceSize budget = 0);   // Call before init() (budget 0: device limit only)
+    TextureStreamingStats   getTextureStreamingStats();
+    void        setTextureAtlas(bool enabled);                  // Call before init()
+    void        setTextureDiskCache(bool enabled, VkDeviceSize maxSize);    // Call before init()
+    TextureDiskCacheStats   getTextureDiskCacheStats();
+    void        setAssetArchive(const std::string &filePath);   // Call before init() (missing archive: loose files only)
+    void        setRuntimeShaderCompilation(bool enabled);      // Call before init() (GLSL sources instead of the .spv)
+    void        setHotReload(bool enabled);                     // Call before init() (watches Shaders/ and Textures/)
+    void        setShaderObjects(bool enabled);                 // Call before init() (used if the device supports them)
+    PipelineBackend getPipelineBackend();                       // Valid after init()
+    RenderGraphStats    getRenderGraphStats();                  // Transient attachments memory (committed size queried)
 
     void        draw(double frameDuration = 16.66666666667);    // 60 fps => (1000.0 / 60.0 = 16.66667 ms)
     void        cleanup();
@@ -41,6 +80,8 @@ private:
     // GLFW Components
     GLFWwindow *                    m_pWindow = nullptr;
     uint8_t                         m_currentFrame = 0U;        // Index of current frame. For Triple Buffer it'll be in {0, 1, 2}
+    bool                            m_depthPrepassEnabled = false;  // Depth-only pre-pass before the main (shading) pass
+    bool                            m_framebufferResized = false;   // Set by the GLFW resize callback, the Swapchain must be re-created
 
     // Scene Objects
     std::vector<Mesh>               m_meshList;
@@ -68,19 +109,30 @@ private:
     VkSwapchainKHR                  m_swapChain = 0;    // '0' instead of 'nullptr' for compatibility with 32bit version
 
     std::vector<SwapchainImage>     m_swapchainImages;
-    std::vector<VkFramebuffer>      m_swapChainFramebuffers;
     std::vector<VkCommandBuffer>    m_commandBuffers;
 
-    VkImage                         m_depthBufferImage = 0;
-    VkDeviceMemory                  m_depthBufferImageMemory = 0;
-    VkImageView                     m_depthBufferImageView = 0;
+    // - Frame
+    RenderGraph                     m_renderGraph;              // Passes, their Render Passes and barriers, Depth Buffer
+    uint32_t                        m_swapchainResource = 0;    // Imported image of the graph (set each frame)
+    uint32_t                        m_depthPrepassPass = 0;
+    uint32_t                        m_mainPass = 0;
+    bool                            m_synchronization2Supported = false;    // VK_KHR_synchronization2 enabled on the device
+    struct FrameDraws
+    {
+        uint32_t                    imageIndex = 0;
+        std::vector<size_t>         opaqueDraws;                // Front-to-back
+        std::vector<size_t>         transparentDraws;           // Back-to-front
+        bool                        depthPrepass = false;       // Pre-pass enabled and its pipelines ready
+        std::array<PipelineDesc, Material::VARIANT_COUNT>   opaquePipelineDescs;        // Per material variant (empty: not drawn)
+        std::array<PipelineDesc, Material::VARIANT_COUNT>   transparentPipelineDescs;
+    }                               m_frameDraws;               // Frame being recorded (read by the graph passes)
 
     VkSampler                       m_textureSampler = 0;
 
     // - Descriptors
-    VkDescriptorSetLayout           m_descriptorSetLayout = 0;
-    VkDescriptorSetLayout           m_samplerSetLayout = 0;
-    VkPushConstantRange             m_pushConstantRange = {};
+    VkDescriptorSetLayout           m_descriptorSetLayout = 0;  // Reflected from the shaders (owned by the layout cache)
+    VkDescriptorSetLayout           m_samplerSetLayout = 0;     // Same
+    VkPushConstantRange             m_pushConstantRange = {};   // Same
 
     VkDescriptorPool                m_descriptorPool = 0;
     VkDescriptorPool                m_samplerDescriptorPool = 0;
@@ -101,11 +153,91 @@ private:
     std::vector<VkImage>            m_textureImages;
     std::vector<VkDeviceMemory>     m_textureImageMemory;
     std::vector<VkImageView>        m_textureImageViews;
+    std::vector<uint32_t>           m_textureMipLevels;
+    std::vector<VkFormat>           m_textureFormats;
+    Ktx2Loader                      m_ktx2Loader;               // Block compressed textures (KTX2)
+    BlockCompressor                 m_blockCompressor;          // Runtime block compression of JPG/PNG textures
+    TextureCompression              m_textureCompression = TextureCompression::None;
+    CompressionQuality              m_compressionQuality = CompressionQuality::Fast;
+    TextureCache                    m_textureCache;             // Resident textures (createTexture() returns them for duplicates)
+    std::vector<int>                m_freeTextureDescriptors;   // Slots of released textures (reused)
+    std::vector<VkDescriptorSet>    m_freeSamplerDescriptorSets;// Retired sampler descriptor sets (reused)
+    WorkerPool                      m_workerPool;               // Texture decodes and their block compression (one core left to the render thread)
+    AssetLoader                     m_assetLoader;              // Texture reads + decodes on the worker pool
+    std::deque<std::unique_ptr<AssetCompletion>>    m_completedAssets;  // Decoded, waiting for their upload (bytes per frame capped)
+    struct TextureUpload
+    {
+        VkImage                     image = 0;
+        uint32_t                    width = 0;                  // Level 0 (mip generation)
+        uint32_t                    height = 0;
+        uint32_t                    mipLevels = 1;
+        bool                        initialized = false;        // Shader readable, contents kept (atlas pages)
+        VkBuffer                    buffer = 0;                 // Staging buffer (or the staging arena one)
+        std::vector<VkBufferImageCopy>  regions;
+        bool                        gpuMipmaps = false;         // Levels without a region blitted from level 0
+    };
+    std::vector<TextureUpload>      m_textureUploads;           // Recorded at the start of the next frame
+    StagingArena                    m_stagingArena;             // Persistently mapped staging memory (zero-copy decodes)
+    int                             m_placeholderTextureLoc = -1;   // 1x1 texture bound while the real one is loading
+    std::vector<int>                m_freeTextureImages;        // Slots of destroyed texture images (reused)
+    TextureStreamer                 m_textureStreamer;          // Mip residency under a VRAM budget
+    bool                            m_textureStreaming = false;
+    struct ResidencyCopy
+    {
+        VkImage                     oldImage = 0;               // Current image (copy source)
+        uint32_t                    oldMipLevels = 0;
+        VkImage                     newImage = 0;
+        uint32_t                    newMipLevels = 0;
+        std::vector<VkImageCopy>    imageCopies;                // Levels resident in both images
+        VkBuffer                    buffer = 0;                 // Streamed in levels (staging), or evicted ones (readback)
+        std::vector<VkBufferImageCopy>  bufferCopies;
+        bool                        readback = false;
+    };
+    std::vector<ResidencyCopy>      m_residencyCopies;          // Recorded at the start of the next frame
+    VkDeviceSize                    m_textureBudget = 0;
+    bool                            m_memoryBudgetSupported = false;    // VK_EXT_memory_budget enabled on the device
+    TextureAtlas                    m_textureAtlas;             // Small textures packed in shared pages
+    bool                            m_textureAtlasEnabled = false;
+    struct AtlasPage
+    {
+        int                         imageLoc;                   // Index in the texture images
+        VkDescriptorSet             descriptorSet;
+    };
+    std::vector<AtlasPage>          m_atlasPages;
+    TextureDiskCache                m_textureDiskCache;         // Processed textures of the previous runs (no decode)
+    bool                            m_textureDiskCacheEnabled = false;
+    VkDeviceSize                    m_textureDiskCacheSize = 0;
+
+    // - Asset Archive
+    AssetArchive                    m_assetArchive;             // Packed assets (mapped), the others are loose files
+    std::string                     m_assetArchivePath;
+
+    // - Hot-Reload
+    bool                            m_hotReload = false;
+    FileWatcher                     m_fileWatcher;              // Modified shaders and textures
+
+    // - Deferred Deletion (resources still used by the frames in flight)
+    struct DeferredRelease
+    {
+        uint64_t                    frameNumber;                // Frames submitted when the resource was retired
+        std::function<void()>       release;
+    };
+    std::deque<DeferredRelease>     m_deferredReleases;
+    uint64_t                        m_frameNumber = 0;          // Frames submitted so far
 
     // - Pipeline
-    VkPipeline                      m_graphicsPipeline = 0;
-    VkPipelineLayout                m_pipelineLayout = 0;
-    VkRenderPass                    m_renderPass = 0;
+    PipelineDesc                    m_opaquePipelineDesc;       // Blending disabled, depth writes enabled (drawn front-to-back)
+    PipelineDesc                    m_transparentPipelineDesc;  // Alpha blending, depth writes disabled (drawn back-to-front)
+    PipelineDesc                    m_opaqueEqualPipelineDesc;  // Opaque after the depth pre-pass (depth EQUAL test, no writes)
+    PipelineDesc                    m_depthPrepassPipelineDesc; // Position-only, no fragment shader (Depth pre-pass)
+    VkPipelineLayout                m_pipelineLayout = 0;       // Main pass (the pre-pass one is in its description)
+    LayoutCache                     m_layoutCache;              // Set and Pipeline layouts reflected from the shaders
+    PipelineCache                   m_pipelineCache;            // Persistent (on disk) cache of compiled pipelines
+    PipelineManager                 m_pipelineManager;          // Pipelines by description, compiled on worker threads
+    ShaderCompiler                  m_shaderCompiler;           // GLSL to SPIR-V (runtime compilation, and hot-reload)
+    bool                            m_runtimeShaderCompilation = false;
+    bool                            m_shaderObjectsEnabled = false;
+    PipelineBackend                 m_pipelineBackend = PipelineBackend::Pipelines;     // Chosen with the device
 
     // - Pools
     VkCommandPool                   m_graphicsCommandPool = 0;
@@ -126,12 +258,10 @@ private:
     void createLogicalDevice();
     void createSurface();
     void createSwapchain();
-    void createRenderPass();
-    void createDescriptorSetLayout();
-    void createPushConstantRange();
+    void createRenderGraph();
     void createGraphicsPipeline();
-    void createDepthBufferImage();
-    void createFramebuffers();
+    std::string getShaderFile(const std::string &source);   // The GLSL source, or its module built offline
+    PipelineDesc getMaterialPipelineDesc(const PipelineDesc &base, const Material &material);   // Specialized variant
     void createCommandPool();
     void createCommandBuffers();
     void createSynchronisation();
@@ -139,12 +269,26 @@ private:
 
     void createUniformBuffers();
     void createDescriptorPool();
+    void createSamplerDescriptorPool();
     void createDescriptorSets();
 
     void updateUniformBuffers(uint32_t imageIndex);
+    void updateProjection();
+
+    // - Swapchain re-creation (resize)
+    void recreateSwapchain();
+    void destroySwapchainAttachments();
+    static void framebufferResizeCbk(GLFWwindow* window, int width, int height);
 
     // - Record Functions
     void recordCommands(uint32_t imageIndex);
+    void recordDepthPrepass(VkCommandBuffer commandBuffer);
+    void recordMainPass(VkCommandBuffer commandBuffer);
+    void recordMeshDraw(VkCommandBuffer commandBuffer, uint32_t imageIndex, size_t meshIdx, VkDescriptorSet * boundTextureSet);
+    void recordMeshDepthDraw(VkCommandBuffer commandBuffer, uint32_t imageIndex, size_t meshIdx);
+
+    // - Sort Functions
+    void sortDrawOrder(std::vector<size_t> &opaqueDraws, std::vector<size_t> &transparentDraws);
 
     // - Get Functions
     void getPhysicalDevice();
@@ -156,6 +300,7 @@ private:
     // -- Checker Functions
     bool checkInstanceExtensionSupport(std::vector<const char*> * extensionsToCheck);
     bool checkDeviceExtensionSupport(VkPhysicalDevice device);
+    bool isDeviceExtensionSupported(VkPhysicalDevice device, const char * extensionName);
     bool checkValidationLayerSupport();
     bool checkDeviceSuitable(VkPhysicalDevice device);
 
@@ -173,16 +318,43 @@ private:
     // -- Create Functions
     VkImage                     createImage(uint32_t width, uint32_t height, VkFormat format, VkImageTiling tiling,
                                             VkImageUsageFlags useFlags, VkMemoryPropertyFlags propFlags,
-                                            VkDeviceMemory *imageMemory);
-    VkImageView                 createImageView(VkImage image, VkFormat format, VkImageAspectFlags aspectFlags);
-    VkShaderModule              createShaderModule(const std::vector<char> &code);
+                                            VkDeviceMemory *imageMemory, uint32_t mipLevels = 1);
+    VkImageView                 createImageView(VkImage image, VkFormat format, VkImageAspectFlags aspectFlags, uint32_t mipLevels = 1);
 
     int                         createTexture(std::string fileName);
-    int                         createTextureImage(std::string fileName);
+    std::string                 resolveTextureFile(const std::string &fileName);
+    void                        createPlaceholderTexture();
+    void                        decodeTexture(const std::string &fileName, std::span<const uint8_t> fileData, TextureData * texture);  // Thread safe
+    int                         uploadTexture(const TextureData &texture, bool copySource = false);
+    int                         uploadTextureLevels(const TextureData &texture, uint32_t baseLevel);
+    void                        swapTextureImage(int textureId, int textureImageLoc, int oldTextureImageLoc);
+    void                        destroyTextureImage(int textureImageLoc);
+    int                         addTextureImage(VkImage image, VkDeviceMemory imageMemory, VkFormat format, uint32_t mipLevels);
+    bool                        packTextureInAtlas(int textureId, const TextureData &texture);
+    void                        createAtlasPage();
+    void                        releaseTextureData(const TextureData &texture);
     int                         createTextureDescriptor(VkImageView textureImage);
+    VkDescriptorSet             allocateTextureDescriptorSet(VkImageView textureImage);
+
+    // -- Asset Streaming Functions
+    void                        processAssetUploads();
+    void                        recordTextureUploads(VkCommandBuffer commandBuffer);
+    void                        processHotReload();
+    void                        reloadTexture(const std::string &filePath);
+    void                        updateTextureStreaming();
+    int                         changeTextureResidency(int textureId, StreamedTexture &texture, uint32_t newBase);
+    void                        recordResidencyCopies(VkCommandBuffer commandBuffer);
+    void                        deferRelease(std::function<void()> release);
+    void                        runDeferredReleases(bool all = false);
+
+    // -- Mipmap Functions
+    bool                        isLinearBlitSupported(VkFormat format);
+    void                        generateMipmaps(VkCommandBuffer commandBuffer, VkImage image, uint32_t width, uint32_t height,
+                                                uint32_t mipLevels);
 
     // -- Loader Functions
-    stbi_uc *                   loadTextureFile(std::string fileName, int * width, int * height, VkDeviceSize * imageSize);
+    stbi_uc *                   loadTextureFile(std::string fileName, int * width, int * height, VkDeviceSize * imageSize,
+                                                std::span<const uint8_t> fileData = {});
 };
 
 #endif //VULKAN_RENDERER_H
@@ -0,0 +1,145 @@
+#include "WorkerPool.h"
+
+// C++ STL
+#include <algorithm>
+
+//------------------------------------------------------------------------------
+WorkerPool::WorkerPool()
+{
+}
+//------------------------------------------------------------------------------
+WorkerPool::~WorkerPool()
+{
+}
+//------------------------------------------------------------------------------
+void WorkerPool::create(uint32_t threadCount)
+{
+    m_stop = false;
+    for (uint32_t i = 0; i < threadCount; ++i)
+    {
+        m_threads.emplace_back(&WorkerPool::workerLoop, this);
+    }
+}
+//------------------------------------------------------------------------------
+void WorkerPool::destroy()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_workAvailable.notify_all();
+    for (std::thread &thread : m_threads)
+    {
+        thread.join();
+    }
+    m_threads.clear();
+    m_batches.clear();
+    m_jobs.clear();
+}
+//------------------------------------------------------------------------------
+uint32_t WorkerPool::getThreadCount() const
+{
+    return static_cast<uint32_t>(m_threads.size());
+}
+//------------------------------------------------------------------------------
+void WorkerPool::submit(std::function<void()> job)
+{
+    if (m_threads.empty())
+    {
+        job();
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_jobs.push_back(std::move(job));
+    }
+    m_workAvailable.notify_one();
+}
+//------------------------------------------------------------------------------
+void WorkerPool::parallelFor(uint32_t count, const std::function<void(uint32_t)> &body)
+{
+    if (m_threads.empty() || count <= 1)
+    {
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            body(i);
+        }
+        return;
+    }
+
+    std::shared_ptr<Batch> batch = std::make_shared<Batch>();
+    batch->body = &body;
+    batch->count = count;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_batches.push_back(batch);
+    }
+    m_workAvailable.notify_all();
+
+    uint32_t doneCount = runBatch(*batch);
+
+    // Everything is handed out: wait for the iterations still running on the workers
+    std::unique_lock<std::mutex> lock(m_mutex);
+    batch->doneCount += doneCount;
+    auto queued = std::find(m_batches.begin(), m_batches.end(), batch);
+    if (queued != m_batches.end())
+    {
+        m_batches.erase(queued);
+    }
+    m_batchDone.wait(lock, [&batch]() { return batch->doneCount == batch->count; });
+}
+//------------------------------------------------------------------------------
+void WorkerPool::workerLoop()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+
+    while (true)
+    {
+        m_workAvailable.wait(lock, [this]() { return m_stop || !m_batches.empty() || !m_jobs.empty(); });
+        if (m_stop)
+        {
+            return;
+        }
+
+        if (m_batches.empty())
+        {
+            std::function<void()> job = std::move(m_jobs.front());
+            m_jobs.pop_front();
+
+            lock.unlock();
+            job();
+            lock.lock();
+            continue;
+        }
+
+        std::shared_ptr<Batch> batch = m_batches.front();
+        if (batch->next >= batch->count)
+        {
+            m_batches.pop_front();      // All handed out (the caller waits for the ones still running)
+            continue;
+        }
+
+        lock.unlock();
+        uint32_t doneCount = runBatch(*batch);
+        lock.lock();
+
+        batch->doneCount += doneCount;
+        if (batch->doneCount == batch->count)
+        {
+            m_batchDone.notify_all();
+        }
+    }
+}
+//------------------------------------------------------------------------------
+uint32_t WorkerPool::runBatch(Batch &batch)
+{
+    // The body is only touched for the iterations handed out: once they're all done, the caller may return
+    uint32_t doneCount = 0;
+    for (uint32_t i = batch.next++; i < batch.count; i = batch.next++)
+    {
+        (*batch.body)(i);
+        ++doneCount;
+    }
+    return doneCount;
+}
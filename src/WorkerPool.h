@@ -0,0 +1,58 @@
+#ifndef WORKER_POOL_H
+#define WORKER_POOL_H
+
+// C++ STL
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Persistent worker threads shared by the CPU heavy work, so that it never runs on more threads than the pool has:
+// - submit() queues independent jobs (e.g. texture decodes), run in submission order;
+// - parallelFor() hands the iterations of a loop out to the workers and to the calling thread, which works too instead
+//   of waiting (so it can be called from several threads at once, even from inside a job or another loop of the pool).
+//   Loops go before the queued jobs: their callers are waiting for them.
+class WorkerPool
+{
+public:
+    WorkerPool();
+    ~WorkerPool();
+
+    void        create(uint32_t threadCount);           // Workers besides the calling threads (0: the callers do it all)
+    void        destroy();                              // Waits for the running jobs, drops the queued ones
+
+    uint32_t    getThreadCount() const;
+
+    void        submit(std::function<void()> job);      // 'job' must not throw
+
+    // body(0) ... body(count - 1), in any order and concurrently. Returns once they all returned; 'body' must not throw.
+    void        parallelFor(uint32_t count, const std::function<void(uint32_t)> &body);
+
+private:
+    struct Batch
+    {
+        const std::function<void(uint32_t)> *  body = nullptr;
+        uint32_t                count = 0;
+        std::atomic<uint32_t>   next { 0 };             // Next iteration to hand out
+        uint32_t                doneCount = 0;          // Iterations returned (m_mutex locked)
+    };
+
+    std::vector<std::thread>    m_threads;
+    std::mutex                  m_mutex;
+    std::condition_variable     m_workAvailable;
+    std::condition_variable     m_batchDone;
+    std::deque<std::shared_ptr<Batch>>  m_batches;      // With iterations left to hand out (the oldest first)
+    std::deque<std::function<void()>>   m_jobs;
+    bool                        m_stop = false;
+
+    // Methods
+    void        workerLoop();
+    static uint32_t runBatch(Batch &batch);             // Returns the number of iterations it ran
+};
+
+#endif //WORKER_POOL_H
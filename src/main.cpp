@@ -25,6 +25,20 @@ constexpr auto FPS_FACTOR           = 2.0;  // Correction factor for the sleep (
 // Set the following to 1 to test the basic graphic libraries on your system
 constexpr auto TEST_VULKAN_SDK      = 0;
 constexpr auto TEST_GLM             = 0;
+// Rendering options
+constexpr auto DEPTH_PREPASS        = false;    // Initial state of the depth pre-pass (toggle at runtime with the 'P' key)
+constexpr auto TEXTURE_COMPRESSION  = TextureCompression::None;     // Block compression of JPG/PNG textures at load time
+constexpr auto COMPRESSION_QUALITY  = CompressionQuality::Fast;     // Fast: shorter load times | Quality: lower error
+constexpr auto TEXTURE_CONTENT_HASH = false;    // Share textures with identical content under different paths (reads the files)
+constexpr auto TEXTURE_STREAMING    = false;    // Mip residency driven by the on-screen size of the objects (no GPU mip generation)
+constexpr auto TEXTURE_BUDGET_MB    = 256;      // VRAM budget of the streamed textures [MiB] (0: device budget only)
+constexpr auto TEXTURE_ATLAS        = false;    // Pack the small (up to 256x256) textures in shared atlas pages, uncompressed
+constexpr auto TEXTURE_DISK_CACHE   = true;     // Store the processed textures on disk, the next runs skip the decode
+constexpr auto DISK_CACHE_SIZE_MB   = 512;      // Size limit of the texture disk cache [MiB] (least recently used entries evicted)
+constexpr auto ASSET_ARCHIVE        = "Assets.pak"; // Packed assets (AssetCooker --archive), mapped at init; missing: loose files
+constexpr auto RUNTIME_SHADERS      = false;    // Compile the GLSL sources at runtime (cached in ShaderCache/) instead of loading the .spv
+constexpr auto HOT_RELOAD           = false;    // Watch Shaders/ and Textures/: modified files are swapped in without a restart (polled on Windows)
+constexpr auto SHADER_OBJECTS       = false;    // VK_EXT_shader_object instead of pipelines, when the device supports it
 
 
 // MAIN ------------------------------------------------------------------------
@@ -136,13 +150,26 @@ int main()
         return EXIT_FAILURE;
     }
 
-    // Initialize Vulkan Renderer instance
+    // Initialize Vulkan Renderer instance (textures are loaded by init, so set their compression before)
+    sg_vulkanRenderer.setTextureCompression(TEXTURE_COMPRESSION, COMPRESSION_QUALITY);
+    sg_vulkanRenderer.setTextureContentHashing(TEXTURE_CONTENT_HASH);
+    sg_vulkanRenderer.setTextureStreaming(TEXTURE_STREAMING, static_cast<VkDeviceSize>(TEXTURE_BUDGET_MB) * 1024 * 1024);
+    sg_vulkanRenderer.setTextureAtlas(TEXTURE_ATLAS);
+    sg_vulkanRenderer.setTextureDiskCache(TEXTURE_DISK_CACHE, static_cast<VkDeviceSize>(DISK_CACHE_SIZE_MB) * 1024 * 1024);
+    sg_vulkanRenderer.setAssetArchive(ASSET_ARCHIVE);
+    sg_vulkanRenderer.setRuntimeShaderCompilation(RUNTIME_SHADERS);
+    sg_vulkanRenderer.setHotReload(HOT_RELOAD);
+    sg_vulkanRenderer.setShaderObjects(SHADER_OBJECTS);
     if (EXIT_FAILURE == sg_vulkanRenderer.init(sg_pWindow))
     {
         cout << "ERROR: Can't initialize the Vulkan Renderer" << endl;
         return EXIT_FAILURE;
     }
 
+    // Depth pre-pass mode (switchable at runtime, to benchmark both modes on the same scene)
+    sg_vulkanRenderer.setDepthPrepassEnabled(DEPTH_PREPASS);
+    bool prepassKeyWasPressed = false;
+
     // 3D Model update variables
     float   angle       = 0.0f;
     double  deltaTime   = 0.0;
@@ -166,6 +193,15 @@ int main()
         // Poll and process events
         glfwPollEvents();
 
+        // Toggle the depth pre-pass on 'P' key press
+        bool prepassKeyPressed = (glfwGetKey(sg_pWindow, GLFW_KEY_P) == GLFW_PRESS);
+        if (prepassKeyPressed && !prepassKeyWasPressed)
+        {
+            sg_vulkanRenderer.setDepthPrepassEnabled(!sg_vulkanRenderer.isDepthPrepassEnabled());
+            cout << "Depth pre-pass " << (sg_vulkanRenderer.isDepthPrepassEnabled() ? "enabled." : "disabled.") << endl;
+        }
+        prepassKeyWasPressed = prepassKeyPressed;
+
         if (sg_vulkanRenderer.isWindowIconified())
         {
             // Just sleep for 1 frame time (frameDuration) if the window is iconified
@@ -222,6 +258,12 @@ int main()
 
     std::chrono::steady_clock::time_point tBeforeCleanup = std::chrono::steady_clock::now();
 
+    // Texture streaming statistics (before the cleanup: the budget is queried from the device)
+    TextureStreamingStats streamingStats = sg_vulkanRenderer.getTextureStreamingStats();
+    TextureDiskCacheStats diskCacheStats = sg_vulkanRenderer.getTextureDiskCacheStats();
+    PipelineBackend pipelineBackend = sg_vulkanRenderer.getPipelineBackend();
+    RenderGraphStats renderGraphStats = sg_vulkanRenderer.getRenderGraphStats();
+
     sg_vulkanRenderer.cleanup();
 
     // Destroy GLFW window and terminate (stop) GLFW
@@ -248,6 +290,28 @@ int main()
               << "[ms]   (Rendering loop time / Rendered frames)" << std::endl;
     std::cout << std::endl << "Average frames per second (FPS): "
               << std::round(1000.0 / avgFrameTime) << std::endl;
+    std::cout << "Pipeline backend: " << (pipelineBackend == PipelineBackend::ShaderObjects
+        ? "shader objects (VK_EXT_shader_object)" : "graphics pipelines") << std::endl;
+    std::cout << "Transient attachments: " << renderGraphStats.transientImageCount << " images in "
+              << renderGraphStats.transientAllocationCount << " allocations, "
+              << (renderGraphStats.transientMemorySize / 1024) << "[KiB] (" << renderGraphStats.lazyAllocationCount
+              << " lazily allocated: " << (renderGraphStats.lazyMemorySize / 1024) << "[KiB] reserved, "
+              << (renderGraphStats.lazyCommittedSize / 1024) << "[KiB] committed)" << std::endl;
+    if (TEXTURE_STREAMING)
+    {
+        const double MiB = 1024.0 * 1024.0;
+        std::cout << std::endl << "Texture streaming: " << streamingStats.textureCount << " textures, "
+                  << std::setprecision(4) << (streamingStats.residentBytes / MiB) << "[MiB] resident (budget "
+                  << (streamingStats.budget / MiB) << "[MiB]"
+                  << (streamingStats.memoryBudgetExt ? ", from VK_EXT_memory_budget" : "") << "), "
+                  << (streamingStats.streamedBytes / MiB) << "[MiB] streamed in, "
+                  << (streamingStats.hostBytes / MiB) << "[MiB] in host memory, "
+                  << streamingStats.evictedLevels << " levels evicted" << std::endl;
+    }
+    if (TEXTURE_DISK_CACHE)
+    {
+        std::cout << "Texture disk cache: " << diskCacheStats.hitCount << " hits, " << diskCacheStats.missCount << " misses" << std::endl;
+    }
 
     return EXIT_SUCCESS;
 }
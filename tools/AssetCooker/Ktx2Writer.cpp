@@ -0,0 +1,143 @@
+#include "Ktx2Writer.h"
+
+// C++ STL
+#include <array>
+#include <stdexcept>
+
+// KTX2 file layout: identifier + header (9 x uint32) + index (4 x uint32, 2 x uint64), level index, DFD, levels
+static const std::array<uint8_t, 12> KTX2_IDENTIFIER = { 0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n' };
+static const size_t KTX2_HEADER_SIZE        = 80;
+static const size_t KTX2_LEVEL_INDEX_SIZE   = 3 * sizeof(uint64_t);    // byteOffset, byteLength, uncompressedByteLength
+// Level data alignment (multiple of every block size, and of 4)
+static const size_t KTX2_LEVEL_ALIGNMENT    = 16;
+
+// Data Format Descriptor values (Khronos Data Format Specification 1.3)
+static const uint32_t KHR_DF_VERSION            = 2;
+static const uint8_t  KHR_DF_MODEL_RGBSDA       = 1;
+static const uint8_t  KHR_DF_MODEL_BC1A         = 128;
+static const uint8_t  KHR_DF_MODEL_BC7          = 135;
+static const uint8_t  KHR_DF_PRIMARIES_BT709    = 1;
+static const uint8_t  KHR_DF_TRANSFER_LINEAR    = 1;
+static const uint8_t  KHR_DF_CHANNEL_ALPHA      = 15;
+
+//------------------------------------------------------------------------------
+// Write a little endian value at the given offset
+template <typename T>
+static void writeValue(std::vector<uint8_t> &data, size_t offset, T value)
+{
+    memcpy(data.data() + offset, &value, sizeof(T));
+}
+
+//------------------------------------------------------------------------------
+void Ktx2Writer::write(const std::string &filePath, VkFormat format, uint32_t width, uint32_t height,
+                       const std::vector<std::vector<uint8_t>> &levels)
+{
+    std::vector<uint32_t> dfd = buildDataFormatDescriptor(format);
+    uint32_t levelCount = static_cast<uint32_t>(levels.size());
+
+    // Header, level index and DFD, then the levels (smallest first, as the specification recommends)
+    size_t dfdOffset = KTX2_HEADER_SIZE + levelCount * KTX2_LEVEL_INDEX_SIZE;
+    size_t dfdLength = dfd.size() * sizeof(uint32_t);
+    size_t fileSize = dfdOffset + dfdLength;
+    std::vector<size_t> levelOffsets(levelCount);
+    for (uint32_t level = levelCount; level-- > 0;)
+    {
+        fileSize = (fileSize + KTX2_LEVEL_ALIGNMENT - 1) & ~(KTX2_LEVEL_ALIGNMENT - 1);
+        levelOffsets[level] = fileSize;
+        fileSize += levels[level].size();
+    }
+
+    std::vector<uint8_t> fileData(fileSize, 0);
+    memcpy(fileData.data(), KTX2_IDENTIFIER.data(), KTX2_IDENTIFIER.size());
+    writeValue<uint32_t>(fileData, 12, static_cast<uint32_t>(format));  // vkFormat
+    writeValue<uint32_t>(fileData, 16, 1);                              // typeSize
+    writeValue<uint32_t>(fileData, 20, width);                          // pixelWidth
+    writeValue<uint32_t>(fileData, 24, height);                         // pixelHeight
+    writeValue<uint32_t>(fileData, 28, 0);                              // pixelDepth (2D)
+    writeValue<uint32_t>(fileData, 32, 0);                              // layerCount (not an array)
+    writeValue<uint32_t>(fileData, 36, 1);                              // faceCount (not a cube map)
+    writeValue<uint32_t>(fileData, 40, levelCount);                     // levelCount
+    writeValue<uint32_t>(fileData, 44, 0);                              // supercompressionScheme (none)
+    writeValue<uint32_t>(fileData, 48, static_cast<uint32_t>(dfdOffset));
+    writeValue<uint32_t>(fileData, 52, static_cast<uint32_t>(dfdLength));
+    // Key/value data and supercompression global data: none (offsets and lengths stay 0)
+
+    for (uint32_t level = 0; level < levelCount; ++level)
+    {
+        size_t indexOffset = KTX2_HEADER_SIZE + level * KTX2_LEVEL_INDEX_SIZE;
+        writeValue<uint64_t>(fileData, indexOffset, levelOffsets[level]);
+        writeValue<uint64_t>(fileData, indexOffset + sizeof(uint64_t), levels[level].size());
+        writeValue<uint64_t>(fileData, indexOffset + 2 * sizeof(uint64_t), levels[level].size());
+        memcpy(fileData.data() + levelOffsets[level], levels[level].data(), levels[level].size());
+    }
+    memcpy(fileData.data() + dfdOffset, dfd.data(), dfdLength);
+
+    std::ofstream file(filePath, std::ios::binary | std::ios::trunc);
+    if (!file.is_open())
+    {
+        throw std::runtime_error("Failed to write the KTX2 file '" + filePath + "'!");
+    }
+    file.write(reinterpret_cast<const char *>(fileData.data()), fileData.size());
+    if (!file.good())
+    {
+        throw std::runtime_error("Failed to write the KTX2 file '" + filePath + "'!");
+    }
+}
+//------------------------------------------------------------------------------
+std::vector<uint32_t> Ktx2Writer::buildDataFormatDescriptor(VkFormat format)
+{
+    // One sample per channel (RGBA8), or one for the whole block (BC1, BC7)
+    struct Sample
+    {
+        uint32_t    bitOffset;
+        uint32_t    bitLength;
+        uint32_t    channel;
+        uint32_t    upper;
+    };
+    uint8_t model;
+    uint8_t blockDimension;     // Texel block size - 1
+    uint8_t bytesPlane0;        // Bytes per block
+    std::vector<Sample> samples;
+    switch (format)
+    {
+    case VK_FORMAT_R8G8B8A8_UNORM:
+        model = KHR_DF_MODEL_RGBSDA;
+        blockDimension = 0;
+        bytesPlane0 = 4;
+        samples = { { 0, 8, 0, 255 }, { 8, 8, 1, 255 }, { 16, 8, 2, 255 }, { 24, 8, KHR_DF_CHANNEL_ALPHA, 255 } };
+        break;
+    case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+        model = KHR_DF_MODEL_BC1A;
+        blockDimension = 3;
+        bytesPlane0 = 8;
+        samples = { { 0, 64, 0, 0xFFFFFFFF } };
+        break;
+    case VK_FORMAT_BC7_UNORM_BLOCK:
+        model = KHR_DF_MODEL_BC7;
+        blockDimension = 3;
+        bytesPlane0 = 16;
+        samples = { { 0, 128, 0, 0xFFFFFFFF } };
+        break;
+    default:
+        throw std::runtime_error("KTX2 writer: format " + std::to_string(format) + " isn't supported!");
+    }
+
+    // dfdTotalSize | basic descriptor block (6 words + 4 words per sample)
+    uint32_t blockSize = static_cast<uint32_t>(6 + 4 * samples.size()) * sizeof(uint32_t);
+    std::vector<uint32_t> dfd;
+    dfd.push_back(sizeof(uint32_t) + blockSize);
+    dfd.push_back(0);                                                   // vendorId (Khronos) | descriptorType (basic)
+    dfd.push_back(KHR_DF_VERSION | (blockSize << 16));                  // versionNumber | descriptorBlockSize
+    dfd.push_back(model | (KHR_DF_PRIMARIES_BT709 << 8) | (KHR_DF_TRANSFER_LINEAR << 16));     // flags: straight alpha
+    dfd.push_back(blockDimension | (blockDimension << 8));              // texelBlockDimension[0..3]
+    dfd.push_back(bytesPlane0);                                         // bytesPlane[0..3]
+    dfd.push_back(0);                                                   // bytesPlane[4..7]
+    for (const Sample &sample : samples)
+    {
+        dfd.push_back(sample.bitOffset | ((sample.bitLength - 1) << 16) | (sample.channel << 24));
+        dfd.push_back(0);                                               // samplePosition[0..3]
+        dfd.push_back(0);                                               // sampleLower
+        dfd.push_back(sample.upper);                                    // sampleUpper
+    }
+    return dfd;
+}
@@ -0,0 +1,25 @@
+#ifndef KTX2_WRITER_H
+#define KTX2_WRITER_H
+
+// C++ STL
+#include <string>
+#include <vector>
+
+// Project includes
+#include "Utilities.h"          // Utilities header includes GLFW [Graphics Library FrameWork] + Vulkan API
+
+// KTX2 (https://registry.khronos.org/KTX/specs/2.0/ktxspec.v2.html) writer for 2D textures with their mip chain,
+// no supercompression: the runtime Ktx2Loader copies the levels as they are.
+// Formats: VK_FORMAT_R8G8B8A8_UNORM, VK_FORMAT_BC1_RGB_UNORM_BLOCK, VK_FORMAT_BC7_UNORM_BLOCK.
+class Ktx2Writer
+{
+public:
+    // Levels: level 0 (the largest one) first. Throws on unsupported formats and I/O failures.
+    static void write(const std::string &filePath, VkFormat format, uint32_t width, uint32_t height,
+                      const std::vector<std::vector<uint8_t>> &levels);
+
+private:
+    static std::vector<uint32_t> buildDataFormatDescriptor(VkFormat format);
+};
+
+#endif //KTX2_WRITER_H
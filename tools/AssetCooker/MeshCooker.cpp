@@ -0,0 +1,100 @@
+#include "MeshCooker.h"
+
+// C++ STL
+#include <stdexcept>
+
+// Open Asset Import Library (https://github.com/assimp/assimp)
+#include <assimp/Importer.hpp>
+#include <assimp/postprocess.h>
+#include <assimp/scene.h>
+
+using namespace Utilities;
+
+// Bump when the processing below changes (cooked meshes are rebuilt)
+static const uint32_t MESH_COOKER_VERSION = 1;
+
+//------------------------------------------------------------------------------
+MeshCooker::MeshCooker()
+{
+}
+//------------------------------------------------------------------------------
+MeshCooker::~MeshCooker()
+{
+}
+//------------------------------------------------------------------------------
+void MeshCooker::cook(const std::string &sourcePath, const std::string &outputPath)
+{
+    // Triangles only (points and lines dropped), node transforms baked in the vertices, UV origin at the top left (Vulkan)
+    Assimp::Importer importer;
+    importer.SetPropertyInteger(AI_CONFIG_PP_SBP_REMOVE, aiPrimitiveType_POINT | aiPrimitiveType_LINE);
+    const aiScene * scene = importer.ReadFile(sourcePath,
+        aiProcess_Triangulate | aiProcess_JoinIdenticalVertices | aiProcess_PreTransformVertices | aiProcess_SortByPType |
+        aiProcess_FindDegenerates | aiProcess_ImproveCacheLocality | aiProcess_FlipUVs);
+    if (!scene || !scene->HasMeshes())
+    {
+        throw std::runtime_error("Failed to import the model '" + sourcePath + "' (" + importer.GetErrorString() + ")");
+    }
+
+    // All the meshes merged (their triangles keep the cache optimized order)
+    MeshPackage package;
+    for (uint32_t meshIdx = 0; meshIdx < scene->mNumMeshes; ++meshIdx)
+    {
+        const aiMesh * mesh = scene->mMeshes[meshIdx];
+        uint32_t baseVertex = static_cast<uint32_t>(package.vertices.size());
+        for (uint32_t i = 0; i < mesh->mNumVertices; ++i)
+        {
+            Vertex vertex;
+            vertex.pos = { mesh->mVertices[i].x, mesh->mVertices[i].y, mesh->mVertices[i].z };
+            vertex.col = mesh->HasVertexColors(0)
+                ? glm::vec3(mesh->mColors[0][i].r, mesh->mColors[0][i].g, mesh->mColors[0][i].b) : glm::vec3(1.0f);
+            vertex.tex = mesh->HasTextureCoords(0)
+                ? glm::vec2(mesh->mTextureCoords[0][i].x, mesh->mTextureCoords[0][i].y) : glm::vec2(0.0f);
+            package.vertices.push_back(vertex);
+        }
+        for (uint32_t faceIdx = 0; faceIdx < mesh->mNumFaces; ++faceIdx)
+        {
+            const aiFace &face = mesh->mFaces[faceIdx];
+            if (face.mNumIndices == 3)
+            {
+                package.indices.push_back(baseVertex + face.mIndices[0]);
+                package.indices.push_back(baseVertex + face.mIndices[1]);
+                package.indices.push_back(baseVertex + face.mIndices[2]);
+            }
+        }
+    }
+    if (package.indices.empty())
+    {
+        throw std::runtime_error("The model '" + sourcePath + "' has no triangles!");
+    }
+
+    optimizeVertexFetch(&package);
+    package.computeBounds();
+    package.write(outputPath);
+}
+//------------------------------------------------------------------------------
+uint64_t MeshCooker::getOptionsHash()
+{
+    uint64_t hash = hashCombine(FNV_OFFSET_BASIS, std::string("mesh"));
+    hash = hashCombine(hash, MESH_COOKER_VERSION);
+    return hashCombine(hash, sizeof(Vertex));
+}
+//------------------------------------------------------------------------------
+void MeshCooker::optimizeVertexFetch(MeshPackage * package)
+{
+    // Vertices in the order the (cache optimized) triangles first use them: sequential vertex fetches.
+    // Unreferenced vertices are dropped.
+    const uint32_t unassigned = ~0U;
+    std::vector<uint32_t> remap(package->vertices.size(), unassigned);
+    std::vector<Vertex> vertices;
+    vertices.reserve(package->vertices.size());
+    for (uint32_t &index : package->indices)
+    {
+        if (remap[index] == unassigned)
+        {
+            remap[index] = static_cast<uint32_t>(vertices.size());
+            vertices.push_back(package->vertices[index]);
+        }
+        index = remap[index];
+    }
+    package->vertices = std::move(vertices);
+}
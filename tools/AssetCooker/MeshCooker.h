@@ -0,0 +1,27 @@
+#ifndef MESH_COOKER_H
+#define MESH_COOKER_H
+
+// C++ STL
+#include <string>
+
+// Project includes
+#include "MeshPackage.h"
+#include "Utilities.h"          // Utilities header includes GLFW [Graphics Library FrameWork] + Vulkan API
+
+// Source model (any format ASSIMP imports: OBJ, FBX, glTF...) to a mesh package (MeshPackage): all the meshes of the
+// scene merged in model space, triangulated, identical vertices joined, triangles reordered for the post-transform
+// vertex cache, vertices reordered by first use (fetch locality), bounding sphere precomputed.
+class MeshCooker
+{
+public:
+    MeshCooker();
+    ~MeshCooker();
+
+    void        cook(const std::string &sourcePath, const std::string &outputPath);    // Throws on failures
+    uint64_t    getOptionsHash();           // Cooked files depend on these options (incremental rebuilds)
+
+private:
+    static void optimizeVertexFetch(MeshPackage * package);
+};
+
+#endif //MESH_COOKER_H
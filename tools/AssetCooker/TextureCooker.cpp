@@ -0,0 +1,69 @@
+#include "TextureCooker.h"
+
+// C++ STL
+#include <stdexcept>
+
+// Project includes
+#include "Ktx2Writer.h"
+
+using namespace Utilities;
+
+// Bump when the output of the processing changes (mip filter, block encoders, KTX2 layout): cooked textures are rebuilt
+static const uint32_t TEXTURE_COOKER_VERSION = 1;
+
+//------------------------------------------------------------------------------
+TextureCooker::TextureCooker(TextureCompression compression, CompressionQuality quality, uint32_t compressorWorkers)
+    : m_compression(compression)
+    , m_quality(quality)
+    , m_blockCompressor(compressorWorkers)
+{
+}
+//------------------------------------------------------------------------------
+TextureCooker::~TextureCooker()
+{
+}
+//------------------------------------------------------------------------------
+void TextureCooker::cook(const std::string &sourcePath, const std::string &outputPath)
+{
+    // Load pixel data for image (always RGBA, as the runtime does)
+    int width, height, channels;
+    stbi_uc * image = stbi_load(sourcePath.c_str(), &width, &height, &channels, STBI_rgb_alpha);
+    if (!image)
+    {
+        throw std::runtime_error("Failed to load the image '" + sourcePath + "' (" + stbi_failure_reason() + ")");
+    }
+
+    // Full mip chain, built on the CPU
+    std::vector<VkBufferImageCopy> regions;
+    uint32_t mipLevels = getMipLevelCount(static_cast<uint32_t>(width), static_cast<uint32_t>(height));
+    std::vector<uint8_t> mipChain = buildMipChainRgba8(image, static_cast<uint32_t>(width), static_cast<uint32_t>(height), mipLevels, &regions);
+    stbi_image_free(image);
+
+    // Every level compressed (or copied, for RGBA8)
+    std::vector<std::vector<uint8_t>> levels;
+    for (const VkBufferImageCopy &region : regions)
+    {
+        const uint8_t * levelPixels = mipChain.data() + region.bufferOffset;
+        if (m_compression == TextureCompression::None)
+        {
+            size_t levelSize = static_cast<size_t>(region.imageExtent.width) * region.imageExtent.height * 4;
+            levels.emplace_back(levelPixels, levelPixels + levelSize);
+        }
+        else
+        {
+            levels.push_back(m_blockCompressor.compress(levelPixels, region.imageExtent.width, region.imageExtent.height,
+                                                        m_compression, m_quality));
+        }
+    }
+
+    VkFormat format = (m_compression == TextureCompression::None) ? VK_FORMAT_R8G8B8A8_UNORM : BlockCompressor::getFormat(m_compression);
+    Ktx2Writer::write(outputPath, format, static_cast<uint32_t>(width), static_cast<uint32_t>(height), levels);
+}
+//------------------------------------------------------------------------------
+uint64_t TextureCooker::getOptionsHash()
+{
+    uint64_t hash = hashCombine(FNV_OFFSET_BASIS, std::string("texture"));
+    hash = hashCombine(hash, TEXTURE_COOKER_VERSION);
+    hash = hashCombine(hash, m_compression);
+    return hashCombine(hash, m_quality);
+}
@@ -0,0 +1,31 @@
+#ifndef TEXTURE_COOKER_H
+#define TEXTURE_COOKER_H
+
+// C++ STL
+#include <string>
+
+// Stub Image (https://github.com/nothings/stb)
+#include "stb_image.h"
+
+// Project includes
+#include "BlockCompressor.h"
+#include "Utilities.h"          // Utilities header includes GLFW [Graphics Library FrameWork] + Vulkan API
+
+// Source image (JPG, PNG, TGA, BMP...) to a KTX2 file: full mip chain, every level block compressed.
+// What the runtime does at load time for JPG/PNG textures (decodeTexture), done once offline.
+class TextureCooker
+{
+public:
+    TextureCooker(TextureCompression compression, CompressionQuality quality, uint32_t compressorWorkers);
+    ~TextureCooker();
+
+    void        cook(const std::string &sourcePath, const std::string &outputPath);    // Throws on failures
+    uint64_t    getOptionsHash();           // Cooked files depend on these options (incremental rebuilds)
+
+private:
+    TextureCompression  m_compression;
+    CompressionQuality  m_quality;
+    BlockCompressor     m_blockCompressor;
+};
+
+#endif //TEXTURE_COOKER_H
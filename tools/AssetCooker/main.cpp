@@ -0,0 +1,370 @@
+// C++ STL
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <charconv>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+using std::cout, std::endl;
+
+// Project includes (same sources as the runtime)
+#include "Utilities.h"          // Utilities header includes GLFW [Graphics Library FrameWork] + Vulkan API
+#include "AssetArchive.h"
+#include "MappedFile.h"
+#include "MeshCooker.h"
+#include "TextureCooker.h"
+
+using namespace Utilities;
+namespace fs = std::filesystem;
+
+// Incremental rebuilds: content hash + options hash of the source of every cooked file
+constexpr auto MANIFEST_FILE_NAME   = "cook_manifest.txt";
+// Directories of the source tree the runtime reads its assets from (outputs and archive names keep these paths)
+static const char * const ASSET_DIRECTORIES[] = { "Textures", "Models", "Shaders" };
+
+// A source asset to cook
+struct CookJob
+{
+    enum class Kind { Texture, Mesh, Copy };   // Copy: already in its runtime format (SPIR-V shaders)
+
+    Kind            kind;
+    std::string     relativePath;           // Manifest key
+    std::string     sourcePath;
+    std::string     outputPath;
+    uint64_t        sourceHash  = 0;
+    uint64_t        optionsHash = 0;
+    bool            upToDate    = false;
+    bool            cooked      = false;
+    std::string     error;
+};
+
+struct ManifestEntry
+{
+    uint64_t        sourceHash  = 0;
+    uint64_t        optionsHash = 0;
+};
+
+//------------------------------------------------------------------------------
+static void printUsage()
+{
+    cout << "Usage: AssetCooker <source directory> <output directory> [options]" << endl
+         << "  The source directory is the one the application runs from: the files of its Textures/, Models/ and Shaders/" << endl
+         << "  keep their path in the output (and in the archive), only their extension changes:" << endl
+         << "  Textures (jpg, jpeg, png, tga, bmp) -> <output>/<path>/<name>.ktx2   (mip chain, block compressed)" << endl
+         << "  Models   (obj, fbx, gltf, glb, dae)  -> <output>/<path>/<name>.mesh   (cache optimized, with bounds)" << endl
+         << "  Shaders  (spv)                       -> <output>/<path>/<name>.spv    (copied)" << endl
+         << "  The output directory can be the source one: the cooked files are read next to their source" << endl
+         << "Options:" << endl
+         << "  --compression <bc7|bc1|none>    Texture format (default: bc7)" << endl
+         << "  --quality <fast|quality>        Block compression quality (default: quality)" << endl
+         << "  --jobs <count>                  Parallel jobs (default: all the cores)" << endl
+         << "  --force                         Cook everything, even the assets that are up to date" << endl
+         << "  --archive <file>                Also pack every cooked asset in a single archive (LZ4 where it pays off, except shaders)" << endl;
+}
+//------------------------------------------------------------------------------
+static uint64_t hashFile(const std::string &filePath)
+{
+    MappedFile file;
+    if (!file.open(filePath))
+    {
+        throw std::runtime_error("Failed to read '" + filePath + "'");
+    }
+    return hashCombine(hashFnv1a(file.getData(), file.getSize()), file.getSize());
+}
+//------------------------------------------------------------------------------
+static std::map<std::string, ManifestEntry> readManifest(const std::string &filePath)
+{
+    // One line per cooked source: <source hash> <options hash> <relative path>
+    std::map<std::string, ManifestEntry> manifest;
+    std::ifstream file(filePath);
+    std::string line;
+    while (std::getline(file, line))
+    {
+        std::istringstream lineStream(line);
+        ManifestEntry entry;
+        std::string relativePath;
+        if (lineStream >> std::hex >> entry.sourceHash >> entry.optionsHash && std::getline(lineStream >> std::ws, relativePath))
+        {
+            manifest[relativePath] = entry;
+        }
+    }
+    return manifest;
+}
+//------------------------------------------------------------------------------
+static void writeManifest(const std::string &filePath, const std::vector<CookJob> &jobs)
+{
+    // Written aside and renamed: an interrupted run never leaves a truncated manifest
+    std::string tempFilePath = filePath + ".tmp";
+    {
+        std::ofstream file(tempFilePath, std::ios::trunc);
+        for (const CookJob &job : jobs)
+        {
+            if (job.upToDate || job.cooked)
+            {
+                file << std::hex << std::setfill('0') << std::setw(16) << job.sourceHash << " "
+                     << std::setw(16) << job.optionsHash << " " << job.relativePath << "\n";
+            }
+        }
+    }
+    std::error_code errorCode;
+    fs::rename(tempFilePath, filePath, errorCode);
+}
+//------------------------------------------------------------------------------
+static bool parseCount(const std::string &value, uint32_t * count)
+{
+    // The whole value must be a positive number (no exceptions: a bad option prints the usage)
+    uint32_t parsed = 0;
+    auto [end, error] = std::from_chars(value.data(), value.data() + value.size(), parsed);
+    if (error != std::errc() || end != value.data() + value.size() || parsed == 0)
+    {
+        return false;
+    }
+    *count = parsed;
+    return true;
+}
+//------------------------------------------------------------------------------
+int main(int argc, char * argv[])
+{
+    if (argc < 3)
+    {
+        printUsage();
+        return EXIT_FAILURE;
+    }
+
+    // Command line
+    fs::path sourceDir = argv[1];
+    fs::path outputDir = argv[2];
+    TextureCompression compression = TextureCompression::BC7;
+    CompressionQuality quality = CompressionQuality::Quality;
+    uint32_t jobCount = std::max(std::thread::hardware_concurrency(), 1U);
+    bool force = false;
+    std::string archivePath;
+    for (int i = 3; i < argc; ++i)
+    {
+        std::string option = argv[i];
+        std::string value = (i + 1 < argc) ? argv[i + 1] : "";
+        if (option == "--compression" && (value == "bc7" || value == "bc1" || value == "none"))
+        {
+            compression = (value == "bc7") ? TextureCompression::BC7 : (value == "bc1") ? TextureCompression::BC1 : TextureCompression::None;
+            ++i;
+        }
+        else if (option == "--quality" && (value == "fast" || value == "quality"))
+        {
+            quality = (value == "fast") ? CompressionQuality::Fast : CompressionQuality::Quality;
+            ++i;
+        }
+        else if (option == "--jobs" && parseCount(value, &jobCount))
+        {
+            ++i;
+        }
+        else if (option == "--archive" && !value.empty())
+        {
+            archivePath = value;
+            ++i;
+        }
+        else if (option == "--force")
+        {
+            force = true;
+        }
+        else
+        {
+            printUsage();
+            return EXIT_FAILURE;
+        }
+    }
+
+    std::error_code errorCode;
+    if (!fs::is_directory(sourceDir, errorCode))
+    {
+        cout << "ERROR: '" << sourceDir.string() << "' is not a directory" << endl;
+        return EXIT_FAILURE;
+    }
+    fs::create_directories(outputDir, errorCode);
+
+    std::chrono::steady_clock::time_point tBegin = std::chrono::steady_clock::now();
+
+    // Collect the source assets (not the ones of an output directory nested in the source tree)
+    fs::path outputRoot = fs::weakly_canonical(outputDir, errorCode);
+    bool nestedOutput = outputRoot != fs::weakly_canonical(sourceDir, errorCode);
+    std::vector<CookJob> jobs;
+    for (const char * directory : ASSET_DIRECTORIES)
+    {
+        for (const auto &entry : fs::recursive_directory_iterator(sourceDir / directory, errorCode))
+        {
+            fs::path entryPath = fs::weakly_canonical(entry.path(), errorCode);
+            if (!entry.is_regular_file() ||
+                (nestedOutput && std::mismatch(outputRoot.begin(), outputRoot.end(), entryPath.begin(), entryPath.end()).first == outputRoot.end()))
+            {
+                continue;
+            }
+            std::string extension = entry.path().extension().string();
+            std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+
+            // Same path as the source (e.g. Textures/giraffe.jpg -> Textures/giraffe.ktx2), what the runtime looks up
+            CookJob job;
+            fs::path relativePath = fs::relative(entry.path(), sourceDir);
+            if (extension == ".jpg" || extension == ".jpeg" || extension == ".png" || extension == ".tga" || extension == ".bmp")
+            {
+                job.kind = CookJob::Kind::Texture;
+                job.outputPath = (outputDir / relativePath).replace_extension(".ktx2").string();
+            }
+            else if (extension == ".obj" || extension == ".fbx" || extension == ".gltf" || extension == ".glb" || extension == ".dae")
+            {
+                job.kind = CookJob::Kind::Mesh;
+                job.outputPath = (outputDir / relativePath).replace_extension(".mesh").string();
+            }
+            else if (extension == ".spv")
+            {
+                job.kind = CookJob::Kind::Copy;
+                job.outputPath = (outputDir / relativePath).string();
+            }
+            else
+            {
+                continue;
+            }
+            job.relativePath = relativePath.generic_string();
+            job.sourcePath = entry.path().string();
+            jobs.push_back(job);
+        }
+    }
+
+    // Jobs are spread on the cores: a texture uses more compressor threads only when there are fewer jobs than cores
+    std::string manifestPath = (outputDir / MANIFEST_FILE_NAME).string();
+    std::map<std::string, ManifestEntry> manifest = force ? std::map<std::string, ManifestEntry>() : readManifest(manifestPath);
+    jobCount = std::min(jobCount, std::max(static_cast<uint32_t>(jobs.size()), 1U));
+    uint32_t compressorWorkers = std::max(std::max(std::thread::hardware_concurrency(), 1U) / jobCount, 1U);
+
+    std::atomic<size_t> nextJob { 0 };
+    std::vector<std::thread> workers;
+    for (uint32_t workerIdx = 0; workerIdx < jobCount; ++workerIdx)
+    {
+        workers.emplace_back([&]() {
+            TextureCooker textureCooker(compression, quality, compressorWorkers);
+            MeshCooker meshCooker;
+            for (size_t jobIdx = nextJob++; jobIdx < jobs.size(); jobIdx = nextJob++)
+            {
+                CookJob &job = jobs[jobIdx];
+                try
+                {
+                    // Skipped when the source content and the options are the same as the last cook
+                    job.sourceHash = hashFile(job.sourcePath);
+                    job.optionsHash = (job.kind == CookJob::Kind::Texture) ? textureCooker.getOptionsHash()
+                                    : (job.kind == CookJob::Kind::Mesh) ? meshCooker.getOptionsHash() : FNV_OFFSET_BASIS;
+                    auto previous = manifest.find(job.relativePath);
+                    std::error_code existsError;
+                    if (previous != manifest.end() && previous->second.sourceHash == job.sourceHash &&
+                        previous->second.optionsHash == job.optionsHash && fs::exists(job.outputPath, existsError))
+                    {
+                        job.upToDate = true;
+                        continue;
+                    }
+
+                    std::error_code directoryError;
+                    fs::create_directories(fs::path(job.outputPath).parent_path(), directoryError);
+                    if (job.kind == CookJob::Kind::Texture)
+                    {
+                        textureCooker.cook(job.sourcePath, job.outputPath);
+                    }
+                    else if (job.kind == CookJob::Kind::Mesh)
+                    {
+                        meshCooker.cook(job.sourcePath, job.outputPath);
+                    }
+                    else if (!fs::equivalent(job.sourcePath, job.outputPath, directoryError))   // Cooked in place: nothing to copy
+                    {
+                        fs::copy_file(job.sourcePath, job.outputPath, fs::copy_options::overwrite_existing);
+                    }
+                    job.cooked = true;
+                }
+                catch (const std::exception &e)
+                {
+                    job.error = e.what();
+                }
+            }
+        });
+    }
+    for (std::thread &worker : workers)
+    {
+        worker.join();
+    }
+
+    // Report (in source order) and remember what is up to date
+    uint32_t cookedCount = 0, upToDateCount = 0, failedCount = 0;
+    for (const CookJob &job : jobs)
+    {
+        if (job.cooked)
+        {
+            cout << "[cooked]     " << job.relativePath << " -> " << job.outputPath << endl;
+            ++cookedCount;
+        }
+        else if (job.upToDate)
+        {
+            ++upToDateCount;
+        }
+        else
+        {
+            cout << "[FAILED]     " << job.relativePath << ": " << job.error << endl;
+            ++failedCount;
+        }
+    }
+    writeManifest(manifestPath, jobs);
+
+    // Single file package: named by their path relative to the output directory (Textures/giraffe.ktx2,
+    // Shaders/vert.spv, ...), as the runtime looks them up
+    if (!archivePath.empty())
+    {
+        try
+        {
+            AssetArchiveWriter archive;
+            std::vector<std::string> packedNames;
+            for (const CookJob &job : jobs)
+            {
+                MappedFile file;
+                if ((job.cooked || job.upToDate) && file.open(job.outputPath))
+                {
+                    // Shaders stay uncompressed: their modules are created straight from the mapping
+                    AssetCompression compression = (job.kind == CookJob::Kind::Copy) ? AssetCompression::None : AssetCompression::Lz4;
+                    packedNames.push_back(fs::path(job.outputPath).lexically_relative(outputDir).generic_string());
+                    archive.add(packedNames.back(), file.getData(), file.getSize(), compression);
+                }
+            }
+            archive.write(archivePath);
+
+            // Self-test: the written archive is read back as the runtime does, every asset must resolve by its name
+            AssetArchive written;
+            if (!written.open(archivePath))
+            {
+                throw std::runtime_error("the written archive can't be opened");
+            }
+            for (const std::string &name : packedNames)
+            {
+                if (!written.contains(name))
+                {
+                    throw std::runtime_error("'" + name + "' doesn't resolve from the archive");
+                }
+            }
+            written.close();
+            cout << packedNames.size() << " assets packed in '" << archivePath << "'" << endl;
+        }
+        catch (const std::exception &e)
+        {
+            cout << "[FAILED]     " << archivePath << ": " << e.what() << endl;
+            ++failedCount;
+        }
+    }
+
+    std::chrono::steady_clock::time_point tEnd = std::chrono::steady_clock::now();
+    cout << endl << cookedCount << " cooked, " << upToDateCount << " up to date, " << failedCount << " failed ("
+         << jobCount << " jobs, " << std::chrono::duration_cast<std::chrono::milliseconds>(tEnd - tBegin).count() << "[ms])" << endl;
+
+    return failedCount == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}